@@ -37,6 +37,7 @@ extern "C" {
 
 class VESSEL;
 class MFD2;
+namespace oapi { union IVECTOR2; }
 
 struct AirfoilContext {
 	lua_State *L;
@@ -108,6 +109,62 @@ public:
 	 */
 	virtual void EndExec ();
 
+	/**
+	 * \brief Switch the interpreter to scheduler mode.
+	 * \param cycle client function performing one execution cycle (normally
+	 *   a RunChunk call on the client's command buffer)
+	 * \param context client context passed to cycle
+	 * \note In scheduler mode, RunChunk runs a command as a Lua coroutine.
+	 *   proc.Frameskip suspends the coroutine, and the next call to RunChunk
+	 *   resumes it (the chunk argument is ignored while IsBusy() is true).
+	 *   The cycle function is called from the orbiter thread by Schedule(),
+	 *   so the client does not need an interpreter thread, and WaitExec and
+	 *   EndExec are not used.
+	 * \note A coroutine can't be suspended across a C call boundary, such
+	 *   as pcall or a metamethod. Calling proc.Frameskip from there raises
+	 *   an error.
+	 */
+	void SetScheduled (void (*cycle)(void*), void *context);
+
+	/**
+	 * \brief Returns true if the interpreter runs in scheduler mode.
+	 */
+	inline bool IsScheduled () const { return cycle != 0; }
+
+	/**
+	 * \brief Returns true if clients should create their interpreters in
+	 *   scheduler mode.
+	 * \note Set with the 'Scheduler' item in Config\LuaInterpreter.cfg.
+	 */
+	static bool UseScheduler ();
+
+	/**
+	 * \brief Run one execution cycle of the scheduled interpreters.
+	 * \note Called by each client from its post-step callback. Only the
+	 *   first call in a frame has an effect. Interpreters are served
+	 *   round-robin until the time budget of the frame (item
+	 *   'SchedulerBudget' in ms in Config\LuaInterpreter.cfg) is used up.
+	 *   The next frame continues with the first interpreter not served.
+	 */
+	static void Schedule ();
+
+	/**
+	 * \brief Write the execution profile of the interpreter to Orbiter.log.
+	 * \note Profiling is enabled with 'Profile = TRUE' in
+	 *   Config\LuaInterpreter.cfg. The profile lists the wall time spent
+	 *   in RunChunk and PostStep, and for each Lua function the number of
+	 *   calls and of instruction samples (one per 'ProfileInterval'
+	 *   instructions, default 1000). Scripts can read the profile with
+	 *   oapi.profile().
+	 * \note An instruction budget per frame ('InstructionBudget' item) is
+	 *   enforced independently. A script exceeding it is suspended until
+	 *   the next frame where possible (interpreter thread, or command
+	 *   coroutine in scheduler mode), and aborted with an error otherwise.
+	 * \note Without either item, no hook is installed and scripts run at
+	 *   full speed.
+	 */
+	void WriteProfile ();
+
 	/**
 	 * \brief Define functions for interfacing with Orbiter API
 	 */
@@ -132,7 +189,8 @@ public:
 	 * \brief Executes a command or script.
 	 * \param chunk command line string
 	 * \param n string length
-	 * \return Execution status as returned by lua_pcall (0=no error)
+	 * \return Execution status as returned by lua_pcall (0=no error),
+	 *   or LUA_YIELD if the command was suspended (scheduler mode)
 	 */
 	virtual int RunChunk (const char *chunk, int n);
 
@@ -203,19 +261,21 @@ protected:
 	// This also handles vector and nil entries.
 	static const char *lua_tostringex (lua_State *L, int idx, char *cbuf = 0);
 
-	// pushes vector 'vec' into a table on top of the stack
+	// pushes vector 'vec' as a vector userdata on top of the stack
 	static void lua_pushvector (lua_State *L, const VECTOR3 &vec);
 
 	// converts the vector at stack position 'idx' into a VECTOR3
+	// (vector userdata, or table with fields x, y, z)
 	static VECTOR3 lua_tovector (lua_State *L, int idx);
 
 	// returns 1 if stack entry idx is a vector, 0 otherwise
 	static int lua_isvector (lua_State *L, int idx);
 
-	// pushes matrix 'mat' into a table on top of the stack
+	// pushes matrix 'mat' as a matrix userdata on top of the stack
 	static void lua_pushmatrix (lua_State *L, const MATRIX3 &mat);
 
 	// converts the matrix at stack position 'idx' into a MATRIX3
+	// (matrix userdata, or table with fields m11 ... m33)
 	static MATRIX3 lua_tomatrix (lua_State *L, int idx);
 
 	// returns 1 if stack entry idx is a matrix, 0 otherwise
@@ -244,6 +304,8 @@ protected:
 	// global functions
 	static int help (lua_State *L);
 	static int help_api (lua_State *L);
+	static int chunkLoadfile (lua_State *L); // loadfile and dofile using the
+	static int chunkDofile (lua_State *L);   // precompiled chunk cache
 
 	// vector library functions
 	static int vec_set (lua_State *L);
@@ -261,6 +323,16 @@ protected:
 	static int mat_tmul (lua_State *L);
 	static int mat_mmul (lua_State *L);
 
+	// vector and matrix userdata metamethods
+	static int vec_unm (lua_State *L);
+	static int vec_index (lua_State *L);
+	static int vec_newindex (lua_State *L);
+	static int vec_tostring (lua_State *L);
+	static int mat_mulop (lua_State *L);
+	static int mat_index (lua_State *L);
+	static int mat_newindex (lua_State *L);
+	static int mat_tostring (lua_State *L);
+
 	// process library functions
 	static int procFrameskip (lua_State *L);
 
@@ -279,6 +351,7 @@ protected:
 	static int oapi_global_to_equ (lua_State *L);
 	static int oapi_equ_to_global (lua_State *L);
 	static int oapi_orthodome (lua_State *L);
+	static int oapi_profile (lua_State *L);
 
 	// Time functions
 	static int oapi_get_simtime (lua_State *L);
@@ -473,6 +546,7 @@ protected:
 	static int v_get_relativepos (lua_State *L);
 	static int v_get_relativevel (lua_State *L);
 	static int v_get_rotationmatrix (lua_State *L);
+	static int v_get_state (lua_State *L);
 
 	// atmospheric parameters
 	static int v_get_atmref (lua_State *L);
@@ -620,6 +694,7 @@ protected:
 	static int skp_ellipse (lua_State *L);
 	static int skp_polygon (lua_State *L);
 	static int skp_polyline (lua_State *L);
+	static int skp_polylines (lua_State *L);
 	static int skp_set_origin (lua_State *L);
 	static int skp_set_textalign (lua_State *L);
 	static int skp_set_textcolor (lua_State *L);
@@ -639,6 +714,41 @@ private:
 	bool bExecLocal;   // flag for locally created mutexes
 	bool bWaitLocal;
 
+	lua_State *co;           // coroutine of the current command (scheduler mode)
+	int coref;               // registry reference anchoring co
+	void (*cycle)(void*);    // client execution cycle (scheduler mode)
+	void *cyclecontext;
+
+	static Interpreter **sched; // interpreters in scheduler mode
+	static DWORD nsched, nschedbuf;
+	static DWORD schednext;     // next interpreter to be served
+	static double schedbudget;  // time budget per frame [s]
+	static bool schedmode;      // clients should use scheduler mode
+
+	struct ProfileData;
+	ProfileData *prof;       // execution profile (NULL if not profiling)
+	DWORD ninstr;            // instructions executed in the current frame
+	double tbudget;          // system time of the current frame
+	DWORD mainthread;        // orbiter thread
+	static bool profmode;       // profiling enabled
+	static int profinterval;    // instructions per hook call
+	static DWORD instrbudget;   // instruction budget per frame (0=none)
+
+	// Sketchpad vertex arena, reused by the polygon/polyline methods
+	oapi::IVECTOR2 *skppt;   // vertex buffer
+	int nskppt;              // vertex buffer size
+	int *skpnpt;             // vertex counts for skp:polylines
+	int nskpnpt;             // vertex count buffer size
+	void SkpReserve (int npt);
+	int SkpReadPoints (lua_State *L, int idx, int ofs);
+
+	static void ReadConfig ();
+	static void ProfileHook (lua_State *L, lua_Debug *ar);
+	void ProfileRecord (lua_State *L, lua_Debug *ar, bool call);
+	void ProfileRun (LONGLONG t0);
+	void BudgetExceeded (lua_State *L);
+	static bool CanYield (lua_State *L, int level);
+
 	static NOTEHANDLE hnote; // screen note (shared between all instances)
 	int status;              // interpreter status
 	bool is_busy;            // interpreter busy (running a script)
@@ -18,7 +18,9 @@
 #include "DlgCtrl.h"
 #include "meshres.h"
 #include "meshres_vc.h"
+#include "../../Common/AeroTable.h"
 #include "resource.h"
+#include "../../Common/AttachIndex.h"
 #include <stdio.h>
 #include <fstream>
 
@@ -33,6 +35,7 @@
 // Global (class-wide) parameters
 
 GDIParams g_Param;
+AttachIndex *g_AttachIndex = 0; // grappling candidate search
 
 char *ActionString[5] = {"STOPPED", "ISCLOSED", "ISOPEN", "CLOSE", "OPEN"};
 
@@ -57,41 +60,41 @@ extern void GetSRB_State (double met, double &thrust_level, double &prop_level);
 // function of angle of attack (alpha or beta)
 // ==============================================================
 
+// Coefficient tables, shared by all Atlantis instances.
+// Built by DefineAirfoilTables at class caps time.
+static AeroTable vlift, hlift;
+
 // 1. vertical lift component (wings and body)
 
 void VLiftCoeff (double aoa, double M, double Re, double *cl, double *cm, double *cd)
 {
-	static const double step = RAD*15.0;
-	static const double istep = 1.0/step;
-	static const int nabsc = 25;
-	static const double CL[nabsc] = {0.1, 0.17, 0.2, 0.2, 0.17, 0.1, 0, -0.11, -0.24, -0.38,  -0.5,  -0.5, -0.02, 0.6355,    0.63,   0.46, 0.28, 0.13, 0.0, -0.16, -0.26, -0.29, -0.24, -0.1, 0.1};
-	static const double CM[nabsc] = {  0,    0,   0,   0,    0,   0, 0,     0,    0,0.002,0.004, 0.0025,0.0012,      0,-0.0012,-0.0007,    0,    0,   0,     0,     0,     0,     0,    0,   0};
-	// lift and moment coefficients from -180 to 180 in 15 degree steps.
-	// This uses a documented lift slope of 0.0437/deg, everything else is rather ad-hoc
-
-	aoa += PI;
-	int idx = max (0, min (23, (int)(aoa*istep)));
-	double d = aoa*istep - idx;
-	*cl = CL[idx] + (CL[idx+1]-CL[idx])*d;
-	*cm = CM[idx] + (CM[idx+1]-CM[idx])*d;
-	*cd = 0.06 + oapiGetInducedDrag (*cl, 2.266, 0.6);
+	vlift.Eval (aoa, M, cl, cm, cd);
 }
 
 // 2. horizontal lift component (vertical stabiliser and body)
 
 void HLiftCoeff (double beta, double M, double Re, double *cl, double *cm, double *cd)
 {
-	static const double step = RAD*22.5;
-	static const double istep = 1.0/step;
-	static const int nabsc = 17;
-	static const double CL[nabsc] = {0, 0.2, 0.3, 0.2, 0, -0.2, -0.3, -0.2, 0, 0.2, 0.3, 0.2, 0, -0.2, -0.3, -0.2, 0};
+	hlift.Eval (beta, M, cl, cm, cd);
+}
+
+// 3. table definitions (once per class)
+
+static void DefineAirfoilTables ()
+{
+	if (vlift.Defined()) return;
 
-	beta += PI;
-	int idx = max (0, min (15, (int)(beta*istep)));
-	double d = beta*istep - idx;
-	*cl = CL[idx] + (CL[idx+1]-CL[idx])*d;
-	*cm = 0.0;
-	*cd = 0.02 + oapiGetInducedDrag (*cl, 1.5, 0.6);
+	static const int nvabsc = 25;
+	static const double VCL[nvabsc] = {0.1, 0.17, 0.2, 0.2, 0.17, 0.1, 0, -0.11, -0.24, -0.38,  -0.5,  -0.5, -0.02, 0.6355,    0.63,   0.46, 0.28, 0.13, 0.0, -0.16, -0.26, -0.29, -0.24, -0.1, 0.1};
+	static const double VCM[nvabsc] = {  0,    0,   0,   0,    0,   0, 0,     0,    0,0.002,0.004, 0.0025,0.0012,      0,-0.0012,-0.0007,    0,    0,   0,     0,     0,     0,     0,    0,   0};
+	// lift and moment coefficients from -180 to 180 in 15 degree steps.
+	// This uses a documented lift slope of 0.0437/deg, everything else is rather ad-hoc
+	vlift.SetLift (nvabsc, 0, VCL, VCM, 0.06, 0.0, 2.266, 0.6);
+
+	static const int nhabsc = 17;
+	static const double HCL[nhabsc] = {0, 0.2, 0.3, 0.2, 0, -0.2, -0.3, -0.2, 0, 0.2, 0.3, 0.2, 0, -0.2, -0.3, -0.2, 0};
+	// lift coefficients from -180 to 180 in 22.5 degree steps
+	hlift.SetLift (nhabsc, 0, HCL, 0, 0.02, 0.0, 1.5, 0.6);
 }
 
 // ==============================================================
@@ -399,6 +402,7 @@ void Atlantis::SetOrbiterConfiguration (void)
 
 	SetRotDrag (_V(0.43,0.43,0.29)); // angular drag
 
+	DefineAirfoilTables();
 	CreateAirfoil (LIFT_VERTICAL,   _V(0,0,-0.5), VLiftCoeff, 20, 270, 2.266);
 	CreateAirfoil (LIFT_HORIZONTAL, _V(0,0,-4), HLiftCoeff, 20,  50, 1.5);
 
@@ -960,36 +964,20 @@ void Atlantis::ToggleGrapple (void)
 
 	} else {             // grapple satellite
 
-		VECTOR3 gpos, grms, pos, dir, rot;
+		VECTOR3 grms;
 		Local2Global (orbiter_ofs+arm_tip[0], grms);  // global position of RMS tip
-		
-		// Search the complete vessel list for a grappling candidate.
-		// Not very scalable ...
-		for (DWORD i = 0; i < oapiGetVesselCount(); i++) {
-			OBJHANDLE hV = oapiGetVesselByIndex (i);
-			if (hV == GetHandle()) continue; // we don't want to grapple ourselves ...
-			oapiGetGlobalPos (hV, &gpos);
-			if (dist (gpos, grms) < oapiGetSize (hV)) { // in range
-				VESSEL *v = oapiGetVesselInterface (hV);
-				DWORD nAttach = v->AttachmentCount (true);
-				for (DWORD j = 0; j < nAttach; j++) { // now scan all attachment points of the candidate
-					ATTACHMENTHANDLE hAtt = v->GetAttachmentHandle (true, j);
-					const char *id = v->GetAttachmentId (hAtt);
-					if (strncmp (id, "GS", 2)) continue; // attachment point not compatible
-					v->GetAttachmentParams (hAtt, pos, dir, rot);
-					v->Local2Global (pos, gpos);
-					if (dist (gpos, grms) < MAX_GRAPPLING_DIST) { // found one!
-						// check whether satellite is currently clamped into payload bay
-						if (hV == GetAttachmentStatus (sat_attach))
-							DetachChild (sat_attach);
-						AttachChild (hV, rms_attach, hAtt);
-						if (hDlg = oapiFindDialog (g_Param.hDLL, IDD_RMS)) {
-							SetWindowText (GetDlgItem (hDlg, IDC_GRAPPLE), "Release");
-							EnableWindow (GetDlgItem (hDlg, IDC_STOW), FALSE);
-						}
-						return;
-					}
-				}
+
+		// Find the closest compatible attachment point within reach
+		OBJHANDLE hV;
+		ATTACHMENTHANDLE hAtt = g_AttachIndex->FindNearest (grms, MAX_GRAPPLING_DIST, "GS", GetHandle(), &hV);
+		if (hAtt) {
+			// check whether satellite is currently clamped into payload bay
+			if (hV == GetAttachmentStatus (sat_attach))
+				DetachChild (sat_attach);
+			AttachChild (hV, rms_attach, hAtt);
+			if (hDlg = oapiFindDialog (g_Param.hDLL, IDD_RMS)) {
+				SetWindowText (GetDlgItem (hDlg, IDC_GRAPPLE), "Release");
+				EnableWindow (GetDlgItem (hDlg, IDC_STOW), FALSE);
 			}
 		}
 
@@ -1015,21 +1003,10 @@ ATTACHMENTHANDLE Atlantis::CanArrest (void) const
 {
 	OBJHANDLE hV = GetAttachmentStatus (rms_attach);
 	if (!hV) return 0;
-	VESSEL *v = oapiGetVesselInterface (hV);
-	DWORD nAttach = v->AttachmentCount (true);
-	VECTOR3 pos, dir, rot, gpos, gbay;
+	VECTOR3 pos, dir, rot, gbay;
 	GetAttachmentParams (sat_attach, pos, dir, rot);
 	Local2Global (pos, gbay);
-	for (DWORD j = 0; j < nAttach; j++) {
-		ATTACHMENTHANDLE hAtt = v->GetAttachmentHandle (true, j);
-		if (strncmp (v->GetAttachmentId (hAtt), "XS", 2)) continue; // attachment point not compatible
-		v->GetAttachmentParams (hAtt, pos, dir, rot);
-		v->Local2Global (pos, gpos);
-		if (dist (gpos, gbay) < MAX_GRAPPLING_DIST) {
-			return hAtt;
-		}
-	}
-	return 0;
+	return g_AttachIndex->FindOnVessel (hV, gbay, MAX_GRAPPLING_DIST, "XS");
 }
 
 void Atlantis::SeparateMMU (void)
@@ -2049,6 +2026,7 @@ DLLCLBK void InitModule (HINSTANCE hModule)
 	g_Param.hDLL = hModule;
 	oapiRegisterCustomControls (hModule);
 	g_Param.tkbk_label = oapiCreateSurface (LOADBMP (IDB_TKBKLABEL));
+	oapiRegisterModule (g_AttachIndex = new AttachIndex (hModule));
 
 	// allocate GDI resources
 	g_Param.font[0] = CreateFont (-11, 0, 0, 0, 400, 0, 0, 0, 0, 0, 0, 0, 0, "Arial");
@@ -13,7 +13,9 @@ static Atlantis *sts_dlg;
 
 // ==============================================================
 
-PayloadBayOp::PayloadBayOp (Atlantis *_sts): sts(_sts)
+PayloadBayOp::PayloadBayOp (Atlantis *_sts): sts(_sts),
+  BayDoorStatus (act.State(ACT_BAYDOOR)), RadiatorStatus (act.State(ACT_RADIATOR)),
+  RadLatchStatus (act.State(ACT_RADLATCH)), KuAntennaStatus (act.State(ACT_KUANTENNA))
 {
 	sts_dlg = sts;
 	hDlg = NULL;
@@ -23,91 +25,58 @@ PayloadBayOp::PayloadBayOp (Atlantis *_sts): sts(_sts)
 	// Cargo bay doors
 	for (i = 0; i < 2; i++) BayDoor[i] = BD_DISABLE;
 	BayDoorOp = BDO_STOP;
-	BayDoorStatus.Set (AnimState::CLOSED, 0);
 
 	// Radiators
 	for (i = 0; i < 2; i++) MechPwr[i] = MP_OFF;
 	for (i = 0; i < 2; i++) RadiatorCtrl[i] = RC_OFF;
 	for (i = 0; i < 2; i++) RadLatchCtrl[i] = LC_OFF;
-	RadiatorStatus.Set (AnimState::CLOSED, 0);
-	RadLatchStatus.Set (AnimState::CLOSED, 0);
 
 	// Ku-band antenna
 	KuCtrl = KU_GND;
 	KuDirectCtrl = KU_DIRECT_OFF;
-	KuAntennaStatus.Set (AnimState::CLOSED, 0);
+
+	// physical systems; all stowed initially
+	act.Init (sts, this);
+	act.Define (ACT_BAYDOOR,   DOOR_OPERATING_SPEED,     ACT_NOANIM, ActuatorMoved, ActuatorDone);
+	act.Define (ACT_RADIATOR,  RAD_OPERATING_SPEED,      ACT_NOANIM, ActuatorMoved, ActuatorDone);
+	act.Define (ACT_RADLATCH,  RADLATCH_OPERATING_SPEED, ACT_NOANIM, ActuatorMoved, ActuatorDone);
+	act.Define (ACT_KUANTENNA, KU_OPERATING_SPEED,       ACT_NOANIM, ActuatorMoved, ActuatorDone);
 }
 
 // ==============================================================
 
 void PayloadBayOp::Step (double t, double dt)
 {
-	// Operate cargo doors
-	if (BayDoorStatus.Moving()) {
-		double da = dt * DOOR_OPERATING_SPEED;
-		if (BayDoorStatus.Closing()) {
-			if (BayDoorStatus.pos > 0.0)
-				BayDoorStatus.pos = max (0.0, BayDoorStatus.pos-da);
-			else
-				SetDoorAction (AnimState::CLOSED);
-		} else { // door opening
-			if (BayDoorStatus.pos < 1.0)
-				BayDoorStatus.pos = min (1.0, BayDoorStatus.pos+da);
-			else
-				SetDoorAction (AnimState::OPEN);
-		}
-		sts->SetBayDoorPosition (BayDoorStatus.pos);
-	}
+	// Operate cargo doors, radiators, radiator latches and Ku-band antenna
+	act.Step (dt);
+}
 
-	// Operate radiators
-	if (RadiatorStatus.Moving()) {
-		double da = dt * RAD_OPERATING_SPEED;
-		if (RadiatorStatus.Closing()) {
-			if (RadiatorStatus.pos > 0.0)
-				RadiatorStatus.pos = max (0.0, RadiatorStatus.pos-da);
-			else
-				SetRadiatorAction (AnimState::CLOSED);
-		} else { // radiator deploying
-			if (RadiatorStatus.pos < 1.0)
-				RadiatorStatus.pos = min (1.0, RadiatorStatus.pos+da);
-			else
-				SetRadiatorAction (AnimState::OPEN);
-		}
-		sts->SetRadiatorPosition (RadiatorStatus.pos);
-	}
+// ==============================================================
+// Actuator callback: apply the new position to the orbiter
+// (the positions are animated by the Atlantis class)
 
-	// Operate radiator latches
-	if (RadLatchStatus.Moving()) {
-		double da = dt * RADLATCH_OPERATING_SPEED;
-		if (RadLatchStatus.Closing()) {
-			if (RadLatchStatus.pos > 0.0)
-				RadLatchStatus.pos = max (0.0, RadLatchStatus.pos-da);
-			else
-				SetRadLatchAction (AnimState::CLOSED);
-		} else { // radiator latches releasing
-			if (RadLatchStatus.pos < 1.0)
-				RadLatchStatus.pos = min (1.0, RadLatchStatus.pos+da);
-			else
-				SetRadLatchAction (AnimState::OPEN);
-		}
-		sts->SetRadLatchPosition (RadLatchStatus.pos);
+void PayloadBayOp::ActuatorMoved (void *context, int id, const AnimState &state)
+{
+	Atlantis *sts = ((PayloadBayOp*)context)->sts;
+	switch (id) {
+	case ACT_BAYDOOR:   sts->SetBayDoorPosition (state.pos); break;
+	case ACT_RADIATOR:  sts->SetRadiatorPosition (state.pos); break;
+	case ACT_RADLATCH:  sts->SetRadLatchPosition (state.pos); break;
+	case ACT_KUANTENNA: sts->SetKuAntennaPosition (state.pos); break;
 	}
+}
 
-	// Operate Ku-band antenna
-	if (KuAntennaStatus.Moving()) {
-		double da = dt * KU_OPERATING_SPEED;
-		if (KuAntennaStatus.Closing()) {
-			if (KuAntennaStatus.pos > 0.0)
-				KuAntennaStatus.pos = max (0.0, KuAntennaStatus.pos-da);
-			else
-				SetKuAntennaAction (AnimState::CLOSED);
-		} else { // antenna deploying
-			if (KuAntennaStatus.pos < 1.0)
-				KuAntennaStatus.pos = min (1.0, KuAntennaStatus.pos+da);
-			else
-				SetKuAntennaAction (AnimState::OPEN);
-		}
-		sts->SetKuAntennaPosition (KuAntennaStatus.pos);
+// ==============================================================
+// Actuator callback: end position reached; update the user interface
+
+void PayloadBayOp::ActuatorDone (void *context, int id, const AnimState &state)
+{
+	PayloadBayOp *plop = (PayloadBayOp*)context;
+	switch (id) {
+	case ACT_BAYDOOR:   plop->SetDoorAction (state.action); break;
+	case ACT_RADIATOR:  plop->SetRadiatorAction (state.action); break;
+	case ACT_RADLATCH:  plop->SetRadLatchAction (state.action); break;
+	case ACT_KUANTENNA: plop->SetKuAntennaAction (state.action); break;
 	}
 }
 
@@ -134,7 +103,7 @@ void PayloadBayOp::SetDoorAction (AnimState::Action action, bool simple)
 	if (action == AnimState::STOPPED && BayDoorStatus.Static()) return;
 	// stopping doesn't make sense if the doors are already fully open or closed
 
-	BayDoorStatus.action = action;
+	act.Operate (ACT_BAYDOOR, action);
 	sts->RecordEvent ("CARGODOOR", ActionString[action]);
 
 	UpdateVC();
@@ -165,7 +134,7 @@ void PayloadBayOp::SetRadiatorAction (AnimState::Action action)
 	if (action == AnimState::OPENING && RadiatorStatus.Closed() && !RadLatchStatus.Open()) return;
 	// don't deploy radiators if the latches are not fully released
 
-	RadiatorStatus.action = action;
+	act.Operate (ACT_RADIATOR, action);
 	sts->RecordEvent ("RADIATOR", ActionString[action]);
 
 	UpdateVC();
@@ -198,7 +167,7 @@ void PayloadBayOp::SetRadLatchAction (AnimState::Action action)
 	if (action == AnimState::STOPPED && RadLatchStatus.Static()) return;
 	// stopping doesn't make sense if the radiators are already fully deployed or stowed
 
-	RadLatchStatus.action = action;
+	act.Operate (ACT_RADLATCH, action);
 	sts->RecordEvent ("RADLATCH", ActionString[action]);
 
 	UpdateVC();
@@ -215,7 +184,7 @@ void PayloadBayOp::SetKuAntennaAction (AnimState::Action action)
 	if (action == AnimState::STOPPED && KuAntennaStatus.Static()) return;
 	// stopping doesn't make sense if the doors are already fully open or closed
 
-	KuAntennaStatus.action = action;
+	act.Operate (ACT_KUANTENNA, action);
 	sts->RecordEvent ("KUBAND", ActionString[action]);
 
 	UpdateVC();
@@ -236,18 +205,17 @@ bool PayloadBayOp::ParseScenarioLine (char *line)
 {
 	if (!_strnicmp (line, "CARGODOOR", 9)) {
 		sscan_state (line+9, BayDoorStatus);
-		return true;
 	} else if (!_strnicmp (line, "RADIATOR", 8)) {
 		sscan_state (line+8, RadiatorStatus);
-		return true;
 	} else if (!_strnicmp (line, "RADLATCH", 8)) {
 		sscan_state (line+8, RadLatchStatus);
-		return true;
 	} else if (!_strnicmp (line, "KUBAND", 6)) {
 		sscan_state (line+6, KuAntennaStatus);
-		return true;
+	} else {
+		return false;
 	}
-	return false;
+	act.Update(); // resume operations in progress
+	return true;
 }
 
 // ==============================================================
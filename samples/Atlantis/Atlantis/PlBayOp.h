@@ -3,6 +3,7 @@
 
 #include <windows.h>
 #include "Atlantis.h"
+#include "../../Common/Actuator.h"
 
 // ==============================================================
 // class PayloadBayOp
@@ -61,10 +62,14 @@ private:
 	int tkbk_state[6];
 
 	// physical status
-	AnimState BayDoorStatus;
-	AnimState RadiatorStatus;
-	AnimState RadLatchStatus;
-	AnimState KuAntennaStatus;
+	enum { ACT_BAYDOOR, ACT_RADIATOR, ACT_RADLATCH, ACT_KUANTENNA };
+	ActuatorSet act;
+	AnimState &BayDoorStatus;
+	AnimState &RadiatorStatus;
+	AnimState &RadLatchStatus;
+	AnimState &KuAntennaStatus;
+	static void ActuatorMoved (void *context, int id, const AnimState &state);
+	static void ActuatorDone (void *context, int id, const AnimState &state);
 };
 
 #endif // !__PLBAYOP_H
\ No newline at end of file
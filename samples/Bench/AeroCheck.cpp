@@ -0,0 +1,284 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AeroCheck.cpp
+// Check and benchmark of the airfoil coefficient tables (AeroTable)
+// against the coefficient functions they replaced, which are kept
+// here as the reference: the airfoils created by the vessel modules
+// given on the command line are evaluated over a sweep of aoa from
+// -Pi to Pi, at random Mach numbers (mostly through the transonic
+// range), and compared with the reference of the module's airfoil.
+// The piecewise linear LiftCoeff profile of ShuttlePB and ScriptVessel
+// is checked on its own table.
+// - lift and moment coefficients must agree to rounding (all profile
+//   breakpoints lie on the table grid)
+// - drag coefficients must agree to CD_TOL (the induced drag, the
+//   sin^2 aoa term of the profile drag and the wave drag are
+//   interpolated)
+// Reports the largest differences, and the time per call of each
+// airfoil function and of its reference, the best of three runs.
+//
+// Usage: aerocheck [-n points] module ...
+// ==============================================================
+
+#include "Host.h"
+#include "AeroTable.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const double CL_TOL = 1e-12; // lift and moment tolerance
+static const double CD_TOL = 5e-4;  // drag tolerance
+
+static DWORD seed = 12345;
+
+static double Rand (double a, double b)
+{
+	seed = seed*1664525 + 1013904223;
+	return a + (b-a)*(seed >> 8)/16777216.0;
+}
+
+static double Seconds (const LARGE_INTEGER &t0, const LARGE_INTEGER &t1)
+{
+	LARGE_INTEGER fq;
+	QueryPerformanceFrequency (&fq);
+	return (double)(t1.QuadPart-t0.QuadPart)/(double)fq.QuadPart;
+}
+
+// ==============================================================
+// Reference: the coefficient functions before AeroTable
+// ==============================================================
+
+static void PB_vlift (VESSEL *v, double aoa, double M, double Re,
+	void *context, double *cl, double *cm, double *cd)
+{
+	static const double clp[] = {  // lift coefficient from -pi to pi in 10deg steps
+		-0.1,-0.5,-0.4,-0.1,0,0,0,0,0,0,0,0,0,0,-0.2,-0.6,-0.6,-0.4,0.2,0.5,0.9,0.8,0.2,0,0,0,0,0,0,0,0,0,0.1,0.4,0.5,0.3,-0.1,-0.5
+	};
+	static const double aoa_step = 10.0*RAD;
+	double a, fidx, saoa = sin(aoa);
+	a = modf((aoa+PI)/aoa_step, &fidx);
+	int idx = (int)(fidx+0.5);
+	*cl = clp[idx]*(1.0-a) + clp[idx+1]*a;     // linear interpolation
+	*cm = 0.0; //-0.03*sin(aoa-0.1);
+	*cd = 0.03 + 0.4*saoa*saoa;                // profile drag
+	*cd += oapiGetInducedDrag (*cl, 1.0, 0.5); // induced drag
+	*cd += oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);  // wave drag
+}
+
+static void PB_hlift (VESSEL *v, double aoa, double M, double Re,
+	void *context, double *cl, double *cm, double *cd)
+{
+	static const double clp[] = {  // lift coefficient from -pi to pi in 45deg steps
+		0,0.4,0,-0.4,0,0.4,0,-0.4,0,0.4
+	};
+	static const double aoa_step = 45.0*RAD;
+	double a, fidx;
+	a = modf((aoa+PI)/aoa_step, &fidx);
+	int idx = (int)(fidx+0.5);
+	*cl = clp[idx]*(1.0-a) + clp[idx+1]*a;     // linear interpolation
+	*cm = 0.0;
+	*cd = 0.03;
+	*cd += oapiGetInducedDrag (*cl, 1.5, 0.6); // induced drag
+	*cd += oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);  // wave drag
+}
+
+static void SA_MomentCoeff (VESSEL *v, double aoa, double M, double Re,
+	void *context, double *cl, double *cm, double *cd)
+{
+	int i;
+	const int nabsc = 7;
+	static const double AOA[nabsc] = {-180*RAD, -90*RAD,-30*RAD, 0*RAD, 60*RAD,90*RAD,180*RAD};
+	static const double CL[nabsc]  = {       0,      0,   -0.004,     0,     0.008,     0,      0};
+	static const double CM[nabsc]  = {       0,      0,   0.0014,  0,-0.0012,     0,      0};
+
+	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
+	double f = (aoa-AOA[i]) / (AOA[i+1]-AOA[i]);
+	*cl = CL[i] + (CL[i+1]-CL[i]) * f;  // aoa-dependent lift coefficient
+	*cm = CM[i] + (CM[i+1]-CM[i]) * f;  // aoa-dependent moment coefficient
+	double saoa = sin(aoa);
+	double pd = 0.045 + 0.4*saoa*saoa;  // profile drag
+	*cd = pd + oapiGetInducedDrag (*cl, 0.1,0.7) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+}
+
+static void DG_VLiftCoeff (VESSEL *v, double aoa, double M, double Re, void *context, double *cl, double *cm, double *cd)
+{
+	int i;
+	const int nabsc = 9;
+	static const double AOA[nabsc] = {-180*RAD,-60*RAD,-30*RAD, -2*RAD, 15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
+	static const double CL[nabsc]  = {       0,      0,   -0.4,      0,    0.7,     1,   0.8,     0,      0};
+	static const double CM[nabsc]  = {       0,      0,  0.014, 0.0039, -0.006,-0.008,-0.010,     0,      0};
+	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
+	double f = (aoa-AOA[i]) / (AOA[i+1]-AOA[i]);
+	*cl = CL[i] + (CL[i+1]-CL[i]) * f;  // aoa-dependent lift coefficient
+	*cm = CM[i] + (CM[i+1]-CM[i]) * f;  // aoa-dependent moment coefficient
+	double saoa = sin(aoa);
+	double pd = 0.015 + 0.4*saoa*saoa;  // profile drag
+	*cd = pd + oapiGetInducedDrag (*cl, 1.5, 0.7) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+}
+
+static void DG_HLiftCoeff (VESSEL *v, double beta, double M, double Re, void *context, double *cl, double *cm, double *cd)
+{
+	int i;
+	const int nabsc = 8;
+	static const double BETA[nabsc] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
+	static const double CL[nabsc]   = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
+	for (i = 0; i < nabsc-1 && BETA[i+1] < beta; i++);
+	*cl = CL[i] + (CL[i+1]-CL[i]) * (beta-BETA[i]) / (BETA[i+1]-BETA[i]);
+	*cm = 0.0;
+	*cd = 0.015 + oapiGetInducedDrag (*cl, 1.5, 0.6) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+}
+
+// LiftCoeff of ShuttlePB and ScriptVessel
+static double LiftCoeff (double aoa)
+{
+	int i;
+	const int nlift = 9;
+	static const double AOA[nlift] = {-180*RAD,-60*RAD,-30*RAD,-1*RAD,15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
+	static const double CL[nlift]  = {       0,      0,   -0.1,     0,   0.2,  0.25,   0.2,     0,      0};
+	static const double SCL[nlift] = {(CL[1]-CL[0])/(AOA[1]-AOA[0]), (CL[2]-CL[1])/(AOA[2]-AOA[1]),
+		                              (CL[3]-CL[2])/(AOA[3]-AOA[2]), (CL[4]-CL[3])/(AOA[4]-AOA[3]),
+									  (CL[5]-CL[4])/(AOA[5]-AOA[4]), (CL[6]-CL[5])/(AOA[6]-AOA[5]),
+									  (CL[7]-CL[6])/(AOA[7]-AOA[6]), (CL[8]-CL[7])/(AOA[8]-AOA[7])};
+	for (i = 0; i < nlift-1 && AOA[i+1] < aoa; i++);
+	return CL[i] + (aoa-AOA[i])*SCL[i];
+}
+
+// Reference of airfoil index of the vessels of module
+struct AeroRef {
+	const char *module;
+	int index;
+	const char *name;
+	AirfoilCoeffFuncEx ref;
+};
+
+static const AeroRef REF[] = {
+	{"ShuttlePB",   0, "vlift",               PB_vlift},
+	{"ShuttlePB",   1, "hlift",               PB_hlift},
+	{"ShuttleA",    0, "Shuttle_MomentCoeff", SA_MomentCoeff},
+	{"DeltaGlider", 0, "VLiftCoeff",          DG_VLiftCoeff},
+	{"DeltaGlider", 1, "HLiftCoeff",          DG_HLiftCoeff}
+};
+static const int NREF = sizeof(REF)/sizeof(AeroRef);
+
+// ==============================================================
+
+static std::vector<double> aoa, mach;
+
+static void Call (VESSEL *v, const BenchAirfoil *af, double a, double M, double *cl, double *cm, double *cd)
+{
+	if (af->cf) af->cf (v, a, M, 1e7, af->context, cl, cm, cd);
+	else        af->cf0 (a, M, 1e7, cl, cm, cd);
+}
+
+// Time per call of the airfoil function (ref = 0) or of the reference
+// over all points, the best of three runs
+static double Time (VESSEL *v, const BenchAirfoil *af, AirfoilCoeffFuncEx ref)
+{
+	LARGE_INTEGER t0, t1;
+	double cl, cm, cd, sum = 0.0, t, tbest = 1e10;
+	size_t i, n = aoa.size();
+	for (int run = 0; run < 3; run++) {
+		QueryPerformanceCounter (&t0);
+		if (ref)
+			for (i = 0; i < n; i++) ref (v, aoa[i], mach[i], 1e7, 0, &cl, &cm, &cd), sum += cd;
+		else
+			for (i = 0; i < n; i++) Call (v, af, aoa[i], mach[i], &cl, &cm, &cd), sum += cd;
+		QueryPerformanceCounter (&t1);
+		if ((t = Seconds (t0, t1)/n) < tbest) tbest = t;
+	}
+	if (sum == 0.0) printf ("  (no drag)\n"); // keeps the loops
+	return tbest;
+}
+
+// Compare airfoil af of vessel v with its reference. Returns the
+// number of failed coefficients.
+static int CheckAirfoil (VESSEL *v, const BenchAirfoil *af, const AeroRef &r)
+{
+	double cl, cm, cd, rcl, rcm, rcd, dcl = 0.0, dcm = 0.0, dcd = 0.0;
+	double amax = 0.0, mmax = 0.0;
+	for (size_t i = 0; i < aoa.size(); i++) {
+		Call (v, af, aoa[i], mach[i], &cl, &cm, &cd);
+		r.ref (v, aoa[i], mach[i], 1e7, 0, &rcl, &rcm, &rcd);
+		dcl = max (dcl, fabs (cl-rcl));
+		dcm = max (dcm, fabs (cm-rcm));
+		if (fabs (cd-rcd) > dcd) dcd = fabs (cd-rcd), amax = aoa[i], mmax = mach[i];
+	}
+	double t = Time (v, af, 0), tref = Time (v, af, r.ref);
+	printf ("  %-12s %-20s max error cl %.1e cm %.1e cd %.1e (aoa %.2f deg, M %.3f), %6.1f ns per call, reference %6.1f ns\n",
+		r.module, r.name, dcl, dcm, dcd, amax*DEG, mmax, t*1e9, tref*1e9);
+	return (dcl > CL_TOL) + (dcm > CL_TOL) + (dcd > CD_TOL);
+}
+
+// Lift coefficient profile of ShuttlePB and ScriptVessel on its table
+static int CheckLiftCoeff ()
+{
+	const int nlift = 9;
+	static const double AOA[nlift] = {-180*RAD,-60*RAD,-30*RAD,-1*RAD,15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
+	static const double CL[nlift]  = {       0,      0,   -0.1,     0,   0.2,  0.25,   0.2,     0,      0};
+	AeroTable lift;
+	lift.SetLift (nlift, AOA, CL);
+
+	LARGE_INTEGER t0, t1;
+	double dcl = 0.0, sum = 0.0;
+	size_t i, n = aoa.size();
+	for (i = 0; i < n; i++)
+		dcl = max (dcl, fabs (lift.Cl (aoa[i]) - LiftCoeff (aoa[i])));
+	QueryPerformanceCounter (&t0);
+	for (i = 0; i < n; i++) sum += lift.Cl (aoa[i]);
+	QueryPerformanceCounter (&t1);
+	double t = Seconds (t0, t1)/n;
+	QueryPerformanceCounter (&t0);
+	for (i = 0; i < n; i++) sum += LiftCoeff (aoa[i]);
+	QueryPerformanceCounter (&t1);
+	double tref = Seconds (t0, t1)/n;
+	printf ("  %-12s %-20s max error cl %.1e, %6.1f ns per call, reference %6.1f ns%s\n",
+		"AeroTable", "LiftCoeff", dcl, t*1e9, tref*1e9, sum == 0.0 ? " (no lift)" : "");
+	return (dcl > CL_TOL);
+}
+
+int main (int argc, char *argv[])
+{
+	int n = 1000000, a, i, j, fail = 0, nchecked = 0;
+	for (a = 1; a < argc-1 && argv[a][0] == '-'; a++) {
+		if (!strcmp (argv[a], "-n")) n = atoi (argv[++a]);
+	}
+
+	// aoa sweep over -Pi ... Pi (both ends included), Mach numbers
+	// mostly through the transonic range, some up to the table limit
+	aoa.resize (n), mach.resize (n);
+	for (i = 0; i < n; i++) {
+		aoa[i] = -PI + 2.0*PI*i/(n-1);
+		mach[i] = (i & 3 ? Rand (0.0, 4.0) : Rand (0.0, AERO_MAXMACH));
+	}
+	printf ("AeroCheck: %d points, airfoil tables against the coefficient functions they replace\n", n);
+
+	for (; a < argc; a++) {
+		BenchModule mod;
+		if (!BenchLoadModule (argv[a], mod)) return 1;
+		const char *classname = BenchModuleName (argv[a]);
+		Vessel *v = BenchCreateVessel (mod, "Aero", classname);
+		for (j = 0; j < NREF; j++) {
+			if (strcmp (REF[j].module, classname)) continue;
+			if (REF[j].index >= (int)v->airfoil.size()) {
+				printf ("  %-12s %-20s airfoil %d not defined\n", REF[j].module, REF[j].name, REF[j].index);
+				fail++;
+				continue;
+			}
+			fail += CheckAirfoil (v->iface, v->airfoil[REF[j].index], REF[j]);
+			nchecked++;
+		}
+		BenchDeleteVessel (mod, v);
+		BenchUnloadModule (mod);
+	}
+	fail += CheckLiftCoeff ();
+	nchecked++;
+
+	printf ("  %d functions checked, %d errors\n", nchecked, fail);
+	return fail;
+}
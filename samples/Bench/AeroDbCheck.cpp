@@ -0,0 +1,238 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AeroDbCheck.cpp
+// Check and benchmark of the aerodynamic database (AeroDatabase):
+// a database with a vertical (aoa x Mach) and a horizontal (sideslip
+// x Mach) table of analytic coefficients is written as a text file,
+// loaded, written in binary format with WriteBinary and loaded again
+// from the binary file (memory-mapped).
+// - the mapped image must be identical to the image parsed from text,
+//   and AeroDbCoeff must return identical coefficients from both, at
+//   random points in and outside the grid
+// - at random points within the grid, AeroDbCoeff must agree with a
+//   bilinear interpolation of the node values in double precision to
+//   float rounding
+// - loading a file again must return the shared instance
+// - corrupt binary files (nodes truncated, file size differing from
+//   the header, and a table whose node count wraps in 32 bits) must be
+//   rejected
+// Reports the errors, the load time of the text and the binary file,
+// and the time per AeroDbCoeff call.
+//
+// Usage: aerodbcheck [-n points]
+// ==============================================================
+
+#include "AeroDatabase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+static const char *TXTFILE = "AeroDbCheck.txt";
+static const char *BINFILE = "AeroDbCheck.adb";
+static const char *BADFILE = "AeroDbCheck.bad";
+
+// Table grids: angle range [deg], number of angle nodes, Mach range,
+// number of Mach nodes
+struct Grid {
+	const char *name;
+	double a0, a1; int na;
+	double m0, m1; int nm;
+};
+static const Grid GRID[AERODB_NTABLE] = {
+	{"VERTICAL",   -180.0, 180.0, 361, 0.0, 10.0, 101},
+	{"HORIZONTAL",  -90.0,  90.0, 181, 0.0,  5.0,  51}
+};
+
+static DWORD seed = 12345;
+
+static double Rand (double a, double b)
+{
+	seed = seed*1664525 + 1013904223;
+	return a + (b-a)*(seed >> 8)/16777216.0;
+}
+
+static double Seconds (const LARGE_INTEGER &t0, const LARGE_INTEGER &t1)
+{
+	LARGE_INTEGER fq;
+	QueryPerformanceFrequency (&fq);
+	return (double)(t1.QuadPart-t0.QuadPart)/(double)fq.QuadPart;
+}
+
+// Coefficient k (cl, cm, cd) of table t at angle a [deg] and Mach M,
+// rounded to float as stored
+static float Coeff (int t, int k, double a, double M)
+{
+	double r = a*RAD;
+	switch (k) {
+	case 0:  return (float)((t ? 0.3 : 1.0)*sin (2.0*r)/(1.0+0.2*M));
+	case 1:  return (float)(-0.01*sin (r) + 0.001*M);
+	default: return (float)(0.02 + 0.4*sin (r)*sin (r) + 0.04*exp (-(M-1.1)*(M-1.1)*10.0));
+	}
+}
+
+static bool WriteText (const char *fname)
+{
+	FILE *f = fopen (fname, "wt");
+	if (!f) return false;
+	fprintf (f, "; AeroDbCheck test database\n");
+	for (DWORD t = 0; t < AERODB_NTABLE; t++) {
+		const Grid &g = GRID[t];
+		fprintf (f, "%s %g %g %d %g %g %d\n", g.name, g.a0, g.a1, g.na, g.m0, g.m1, g.nm);
+		for (int j = 0; j < g.nm; j++) {
+			double M = g.m0 + (g.m1-g.m0)*j/(g.nm-1);
+			for (int i = 0; i < g.na; i++) {
+				double a = g.a0 + (g.a1-g.a0)*i/(g.na-1);
+				fprintf (f, "%.9g %.9g %.9g\n", Coeff (t,0,a,M), Coeff (t,1,a,M), Coeff (t,2,a,M));
+			}
+		}
+	}
+	fclose (f);
+	return true;
+}
+
+static bool WriteFile (const char *fname, const void *data, size_t size)
+{
+	FILE *f = fopen (fname, "wb");
+	if (!f) return false;
+	bool ok = (fwrite (data, 1, size, f) == size);
+	fclose (f);
+	return ok;
+}
+
+// Corrupt binary file: must fail to load
+static int CheckReject (const char *what, const void *data, size_t size)
+{
+	WriteFile (BADFILE, data, size);
+	AeroDatabase *db = AeroDatabase::Load (BADFILE);
+	remove (BADFILE);
+	if (!db) return 0;
+	printf ("  %s: loaded\n", what);
+	db->Release();
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	int n = 1000000, i, k, fail = 0;
+	DWORD t;
+	for (int a = 1; a < argc-1; a++)
+		if (!strcmp (argv[a], "-n")) n = atoi (argv[++a]);
+
+	printf ("AeroDbCheck: text and memory-mapped binary database, %d points\n", n);
+	if (!WriteText (TXTFILE)) {
+		printf ("  can't write %s\n", TXTFILE);
+		return 1;
+	}
+
+	LARGE_INTEGER t0, t1;
+	QueryPerformanceCounter (&t0);
+	AeroDatabase *txt = AeroDatabase::Load (TXTFILE);
+	QueryPerformanceCounter (&t1);
+	double ttxt = Seconds (t0, t1);
+	if (!txt || !txt->WriteBinary (BINFILE)) {
+		printf ("  can't load %s or write %s\n", TXTFILE, BINFILE);
+		return 1;
+	}
+	QueryPerformanceCounter (&t0);
+	AeroDatabase *bin = AeroDatabase::Load (BINFILE);
+	QueryPerformanceCounter (&t1);
+	double tbin = Seconds (t0, t1);
+	if (!bin) {
+		printf ("  can't load %s\n", BINFILE);
+		return 1;
+	}
+
+	// shared instances
+	AeroDatabase *bin2 = AeroDatabase::Load (BINFILE);
+	if (bin2 != bin) printf ("  second load of %s not shared\n", BINFILE), fail++;
+	bin2->Release();
+
+	// images
+	for (t = 0; t < AERODB_NTABLE; t++) {
+		const AeroDbTable *tt = txt->Table (t), *tb = bin->Table (t);
+		if (!tt || !tb || tt->na != (DWORD)GRID[t].na || tt->nm != (DWORD)GRID[t].nm) {
+			printf ("  table %s missing or wrong size\n", GRID[t].name);
+			return 1;
+		}
+		if (memcmp (tt, tb, sizeof(AeroDbTable) + tt->na*tt->nm*4*sizeof(float))) {
+			printf ("  table %s: mapped image differs from text\n", GRID[t].name);
+			fail++;
+		}
+	}
+
+	// coefficients
+	double c[2][3], emax = 0.0;
+	int ndiff = 0;
+	for (i = 0; i < n; i++) {
+		t = i & 1;
+		const Grid &g = GRID[t];
+		double a = Rand (g.a0-10.0, g.a1+10.0), M = Rand (g.m0-1.0, g.m1+1.0);
+		AeroDbCoeff (0, a*RAD, M, 1e7, (void*)txt->Table (t), c[0], c[0]+1, c[0]+2);
+		AeroDbCoeff (0, a*RAD, M, 1e7, (void*)bin->Table (t), c[1], c[1]+1, c[1]+2);
+		if (memcmp (c[0], c[1], sizeof(c[0]))) ndiff++;
+		if (a < g.a0 || a > g.a1 || M < g.m0 || M > g.m1) continue;
+
+		// bilinear interpolation of the nodes in double precision
+		double fa = (a-g.a0)/(g.a1-g.a0)*(g.na-1), fm = (M-g.m0)/(g.m1-g.m0)*(g.nm-1);
+		int ia = min ((int)fa, g.na-2), im = min ((int)fm, g.nm-2);
+		fa -= ia, fm -= im;
+		double a0 = g.a0 + (g.a1-g.a0)*ia/(g.na-1), a1 = g.a0 + (g.a1-g.a0)*(ia+1)/(g.na-1);
+		double m0 = g.m0 + (g.m1-g.m0)*im/(g.nm-1), m1 = g.m0 + (g.m1-g.m0)*(im+1)/(g.nm-1);
+		for (k = 0; k < 3; k++) {
+			double r0 = Coeff (t,k,a0,m0) + (Coeff (t,k,a1,m0)-Coeff (t,k,a0,m0))*fa;
+			double r1 = Coeff (t,k,a0,m1) + (Coeff (t,k,a1,m1)-Coeff (t,k,a0,m1))*fa;
+			double e = fabs (c[1][k] - (r0 + (r1-r0)*fm));
+			if (e > emax) emax = e;
+		}
+	}
+	if (ndiff) printf ("  %d points differ between text and mapped binary\n", ndiff), fail++;
+	if (emax > 1e-5) printf ("  interpolation error %g\n", emax), fail++;
+
+	// corrupt files
+	// (the header precedes the first table in the image)
+	const AeroDbHeader *h = (const AeroDbHeader*)txt->Table (AERODB_VERTICAL) - 1;
+	std::vector<char> trunc ((const char*)h, (const char*)h + h->size-16);
+	((AeroDbHeader*)&trunc[0])->size = trunc.size();
+	fail += CheckReject ("truncated nodes", &trunc[0], trunc.size());
+	char img[sizeof(AeroDbHeader) + sizeof(AeroDbTable)];
+	AeroDbHeader *bh = (AeroDbHeader*)img;
+	AeroDbTable *bt = (AeroDbTable*)(bh+1);
+	memset (img, 0, sizeof(img));
+	memcpy (bh->magic, "ADB1", 4);
+	bh->ntable = 1;
+	bh->size = sizeof(img)+16;
+	fail += CheckReject ("wrong size in header", img, sizeof(img));
+	bh->size = sizeof(img);
+	bt->type = AERODB_VERTICAL;
+	bt->na = 0x10000, bt->nm = 0x1000; // na*nm*16 wraps to 0
+	fail += CheckReject ("table node count wrapping in 32 bits", img, sizeof(img));
+
+	// timing
+	float sum = 0.0f;
+	const AeroDbTable *tv = bin->Table (AERODB_VERTICAL);
+	QueryPerformanceCounter (&t0);
+	for (i = 0; i < n; i++) {
+		AeroDbCoeff (0, (i%3600)*(0.1*RAD)-PI, (i%1000)*0.01, 1e7, (void*)tv, c[0], c[0]+1, c[0]+2);
+		sum += (float)c[0][2];
+	}
+	QueryPerformanceCounter (&t1);
+	double tcall = Seconds (t0, t1)/n;
+
+	printf ("  %d bytes, %d points compared, text and mapped binary %s, max interpolation error %.1e\n",
+		h->size, n, ndiff ? "differ" : "identical", emax);
+	printf ("  load: text %.3f ms, binary %.3f ms; %.1f ns per AeroDbCoeff call%s\n",
+		ttxt*1e3, tbin*1e3, tcall*1e9, sum == 0.0f ? " (no drag)" : "");
+	printf ("  %d errors\n", fail);
+
+	bin->Release();
+	txt->Release();
+	remove (TXTFILE);
+	remove (BINFILE);
+	return fail;
+}
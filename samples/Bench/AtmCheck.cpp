@@ -0,0 +1,133 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AtmCheck.cpp
+// Check and throughput benchmark of the batch atmosphere evaluation:
+// StdAtmosphere with Earth constants against tabulated values of the
+// US Standard Atmosphere 1976, batch against per-point evaluation in
+// points/s (AtmBatchReport), for the reference atmosphere and for
+// the atmosphere of a planet module. Also checks when the tables of
+// an AtmCache are rebuilt (including negative simulation times and
+// time jumps backwards), and logs the cache's error/speed report.
+//
+// Usage: atmcheck [-n points] [module]
+// ==============================================================
+
+#include "Host.h"
+#include "AtmCache.h"
+#include <stdlib.h>
+
+// US Standard Atmosphere 1976 at the layer bases (geopotential
+// altitude [m], temperature [K], pressure [Pa])
+static const struct { double h, T, p; } US76[] = {
+	{    0.0, 288.15, 101325.0 },
+	{ 11000.0, 216.65,  22632.1 },
+	{ 20000.0, 216.65,  5474.89 },
+	{ 32000.0, 228.65,  868.019 },
+	{ 47000.0, 270.65,  110.906 },
+	{ 51000.0, 270.65,  66.9389 },
+	{ 71000.0, 214.65,  3.95642 }
+};
+
+// Model that counts its clbkParams calls
+class CountingAtmosphere: public StdAtmosphere {
+public:
+	CountingAtmosphere (const ATMCONST &atmc, double g0): StdAtmosphere (0, atmc, g0), ncall (0) {}
+	bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm_out)
+	{ ncall++; return StdAtmosphere::clbkParams (prm_in, prm_out); }
+	int ncall;
+};
+
+// Query cache at simulation time simt. Returns true if the model was
+// sampled (tables rebuilt).
+static bool Rebuilt (AtmCache &cache, CountingAtmosphere &src, double simt)
+{
+	ATMOSPHERE::PRM_IN prm;
+	ATMOSPHERE::PRM_OUT out;
+	memset (&prm, 0, sizeof(prm));
+	prm.flag = ATMOSPHERE::PRM_ALT;
+	prm.alt = 30e3;
+	BenchSetTime (simt, 0.0);
+	int n = src.ncall;
+	cache.clbkParams (&prm, &out);
+	return src.ncall > n+1; // more than the query itself
+}
+
+int main (int argc, char *argv[])
+{
+	int i, n = 100000, fail = 0;
+	const char *module = 0;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp (argv[i], "-n") && i+1 < argc) n = atoi (argv[++i]);
+		else module = argv[i];
+	}
+	if (n < 1) {
+		fprintf (stderr, "Usage: atmcheck [-n points] [module]\n");
+		return 1;
+	}
+
+	// reference atmosphere with the constants of US76
+	ATMCONST ac;
+	memset (&ac, 0, sizeof(ATMCONST));
+	ac.p0 = 101325.0;
+	ac.R = 287.053;
+	ac.rho0 = ac.p0/(ac.R*288.15);
+	ac.gamma = 1.4;
+	ac.altlimit = 200e3;
+	StdAtmosphere std (0, ac, 9.80665);
+	ATMOSPHERE::PRM_IN prm;
+	ATMOSPHERE::PRM_OUT out;
+	double emax = 0.0;
+	memset (&prm, 0, sizeof(prm));
+	prm.flag = ATMOSPHERE::PRM_ALT;
+	for (i = 0; i < (int)(sizeof(US76)/sizeof(US76[0])); i++) {
+		prm.alt = US76[i].h;
+		if (!std.clbkParams (&prm, &out)) { emax = 1.0; continue; }
+		double e = max (fabs (out.T/US76[i].T - 1.0), fabs (out.p/US76[i].p - 1.0));
+		if (e > emax) emax = e;
+	}
+	printf ("AtmCheck: StdAtmosphere vs US76 table, max. rel. error %0.2g\n", emax);
+	if (emax > 1e-5) fail++;
+
+	// batch vs per point
+	if (AtmBatchReport (&std, n) > 1e-12) fail++;
+
+	// cache with a table lifetime of 600 s, starting at negative
+	// simulation time: built once, reused within 600 s in either
+	// direction, rebuilt after that and after a jump backwards
+	CountingAtmosphere src (ac, 9.80665);
+	AtmCache cache (0, &src, 1e-4, 1, 1, 600.0);
+	static const struct { double simt; bool rebuild; } step[] = {
+		{-1000.0, true}, {-900.0, false}, {-500.0, false}, {-300.0, true},
+		{-200.0, false}, {-2000.0, true}, {-1500.0, false}
+	};
+	int nerr = 0;
+	for (i = 0; i < (int)(sizeof(step)/sizeof(step[0])); i++)
+		if (Rebuilt (cache, src, step[i].simt) != step[i].rebuild) {
+			printf ("AtmCheck: cache at simt=%g: tables %s\n", step[i].simt, step[i].rebuild ? "not rebuilt" : "rebuilt");
+			nerr++;
+		}
+	printf ("AtmCheck: cache rebuild schedule %s\n", nerr ? "wrong" : "ok");
+	if (nerr) fail++;
+	cache.Report (n);
+	if (module) {
+		BenchModule mod;
+		if (!BenchLoadModule (module, mod) || !mod.InitInstance) return 1;
+		CelBody *cb = BenchCreateBody (mod, BenchModuleName (module));
+		CELBODY2 *body = (cb->iface->Version() >= 2 ? (CELBODY2*)cb->iface : 0);
+		ATMOSPHERE *atm = (body ? body->GetAtmosphere() : 0);
+		if (!atm) {
+			printf ("AtmCheck: %s has no atmosphere\n", module);
+			fail++;
+		} else if (AtmBatchReport (atm, n) > 1e-12)
+			fail++;
+		BenchDeleteBody (mod, cb);
+		BenchUnloadModule (mod);
+	}
+	if (fail) printf ("AtmCheck: FAILED\n");
+	return fail;
+}
@@ -0,0 +1,175 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AttachCheck.cpp
+// Check and benchmark of the attachment point index (AttachIndex)
+// against a scan of all attachment points of all vessels, as done by
+// the grappling code before the index: an assembly of vessels in a
+// common heliocentric orbit, drifting relative to each other, with
+// vessels created, deleted and moved onto other vessels (as by
+// attaching) during the run. Reports wrong results, the number of
+// vessels re-binned and grid rebuilds, and the time per query.
+//
+// Usage: attachcheck [-n vessels] [-a attachments] [-s steps] [-q queries]
+// ==============================================================
+
+#include "Host.h"
+#include "AttachIndex.h"
+#include <stdlib.h>
+
+static const double RANGE = 0.5; // grappling range, as in Atlantis and ShuttleA
+
+static DWORD seed = 12345;
+
+static double Rand (double a, double b)
+{
+	seed = seed*1664525 + 1013904223;
+	return a + (b-a)*(seed >> 8)/16777216.0;
+}
+
+static VECTOR3 RandV (double a) { return _V(Rand (-a,a), Rand (-a,a), Rand (-a,a)); }
+
+// Vessels without a module: plain VESSEL2 interfaces
+static VESSEL *ProbeInit (OBJHANDLE hVessel, int flightmodel) { return new VESSEL2 (hVessel, flightmodel); }
+static void ProbeExit (VESSEL *v) { delete (VESSEL2*)v; }
+
+static const VECTOR3 P0 = {1.496e11, 0.0, 2e7};   // assembly centre at t=0 [m]
+static const VECTOR3 V0 = {-3.0e3, 0.0, 29.8e3};  // assembly velocity [m/s]
+
+// New vessel of radius 5-15 m within the assembly, with natt
+// attachment points alternately labelled "GS" and "XS"
+static Vessel *NewVessel (BenchModule &probe, int natt, double simt)
+{
+	static int count = 0;
+	char name[32];
+	sprintf (name, "Probe-%d", count++);
+	Vessel *v = BenchCreateVessel (probe, name, "Probe");
+	v->size = Rand (5.0, 15.0);
+	v->gvel = V0 + RandV (0.2);
+	v->gpos = P0 + V0*simt + RandV (1000.0);
+	for (int i = 0; i < natt; i++)
+		v->iface->CreateAttachment (true, RandV (0.5*v->size), _V(0,1,0), _V(0,0,1), i & 1 ? "XS" : "GS");
+	return v;
+}
+
+// Closest compatible attachment point by scanning all vessels
+static ATTACHMENTHANDLE FindAll (const VECTOR3 &gpos, double range, const char *prefix,
+	OBJHANDLE hSelf, OBJHANDLE *hVessel)
+{
+	ATTACHMENTHANDLE hBest = 0;
+	double dmin = range;
+	VECTOR3 pos, dir, rot, apos;
+	size_t plen = strlen (prefix);
+	DWORD i, j, n = oapiGetVesselCount();
+	for (i = 0; i < n; i++) {
+		OBJHANDLE hV = oapiGetVesselByIndex (i);
+		if (hV == hSelf) continue;
+		VESSEL *v = oapiGetVesselInterface (hV);
+		DWORD nAttach = v->AttachmentCount (true);
+		for (j = 0; j < nAttach; j++) {
+			ATTACHMENTHANDLE hAtt = v->GetAttachmentHandle (true, j);
+			if (strncmp (v->GetAttachmentId (hAtt), prefix, plen)) continue;
+			v->GetAttachmentParams (hAtt, pos, dir, rot);
+			v->Local2Global (pos, apos);
+			double d = dist (apos, gpos);
+			if (d < dmin) hBest = hAtt, dmin = d, *hVessel = hV;
+		}
+	}
+	return hBest;
+}
+
+int main (int argc, char *argv[])
+{
+	int i, k, nv = 1000, natt = 8, nstep = 2000, nq = 4;
+
+	for (i = 1; i < argc; i++) {
+		if      (!strcmp (argv[i], "-n") && i+1 < argc) nv = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-a") && i+1 < argc) natt = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-s") && i+1 < argc) nstep = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-q") && i+1 < argc) nq = atoi (argv[++i]);
+	}
+	if (nv < 50 || natt < 1 || nstep < 4 || nq < 1) {
+		fprintf (stderr, "Usage: attachcheck [-n vessels>=50] [-a attachments] [-s steps] [-q queries]\n");
+		return 1;
+	}
+
+	BenchModule probe;
+	memset (&probe, 0, sizeof(BenchModule));
+	probe.ovcInit = ProbeInit;
+	probe.ovcExit = ProbeExit;
+	AttachIndex *index = new AttachIndex (0);
+	oapiRegisterModule (index);
+
+	// the index picks up the existing vessels at the first query, and
+	// later ones via clbkNewVessel
+	std::vector<Vessel*> vessel;
+	for (i = 0; i < nv; i++) vessel.push_back (NewVessel (probe, natt, 0.0));
+
+	const double dt = 1.0;
+	int nquery = 0, nhit = 0, nwrong = 0;
+	LARGE_INTEGER freq, t0, t1;
+	LONGLONG tindex = 0, tscan = 0;
+	for (k = 0; k < nstep; k++) {
+		double simt = k*dt;
+		BenchSetTime (simt, dt);
+		for (i = 0; i < (int)vessel.size(); i++) vessel[i]->gpos += vessel[i]->gvel*dt;
+
+		if (k == nstep/4) { // delete vessels, including the first (the anchor)
+			for (i = 0; i < 20; i++) {
+				int j = (i ? (int)Rand (0, vessel.size()-1) : 0);
+				BenchDeleteVessel (probe, vessel[j]);
+				vessel.erase (vessel.begin()+j);
+			}
+		} else if (k == nstep/2) { // create vessels
+			for (i = 0; i < 20; i++) vessel.push_back (NewVessel (probe, natt, simt));
+		} else if (k == 3*nstep/4) { // move vessels onto others, without notification
+			for (i = 0; i < 10; i++) {
+				Vessel *v = vessel[(int)Rand (0, vessel.size()-1)], *p = vessel[(int)Rand (0, vessel.size()-1)];
+				v->gpos = p->gpos + RandV (p->size);
+				v->gvel = p->gvel;
+			}
+		} else if (k == nstep/8) { // a vessel leaving the assembly
+			vessel[1]->gvel += _V(0, 50.0, 0);
+		}
+
+		for (i = 0; i < nq; i++) {
+			// search next to an attachment point of another vessel, or at
+			// a random point of the assembly
+			Vessel *self = vessel[(int)Rand (0, vessel.size()-1)];
+			VECTOR3 gpos;
+			if (i & 1) {
+				Vessel *v = vessel[(int)Rand (0, vessel.size()-1)];
+				BenchAttachment *at = v->attach[(int)Rand (0, v->attach.size()-1)];
+				gpos = v->gpos + at->pos + RandV (0.3);
+			} else
+				gpos = P0 + V0*simt + RandV (1000.0);
+			const char *prefix = (Rand (0,1) < 0.5 ? "GS" : "XS");
+			OBJHANDLE hV1 = 0, hV2 = 0;
+			QueryPerformanceCounter (&t0);
+			ATTACHMENTHANDLE h1 = index->FindNearest (gpos, RANGE, prefix, (OBJHANDLE)self, &hV1);
+			QueryPerformanceCounter (&t1);
+			tindex += t1.QuadPart-t0.QuadPart;
+			ATTACHMENTHANDLE h2 = FindAll (gpos, RANGE, prefix, (OBJHANDLE)self, &hV2);
+			QueryPerformanceCounter (&t0);
+			tscan += t0.QuadPart-t1.QuadPart;
+			nquery++;
+			if (h2) nhit++;
+			if (h1 != h2 || (h1 && hV1 != hV2)) nwrong++;
+		}
+	}
+
+	QueryPerformanceFrequency (&freq);
+	double ns = 1e9/((double)freq.QuadPart*nquery);
+	printf ("AttachCheck: %d vessels x %d attachments, %d steps x %d queries\n", nv, natt, nstep, nq);
+	printf ("  %d queries, %d with a candidate, %d wrong\n", nquery, nhit, nwrong);
+	printf ("  %d vessels re-binned, %d grid rebuilds\n", index->RebinCount(), index->RebuildCount());
+	printf ("  AttachIndex %8.1f ns/query, scan of all vessels %8.1f ns/query\n", tindex*ns, tscan*ns);
+
+	for (i = 0; i < (int)vessel.size(); i++) BenchDeleteVessel (probe, vessel[i]);
+	bool ok = (!nwrong && nhit);
+	if (!ok) printf ("AttachCheck: FAILED\n");
+	return (ok ? 0 : 1);
+}
@@ -0,0 +1,162 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Bench.cpp
+// Benchmark runner for vessel modules: loads a vessel module,
+// creates N instances and times their per-frame callbacks over a
+// scripted flight, in which the landing gear is operated twice. The
+// HUD of the first vessel (the focus vessel) is
+// rendered in docking mode every frame, and the meshes created by
+// it are counted.
+//
+// Usage: bench [-n vessels] [-t seconds] [-dt step] [-c class] module
+// ==============================================================
+
+#include "Host.h"
+#include <stdlib.h>
+
+// ==============================================================
+// Scripted flight: the same control inputs for every vessel, in
+// phases of equal length over the run (fraction f = simt/tmax)
+
+static void Script (VESSEL *v, double f, double simt, double &aoa, double &M)
+{
+	v->SetThrusterGroupLevel (THGROUP_MAIN,  f < 0.2 ? 1.0 : 0.0);
+	v->SetThrusterGroupLevel (THGROUP_HOVER, f >= 0.2 && f < 0.4 ? 0.6 : 0.0);
+	v->SetThrusterGroupLevel (THGROUP_RETRO, f >= 0.4 && f < 0.6 ? 0.5 : 0.0);
+	v->SetThrusterGroupLevel (THGROUP_ATT_PITCHUP, f >= 0.6 && f < 0.7 ? 0.2 : 0.0);
+	v->SetThrusterGroupLevel (THGROUP_ATT_BANKLEFT, f >= 0.7 && f < 0.8 ? 0.2 : 0.0);
+
+	// flow state seen by the airfoils: aoa sweep of +/-20 deg,
+	// Mach number ramping through the transonic range
+	aoa = 20.0*RAD*sin (simt*0.1);
+	M = 0.2 + 2.0*f;
+}
+
+// ==============================================================
+
+static double Ticks2us (LONGLONG ticks, double n)
+{
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency (&freq);
+	return (n > 0.0 ? ticks*1e6/(freq.QuadPart*n) : 0.0);
+}
+
+int main (int argc, char *argv[])
+{
+	int i, k, nv = 100;
+	double tmax = 600.0, dt = 0.02;
+	const char *module = 0, *classname = 0;
+
+	for (i = 1; i < argc; i++) {
+		if      (!strcmp (argv[i], "-n")  && i+1 < argc) nv = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-t")  && i+1 < argc) tmax = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-dt") && i+1 < argc) dt = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-c")  && i+1 < argc) classname = argv[++i];
+		else module = argv[i];
+	}
+	if (!module || nv < 1 || tmax <= 0.0 || dt <= 0.0) {
+		fprintf (stderr, "Usage: bench [-n vessels] [-t seconds] [-dt step] [-c class] module\n");
+		return 1;
+	}
+	if (!classname) // default: module file name without path and extension
+		classname = BenchModuleName (module);
+
+	BenchModule mod;
+	if (!BenchLoadModule (module, mod)) return 1;
+
+	Vessel **vessel = new Vessel*[nv];
+	LARGE_INTEGER t0, t1;
+	LONGLONG tpre = 0, tpost = 0, thost = 0, thud = 0, tcreate;
+	char name[64];
+	HUDPAINTSPEC hps = {1024, 768, 512, 384, 768.0, 24};
+
+	QueryPerformanceCounter (&t0);
+	for (i = 0; i < nv; i++) {
+		sprintf (name, "%s-%d", classname, i+1);
+		vessel[i] = BenchCreateVessel (mod, name, classname);
+	}
+	QueryPerformanceCounter (&t1);
+	tcreate = t1.QuadPart-t0.QuadPart;
+	bool hud = (vessel[0]->iface->Version() >= 2); // clbkRenderHUD is a VESSEL3 callback
+	if (hud) oapiSetHUDMode (HUD_DOCKING);
+	DWORD nmesh = BenchMeshCount();
+
+	int nstep = (int)(tmax/dt + 0.5);
+	double simt = 0.0, mjd, aoa, M;
+	for (k = 0; k < nstep; k++) {
+		if (k == nstep/10 || k == nstep/2) { // operate the landing gear
+			char kstate[256];
+			memset (kstate, 0, 256);
+			for (i = 0; i < nv; i++)
+				((VESSEL2*)vessel[i]->iface)->clbkConsumeBufferedKey (OAPI_KEY_G, true, kstate);
+		}
+		mjd = oapiGetSimMJD();
+		BenchSetTime (simt, dt);
+		QueryPerformanceCounter (&t0);
+		for (i = 0; i < nv; i++)
+			((VESSEL2*)vessel[i]->iface)->clbkPreStep (simt, dt, mjd);
+		QueryPerformanceCounter (&t1);
+		tpre += t1.QuadPart-t0.QuadPart;
+
+		for (i = 0; i < nv; i++) {
+			Script (vessel[i]->iface, simt/tmax, simt, aoa, M);
+			vessel[i]->Step (dt, aoa, M);
+		}
+		simt += dt;
+		BenchSetTime (simt, dt);
+		mjd = oapiGetSimMJD();
+		QueryPerformanceCounter (&t0);
+		thost += t0.QuadPart-t1.QuadPart;
+
+		for (i = 0; i < nv; i++)
+			((VESSEL2*)vessel[i]->iface)->clbkPostStep (simt, dt, mjd);
+		QueryPerformanceCounter (&t1);
+		tpost += t1.QuadPart-t0.QuadPart;
+
+		if (hud) {
+			((VESSEL3*)vessel[0]->iface)->clbkRenderHUD (HUD_DOCKING, &hps, 0);
+			QueryPerformanceCounter (&t0);
+			thud += t0.QuadPart-t1.QuadPart;
+		}
+	}
+	nmesh = BenchMeshCount()-nmesh;
+
+	// scenario round trip of the first vessel
+	bool scnok = false;
+	FILEHANDLE scn = oapiOpenFile ("Bench.scn", FILE_OUT, ROOT);
+	if (scn) {
+		((VESSEL2*)vessel[0]->iface)->clbkSaveState (scn);
+		oapiWriteLine (scn, "END");
+		oapiCloseFile (scn, FILE_OUT);
+		if ((scn = oapiOpenFile ("Bench.scn", FILE_IN, ROOT))) {
+			((VESSEL2*)vessel[0]->iface)->clbkLoadStateEx (scn, 0);
+			oapiCloseFile (scn, FILE_IN);
+			scnok = true;
+		}
+		remove ("Bench.scn");
+	}
+
+	double nframe = (double)nv*nstep;
+	VESSEL *v = vessel[0]->iface;
+	printf ("Bench: %s, %d vessels, %d frames (dt=%g s)\n", classname, nv, nstep, dt);
+	printf ("  create         %10.3f us/vessel\n", Ticks2us (tcreate, nv));
+	printf ("  clbkPreStep    %10.3f us/vessel/frame\n", Ticks2us (tpre, nframe));
+	printf ("  clbkPostStep   %10.3f us/vessel/frame\n", Ticks2us (tpost, nframe));
+	printf ("  host step      %10.3f us/vessel/frame (thrust, propellant, airfoils)\n", Ticks2us (thost, nframe));
+	if (hud)
+		printf ("  clbkRenderHUD  %10.3f us/frame, %d meshes created (%.2f/s at %g frames/s)\n",
+			Ticks2us (thud, nstep), (int)nmesh, nmesh/(nstep*dt), 1.0/dt);
+	printf ("  state: mass %.1f kg, propellant %.1f kg, %d thrusters, %d animations, %d airfoils, scenario %s\n",
+		v->GetMass(), v->GetTotalPropellantMass(), (int)vessel[0]->thr.size(),
+		(int)vessel[0]->anim.size(), (int)vessel[0]->airfoil.size(), scnok ? "ok" : "failed");
+
+	for (i = 0; i < nv; i++)
+		BenchDeleteVessel (mod, vessel[i]);
+	delete []vessel;
+	BenchUnloadModule (mod);
+	return (scnok ? 0 : 1);
+}
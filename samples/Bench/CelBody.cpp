@@ -0,0 +1,108 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// CelBody.cpp
+// Headless stand-in for the CELBODY, CELBODY2 and ATMOSPHERE base
+// classes. Bodies have no parent or children, and external
+// atmosphere modules are not supported.
+// ==============================================================
+
+#include "Host.h"
+
+// ==============================================================
+// class CelBody
+
+CelBody::CelBody (const char *_name)
+{
+	strncpy (name, _name, 63); name[63] = '\0';
+	iface = 0;
+}
+
+// Vessels fly far from any body (see Vessel.cpp), so no vessel has a
+// body as its atmosphere reference, and these are not called for one
+DLLEXPORT const ATMCONST *oapiGetPlanetAtmConstants (OBJHANDLE hPlanet) { return 0; }
+
+DLLEXPORT void oapiGlobalToEqu (OBJHANDLE hObj, const VECTOR3 &glob, double *lng, double *lat, double *rad)
+{
+	*lng = *lat = 0.0;
+	*rad = length (glob);
+}
+
+// ==============================================================
+// class CELBODY
+
+CELBODY::CELBODY () { version = 1; }
+bool CELBODY::bEphemeris () const { return false; }
+void CELBODY::clbkInit (FILEHANDLE cfg) {}
+int CELBODY::clbkEphemeris (double mjd, int req, double *ret) { return 0; }
+int CELBODY::clbkFastEphemeris (double simt, int req, double *ret) { return 0; }
+bool CELBODY::clbkAtmParam (double alt, ATMPARAM *prm) { return false; }
+
+void CELBODY::Pol2Crt (double *pol, double *crt)
+{
+	// position: lng, lat [rad], r [AU] -> x, y, z [m]
+	// velocity: dlng/dt, dlat/dt [rad/s], dr/dt [AU/s] -> [m/s]
+	double cl = cos (pol[0]), sl = sin (pol[0]);
+	double cb = cos (pol[1]), sb = sin (pol[1]);
+	double r = pol[2]*AU, dl = pol[3], db = pol[4], dr = pol[5]*AU;
+	crt[0] = r*cb*cl;
+	crt[1] = r*sb;
+	crt[2] = r*cb*sl;
+	crt[3] = dr*cb*cl - r*(db*sb*cl + dl*cb*sl);
+	crt[4] = dr*sb + r*db*cb;
+	crt[5] = dr*cb*sl - r*(db*sb*sl - dl*cb*cl);
+}
+
+// ==============================================================
+// class CELBODY2
+
+CELBODY2::CELBODY2 (OBJHANDLE hCBody): CELBODY ()
+{
+	version = 2;
+	hBody = hCBody;
+	atm = 0;
+	hAtmModule = 0;
+}
+
+CELBODY2::~CELBODY2 () { FreeAtmosphere (); }
+void CELBODY2::clbkInit (FILEHANDLE cfg) { CELBODY::clbkInit (cfg); }
+OBJHANDLE CELBODY2::GetParent () const { return 0; }
+OBJHANDLE CELBODY2::GetChild (DWORD idx) const { return 0; }
+double CELBODY2::SidRotPeriod () const { return 86400.0; }
+
+void CELBODY2::SetAtmosphere (ATMOSPHERE *a)
+{
+	FreeAtmosphere ();
+	atm = a;
+}
+
+// Orbiter deletes the instance here. ATMOSPHERE has no virtual
+// destructor, so that is undefined for the derived models; the modules
+// in this tree delete their models themselves, and the stand-in only
+// drops the pointer
+bool CELBODY2::FreeAtmosphere ()
+{
+	if (!atm) return false;
+	atm = 0;
+	return true;
+}
+
+bool CELBODY2::LoadAtmosphereModule (const char *fname) { return false; }
+bool CELBODY2::FreeAtmosphereModule () { return false; }
+
+// ==============================================================
+// class ATMOSPHERE
+
+ATMOSPHERE::ATMOSPHERE (CELBODY2 *body) { cbody = body; }
+
+bool ATMOSPHERE::clbkConstants (ATMCONST *atmc) const
+{
+	atmc->R = 286.91;
+	atmc->gamma = 1.4;
+	return false;
+}
+
+bool ATMOSPHERE::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm_out) { return false; }
@@ -0,0 +1,238 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Cockpit.cpp
+// Headless stand-in for the visual and user interface functions of
+// the API: meshes, surfaces and textures, 2-D panels, virtual
+// cockpits, MFDs, HUD, dialogs, nav radios and script interpreters.
+// There is no display: meshes created by modules are kept in memory
+// and edited as by Orbiter, so modules that build geometry at
+// runtime do the same work; everything that draws or opens a window
+// does nothing and returns a NULL handle.
+// ==============================================================
+
+#include "Host.h"
+#include "DlgCtrl.h"
+#include <map>
+#include <string>
+
+// ==============================================================
+// Meshes
+
+struct BenchMesh {
+	std::vector<MESHGROUP> grp;
+};
+
+static DWORD g_nmesh = 0; // meshes created with oapiCreateMesh
+static std::map<std::string,BenchMesh*> g_globalmesh;
+
+DWORD BenchMeshCount () { return g_nmesh; }
+
+// Copy a group with its own vertex and index lists, as Orbiter does
+static MESHGROUP CopyGroup (const MESHGROUP &g)
+{
+	MESHGROUP c = g;
+	c.Vtx = new NTVERTEX[g.nVtx ? g.nVtx : 1];
+	c.Idx = new WORD[g.nIdx ? g.nIdx : 1];
+	if (g.nVtx) memcpy (c.Vtx, g.Vtx, g.nVtx*sizeof(NTVERTEX));
+	if (g.nIdx) memcpy (c.Idx, g.Idx, g.nIdx*sizeof(WORD));
+	return c;
+}
+
+DLLEXPORT MESHHANDLE oapiCreateMesh (DWORD ngrp, MESHGROUP *grp)
+{
+	BenchMesh *mesh = new BenchMesh;
+	for (DWORD i = 0; i < ngrp; i++)
+		mesh->grp.push_back (CopyGroup (grp[i]));
+	g_nmesh++;
+	return (MESHHANDLE)mesh;
+}
+
+DLLEXPORT void oapiDeleteMesh (MESHHANDLE hMesh)
+{
+	BenchMesh *mesh = (BenchMesh*)hMesh;
+	if (!mesh) return;
+	for (size_t i = 0; i < mesh->grp.size(); i++) {
+		delete []mesh->grp[i].Vtx;
+		delete []mesh->grp[i].Idx;
+	}
+	delete mesh;
+}
+
+// Mesh files are not read: a global mesh is an empty mesh, loaded once
+// per name and kept until the process exits
+DLLEXPORT const MESHHANDLE oapiLoadMeshGlobal (const char *fname)
+{
+	BenchMesh *&mesh = g_globalmesh[fname];
+	if (!mesh) mesh = new BenchMesh;
+	return (MESHHANDLE)mesh;
+}
+
+DLLEXPORT MESHGROUP *oapiMeshGroup (MESHHANDLE hMesh, DWORD idx)
+{
+	BenchMesh *mesh = (BenchMesh*)hMesh;
+	return (mesh && idx < mesh->grp.size() ? &mesh->grp[idx] : 0);
+}
+
+DLLEXPORT DWORD oapiAddMeshGroup (MESHHANDLE hMesh, MESHGROUP *grp)
+{
+	BenchMesh *mesh = (BenchMesh*)hMesh;
+	mesh->grp.push_back (CopyGroup (*grp));
+	return (DWORD)mesh->grp.size()-1;
+}
+
+DLLEXPORT bool oapiAddMeshGroupBlock (MESHHANDLE hMesh, DWORD grpidx,
+	const NTVERTEX *vtx, DWORD nvtx, const WORD *idx, DWORD nidx)
+{
+	MESHGROUP *g = oapiMeshGroup (hMesh, grpidx);
+	if (!g) return false;
+	NTVERTEX *v = new NTVERTEX[g->nVtx+nvtx];
+	WORD *x = new WORD[g->nIdx+nidx];
+	memcpy (v, g->Vtx, g->nVtx*sizeof(NTVERTEX));
+	memcpy (v+g->nVtx, vtx, nvtx*sizeof(NTVERTEX));
+	memcpy (x, g->Idx, g->nIdx*sizeof(WORD));
+	for (DWORD i = 0; i < nidx; i++) x[g->nIdx+i] = (WORD)(idx[i] + g->nVtx);
+	delete []g->Vtx;
+	delete []g->Idx;
+	g->Vtx = v, g->nVtx += nvtx;
+	g->Idx = x, g->nIdx += nidx;
+	return true;
+}
+
+DLLEXPORT int oapiEditMeshGroup (MESHHANDLE hMesh, DWORD grpidx, GROUPEDITSPEC *ges)
+{
+	MESHGROUP *g = oapiMeshGroup (hMesh, grpidx);
+	if (!g || ges->nVtx > g->nVtx) return -1;
+	DWORD flag = ges->flags;
+	if      (flag & GRPEDIT_SETUSERFLAG) g->UsrFlag = ges->UsrFlag;
+	else if (flag & GRPEDIT_ADDUSERFLAG) g->UsrFlag |= ges->UsrFlag;
+	else if (flag & GRPEDIT_DELUSERFLAG) g->UsrFlag &= ~ges->UsrFlag;
+	if (flag & GRPEDIT_VTX) {
+		for (DWORD i = 0; i < ges->nVtx; i++) {
+			DWORD j = (ges->vIdx ? ges->vIdx[i] : i);
+			if (j >= g->nVtx) continue;
+			NTVERTEX &v = g->Vtx[j], &s = ges->Vtx[i];
+			if (flag & GRPEDIT_VTXCRDX) v.x  = s.x;
+			if (flag & GRPEDIT_VTXCRDY) v.y  = s.y;
+			if (flag & GRPEDIT_VTXCRDZ) v.z  = s.z;
+			if (flag & GRPEDIT_VTXNMLX) v.nx = s.nx;
+			if (flag & GRPEDIT_VTXNMLY) v.ny = s.ny;
+			if (flag & GRPEDIT_VTXNMLZ) v.nz = s.nz;
+			if (flag & GRPEDIT_VTXTEXU) v.tu = s.tu;
+			if (flag & GRPEDIT_VTXTEXV) v.tv = s.tv;
+		}
+	}
+	return 0;
+}
+
+// Device meshes belong to a visual, and there are none
+DLLEXPORT int oapiEditMeshGroup (DEVMESHHANDLE hMesh, DWORD grpidx, GROUPEDITSPEC *ges) { return -1; }
+DLLEXPORT bool oapiSetTexture (DEVMESHHANDLE hMesh, DWORD texidx, SURFHANDLE tex) { return false; }
+DLLEXPORT SURFHANDLE oapiGetTextureHandle (MESHHANDLE hMesh, DWORD texidx) { return 0; }
+
+// ==============================================================
+// Surfaces, textures, fonts and sketchpads
+
+DLLEXPORT SURFHANDLE oapiCreateSurface (HBITMAP hBmp, bool release_bmp) { return 0; }
+DLLEXPORT SURFHANDLE oapiCreateTextureSurface (int width, int height) { return 0; }
+DLLEXPORT void oapiDestroySurface (SURFHANDLE surf) {}
+DLLEXPORT void oapiSetSurfaceColourKey (SURFHANDLE surf, DWORD ck) {}
+DLLEXPORT HDC oapiGetDC (SURFHANDLE surf) { return 0; }
+DLLEXPORT void oapiReleaseDC (SURFHANDLE surf, HDC hDC) {}
+DLLEXPORT void oapiBlt (SURFHANDLE tgt, SURFHANDLE src, int tgtx, int tgty, int srcx, int srcy, int w, int h, DWORD ck) {}
+DLLEXPORT void oapiColourFill (SURFHANDLE tgt, DWORD fillcolor, int tgtx, int tgty, int w, int h) {}
+DLLEXPORT DWORD oapiGetColour (DWORD red, DWORD green, DWORD blue) { return (red << 16) | (green << 8) | blue; }
+DLLEXPORT SURFHANDLE oapiLoadTexture (const char *fname, bool dynamic) { return 0; }
+DLLEXPORT void oapiReleaseTexture (SURFHANDLE hTex) {}
+DLLEXPORT SURFHANDLE oapiRegisterParticleTexture (char *name) { return 0; }
+DLLEXPORT void oapiParticleSetLevelRef (PSTREAM_HANDLE ph, double *lvl) {}
+DLLEXPORT oapi::Font *oapiCreateFont (int height, bool prop, char *face, FontStyle style) { return 0; }
+DLLEXPORT void oapiReleaseFont (oapi::Font *font) {}
+DLLEXPORT oapi::Sketchpad *oapiGetSketchpad (SURFHANDLE surf) { return 0; }
+DLLEXPORT void oapiReleaseSketchpad (oapi::Sketchpad *skp) {}
+
+// ==============================================================
+// 2-D panels and virtual cockpits
+
+DLLEXPORT int oapiCockpitMode () { return COCKPIT_GENERIC; }
+DLLEXPORT void oapiCameraSetCockpitDir (double polar, double azimuth, bool transition) {}
+DLLEXPORT void oapiRegisterPanelBackground (HBITMAP hBmp, DWORD flag, DWORD ck) {}
+DLLEXPORT void oapiRegisterPanelArea (int id, const RECT &pos, int draw_event, int mouse_event, int bkmode) {}
+DLLEXPORT void oapiSetPanelNeighbours (int left, int right, int top, int bottom) {}
+DLLEXPORT bool oapiBltPanelAreaBackground (int area_id, SURFHANDLE surf) { return false; }
+DLLEXPORT void oapiTriggerPanelRedrawArea (int panel_id, int area_id) {}
+DLLEXPORT void oapiTriggerRedrawArea (int panel_id, int vc_id, int area_id) {}
+DLLEXPORT void oapiVCRegisterArea (int id, const RECT &tgtrect, int draw_event, int mouse_event, int bkmode, SURFHANDLE tgt) {}
+DLLEXPORT void oapiVCRegisterArea (int id, int draw_event, int mouse_event) {}
+DLLEXPORT void oapiVCSetAreaClickmode_Quadrilateral (int id, const VECTOR3 &p1, const VECTOR3 &p2, const VECTOR3 &p3, const VECTOR3 &p4) {}
+DLLEXPORT void oapiVCSetAreaClickmode_Spherical (int id, const VECTOR3 &cnt, double rad) {}
+DLLEXPORT void oapiVCSetNeighbours (int left, int right, int top, int bottom) {}
+DLLEXPORT void oapiVCTriggerRedrawArea (int vc_id, int area_id) {}
+DLLEXPORT void oapiVCRegisterHUD (const VCHUDSPEC *spec) {}
+DLLEXPORT void oapiVCRegisterMFD (int mfd, const VCMFDSPEC *spec) {}
+
+// ==============================================================
+// MFDs and HUD. The HUD mode is kept; changes are reported to the
+// focus vessel, as by Orbiter.
+
+static int g_hudmode = HUD_NONE;
+
+DLLEXPORT void oapiRegisterMFD (int mfd, const MFDSPEC &spec) {}
+DLLEXPORT const char *oapiMFDButtonLabel (int mfd, int bt) { return 0; }
+DLLEXPORT bool oapiProcessMFDButton (int mfd, int bt, int event) { return false; }
+DLLEXPORT int oapiSendMFDKey (int mfd, DWORD key) { return 0; }
+DLLEXPORT void oapiToggleMFD_on (int mfd) {}
+DLLEXPORT void oapiSetDefNavDisplay (int mode) {}
+DLLEXPORT void oapiSetDefRCSDisplay (int mode) {}
+
+DLLEXPORT int oapiGetHUDMode () { return g_hudmode; }
+
+DLLEXPORT bool oapiSetHUDMode (int mode)
+{
+	if (mode < HUD_NONE || mode > HUD_DOCKING) return false;
+	if (mode != g_hudmode) {
+		g_hudmode = mode;
+		OBJHANDLE hFocus = oapiGetFocusObject();
+		VESSEL *v = (hFocus ? oapiGetVesselInterface (hFocus) : 0);
+		if (v && v->Version() >= 1) ((VESSEL2*)v)->clbkHUDMode (mode);
+	}
+	return true;
+}
+
+DLLEXPORT void oapiIncHUDIntensity () {}
+DLLEXPORT void oapiDecHUDIntensity () {}
+DLLEXPORT void oapiToggleHUDColour () {}
+DLLEXPORT void oapiRenderHUD (MESHHANDLE hMesh, SURFHANDLE *hTex) {}
+
+// ==============================================================
+// Dialogs and dialog controls
+
+DLLEXPORT HWND oapiOpenDialogEx (HINSTANCE hDLLInst, int resourceId, DLGPROC msgProc, DWORD flag, void *context) { return 0; }
+DLLEXPORT void oapiCloseDialog (HWND hDlg) {}
+DLLEXPORT HWND oapiFindDialog (HINSTANCE hDLLInst, int resourceId) { return 0; }
+DLLEXPORT void *oapiGetDialogContext (HWND hDlg) { return 0; }
+DLLEXPORT BOOL oapiDefDialogProc (HWND hDlg, UINT uMsg, WPARAM wParam, LPARAM lParam) { return FALSE; }
+DLLEXPORT bool oapiOpenHelp (HELPCONTEXT *hcontext) { return false; }
+
+void oapiRegisterCustomControls (HINSTANCE hInst) {}
+void oapiUnregisterCustomControls (HINSTANCE hInst) {}
+void oapiSetGaugeParams (HWND hCtrl, GAUGEPARAM *gp, bool redraw) {}
+int oapiSetGaugePos (HWND hCtrl, int pos, bool redraw) { return 0; }
+int oapiGetGaugePos (HWND hCtrl) { return 0; }
+
+// ==============================================================
+// Nav radios. Vessels have no nav sources, so no handle is valid.
+
+DLLEXPORT void oapiGetNavPos (NAVHANDLE hNav, VECTOR3 *gpos) { *gpos = _V(0,0,0); }
+DLLEXPORT DWORD oapiGetNavType (NAVHANDLE hNav) { return TRANSMITTER_NONE; }
+DLLEXPORT int oapiGetNavData (NAVHANDLE hNav, NAVDATA *data) { return -1; }
+
+// ==============================================================
+// Script interpreters. The runner is built without Lua, so no
+// interpreter can be created.
+
+DLLEXPORT INTERPRETERHANDLE oapiCreateInterpreter () { return 0; }
+DLLEXPORT bool oapiAsyncScriptCmd (INTERPRETERHANDLE hInterp, const char *cmd) { return false; }
@@ -0,0 +1,16 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// DGNoLua.cpp
+// Replaces the DeltaGlider's Lua bindings (DGLua.cpp) in the
+// benchmark build, which has no Lua library. The stand-in creates no
+// interpreters, so the callbacks that use these are never reached.
+// ==============================================================
+
+#include "DeltaGlider.h"
+
+int DeltaGlider::Lua_InitInterpreter (void *context) { return 0; }
+int DeltaGlider::Lua_InitInstance (void *context) { return 0; }
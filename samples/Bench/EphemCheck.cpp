@@ -0,0 +1,129 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// EphemCheck.cpp
+// Accuracy check and benchmark of the ephemeris cache of a planet
+// module: clbkFastEphemeris (interpolated) is compared with
+// clbkEphemeris (analytic) over a simulated flight of several years,
+// including a date jump, and both are timed.
+//
+// Usage: ephemcheck [-y years] [-tol reltol] module
+// ==============================================================
+
+#include "Host.h"
+#include <stdlib.h>
+
+// Polar (lng, lat [rad], r [AU] and rates) to cartesian [m, m/s]
+static void Pol2Crt (const double *pol, VECTOR3 &pos, VECTOR3 &vel)
+{
+	double cl = cos (pol[0]), sl = sin (pol[0]);
+	double cb = cos (pol[1]), sb = sin (pol[1]);
+	double r = pol[2]*AU, dl = pol[3], db = pol[4], dr = pol[5]*AU;
+	pos = _V(r*cb*cl, r*sb, r*cb*sl);
+	vel = _V(dr*cb*cl - r*(db*sb*cl + dl*cb*sl), dr*sb + r*db*cb, dr*cb*sl - r*(db*sb*sl - dl*cb*cl));
+}
+
+// State of body at simt from clbkFastEphemeris (fast = true) or
+// clbkEphemeris, in cartesian coordinates
+static int State (CELBODY *body, double simt, bool fast, VECTOR3 &pos, VECTOR3 &vel)
+{
+	double ret[12];
+	const int req = EPHEM_TRUEPOS | EPHEM_TRUEVEL;
+	int flag = (fast ? body->clbkFastEphemeris (simt, req, ret) :
+		body->clbkEphemeris (oapiGetSimMJD() + (simt-oapiGetSimTime())/86400.0, req, ret));
+	if (flag & EPHEM_POLAR) Pol2Crt (ret, pos, vel);
+	else pos = _V(ret[0], ret[1], ret[2]), vel = _V(ret[3], ret[4], ret[5]);
+	return flag;
+}
+
+// Compare fast and full ephemerides at the current simulation time
+static void Compare (CELBODY *body, double &epos, double &evel, int &nbad)
+{
+	VECTOR3 p0, v0, p1, v1;
+	double simt = oapiGetSimTime();
+	int f0 = State (body, simt, false, p0, v0);
+	int f1 = State (body, simt, true, p1, v1);
+	if ((f0 & (EPHEM_TRUEPOS | EPHEM_TRUEVEL)) != (f1 & (EPHEM_TRUEPOS | EPHEM_TRUEVEL))) nbad++;
+	double e = length (p1-p0)/length (p0);
+	if (e > epos) epos = e;
+	e = length (v1-v0)/length (v0);
+	if (e > evel) evel = e;
+}
+
+static double Ticks2ns (LONGLONG ticks, double n)
+{
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency (&freq);
+	return ticks*1e9/(freq.QuadPart*n);
+}
+
+int main (int argc, char *argv[])
+{
+	int i, k, nbad = 0;
+	double years = 4.0, tol = 1e-8;
+	const char *module = 0;
+
+	for (i = 1; i < argc; i++) {
+		if      (!strcmp (argv[i], "-y")   && i+1 < argc) years = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-tol") && i+1 < argc) tol = atof (argv[++i]);
+		else module = argv[i];
+	}
+	if (!module || years <= 0.0) {
+		fprintf (stderr, "Usage: ephemcheck [-y years] [-tol reltol] module\n");
+		return 1;
+	}
+	BenchModule mod;
+	if (!BenchLoadModule (module, mod)) return 1;
+	if (!mod.InitInstance) {
+		fprintf (stderr, "EphemCheck: %s is not a planet module\n", module);
+		return 1;
+	}
+	const char *name = BenchModuleName (module);
+	CelBody *cb = BenchCreateBody (mod, name);
+	CELBODY *body = cb->iface;
+
+	// accuracy: hourly frames over the flight, then a jump back by
+	// 10 years and another 30 days
+	double tmax = years*365.25*86400.0, dt = 3600.0, simt;
+	double epos = 0.0, evel = 0.0;
+	int nstep = (int)(tmax/dt);
+	for (k = 0; k < nstep; k++) {
+		BenchSetTime (simt = k*dt, dt);
+		Compare (body, epos, evel, nbad);
+	}
+	double t0 = -10.0*365.25*86400.0;
+	for (k = 0; k < 720; k++) {
+		BenchSetTime (simt = t0 + k*dt, dt);
+		Compare (body, epos, evel, nbad);
+	}
+
+	// timings: frames of 20 ms, and full evaluations at the same times
+	const int ncall = 1000000, req = EPHEM_TRUEPOS | EPHEM_TRUEVEL;
+	double ret[12];
+	LARGE_INTEGER ta, tb, tc;
+	QueryPerformanceCounter (&ta);
+	for (k = 0; k < ncall; k++) {
+		BenchSetTime (simt = k*0.02, 0.02);
+		body->clbkFastEphemeris (simt, req, ret);
+	}
+	QueryPerformanceCounter (&tb);
+	for (k = 0; k < ncall; k++) {
+		BenchSetTime (simt = k*0.02, 0.02);
+		body->clbkEphemeris (oapiGetSimMJD(), req, ret);
+	}
+	QueryPerformanceCounter (&tc);
+
+	printf ("EphemCheck: %s, %d frames over %g years + date jump\n", name, nstep+720, years);
+	printf ("  rel. error position %0.3g, velocity %0.3g (limit %0.3g)\n", epos, evel, tol);
+	printf ("  clbkFastEphemeris %8.1f ns/call\n", Ticks2ns (tb.QuadPart-ta.QuadPart, ncall));
+	printf ("  clbkEphemeris     %8.1f ns/call\n", Ticks2ns (tc.QuadPart-tb.QuadPart, ncall));
+
+	BenchDeleteBody (mod, cb);
+	BenchUnloadModule (mod);
+	bool ok = (epos <= tol && evel <= tol && !nbad);
+	if (!ok) printf ("EphemCheck: FAILED\n");
+	return (ok ? 0 : 1);
+}
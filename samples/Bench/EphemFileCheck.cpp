@@ -0,0 +1,188 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// EphemFileCheck.cpp
+// Check of an ephemeris file written by ephemtool against the planet
+// module it was sampled from: accuracy within the coverage, no data
+// outside it, rewriting the file while another thread queries it,
+// and rejection of a corrupt file.
+//
+// Usage: ephemfilecheck [-tol reltol] module file
+// ==============================================================
+
+#include "Host.h"
+#include "EphemFile.h"
+#include <stdlib.h>
+
+static const int REQ = EPHEM_TRUEPOS | EPHEM_TRUEVEL;
+
+// Polar (lng, lat [rad], r [AU] and rates) or cartesian data to
+// cartesian position and velocity [m, m/s]
+static void State (int flag, const double *ret, VECTOR3 &pos, VECTOR3 &vel)
+{
+	if (flag & EPHEM_POLAR) {
+		double cl = cos (ret[0]), sl = sin (ret[0]);
+		double cb = cos (ret[1]), sb = sin (ret[1]);
+		double r = ret[2]*AU, dl = ret[3], db = ret[4], dr = ret[5]*AU;
+		pos = _V(r*cb*cl, r*sb, r*cb*sl);
+		vel = _V(dr*cb*cl - r*(db*sb*cl + dl*cb*sl), dr*sb + r*db*cb, dr*cb*sl - r*(db*sb*sl - dl*cb*cl));
+	} else {
+		pos = _V(ret[0], ret[1], ret[2]);
+		vel = _V(ret[3], ret[4], ret[5]);
+	}
+}
+
+// Relative position/velocity errors of the file data at mjd. Returns
+// false if the file has no data.
+static bool Compare (EphemFile &ef, CELBODY *body, double mjd, double &epos, double &evel)
+{
+	double r0[12], r1[12];
+	VECTOR3 p0, v0, p1, v1;
+	int f1 = ef.Eval (mjd, REQ, r1);
+	if (!f1) return false;
+	int f0 = body->clbkEphemeris (mjd, REQ, r0);
+	State (f0, r0, p0, v0);
+	State (f1, r1, p1, v1);
+	epos = length (p1-p0)/length (p0);
+	evel = length (v1-v0)/length (v0);
+	if ((f0 & REQ) != (f1 & REQ)) epos = evel = 1.0;
+	return true;
+}
+
+// Query thread for the rewrite test: queries until stopped, and
+// counts queries with data and wrong data
+struct Query {
+	EphemFile *ef;
+	CELBODY *body;
+	double mjd0, mjd1, tol;
+	volatile LONG stop;
+	int ndata, nbad;
+};
+
+static unsigned int WINAPI QueryProc (LPVOID context)
+{
+	Query *q = (Query*)context;
+	DWORD seed = 4711;
+	double ep, ev;
+	while (!q->stop) {
+		seed = seed*1664525 + 1013904223;
+		double mjd = q->mjd0 + (q->mjd1-q->mjd0)*(seed >> 8)/16777216.0;
+		if (Compare (*q->ef, q->body, mjd, ep, ev)) {
+			q->ndata++;
+			if (ep > q->tol || ev > q->tol) q->nbad++;
+		}
+	}
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	int i, fail = 0;
+	double tol = 1e-9;
+	const char *module = 0, *fname = 0;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp (argv[i], "-tol") && i+1 < argc) tol = atof (argv[++i]);
+		else if (!module) module = argv[i];
+		else fname = argv[i];
+	}
+	if (!module || !fname) {
+		fprintf (stderr, "Usage: ephemfilecheck [-tol reltol] module file\n");
+		return 1;
+	}
+	EphemFileHeader hdr;
+	FILE *f = fopen (fname, "rb");
+	if (!f || fread (&hdr, sizeof(EphemFileHeader), 1, f) != 1) {
+		fprintf (stderr, "EphemFileCheck: can't read %s\n", fname);
+		return 1;
+	}
+	fclose (f);
+	double mjd0 = hdr.mjd0, mjd1 = hdr.mjd0 + hdr.nrec*hdr.dt;
+
+	BenchModule mod;
+	if (!BenchLoadModule (module, mod)) return 1;
+	if (!mod.InitInstance) {
+		fprintf (stderr, "EphemFileCheck: %s is not a planet module\n", module);
+		return 1;
+	}
+	CelBody *cb = BenchCreateBody (mod, BenchModuleName (module));
+	CELBODY *body = cb->iface;
+	EphemFile ef (fname);
+
+	// accuracy at random dates within the coverage, including the
+	// record boundaries
+	const int nsample = 100000;
+	double ep, ev, epos = 0.0, evel = 0.0;
+	DWORD seed = 12345;
+	int nmiss = 0;
+	LARGE_INTEGER freq, t0, t1, t2;
+	double *mjd = new double[nsample], ret[12];
+	for (i = 0; i < nsample; i++) {
+		seed = seed*1664525 + 1013904223;
+		mjd[i] = (i < (int)hdr.nrec ? mjd0 + i*hdr.dt : mjd0 + (mjd1-mjd0)*(seed >> 8)/16777216.0);
+		if (!Compare (ef, body, mjd[i], ep, ev)) { nmiss++; continue; }
+		if (ep > epos) epos = ep;
+		if (ev > evel) evel = ev;
+	}
+	printf ("EphemFileCheck: %s, %d records of %g days from MJD %g, max. fit error %0.2g\n",
+		fname, hdr.nrec, hdr.dt, mjd0, hdr.maxerr);
+	printf ("  rel. error position %0.3g, velocity %0.3g (limit %0.3g), %d dates without data\n",
+		epos, evel, tol, nmiss);
+	if (epos > tol || evel > tol || nmiss) fail++;
+
+	// no data outside the coverage
+	if (ef.Eval (mjd0-1.0, REQ, ret) || ef.Eval (mjd1+1.0, REQ, ret)) {
+		printf ("EphemFileCheck: data returned outside the coverage\n");
+		fail++;
+	}
+
+	// timings
+	QueryPerformanceFrequency (&freq);
+	QueryPerformanceCounter (&t0);
+	for (i = 0; i < nsample; i++) ef.Eval (mjd[i], REQ, ret);
+	QueryPerformanceCounter (&t1);
+	for (i = 0; i < nsample; i++) body->clbkEphemeris (mjd[i], REQ, ret);
+	QueryPerformanceCounter (&t2);
+	double ns = 1e9/((double)freq.QuadPart*nsample);
+	printf ("  EphemFile::Eval %8.1f ns/call, clbkEphemeris %8.1f ns/call\n",
+		(t1.QuadPart-t0.QuadPart)*ns, (t2.QuadPart-t1.QuadPart)*ns);
+
+	// rewrite the file while another thread queries it: queries return
+	// either no data (while writing) or correct data
+	Query q = {&ef, body, mjd0, mjd1, tol, 0, 0, 0};
+	unsigned int id;
+	HANDLE hThread = (HANDLE)_beginthreadex (NULL, 0, &QueryProc, &q, 0, &id);
+	for (i = 0; i < 5; i++) {
+		if (!ef.Write (body, mjd0, mjd1, hdr.dt)) fail++;
+		Sleep (20);
+	}
+	q.stop = 1;
+	WaitForSingleObject (hThread, INFINITE);
+	CloseHandle (hThread);
+	printf ("  rewrite: %d concurrent queries with data, %d wrong\n", q.ndata, q.nbad);
+	if (q.nbad || !q.ndata) fail++;
+
+	// a file whose records extend beyond its size must be rejected
+	char cname[256];
+	sprintf (cname, "%.240s.bad", fname);
+	if ((f = fopen (cname, "wb"))) {
+		hdr.nrec *= 2;
+		fwrite (&hdr, sizeof(EphemFileHeader), 1, f);
+		fclose (f);
+		EphemFile bad (cname);
+		if (bad.Eval (mjd0, REQ, ret)) {
+			printf ("EphemFileCheck: corrupt file accepted\n");
+			fail++;
+		}
+		remove (cname);
+	}
+
+	delete []mjd;
+	BenchDeleteBody (mod, cb);
+	BenchUnloadModule (mod);
+	if (fail) printf ("EphemFileCheck: FAILED\n");
+	return fail;
+}
@@ -0,0 +1,56 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// EphemTool.cpp
+// Precompute an ephemeris file (see EphemFile.h) from a planet
+// module: the module is loaded with the headless host, and its
+// clbkEphemeris is sampled from mjd0 to mjd1 in records of dt days.
+//
+// Usage: ephemtool [-mjd0 mjd] [-mjd1 mjd] [-dt days] module file
+// ==============================================================
+
+#include "Host.h"
+#include "EphemFile.h"
+#include <stdlib.h>
+
+int main (int argc, char *argv[])
+{
+	int i;
+	double mjd0 = 51544.5, mjd1 = 51544.5 + 100.0*365.25, dt = 8.0;
+	const char *module = 0, *fname = 0;
+
+	for (i = 1; i < argc; i++) {
+		if      (!strcmp (argv[i], "-mjd0") && i+1 < argc) mjd0 = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-mjd1") && i+1 < argc) mjd1 = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-dt")   && i+1 < argc) dt = atof (argv[++i]);
+		else if (!module) module = argv[i];
+		else fname = argv[i];
+	}
+	if (!module || !fname || mjd1 <= mjd0 || dt <= 0.0) {
+		fprintf (stderr, "Usage: ephemtool [-mjd0 mjd] [-mjd1 mjd] [-dt days] module file\n");
+		return 1;
+	}
+	BenchModule mod;
+	if (!BenchLoadModule (module, mod)) return 1;
+	if (!mod.InitInstance) {
+		fprintf (stderr, "EphemTool: %s is not a planet module\n", module);
+		return 1;
+	}
+	const char *name = BenchModuleName (module);
+	CelBody *cb = BenchCreateBody (mod, name);
+
+	bool ok;
+	if (!cb->iface->bEphemeris()) {
+		fprintf (stderr, "EphemTool: %s has no ephemerides\n", module);
+		ok = false;
+	} else {
+		EphemFile ef (fname);
+		ok = ef.Write (cb->iface, mjd0, mjd1, dt);
+	}
+	BenchDeleteBody (mod, cb);
+	BenchUnloadModule (mod);
+	return (ok ? 0 : 1);
+}
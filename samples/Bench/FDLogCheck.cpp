@@ -0,0 +1,347 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// FDLogCheck.cpp
+// Checks of the FlightData log writer:
+// - Round trip: the same segments and samples are logged in text and
+//   binary format, and the binary log converted with
+//   FlightDataLog::Convert must be byte-identical to the text log.
+// - Golden log: all nine graphs of the module sample a vessel, and the
+//   text log and the converted binary log must be byte-identical to
+//   the log of the writer they replaced (FlightData.cpp opcPreStep and
+//   WriteLogHeader, FDGraph.cpp AppendDataPoint(FILE*) and WriteHeader,
+//   kept below as BaseHeader and BaseSample).
+// - A corrupt name length in a binary log must be rejected.
+// - Throughput: samples per second written by the baseline writer,
+//   which opened and closed the log file for every sample, and by
+//   FlightDataLog in both formats.
+// ==============================================================
+
+#include "FDLog.h"
+#include "FDGraph.h"
+#include "Host.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+VESSEL *g_VESSEL = 0; // vessel sampled by the graphs
+
+static char *ReadAll (const char *fname, long &n)
+{
+	FILE *f = fopen (fname, "rb");
+	if (!f) return 0;
+	fseek (f, 0, SEEK_END);
+	n = ftell (f);
+	rewind (f);
+	char *buf = new char[n+1];
+	n = (long)fread (buf, 1, n, f);
+	fclose (f);
+	return buf;
+}
+
+static void WriteLog (const char *fname, bool binary, const char **name, int nseg)
+{
+	FDLogChannel ch[3] = {
+		{"_____ALT", " %8.2f"}, {"AIRSPEED", " %8.2f"}, {"____MACH", " %8.3f"}
+	};
+	double val[3];
+	FlightDataLog log;
+	log.Open (fname, binary, true);
+	for (int s = 0; s < nseg; s++) {
+		log.BeginSegment (name[s], 3, ch);
+		for (int i = 0; i < 500; i++) {
+			val[0] = 0.1*i + s, val[1] = 200.0 + i, val[2] = 0.003*i;
+			while (!log.Push (i*0.5, val)) Sleep (1);
+		}
+		log.EndSegment (name[s]);
+	}
+	log.Close ();
+}
+
+// ==============================================================
+// Baseline writer
+
+static void BaseHeader (const char *fname, bool start, bool reset, const int *dtype, int ngraph)
+{
+	FILE *f = fopen (fname, reset ? "wt":"at");
+	if (reset) {
+		fprintf (f, "Orbiter Flight Data Log Record\n");
+		fprintf (f, "==============================\n");
+		fprintf (f, "Columns:\n");
+		fprintf (f, "\tTIME:     simulation time (seconds)\n");
+		fprintf (f, "\tALT:      altitude (km)\n");
+		fprintf (f, "\tAIRSPEED: airspeed (m/s)\n");
+		fprintf (f, "\tMACH:     Mach number\n");
+		fprintf (f, "\tTEMP:     freestream temperature (K)\n");
+		fprintf (f, "\tSTP:      static pressure (kPa)\n");
+		fprintf (f, "\tDNP:      dynamic pressure (kPa)\n");
+		fprintf (f, "\tAOA:      angle of attack (deg)\n");
+		fprintf (f, "\tSLIP:     horizontal slip angle (deg)\n");
+		fprintf (f, "\tLIFT:     total lift force (kN)\n");
+		fprintf (f, "\tDRAG:     total drag force (kN)\n");
+		fprintf (f, "\tL/D:      lift/drag ratio\n");
+		fprintf (f, "\tMASS:     vessel mass (kg)\n\n");
+	}
+	if (start) {
+		fprintf (f, "# Log started for %s\n", g_VESSEL->GetName());
+		fprintf (f, "# ____TIME");
+		for (int i = 0; i < ngraph; i++) {
+			switch (dtype[i]) {
+			case 0: fprintf (f, " _______ALT"); break;
+			case 1: fprintf (f, " _AIRSPEED"); break;
+			case 2: fprintf (f, " __MACH"); break;
+			case 3: fprintf (f, " ___TEMP"); break;
+			case 4: fprintf (f, " _______STP _______DNP"); break;
+			case 5: fprintf (f, " ____AOA ___SLIP"); break;
+			case 6: fprintf (f, " _____LIFT _____DRAG"); break;
+			case 7: fprintf (f, " _____L/D"); break;
+			case 8: fprintf (f, " ____MASS"); break;
+			}
+		}
+		fprintf (f, "\n");
+	} else {
+		fprintf (f, "# Log stopped for %s\n", g_VESSEL->GetName());
+	}
+	fclose (f);
+}
+
+static void BaseSample (const char *fname, double simt, const int *dtype, int ngraph)
+{
+	double dp;
+	float dp2[2];
+	FILE *f = fopen (fname, "at");
+	fprintf (f, "%10.2f", simt);
+	for (int i = 0; i < ngraph; i++) {
+		switch (dtype[i]) {
+		case 0: // altitude
+			dp = g_VESSEL->GetAltitude() * 0.001;
+			fprintf (f, " %10.4f", dp);
+			break;
+		case 1: // airspeed
+			dp = g_VESSEL->GetAirspeed();
+			fprintf (f, " %9.2f", dp);
+			break;
+		case 2: // Mach number
+			dp = g_VESSEL->GetMachNumber();
+			fprintf (f, " %6.2f", dp);
+			break;
+		case 3: // temperature
+			dp = g_VESSEL->GetAtmTemperature();
+			fprintf (f, " %7.1f", dp);
+			break;
+		case 4: // pressure
+			dp2[0] = (float)(g_VESSEL->GetAtmPressure() * 0.001);
+			dp2[1] = (float)(g_VESSEL->GetDynPressure() * 0.001);
+			fprintf (f, " %10.4f %10.4f", dp2[0], dp2[1]);
+			break;
+		case 5: // AOA
+			dp2[0] = (float)(g_VESSEL->GetAOA()*DEG);
+			dp2[1] = (float)(g_VESSEL->GetSlipAngle()*DEG);
+			fprintf (f, " %7.1f %7.1f", dp2[0], dp2[1]);
+			break;
+		case 6: // lift and drag
+			dp2[0] = (float)(g_VESSEL->GetLift() * 0.001);
+			dp2[1] = (float)(g_VESSEL->GetDrag() * 0.001);
+			fprintf (f, " %9.2f %9.2f", dp2[0], dp2[1]);
+			break;
+		case 7: // L/D
+			dp = (g_VESSEL->GetDrag() ? g_VESSEL->GetLift()/g_VESSEL->GetDrag() : 0.0);
+			fprintf (f, " %8.3f", dp);
+			break;
+		case 8: // Mass
+			dp = g_VESSEL->GetMass();
+			fprintf (f, " %8.0f", dp);
+			break;
+		}
+	}
+	fprintf (f, "\n");
+	fclose (f);
+}
+
+// ==============================================================
+// Golden log and throughput
+
+const int NGRAPH = 9;
+static const int dtype[NGRAPH] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+
+// flight state of sample i, with every column changing, and some
+// samples without drag for the L/D special case
+static void SetState (Vessel *hv, int i)
+{
+	hv->gpos = _V(6.371e6 + 37.1*i, 0, 0);
+	hv->gvel = _V(0, 210.0 + 1.37*i, 0);
+	hv->mach = 0.61 + 0.0029*i;
+	hv->atmtemp = 288.15 - 0.065*i;
+	hv->atmpress = 101325.0*exp (-i/800.0);
+	hv->dynpress = 0.5*1.225*exp (-i/800.0)*(210.0 + 1.37*i)*(210.0 + 1.37*i);
+	hv->aoa = (5.0 - 0.13*i)*RAD;
+	hv->slip = (0.7 - 0.011*i)*RAD;
+	hv->lift = 1e5 + 53.7*i;
+	hv->drag = (i % 7 ? 2e4 + 11.3*i : 0.0);
+	hv->emptymass = 12000.0 - 0.77*i;
+}
+
+// log nseg segments of nsample samples each, sampled by the graphs,
+// with the replacement writer (text if fmt == 0, binary if fmt == 1)
+// or with the baseline writer (fmt < 0)
+static void Log (const char *fname, int fmt, Vessel *hv, int nseg, int nsample)
+{
+	FlightDataGraph *graph[NGRAPH];
+	FDLogChannel ch[FDLOG_MAXCHANNEL];
+	double val[FDLOG_MAXCHANNEL];
+	FlightDataLog log;
+	int g, s, i, n;
+
+	for (g = 0; g < NGRAPH; g++)
+		graph[g] = new FlightDataGraph (dtype[g], dtype[g] >= 4 && dtype[g] <= 6 ? 2 : 1);
+	if (fmt >= 0) log.Open (fname, fmt != 0, true);
+	for (s = 0; s < nseg; s++) {
+		if (fmt < 0) {
+			BaseHeader (fname, true, s == 0, dtype, NGRAPH);
+		} else {
+			for (g = n = 0; g < NGRAPH; g++)
+				n += graph[g]->GetChannels (ch+n);
+			log.BeginSegment (g_VESSEL->GetName(), n, ch);
+		}
+		for (i = 0; i < nsample; i++) {
+			SetState (hv, s*nsample+i);
+			if (fmt < 0) {
+				BaseSample (fname, (s*nsample+i)*0.37, dtype, NGRAPH);
+			} else {
+				for (g = n = 0; g < NGRAPH; g++)
+					n += graph[g]->AppendDataPoint (val+n);
+				while (!log.Push ((s*nsample+i)*0.37, val)) Sleep (0);
+			}
+		}
+		if (fmt < 0) BaseHeader (fname, false, false, dtype, NGRAPH);
+		else         log.EndSegment (g_VESSEL->GetName());
+	}
+	log.Close ();
+	for (g = 0; g < NGRAPH; g++)
+		delete graph[g];
+}
+
+// samples/sec written to file, including the time the writer thread
+// takes to drain the queue. The graphs are left out: they sample the
+// vessel in the same way for both writers.
+static double Throughput (const char *fname, int fmt, Vessel *hv, int nsample)
+{
+	FlightDataGraph *graph[NGRAPH];
+	FDLogChannel ch[FDLOG_MAXCHANNEL];
+	double val[FDLOG_MAXCHANNEL];
+	FlightDataLog log;
+	LARGE_INTEGER fq, t0, t1;
+	int g, i, n;
+
+	// the columns of one sample, for the replacement writer
+	SetState (hv, 0);
+	for (g = n = 0; g < NGRAPH; g++) {
+		graph[g] = new FlightDataGraph (dtype[g], dtype[g] >= 4 && dtype[g] <= 6 ? 2 : 1);
+		graph[g]->GetChannels (ch+n);
+		n += graph[g]->AppendDataPoint (val+n);
+		delete graph[g];
+	}
+
+	QueryPerformanceFrequency (&fq);
+	QueryPerformanceCounter (&t0);
+	if (fmt < 0) {
+		BaseHeader (fname, true, true, dtype, NGRAPH);
+		for (i = 0; i < nsample; i++) {
+			SetState (hv, i);
+			BaseSample (fname, i*0.37, dtype, NGRAPH);
+		}
+		BaseHeader (fname, false, false, dtype, NGRAPH);
+	} else {
+		log.Open (fname, fmt != 0, true);
+		log.BeginSegment (g_VESSEL->GetName(), n, ch);
+		for (i = 0; i < nsample; i++) {
+			SetState (hv, i);
+			val[0] = hv->gpos.x*0.001;
+			while (!log.Push (i*0.37, val)) Sleep (0);
+		}
+		log.EndSegment (g_VESSEL->GetName());
+		log.Close ();
+	}
+	QueryPerformanceCounter (&t1);
+	return (double)nsample*fq.QuadPart/(double)(t1.QuadPart-t0.QuadPart);
+}
+
+static bool Identical (const char *fname1, const char *fname2)
+{
+	long n1, n2;
+	char *b1 = ReadAll (fname1, n1);
+	char *b2 = ReadAll (fname2, n2);
+	bool same = (b1 && b2 && n1 == n2 && !memcmp (b1, b2, n1));
+	if (same) printf ("FDLogCheck: %s identical to %s (%ld bytes)\n", fname2, fname1, n1);
+	else      printf ("FDLogCheck: %s differs from %s (%ld/%ld bytes)\n", fname2, fname1, n1, n2);
+	delete []b1;
+	delete []b2;
+	return same;
+}
+
+int main ()
+{
+	int fail = 0;
+	char longname[400];
+	memset (longname, 'x', 399); longname[399] = '\0';
+	memcpy (longname, "LongName", 8);
+	const char *name[3] = {"GL-01", longname, "SH-02"};
+
+	WriteLog ("fdlog_check.log", false, name, 3);
+	WriteLog ("fdlog_check.bin", true, name, 3);
+	if (!FlightDataLog::Convert ("fdlog_check.bin", "fdlog_check.cnv")) {
+		printf ("FDLogCheck: conversion failed\n");
+		fail++;
+	} else {
+		long n1, n2;
+		char *b1 = ReadAll ("fdlog_check.log", n1);
+		char *b2 = ReadAll ("fdlog_check.cnv", n2);
+		if (!b1 || !b2 || n1 != n2 || memcmp (b1, b2, n1)) {
+			printf ("FDLogCheck: converted log differs from text log (%ld/%ld bytes)\n", n1, n2);
+			fail++;
+		} else
+			printf ("FDLogCheck: converted log identical to text log (%ld bytes)\n", n1);
+		delete []b1;
+		delete []b2;
+	}
+
+	// a name length beyond FDLOG_MAXNAME can't have been written by the
+	// logger: Convert must reject it rather than misread the records
+	FILE *f = fopen ("fdlog_check.bin", "wb");
+	DWORD rec[2] = {1, 300};
+	fwrite ("FDLOGBIN", 1, 8, f);
+	fwrite (rec, sizeof(DWORD), 2, f);
+	fwrite (longname, 1, 300, f);
+	fclose (f);
+	if (FlightDataLog::Convert ("fdlog_check.bin", "fdlog_check.cnv")) {
+		printf ("FDLogCheck: corrupt name length accepted\n");
+		fail++;
+	}
+
+	// golden log of the baseline writer
+	Vessel *hv = new Vessel ("GL-01", "DeltaGlider");
+	g_VESSEL = new VESSEL ((OBJHANDLE)hv, 1);
+	Log ("fdlog_base.log", -1, hv, 2, 300);
+	Log ("fdlog_check.log", 0, hv, 2, 300);
+	Log ("fdlog_check.bin", 1, hv, 2, 300);
+	if (!Identical ("fdlog_base.log", "fdlog_check.log")) fail++;
+	if (!FlightDataLog::Convert ("fdlog_check.bin", "fdlog_check.cnv") ||
+		!Identical ("fdlog_base.log", "fdlog_check.cnv")) fail++;
+
+	// throughput, 12 columns per sample
+	printf ("FDLogCheck: samples/sec, 12 columns\n");
+	printf ("  baseline (open/close per sample): %9.0f\n", Throughput ("fdlog_base.log", -1, hv, 20000));
+	printf ("  text log:                         %9.0f\n", Throughput ("fdlog_check.log", 0, hv, 200000));
+	printf ("  binary log:                       %9.0f\n", Throughput ("fdlog_check.bin", 1, hv, 200000));
+	delete g_VESSEL;
+	delete hv;
+
+	remove ("fdlog_base.log");
+	remove ("fdlog_check.log");
+	remove ("fdlog_check.bin");
+	remove ("fdlog_check.cnv");
+	return fail;
+}
@@ -0,0 +1,398 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Host.cpp
+// Headless stand-in for the Orbiter core: simulation clock, vessel
+// list, module loading, plugin module registration and file I/O
+// functions of the API.
+// ==============================================================
+
+#include "Host.h"
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+static double g_simt = 0.0, g_simdt = 0.0;
+static double g_mjd0 = 51982.0;      // MJD at simulation start
+static LONGLONG g_t0 = 0;            // system time at startup
+static std::vector<Vessel*> g_vessel; // vessel list
+static std::vector<oapi::Module*> g_module; // registered plugin modules
+
+void dummy () {}
+
+// ==============================================================
+// Simulation clock
+
+void BenchSetTime (double simt, double simdt)
+{
+	g_simt = simt;
+	g_simdt = simdt;
+}
+
+DLLEXPORT double oapiGetSimTime () { return g_simt; }
+DLLEXPORT double oapiGetSimStep () { return g_simdt; }
+DLLEXPORT double oapiGetSimMJD () { return g_mjd0 + g_simt/86400.0; }
+
+DLLEXPORT double oapiGetSysTime ()
+{
+	LARGE_INTEGER t;
+	QueryPerformanceCounter (&t);
+	if (!g_t0) g_t0 = t.QuadPart;
+	return (t.QuadPart-g_t0)*1e-9;
+}
+
+// The runner has no time acceleration
+DLLEXPORT double oapiGetSysStep () { return g_simdt; }
+
+// Unlike Orbiter's, the sequence is the same in every run
+DLLEXPORT double oapiRand ()
+{
+	return rand()/(double)RAND_MAX;
+}
+
+DLLEXPORT void oapiWriteLog (char *line)
+{
+	fprintf (stderr, "%s\n", line);
+}
+
+// ==============================================================
+// Aerodynamics helpers
+
+DLLEXPORT double oapiGetInducedDrag (double cl, double A, double e)
+{
+	return cl*cl/(PI*A*e);
+}
+
+DLLEXPORT double oapiGetWaveDrag (double M, double M1, double M2, double M3, double cmax)
+{
+	if (M < M1) return 0.0;
+	if (M < M2) return cmax*(M-M1)/(M2-M1);
+	if (M < M3) return cmax;
+	return cmax*sqrt(M3*M3-1.0)/sqrt(M*M-1.0);
+}
+
+// ==============================================================
+// Vessel list
+
+DLLEXPORT DWORD oapiGetVesselCount ()
+{
+	return (DWORD)g_vessel.size();
+}
+
+DLLEXPORT OBJHANDLE oapiGetVesselByIndex (int index)
+{
+	return (index >= 0 && index < (int)g_vessel.size() ? (OBJHANDLE)g_vessel[index] : 0);
+}
+
+DLLEXPORT OBJHANDLE oapiGetObjectByName (char *name)
+{
+	for (size_t i = 0; i < g_vessel.size(); i++)
+		if (!_stricmp (g_vessel[i]->name, name)) return (OBJHANDLE)g_vessel[i];
+	return 0;
+}
+
+DLLEXPORT OBJHANDLE oapiGetFocusObject ()
+{
+	return (g_vessel.size() ? (OBJHANDLE)g_vessel[0] : 0);
+}
+
+DLLEXPORT VESSEL *oapiGetVesselInterface (OBJHANDLE hVessel)
+{
+	return ((Vessel*)hVessel)->iface;
+}
+
+DLLEXPORT void oapiGetGlobalPos (OBJHANDLE hVessel, VECTOR3 *pos)
+{
+	*pos = ((Vessel*)hVessel)->gpos;
+}
+
+DLLEXPORT void oapiGetGlobalVel (OBJHANDLE hVessel, VECTOR3 *vel)
+{
+	*vel = ((Vessel*)hVessel)->gvel;
+}
+
+DLLEXPORT double oapiGetSize (OBJHANDLE hVessel)
+{
+	return ((Vessel*)hVessel)->size;
+}
+
+// ==============================================================
+// Plugin modules (oapi::Module). Modules stay registered until the
+// process exits; callbacks other than vessel creation/deletion are
+// not issued.
+
+DLLEXPORT void oapiRegisterModule (oapi::Module *module)
+{
+	g_module.push_back (module);
+}
+
+oapi::ModuleNV::ModuleNV (HINSTANCE hDLL) { hModule = hDLL; version = 0; }
+oapi::Module::Module (HINSTANCE hDLL): ModuleNV (hDLL) {}
+oapi::Module::~Module () {}
+void oapi::Module::clbkSimulationStart (RenderMode mode) {}
+void oapi::Module::clbkSimulationEnd () {}
+void oapi::Module::clbkPreStep (double simt, double simdt, double mjd) {}
+void oapi::Module::clbkPostStep (double simt, double simdt, double mjd) {}
+void oapi::Module::clbkFocusChanged (OBJHANDLE new_focus, OBJHANDLE old_focus) {}
+void oapi::Module::clbkTimeAccChanged (double new_warp, double old_warp) {}
+void oapi::Module::clbkDeleteVessel (OBJHANDLE hVessel) {}
+void oapi::Module::clbkPause (bool pause) {}
+
+// ==============================================================
+// Modules
+
+bool BenchLoadModule (const char *path, BenchModule &mod)
+{
+	memset (&mod, 0, sizeof(BenchModule));
+	if (!(mod.hDLL = dlopen (path, RTLD_NOW | RTLD_LOCAL))) {
+		fprintf (stderr, "Bench: %s\n", dlerror());
+		return false;
+	}
+	mod.InitModule = (void(*)(HINSTANCE))dlsym (mod.hDLL, "InitModule");
+	mod.ExitModule = (void(*)(HINSTANCE))dlsym (mod.hDLL, "ExitModule");
+	mod.ovcInit = (VESSEL*(*)(OBJHANDLE,int))dlsym (mod.hDLL, "ovcInit");
+	mod.ovcExit = (void(*)(VESSEL*))dlsym (mod.hDLL, "ovcExit");
+	mod.InitInstance = (CELBODY*(*)(OBJHANDLE))dlsym (mod.hDLL, "InitInstance");
+	mod.ExitInstance = (void(*)(CELBODY*))dlsym (mod.hDLL, "ExitInstance");
+	if (!(mod.ovcInit && mod.ovcExit) && !(mod.InitInstance && mod.ExitInstance)) {
+		fprintf (stderr, "Bench: %s is not a vessel or planet module\n", path);
+		dlclose (mod.hDLL);
+		mod.hDLL = 0;
+		return false;
+	}
+	if (mod.InitModule) mod.InitModule ((HINSTANCE)mod.hDLL);
+	return true;
+}
+
+void BenchUnloadModule (BenchModule &mod)
+{
+	if (!mod.hDLL) return;
+	if (mod.ExitModule) mod.ExitModule ((HINSTANCE)mod.hDLL);
+	// destroy the modules it registered, as Orbiter does
+	for (size_t i = g_module.size(); i-- > 0;)
+		if (g_module[i]->GetModule() == (HINSTANCE)mod.hDLL) {
+			delete g_module[i];
+			g_module.erase (g_module.begin()+i);
+		}
+	dlclose (mod.hDLL);
+	mod.hDLL = 0;
+}
+
+const char *BenchModuleName (const char *path)
+{
+	static char name[64];
+	const char *c = strrchr (path, '/');
+	strncpy (name, c ? c+1 : path, 63); name[63] = '\0';
+	char *e = strchr (name, '.');
+	if (e) *e = '\0';
+	return name;
+}
+
+Vessel *BenchCreateVessel (BenchModule &mod, const char *name, const char *classname)
+{
+	Vessel *v = new Vessel (name, classname);
+	g_vessel.push_back (v);
+	v->iface = mod.ovcInit ((OBJHANDLE)v, 1);
+	VESSEL2 *v2 = (VESSEL2*)v->iface;
+	char cfgname[256];
+	sprintf (cfgname, "Vessels\\%s.cfg", classname);
+	FILEHANDLE cfg = oapiOpenFile (cfgname, FILE_IN, CONFIG);
+	v2->clbkSetClassCaps (cfg);
+	if (cfg) oapiCloseFile (cfg, FILE_IN);
+	v2->clbkPostCreation ();
+	for (size_t i = 0; i < g_module.size(); i++)
+		g_module[i]->clbkNewVessel ((OBJHANDLE)v);
+	return v;
+}
+
+void BenchDeleteVessel (BenchModule &mod, Vessel *v)
+{
+	size_t i;
+	for (i = 0; i < g_module.size(); i++)
+		g_module[i]->clbkDeleteVessel ((OBJHANDLE)v);
+	mod.ovcExit (v->iface);
+	for (i = 0; i < g_vessel.size(); i++)
+		if (g_vessel[i] == v) {
+			g_vessel.erase (g_vessel.begin()+i);
+			break;
+		}
+	delete v;
+}
+
+CelBody *BenchCreateBody (BenchModule &mod, const char *name)
+{
+	CelBody *cb = new CelBody (name);
+	cb->iface = mod.InitInstance ((OBJHANDLE)cb);
+	char cfgname[256];
+	sprintf (cfgname, "%s.cfg", name);
+	FILEHANDLE cfg = oapiOpenFile (cfgname, FILE_IN, CONFIG);
+	cb->iface->clbkInit (cfg);
+	if (cfg) oapiCloseFile (cfg, FILE_IN);
+	return cb;
+}
+
+void BenchDeleteBody (BenchModule &mod, CelBody *cb)
+{
+	mod.ExitInstance (cb->iface);
+	delete cb;
+}
+
+// ==============================================================
+// Configuration and scenario files
+//
+// Files are plain text. Items are read from lines of the form
+// "<item> = <value>" (case-insensitive item names), scenario lines
+// are read up to the terminating "END" line.
+
+struct BenchFile {
+	FILE *f;
+	char line[1024];
+};
+
+static const char *rootdir[] = {"", "Config/", "Scenarios/", "Textures/", "Textures2/", "Meshes/", "Modules/"};
+
+DLLEXPORT FILEHANDLE oapiOpenFile (const char *fname, FileAccessMode mode, PathRoot root)
+{
+	char path[512];
+	const char *base = getenv ("ORBITER_ROOT");
+	int i, n = sprintf (path, "%s%s%s", base ? base : "", base ? "/" : "", rootdir[root]);
+	for (i = 0; fname[i] && n < 511; i++)
+		path[n++] = (fname[i] == '\\' ? '/' : fname[i]);
+	path[n] = '\0';
+	FILE *f = fopen (path, mode == FILE_IN ? "rt" : mode == FILE_OUT ? "wt" : "at");
+	if (!f) return 0;
+	BenchFile *bf = new BenchFile;
+	bf->f = f;
+	return (FILEHANDLE)bf;
+}
+
+DLLEXPORT void oapiCloseFile (FILEHANDLE file, FileAccessMode mode)
+{
+	BenchFile *bf = (BenchFile*)file;
+	if (!bf) return;
+	fclose (bf->f);
+	delete bf;
+}
+
+DLLEXPORT void oapiWriteLine (FILEHANDLE file, char *line)
+{
+	if (file) fprintf (((BenchFile*)file)->f, "%s\n", line);
+}
+
+// Find "item = value" and return a pointer to the value
+static char *FindItem (FILEHANDLE file, const char *item)
+{
+	BenchFile *bf = (BenchFile*)file;
+	if (!bf) return 0;
+	size_t n = strlen (item);
+	rewind (bf->f);
+	while (fgets (bf->line, 1024, bf->f)) {
+		char *c = bf->line, *e;
+		while (isspace (*c)) c++;
+		if (_strnicmp (c, item, n) || (!isspace (c[n]) && c[n] != '=')) continue;
+		for (c += n; isspace (*c); c++);
+		if (*c++ != '=') continue;
+		while (isspace (*c)) c++;
+		for (e = c + strlen (c); e > c && isspace (e[-1]); e--);
+		*e = '\0';
+		return c;
+	}
+	return 0;
+}
+
+DLLEXPORT bool oapiReadItem_string (FILEHANDLE f, char *item, char *string)
+{
+	char *c = FindItem (f, item);
+	if (!c) return false;
+	strcpy (string, c);
+	return true;
+}
+
+DLLEXPORT bool oapiReadItem_float (FILEHANDLE f, char *item, double &d)
+{
+	char *c = FindItem (f, item);
+	return (c && sscanf (c, "%lf", &d) == 1);
+}
+
+DLLEXPORT bool oapiReadItem_int (FILEHANDLE f, char *item, int &i)
+{
+	char *c = FindItem (f, item);
+	return (c && sscanf (c, "%d", &i) == 1);
+}
+
+DLLEXPORT bool oapiReadItem_bool (FILEHANDLE f, char *item, bool &b)
+{
+	char *c = FindItem (f, item);
+	if (!c) return false;
+	if      (!_stricmp (c, "TRUE"))  b = true;
+	else if (!_stricmp (c, "FALSE")) b = false;
+	else return false;
+	return true;
+}
+
+DLLEXPORT bool oapiReadItem_vec (FILEHANDLE f, char *item, VECTOR3 &vec)
+{
+	char *c = FindItem (f, item);
+	return (c && sscanf (c, "%lf%lf%lf", &vec.x, &vec.y, &vec.z) == 3);
+}
+
+DLLEXPORT void oapiWriteItem_string (FILEHANDLE f, char *item, char *string)
+{
+	if (f) fprintf (((BenchFile*)f)->f, "%s = %s\n", item, string);
+}
+
+DLLEXPORT void oapiWriteItem_float (FILEHANDLE f, char *item, double d)
+{
+	if (f) fprintf (((BenchFile*)f)->f, "%s = %g\n", item, d);
+}
+
+DLLEXPORT void oapiWriteItem_int (FILEHANDLE f, char *item, int i)
+{
+	if (f) fprintf (((BenchFile*)f)->f, "%s = %d\n", item, i);
+}
+
+DLLEXPORT void oapiWriteItem_bool (FILEHANDLE f, char *item, bool b)
+{
+	if (f) fprintf (((BenchFile*)f)->f, "%s = %s\n", item, b ? "TRUE" : "FALSE");
+}
+
+DLLEXPORT void oapiWriteItem_vec (FILEHANDLE f, char *item, const VECTOR3 &vec)
+{
+	if (f) fprintf (((BenchFile*)f)->f, "%s = %g %g %g\n", item, vec.x, vec.y, vec.z);
+}
+
+DLLEXPORT void oapiWriteScenario_string (FILEHANDLE scn, char *item, char *string)
+{
+	if (scn) fprintf (((BenchFile*)scn)->f, "  %s %s\n", item, string);
+}
+
+DLLEXPORT void oapiWriteScenario_int (FILEHANDLE scn, char *item, int i)
+{
+	if (scn) fprintf (((BenchFile*)scn)->f, "  %s %d\n", item, i);
+}
+
+DLLEXPORT void oapiWriteScenario_float (FILEHANDLE scn, char *item, double d)
+{
+	if (scn) fprintf (((BenchFile*)scn)->f, "  %s %0.6g\n", item, d);
+}
+
+DLLEXPORT void oapiWriteScenario_vec (FILEHANDLE scn, char *item, const VECTOR3 &vec)
+{
+	if (scn) fprintf (((BenchFile*)scn)->f, "  %s %0.6g %0.6g %0.6g\n", item, vec.x, vec.y, vec.z);
+}
+
+DLLEXPORT bool oapiReadScenario_nextline (FILEHANDLE scn, char *&line)
+{
+	BenchFile *bf = (BenchFile*)scn;
+	if (!bf || !fgets (bf->line, 1024, bf->f)) return false;
+	char *c = bf->line, *e;
+	while (isspace (*c)) c++;
+	for (e = c + strlen (c); e > c && isspace (e[-1]); e--);
+	*e = '\0';
+	if (!_strnicmp (c, "END", 3) && (!c[3] || isspace (c[3]))) return false;
+	line = c;
+	return true;
+}
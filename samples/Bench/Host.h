@@ -0,0 +1,175 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Host.h
+// Headless stand-in for the subset of the Orbiter core used by the
+// sample modules: vessel bookkeeping (propellant resources,
+// thrusters and thruster groups, animations, meshes, airfoils,
+// attachment points), simulation time, celestial body modules,
+// plugin modules registered with oapiRegisterModule,
+// configuration/scenario file I/O, and the cockpit and visual
+// interfaces (panels, MFDs, HUD, surfaces, in-memory meshes).
+//
+// Vessel and planet modules are built as shared objects and loaded at
+// runtime, as orbiter.exe loads module DLLs. The stand-in implements
+// the VESSEL interface on top of the Vessel class declared here, and
+// the CELBODY base classes for bodies of class CelBody.
+// ==============================================================
+
+#ifndef __BENCH_HOST_H
+#define __BENCH_HOST_H
+
+#include "Orbitersdk.h"
+#include <stdio.h>
+#include <vector>
+
+// ==============================================================
+// Vessel state bookkeeping
+
+struct BenchPropellant {
+	double maxmass, mass, efficiency;
+};
+
+struct BenchThruster {
+	VECTOR3 pos, dir;
+	double max0, isp0, level;
+	BenchPropellant *ph;
+};
+
+struct BenchThGroup {
+	THGROUP_TYPE type;
+	std::vector<BenchThruster*> th;
+};
+
+struct BenchAnimComp {
+	double state0, state1;
+	MGROUP_TRANSFORM *trans;
+	BenchAnimComp *parent;
+};
+
+struct BenchAnimation {
+	double state, defstate;
+	std::vector<BenchAnimComp*> comp;
+};
+
+struct BenchAttachment {
+	bool toparent;
+	VECTOR3 pos, dir, rot;
+	char id[9];
+};
+
+struct BenchAirfoil {
+	AIRFOIL_ORIENTATION align;
+	AirfoilCoeffFunc cf0;         // CreateAirfoil (no vessel or context)
+	AirfoilCoeffFuncEx cf;        // CreateAirfoil3
+	void *context;
+	double c, S, A;
+};
+
+struct BenchCtrlSurf {
+	AIRCTRL_TYPE type;
+	double area, dCl;
+	UINT anim;
+};
+
+class Vessel {
+public:
+	Vessel (const char *_name, const char *_classname);
+	~Vessel ();
+
+	// Advance the state by dt: thrust, propellant consumption and
+	// aerodynamic coefficients of all airfoils at the given flow state
+	void Step (double dt, double aoa, double M);
+
+	double Mass () const;
+
+	char name[64], classname[64];
+	double size, emptymass;
+	VECTOR3 pmi, cs, rotdrag, camofs;
+	VECTOR3 gpos, gvel;           // global position and velocity
+	double aoa, mach;             // flow state of the last step
+	double slip, atmtemp, atmpress, dynpress, lift, drag; // set by the checks, 0 in vacuum
+	int attmode;                  // RCS mode
+	DWORD adcmode;                // aerodynamic control surface mode
+	DWORD navmode;                // active navmodes (bit n: navmode n)
+	double ctrllevel[6];          // control surface levels, by AIRCTRL_TYPE
+	double wbrake[2];             // left and right wheel brake levels
+	VESSEL *iface;                // module interface returned by ovcInit
+
+	std::vector<BenchPropellant*> prop;
+	std::vector<BenchThruster*> thr;
+	std::vector<BenchThGroup*> thg;
+	std::vector<BenchAnimation*> anim;
+	std::vector<BenchAirfoil*> airfoil;
+	std::vector<BenchCtrlSurf*> ctrlsurf;
+	std::vector<BenchAttachment*> attach;
+	std::vector<char*> mesh;        // mesh file names ("" for meshes added by handle)
+	std::vector<LightEmitter*> light;
+};
+
+// ==============================================================
+// Celestial bodies
+
+class CelBody {
+public:
+	CelBody (const char *_name);
+
+	char name[64];
+	CELBODY *iface;               // module interface returned by InitInstance
+};
+
+// ==============================================================
+// Vessel and planet modules
+
+struct BenchModule {
+	void *hDLL;
+	void (*InitModule)(HINSTANCE);
+	void (*ExitModule)(HINSTANCE);
+	VESSEL *(*ovcInit)(OBJHANDLE, int);
+	void (*ovcExit)(VESSEL*);
+	CELBODY *(*InitInstance)(OBJHANDLE);
+	void (*ExitInstance)(CELBODY*);
+};
+
+// Load a vessel or planet module (shared object) and call its
+// InitModule. Returns false and prints the reason if the module can't
+// be loaded.
+bool BenchLoadModule (const char *path, BenchModule &mod);
+
+// Call ExitModule, destroy the modules it registered with
+// oapiRegisterModule and unload the module
+void BenchUnloadModule (BenchModule &mod);
+
+// Module file name without path and extension (static buffer)
+const char *BenchModuleName (const char *path);
+
+// Create a vessel, create its module interface and set its class caps.
+// Registered plugin modules are notified with clbkNewVessel.
+Vessel *BenchCreateVessel (BenchModule &mod, const char *name, const char *classname);
+
+// Notify registered plugin modules with clbkDeleteVessel, delete the
+// module interface and the vessel
+void BenchDeleteVessel (BenchModule &mod, Vessel *v);
+
+// Create a celestial body, create its module interface and initialise
+// it from Config\<name>.cfg (if present)
+CelBody *BenchCreateBody (BenchModule &mod, const char *name);
+
+// Delete the module interface and the body
+void BenchDeleteBody (BenchModule &mod, CelBody *cb);
+
+// ==============================================================
+// Simulation clock
+
+void BenchSetTime (double simt, double simdt);
+
+// ==============================================================
+// Meshes
+
+// Number of meshes created with oapiCreateMesh so far
+DWORD BenchMeshCount ();
+
+#endif // !__BENCH_HOST_H
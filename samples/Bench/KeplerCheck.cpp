@@ -0,0 +1,175 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// KeplerCheck.cpp
+// Checks and throughput benchmark of the two-body library:
+// - Vallado, Fundamentals of Astrodynamics, example 2-4 (Kepler
+//   problem) and example 2-5 (elements from state vectors)
+// - Kepler equation residuals for e up to 0.9999 and hyperbolic e
+// - elements -> state -> elements round trips, elliptic and
+//   hyperbolic
+// - KeplerBatch against El2State, and the throughput of both in
+//   propagations (objects x epochs) per second
+//
+// Usage: keplercheck [-n objects] [-m epochs]
+// ==============================================================
+
+#include "Kepler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int fail = 0;
+
+static void Check (const char *what, double err, double tol)
+{
+	printf ("  %-44s %10.3g (limit %0.0e)%s\n", what, err, tol, err <= tol ? "" : "  FAILED");
+	if (!(err <= tol)) fail++;
+}
+
+// Vallado's right-handed equatorial (I, J, K) to Orbiter's frame
+static VECTOR3 IJK (double i, double j, double k) { return _V(i, k, j); }
+
+// Difference of two angles, in -Pi ... Pi
+static double AngDiff (double a, double b)
+{
+	double d = fmod (a-b, PI2);
+	if (d > PI) d -= PI2; else if (d < -PI) d += PI2;
+	return d;
+}
+
+static double Rand (DWORD &seed, double a, double b)
+{
+	seed = seed*1664525 + 1013904223;
+	return a + (b-a)*(seed >> 8)/16777216.0;
+}
+
+int main (int argc, char *argv[])
+{
+	const double mu_earth = 3.986004418e14;
+	int i, k, nobj = 1000, nep = 100;
+	DWORD seed = 12345;
+
+	for (i = 1; i < argc; i++) {
+		if      (!strcmp (argv[i], "-n") && i+1 < argc) nobj = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-m") && i+1 < argc) nep = atoi (argv[++i]);
+	}
+	if (nobj < 1 || nep < 1) {
+		fprintf (stderr, "Usage: keplercheck [-n objects] [-m epochs]\n");
+		return 1;
+	}
+	printf ("KeplerCheck:\n");
+
+	// Vallado example 2-4: propagate by 40 minutes
+	ELEMENTS el;
+	VECTOR3 pos, vel;
+	State2El (IJK (1131.340e3, -2282.343e3, 6672.423e3), IJK (-5.64305e3, 4.30333e3, 2.42879e3), mu_earth, el);
+	El2State (el, mu_earth, 2400.0, pos, vel);
+	VECTOR3 rref = IJK (-4219.7527e3, 4363.0292e3, -3958.7666e3);
+	VECTOR3 vref = IJK (3.689866e3, -1.916735e3, -6.112511e3);
+	Check ("Vallado 2-4 position (rel.)", length (pos-rref)/length (rref), 1e-7);
+	Check ("Vallado 2-4 velocity (rel.)", length (vel-vref)/length (vref), 1e-6);
+
+	// Vallado example 2-5: elements of a state vector
+	ORBITPARAM prm;
+	State2El (IJK (6524.834e3, 6862.875e3, 6448.296e3), IJK (4.901327e3, 5.533756e3, -1.976341e3), mu_earth, el, &prm);
+	Check ("Vallado 2-5 semi-major axis (rel.)", fabs (el.a/36127.343e3 - 1.0), 1e-6);
+	Check ("Vallado 2-5 eccentricity", fabs (el.e - 0.832853), 1e-6);
+	double eang = fabs (el.i - 87.870*RAD);
+	eang = max (eang, fabs (AngDiff (el.theta, 227.898*RAD)));
+	eang = max (eang, fabs (AngDiff (el.omegab, (227.898+53.38)*RAD)));
+	eang = max (eang, fabs (AngDiff (prm.TrA, 92.335*RAD)));
+	Check ("Vallado 2-5 i, theta, omegab, TrA [deg]", eang*DEG, 0.006);
+
+	// Kepler equation residuals
+	static const double ecc[] = {0.0, 0.1, 0.5, 0.9, 0.99, 0.9999};
+	double res = 0.0;
+	for (k = 0; k < (int)(sizeof(ecc)/sizeof(ecc[0])); k++)
+		for (i = -2000; i <= 2000; i++) {
+			double M = i*0.01, E = EccAnomaly (M, ecc[k]);
+			res = max (res, fabs (E - ecc[k]*sin (E) - M));
+		}
+	Check ("Kepler equation residual, e < 1", res, 1e-12);
+	static const double hec[] = {1.0001, 1.01, 1.5, 3.0, 100.0};
+	res = 0.0;
+	for (k = 0; k < (int)(sizeof(hec)/sizeof(hec[0])); k++)
+		for (i = -2000; i <= 2000; i++) {
+			double M = i*i*i*1e-6, H = HypAnomaly (M, hec[k]);
+			res = max (res, fabs (hec[k]*sinh (H) - H - M)/max (1.0, fabs (M)));
+		}
+	Check ("Kepler equation residual, e > 1 (rel.)", res, 1e-12);
+
+	// round trips
+	double ea = 0.0, ee = 0.0, eL = 0.0, er = 0.0;
+	for (i = 0; i < 10000; i++) {
+		ELEMENTS e0, e1;
+		bool hyp = (i & 1) != 0;
+		e0.e = (hyp ? Rand (seed, 1.05, 5.0) : Rand (seed, 0.001, 0.97));
+		e0.a = (hyp ? -1.0 : 1.0)*Rand (seed, 7e6, 5e7);
+		e0.i = Rand (seed, 0.01, PI-0.01);
+		e0.theta = Rand (seed, 0.0, PI2);
+		e0.omegab = Rand (seed, 0.0, PI2);
+		e0.L = (hyp ? e0.omegab + Rand (seed, -5.0, 5.0) : Rand (seed, 0.0, PI2));
+		El2State (e0, mu_earth, 0.0, pos, vel);
+		State2El (pos, vel, mu_earth, e1);
+		ea = max (ea, fabs (e1.a/e0.a - 1.0));
+		ee = max (ee, fabs (e1.e - e0.e));
+		double dang = max (fabs (e1.i - e0.i), fabs (AngDiff (e1.theta, e0.theta)));
+		dang = max (dang, fabs (AngDiff (e1.omegab, e0.omegab)));
+		eL = max (eL, max (dang, fabs (hyp ? e1.L - e0.L : AngDiff (e1.L, e0.L))));
+		VECTOR3 p1, v1;
+		El2State (e1, mu_earth, 0.0, p1, v1);
+		er = max (er, length (p1-pos)/length (pos));
+	}
+	Check ("round trip a (rel.)", ea, 1e-10);
+	Check ("round trip e", ee, 1e-10);
+	Check ("round trip angles [rad]", eL, 1e-8);
+	Check ("round trip position (rel.)", er, 1e-10);
+
+	// batch against scalar propagation, and throughput
+	KeplerBatch kb (nobj);
+	ELEMENTS *els = new ELEMENTS[nobj];
+	double *mjd = new double[nep];
+	double *buf = new double[6*nobj*nep];
+	double *x = buf, *y = x + nobj*nep, *z = y + nobj*nep;
+	double *vx = z + nobj*nep, *vy = vx + nobj*nep, *vz = vy + nobj*nep;
+	for (i = 0; i < nobj; i++) {
+		els[i].a = Rand (seed, 6.6e6, 4.5e7);
+		els[i].e = Rand (seed, 0.0, 0.9);
+		els[i].i = Rand (seed, 0.0, PI);
+		els[i].theta = Rand (seed, 0.0, PI2);
+		els[i].omegab = Rand (seed, 0.0, PI2);
+		els[i].L = Rand (seed, 0.0, PI2);
+		kb.Add (els[i], mu_earth, 51544.5);
+	}
+	for (k = 0; k < nep; k++) mjd[k] = 51544.5 + k*0.37;
+
+	LARGE_INTEGER f, t0, t1, t2;
+	QueryPerformanceFrequency (&f);
+	QueryPerformanceCounter (&t0);
+	kb.Propagate (mjd, nep, x, y, z, vx, vy, vz);
+	QueryPerformanceCounter (&t1);
+	double dmax = 0.0;
+	for (k = 0; k < nep; k++)
+		for (i = 0; i < nobj; i++) {
+			El2State (els[i], mu_earth, (mjd[k]-51544.5)*86400.0, pos, vel);
+			int ofs = k*nobj + i;
+			VECTOR3 pb = _V(x[ofs], y[ofs], z[ofs]);
+			dmax = max (dmax, length (pb-pos)/length (pos));
+		}
+	QueryPerformanceCounter (&t2);
+	Check ("KeplerBatch vs El2State position (rel.)", dmax, 1e-9);
+
+	double np = (double)nobj*nep;
+	printf ("  %d objects x %d epochs: KeplerBatch %0.3g/s, El2State %0.3g/s\n", nobj, nep,
+		np*f.QuadPart/(t1.QuadPart-t0.QuadPart), np*f.QuadPart/(t2.QuadPart-t1.QuadPart));
+
+	delete []els;
+	delete []mjd;
+	delete []buf;
+	if (fail) printf ("KeplerCheck: FAILED\n");
+	return fail;
+}
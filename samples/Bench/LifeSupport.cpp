@@ -0,0 +1,211 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// LifeSupport.cpp
+// Soak test of the Dragonfly life support under time acceleration:
+// the network of ShipInternal::Init from the cryo O2 tanks to the
+// cabin (O2 tanks 0-2, manifold 0, regulators and boiler, CO2 tank
+// 12, fan room 16 with both fans, manifold 3, cabin O2 room 10) and
+// the crew breathing in it, stepped as ShipInternal::Refresh does.
+// The fuel cells are replaced by a battery that does not run down.
+// For each warp factor, at 10 frames per second (the slower the
+// frame rate, the longer the frames at a given warp), reports
+// - the sub-steps per frame and the time per simulated day
+// - the gas mass error: the network is closed, so the mass in all
+//   tanks must stay the same
+// - the heat (mass x specific heat x temperature) of all tanks and
+//   the cabin pressure, against the same run at 1x
+// - frames with a negative or undefined pressure or mass
+// The explicit integrator is run for comparison only. The check fails
+// if the sub-stepped one goes unstable, loses mass, takes more than
+// H_MAXSUBSTEPS sub-steps in a frame (beyond that, the steps are only
+// limited by flux), or drifts from 1x by more than 1% beyond the drift
+// at 10x: the model depends on the frame length a little even where one
+// step per frame is stable (the fans switch per step, valves see their
+// source's pressure of the last step), and sub-stepping cannot take
+// that out.
+//
+// Usage: lifesupport [-d days] [-f frame] [-w maxwarp]
+// ==============================================================
+
+#include "Host.h"
+#include "esystems.h"
+#include <stdlib.h>
+#include <math.h>
+
+struct LifeSupport {
+	H_system H;
+	E_system E;
+	Tank *Tanks[17];
+	Manifold *Man[4];
+	Valve *Valves[24];
+	Fan *Fans[2];
+
+	LifeSupport (int mode);
+	void Refresh (double dt, int &n);
+	double Mass ();
+	double Heat ();
+	bool Sane ();
+};
+
+LifeSupport::LifeSupport (int mode)
+{
+	memset (Tanks, 0, sizeof(Tanks));
+	// cryo O2, as in ShipInternal::Init
+	for (int i = 0; i < 3; i++) {
+		H.AddSystem (Tanks[i] = new Tank (_vector3(0,0,0), 4));
+		Tanks[i]->FillTank (O2_SPECIFICC, 130000, 170, O2_MMASS, 0, 600, 150);
+	}
+	H.AddSystem (Man[0] = new Manifold (Tanks[0], Tanks[1], Tanks[2], 150));
+
+	// power: a battery for the fuel cells, the main bus and the fan bus
+	Battery *bt;
+	DCbus *dc0, *dc3;
+	E.AddSystem (bt = new Battery (0, 1e15));
+	E.AddSystem (dc0 = new DCbus (bt));
+	E.AddSystem (dc3 = new DCbus (dc0));
+
+	H.AddSystem (Valves[13] = new PValve (1, 5, 290.0, 280.0, 120, &Man[0]->OV[2]));
+	H.AddSystem (Valves[22] = new Boiler (1, 5, 120, Valves[13], 295.0, O2_BOILING, dc0));
+	H.AddSystem (Valves[23] = new PValve (1, 5, 23.0, 20.0, 120, Valves[22]));
+
+	H.AddSystem (Tanks[12] = new Tank (_vector3(0,0,0), 30));
+	Tanks[12]->FillTank (5, 4800, 295, CO2_MMASS, 0, 600, 150);
+	H.AddSystem (Tanks[16] = new Room (_vector3(0,0,0), 5, Tanks[12]));
+	Tanks[16]->FillTank (5, 2100, 295, CO2_MMASS, 2, 600, 150);
+	H.AddSystem (Man[3] = new Manifold (Valves[23], Tanks[16], Tanks[16], 150));
+	Man[3]->X[2].open = 0; Man[3]->X[1].open = 1; Man[3]->X[0].open = 1;
+	Man[3]->OV[2].open = 0; Man[3]->OV[1].open = 0; Man[3]->OV[0].open = 1;
+	H.AddSystem (Tanks[10] = new Room (_vector3(0,0,0), 30, &Man[3]->OV[0]));
+	Tanks[10]->FillTank (O2_SPECIFICC, 9100, 295, O2_MMASS, 0, 600, 150);
+
+	E.AddSystem (Fans[0] = new Fan (Tanks[12], Tanks[16], -20.0, 7, dc3));
+	E.AddSystem (Fans[1] = new Fan (Tanks[12], Tanks[16], -20.0, 7, dc3));
+	Fans[0]->start_handle = Fans[1]->start_handle = 1; // switched on at the panel
+	dc0->PLOAD (70);
+
+	// CrossValve leaves its cross-feed flows uninitialised
+	for (int k = 0; k < 3; k++) {
+		memset (&Man[0]->OV[k].f1, 0, 6*sizeof(double));
+		memset (&Man[3]->OV[k].f1, 0, 6*sizeof(double));
+	}
+	H.SetIntegrator (mode);
+}
+
+// As ShipInternal::Refresh. Returns the number of sub-steps in n
+void LifeSupport::Refresh (double dt, int &n)
+{
+	n = H.SubSteps (dt, E.Rate());
+	double h = dt/n;
+	for (int i = 0; i < n; i++) {
+		H.Step (h);
+		E.Step (h);
+		float Lungs = Tanks[10]->Flow (0.075, h);
+		Tanks[12]->PutMass (Lungs*h, Tanks[10]->Temp);
+	}
+	E.Refresh (dt, 0);
+}
+
+double LifeSupport::Mass ()
+{
+	double m = 0.0;
+	for (int i = 0; i < 17; i++)
+		if (Tanks[i]) m += Tanks[i]->mass;
+	return m;
+}
+
+double LifeSupport::Heat ()
+{
+	double q = 0.0;
+	for (int i = 0; i < 17; i++)
+		if (Tanks[i]) q += Tanks[i]->mass*Tanks[i]->c*Tanks[i]->Temp;
+	return q;
+}
+
+bool LifeSupport::Sane ()
+{
+	for (int i = 0; i < 17; i++)
+		if (Tanks[i] && !(Tanks[i]->Press >= 0 && Tanks[i]->mass >= 0 && Tanks[i]->Temp > 0)) return false;
+	return true;
+}
+
+struct Result {
+	double mass, heat, press;  // at the end
+	double pmin, pmax;         // cabin pressure range
+	double merr;               // max. rel. mass error
+	int nbad, nframe, maxsub;
+	double nsub, tday, tframe; // sub-steps per frame, wall clock s per day and per frame
+};
+
+static Result Run (int mode, double warp, double frame, double days)
+{
+	LifeSupport ls (mode);
+	Result r;
+	memset (&r, 0, sizeof(r));
+	double m0 = ls.Mass(), dt = frame*warp, simt = 0.0, tend = days*86400.0;
+	r.pmin = 1e10;
+	LARGE_INTEGER freq, t0, t1;
+	QueryPerformanceFrequency (&freq);
+	QueryPerformanceCounter (&t0);
+	for (; simt < tend; simt += dt) {
+		int n;
+		ls.Refresh (dt, n);
+		r.nframe++;
+		r.nsub += n;
+		if (n > r.maxsub) r.maxsub = n;
+		if (!ls.Sane()) r.nbad++;
+		double p = ls.Tanks[10]->Press, e = fabs (ls.Mass()/m0 - 1.0);
+		if (p < r.pmin) r.pmin = p;
+		if (p > r.pmax) r.pmax = p;
+		if (!(e <= r.merr)) r.merr = e; // also catches NaN
+	}
+	QueryPerformanceCounter (&t1);
+	r.nsub /= r.nframe;
+	r.tday = (t1.QuadPart-t0.QuadPart)/(double)freq.QuadPart/days;
+	r.tframe = r.tday*days/r.nframe;
+	r.mass = ls.Mass();
+	r.heat = ls.Heat();
+	r.press = ls.Tanks[10]->Press;
+	return r;
+}
+
+static void Print (const char *name, double warp, const Result &r, const Result &ref)
+{
+	printf ("  %-11s %6gx %7d frames %6.1f/%-4d sub-steps %6.3f s/day %6.1f us/frame  mass %7.2g  heat %7.2g  cabin %5.2f kPa (%5.2f-%5.2f) %7.2g  %d bad\n",
+		name, warp, r.nframe, r.nsub, r.maxsub, r.tday, r.tframe*1e6, r.merr, fabs (r.heat/ref.heat - 1.0),
+		r.press, r.pmin, r.pmax, fabs (r.press/ref.press - 1.0), r.nbad);
+}
+
+int main (int argc, char *argv[])
+{
+	int i, fail = 0;
+	double days = 2.0, frame = 0.1, maxwarp = 10000.0;
+
+	for (i = 1; i < argc; i++) {
+		if      (!strcmp (argv[i], "-d") && i+1 < argc) days = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-f") && i+1 < argc) frame = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-w") && i+1 < argc) maxwarp = atof (argv[++i]);
+	}
+	if (days <= 0.0 || frame <= 0.0 || maxwarp < 1.0) {
+		fprintf (stderr, "Usage: lifesupport [-d days] [-f frame] [-w maxwarp]\n");
+		return 1;
+	}
+	printf ("LifeSupport: %g days, %g s frames; mass: max. rel. error, heat and cabin: rel. to 1x\n", days, frame);
+	Result ref = Run (H_SUBSTEP, 1.0, frame, days);
+	Print ("sub-stepped", 1.0, ref, ref);
+	if (ref.nbad || ref.merr > 1e-6) fail++;
+	double tol_p = 0.01, tol_q = 0.01;
+	for (double warp = 10.0; warp <= maxwarp; warp *= 10.0) {
+		Result r = Run (H_SUBSTEP, warp, frame, days);
+		Print ("sub-stepped", warp, r, ref);
+		double dp = fabs (r.press/ref.press - 1.0), dq = fabs (r.heat/ref.heat - 1.0);
+		if (warp == 10.0) tol_p += dp, tol_q += dq;
+		if (r.nbad || r.merr > 1e-6 || r.maxsub > H_MAXSUBSTEPS || dp > tol_p || dq > tol_q) fail++;
+		Print ("explicit", warp, Run (H_EXPLICIT, warp, frame, days), ref);
+	}
+	if (fail) printf ("LifeSupport: FAILED\n");
+	return fail;
+}
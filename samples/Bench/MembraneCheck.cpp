@@ -0,0 +1,303 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// MembraneCheck.cpp
+// Check and benchmark of the SolarSail membrane solver (Membrane) on
+// synthetic sail segments: a square grid of nodes in the first
+// quadrant, fixed along both axes as the SolarSail segments are, with
+// a front and a back side. The SolarSail mesh itself is not in the
+// tree, so the reference segment size is a parameter.
+// - every step of the solver is compared with a scalar reference that
+//   evaluates every mesh edge as a spring, from the same state: the
+//   nodal forces must agree to float rounding of the sum of the
+//   pressure and spring terms of each node (the terms largely cancel,
+//   and their order differs), and so must the smooth normals. Fixed
+//   nodes must stay in place and the back side must follow the front
+//   side. The grid is run with
+//   its nodes in row order (most springs in SSE blocks) and shuffled
+//   (all springs through the scalar loop)
+// - reports the time per step of the full sail (four segments) at the
+//   reference size and at 10x, on the calling thread and on the worker
+//   pool (MembraneSolver/MembranePool, from Submit until the step can
+//   be published), the best of five runs. The check fails if the full
+//   sail at 10x does not fit the frame budget on the calling thread
+//
+// Usage: membranecheck [-n nodes] [-s steps] [-b budget_ms]
+// ==============================================================
+
+#include "Host.h"
+#include "../Solarsail/Membrane.h"
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <set>
+
+static const float ELAST  = 1e-1f; // as in Membrane.cpp
+static const float PSCALE = 1e3f;
+
+static DWORD seed = 4711;
+
+static double Rand (double a, double b)
+{
+	seed = seed*1664525 + 1013904223;
+	return a + (b-a)*(seed >> 8)/16777216.0;
+}
+
+// A segment of m x m nodes, spacing h, front side followed by the back
+// side. shuffle: number the nodes in random order
+static MESHGROUP Segment (int m, float h, bool shuffle)
+{
+	DWORD i, n = m*m, ntri = 2*(m-1)*(m-1);
+	std::vector<DWORD> id(n);
+	for (i = 0; i < n; i++) id[i] = i;
+	if (shuffle)
+		for (i = n-1; i > 0; i--) {
+			DWORD j = (DWORD)Rand (0.0, i+0.999);
+			DWORD t = id[i]; id[i] = id[j]; id[j] = t;
+		}
+
+	MESHGROUP g;
+	memset (&g, 0, sizeof(g));
+	g.nVtx = 2*n;
+	g.nIdx = 2*ntri*3;
+	g.Vtx = new NTVERTEX[g.nVtx];
+	g.Idx = new WORD[g.nIdx];
+	memset (g.Vtx, 0, g.nVtx*sizeof(NTVERTEX));
+	for (int r = 0; r < m; r++)
+		for (int c = 0; c < m; c++) {
+			NTVERTEX *vf = g.Vtx+id[r*m+c], *vb = vf+n;
+			vf->x = vb->x = c*h;
+			vf->y = vb->y = r*h;
+			vf->nz = 1.0f, vb->nz = -1.0f;
+		}
+	WORD *f = g.Idx, *b = g.Idx+ntri*3;
+	for (int r = 0; r < m-1; r++)
+		for (int c = 0; c < m-1; c++) {
+			WORD n00 = (WORD)id[r*m+c], n01 = (WORD)id[r*m+c+1];
+			WORD n10 = (WORD)id[(r+1)*m+c], n11 = (WORD)id[(r+1)*m+c+1];
+			*f++ = n00, *f++ = n01, *f++ = n11;
+			*f++ = n00, *f++ = n11, *f++ = n10;
+			*b++ = (WORD)(n00+n), *b++ = (WORD)(n11+n), *b++ = (WORD)(n01+n);
+			*b++ = (WORD)(n00+n), *b++ = (WORD)(n10+n), *b++ = (WORD)(n11+n);
+		}
+	return g;
+}
+
+static void FreeSegment (MESHGROUP &g)
+{
+	delete []g.Vtx;
+	delete []g.Idx;
+}
+
+// Scalar reference: one relaxation step as Membrane::Update, with every
+// edge of the front side triangles evaluated as a spring
+struct RefMembrane {
+	DWORD nvtx;
+	std::vector<DWORD> a, b;
+	std::vector<float> k, d0sq;
+	std::vector<bool> fix;
+
+	RefMembrane (const MESHGROUP &g)
+	{
+		nvtx = g.nVtx/2;
+		std::set<std::pair<DWORD,DWORD> > edges;
+		for (DWORD i = 0; i < g.nIdx/2; i += 3)
+			for (DWORD j = 0; j < 3; j++) {
+				DWORD n1 = g.Idx[i+j], n2 = g.Idx[i+(j+1)%3];
+				edges.insert (std::make_pair (min (n1, n2), max (n1, n2)));
+			}
+		for (std::set<std::pair<DWORD,DWORD> >::iterator e = edges.begin(); e != edges.end(); e++) {
+			const NTVERTEX *v1 = g.Vtx+e->first, *v2 = g.Vtx+e->second;
+			float dx = v2->x-v1->x, dy = v2->y-v1->y, dz = v2->z-v1->z;
+			a.push_back (e->first);
+			b.push_back (e->second);
+			d0sq.push_back (dx*dx + dy*dy + dz*dz);
+			k.push_back (ELAST/(float)sqrt (d0sq.back()));
+		}
+		for (DWORD i = 0; i < nvtx; i++)
+			fix.push_back (g.Vtx[i].x == 0 || g.Vtx[i].y == 0);
+	}
+
+	// smooth normals of the front side nodes: the average of the unit
+	// normals of the triangles sharing a node
+	void Normals (const NTVERTEX *vtx, const WORD *idx, DWORD ntri, std::vector<float> &nml) const
+	{
+		std::vector<int> nsd(nvtx, 0);
+		nml.assign (nvtx*3, 0.0f);
+		for (DWORD i = 0; i < ntri*3; i += 3) {
+			const NTVERTEX *v0 = vtx+idx[i], *v1 = vtx+idx[i+1], *v2 = vtx+idx[i+2];
+			float dx1 = v1->x-v0->x, dx2 = v2->x-v0->x;
+			float dy1 = v1->y-v0->y, dy2 = v2->y-v0->y;
+			float dz1 = v1->z-v0->z, dz2 = v2->z-v0->z;
+			float c[3] = {dy1*dz2 - dy2*dz1, dz1*dx2 - dz2*dx1, dx1*dy2 - dx2*dy1};
+			float len = (float)sqrt (c[0]*c[0] + c[1]*c[1] + c[2]*c[2]);
+			for (int j = 0; j < 3; j++) {
+				for (int k = 0; k < 3; k++) nml[idx[i+j]*3+k] += (len ? c[k]/len : 0.0f);
+				nsd[idx[i+j]]++;
+			}
+		}
+		for (DWORD i = 0; i < nvtx; i++)
+			if (nsd[i] > 1) for (int k = 0; k < 3; k++) nml[i*3+k] /= nsd[i];
+	}
+
+	// force on the front side nodes for one step from vtx (the
+	// displacement of the free nodes), and the sum of the magnitudes of
+	// its terms
+	void Displacement (const NTVERTEX *vtx, const VECTOR3 &mflux, std::vector<float> &d, std::vector<double> &mag) const
+	{
+		d.assign (nvtx*3, 0.0f);
+		mag.assign (nvtx*3, 0.0);
+		for (DWORD i = 0; i < nvtx; i++) {
+			const NTVERTEX *v = vtx+i;
+			float n2 = v->nx*v->nx + v->ny*v->ny + v->nz*v->nz;
+			float p = (n2 ? ((float)mflux.x*v->nx + (float)mflux.y*v->ny + (float)mflux.z*v->nz)*PSCALE/n2 : 0.0f);
+			d[i*3] = v->nx*p, d[i*3+1] = v->ny*p, d[i*3+2] = v->nz*p;
+			for (int j = 0; j < 3; j++) mag[i*3+j] = fabs (d[i*3+j]);
+		}
+		for (size_t s = 0; s < a.size(); s++) {
+			const NTVERTEX *va = vtx+a[s], *vb = vtx+b[s];
+			float dx = vb->x-va->x, dy = vb->y-va->y, dz = vb->z-va->z;
+			if (dx*dx + dy*dy + dz*dz > d0sq[s]) {
+				d[a[s]*3] += dx*k[s], d[a[s]*3+1] += dy*k[s], d[a[s]*3+2] += dz*k[s];
+				d[b[s]*3] -= dx*k[s], d[b[s]*3+1] -= dy*k[s], d[b[s]*3+2] -= dz*k[s];
+				float t[3] = {fabs (dx*k[s]), fabs (dy*k[s]), fabs (dz*k[s])};
+				for (int j = 0; j < 3; j++) mag[a[s]*3+j] += t[j], mag[b[s]*3+j] += t[j];
+			}
+		}
+	}
+};
+
+// Run nstep steps of one segment, each compared with the reference from
+// the same state. Returns the largest force error relative to the sum of
+// the magnitudes of its terms
+static double Compare (int m, bool shuffle, int nstep, const VECTOR3 &mflux)
+{
+	MESHGROUP g = Segment (m, 10.0f, shuffle);
+	Membrane mb (&g);
+	RefMembrane ref (g);
+	MembraneWork wk (mb.nVtx());
+	DWORD i, n = mb.nVtx();
+	// a crumpled sail, so that springs are stretched from the start
+	for (i = 0; i < n; i++)
+		if (g.Vtx[i].x && g.Vtx[i].y) g.Vtx[i].z = g.Vtx[i+n].z = (float)Rand (-1.0, 1.0);
+	printf ("  %5d nodes, %s: %5.1f%% of %5d springs, %5.1f%% of %5d triangles in SSE blocks",
+		(int)n, shuffle ? "shuffled" : "in rows ", 100.0*mb.nVecSpring()/mb.nSpring(), (int)mb.nSpring(),
+		100.0*mb.nVecTri()/mb.nTri(), (int)mb.nTri());
+
+	double emax = 0.0;
+	std::vector<float> d, nml;
+	std::vector<double> mag;
+	std::vector<NTVERTEX> v0(g.nVtx);
+	for (int s = 0; s < nstep; s++) {
+		memcpy (&v0[0], g.Vtx, g.nVtx*sizeof(NTVERTEX));
+		ref.Displacement (&v0[0], mflux, d, mag);
+		mb.Update (g.Vtx, mflux, wk);
+		ref.Normals (g.Vtx, g.Idx, mb.nTri(), nml);
+		for (i = 0; i < n; i++) {
+			float en[3] = {g.Vtx[i].nx-nml[i*3], g.Vtx[i].ny-nml[i*3+1], g.Vtx[i].nz-nml[i*3+2]};
+			for (int j = 0; j < 3; j++)
+				if (!(fabs (en[j]) <= emax)) emax = fabs (en[j]); // unit vectors
+			float e[3] = {wk.fx[i]-d[i*3], wk.fy[i]-d[i*3+1], wk.fz[i]-d[i*3+2]};
+			for (int j = 0; j < 3; j++) {
+				double err = fabs (e[j])/(mag[i*3+j] + 1e-30);
+				if (!(err <= emax)) emax = err; // also catches NaN
+			}
+			if (ref.fix[i] && (g.Vtx[i].x != v0[i].x || g.Vtx[i].y != v0[i].y || g.Vtx[i].z != v0[i].z)) emax = 1e10;
+			// the back side follows the front side
+			if (g.Vtx[i+n].x != g.Vtx[i].x || g.Vtx[i+n].y != g.Vtx[i].y || g.Vtx[i+n].z != g.Vtx[i].z) emax = 1e10;
+		}
+	}
+	printf (", rel. error %.2g\n", emax);
+	FreeSegment (g);
+	return emax;
+}
+
+static double Seconds (const LARGE_INTEGER &t0, const LARGE_INTEGER &t1)
+{
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency (&freq);
+	return (t1.QuadPart-t0.QuadPart)/(double)freq.QuadPart;
+}
+
+// Time per step of a full sail of four m x m segments, on the calling
+// thread and on the worker pool. Returns the time on the calling thread
+static double Time (int m, int nstep, const VECTOR3 &mflux, MembranePool *pool)
+{
+	MESHGROUP g[4];
+	for (int i = 0; i < 4; i++) g[i] = Segment (m, 10.0f*33/m, false);
+	Membrane mb (&g[0]);
+	MESHHANDLE hMesh = oapiCreateMesh (4, g);
+	static const UINT grp[4] = {0,1,2,3};
+	LARGE_INTEGER t0, t1;
+
+	// the best of NRUN runs, so that other load on the machine does not
+	// count against the solver
+	const int NRUN = 5;
+	double tsync = 1e10, tasync = 1e10;
+	MembraneSolver sync (&mb, 4), async (&mb, 4);
+	async.Load (hMesh, grp);
+	for (int r = 0; r < NRUN; r++) {
+		QueryPerformanceCounter (&t0);
+		for (int s = 0; s < nstep; s++)
+			sync.Update (hMesh, grp, mflux);
+		QueryPerformanceCounter (&t1);
+		tsync = min (tsync, Seconds (t0, t1)/nstep);
+
+		QueryPerformanceCounter (&t0);
+		for (int s = 0; s < nstep; s++) {
+			async.Submit (pool, mflux);
+			async.Wait ();
+			async.Publish (hMesh, grp);
+		}
+		QueryPerformanceCounter (&t1);
+		tasync = min (tasync, Seconds (t0, t1)/nstep);
+	}
+
+	printf ("  %6d nodes x 4 segments: %7.3f ms/step on the calling thread, %7.3f ms/step on the pool\n",
+		(int)mb.nVtx(), tsync*1e3, tasync*1e3);
+	oapiDeleteMesh (hMesh);
+	for (int i = 0; i < 4; i++) FreeSegment (g[i]);
+	return tsync;
+}
+
+int main (int argc, char *argv[])
+{
+	int i, n = 1089, nstep = 200, fail = 0;
+	double budget = 4.0;
+
+	for (i = 1; i < argc; i++) {
+		if      (!strcmp (argv[i], "-n") && i+1 < argc) n = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-s") && i+1 < argc) nstep = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-b") && i+1 < argc) budget = atof (argv[++i]);
+	}
+	// front and back side of the 10x segment must fit WORD indices
+	if (n < 16 || n > 3200 || nstep < 1 || budget <= 0.0) {
+		fprintf (stderr, "Usage: membranecheck [-n nodes (16-3200)] [-s steps] [-b budget_ms]\n");
+		return 1;
+	}
+	int m1 = (int)(sqrt ((double)n)+0.5), m10 = (int)(sqrt (10.0*n)+0.5);
+	VECTOR3 mflux = _V(1e-6, -2e-6, 4.5e-6); // radiation momentum flux near Earth [N/m^2]
+
+	printf ("MembraneCheck: steps compared with a scalar reference\n");
+	double err = 0.0, e;
+	if ((e = Compare (m1, false, 20, mflux)) > err || !(e == e)) err = e;
+	if ((e = Compare (m1, true,  20, mflux)) > err || !(e == e)) err = e;
+	if ((e = Compare (m10, false, 5, mflux)) > err || !(e == e)) err = e;
+	if (!(err < 1e-5)) fail++;
+
+	MembranePool *pool = new MembranePool (4);
+	printf ("MembraneCheck: full sail, budget %g ms per frame\n", budget);
+	Time (m1, nstep, mflux, pool);
+	double t10 = Time (m10, nstep/10 > 0 ? nstep/10 : 1, mflux, pool);
+	if (t10*1e3 > budget) {
+		printf ("  10x mesh: %.3f ms/step exceeds the budget\n", t10*1e3);
+		fail++;
+	}
+	delete pool;
+
+	if (fail) printf ("MembraneCheck: FAILED\n");
+	return fail;
+}
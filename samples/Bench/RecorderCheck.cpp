@@ -0,0 +1,175 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// RecorderCheck.cpp
+// Check and benchmark of the data recorder (DataRecorder) against a
+// brute-force scan of all samples: a two-channel signal with spikes
+// is recorded under a small storage budget (64 kB against 3.2 MB for
+// the raw samples alone), so that the oldest raw samples and fine bins
+// are dropped throughout the run. At checkpoints, Resample and Range
+// are compared with the samples in a set of windows:
+// - windows within the retained raw samples, with no more than
+//   REC_FANOUT samples per column, must be resampled exactly
+//   (minimum, maximum and mean of each column)
+// - wider windows, and windows over history that is only retained at
+//   reduced resolution, must report a range that contains the range of
+//   the samples in the window, and that doesn't extend beyond the
+//   range of the samples of the bins straddling the window edges.
+// Reports the errors, and the time per Append and per Range query
+// (a graph calls both for every sample).
+//
+// Usage: recordercheck [-n samples] [-b budget kB]
+// ==============================================================
+
+#include "DataRecorder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+
+static DWORD seed = 12345;
+
+static double Rand (double a, double b)
+{
+	seed = seed*1664525 + 1013904223;
+	return a + (b-a)*(seed >> 8)/16777216.0;
+}
+
+// sample i of channel 0 (channel 1 is its negative): a slow sine
+// with noise, and a spike every 997 samples
+static float Signal (int i)
+{
+	return (float)(100.0*sin (i*0.01) + Rand (-1.0, 1.0) + (i % 997 ? 0.0 : 500.0));
+}
+
+static double Seconds (const LARGE_INTEGER &t0, const LARGE_INTEGER &t1)
+{
+	LARGE_INTEGER fq;
+	QueryPerformanceFrequency (&fq);
+	return (double)(t1.QuadPart-t0.QuadPart)/(double)fq.QuadPart;
+}
+
+// Range of samples i0..i1 of channel ch (the sample index is its time)
+static void BruteRange (const std::vector<float> *v, int ch, int i0, int i1, float &vmin, float &vmax)
+{
+	vmin = FLT_MAX, vmax = -FLT_MAX;
+	for (int i = max (i0, 0); i <= i1 && i < (int)v[ch].size(); i++) {
+		if (v[ch][i] < vmin) vmin = v[ch][i];
+		if (v[ch][i] > vmax) vmax = v[ch][i];
+	}
+}
+
+// Exact check of window [t0,t1] resampled into ncol columns
+static int CheckExact (const DataRecorder &rec, const std::vector<float> *v, int ch, int t0, int t1, int ncol)
+{
+	std::vector<float> cmin(ncol), cmax(ncol), cmean(ncol);
+	std::vector<float> bmin(ncol, FLT_MAX), bmax(ncol, -FLT_MAX);
+	std::vector<double> bsum(ncol, 0.0), bn(ncol, 0.0);
+	int c, i, err = 0;
+	double scale = ncol/(double)(t1-t0);
+
+	rec.Resample (ch, t0, t1, ncol, &cmin[0], &cmax[0], &cmean[0]);
+	for (i = t0; i <= t1; i++) {
+		c = max (0, min (ncol-1, (int)((i-t0)*scale)));
+		if (v[ch][i] < bmin[c]) bmin[c] = v[ch][i];
+		if (v[ch][i] > bmax[c]) bmax[c] = v[ch][i];
+		bsum[c] += v[ch][i];
+		bn[c]++;
+	}
+	for (c = 0; c < ncol; c++) {
+		if (cmin[c] != bmin[c] || cmax[c] != bmax[c] ||
+			(bn[c] && fabs (cmean[c] - bsum[c]/bn[c]) > 1e-5*(fabs (bsum[c]/bn[c]) + 1.0))) {
+			if (!err++)
+				printf ("  window %d-%d, column %d: %g %g %g, expected %g %g %g\n", t0, t1, c,
+					cmin[c], cmax[c], cmean[c], bmin[c], bmax[c], bn[c] ? bsum[c]/bn[c] : 0.0);
+		}
+	}
+	return err;
+}
+
+// Bounds check of Range over window [t0,t1]. bin: width of the
+// coarsest bins in use, in samples
+static int CheckRange (const DataRecorder &rec, const std::vector<float> *v, int ch, int t0, int t1, int bin)
+{
+	float vmin, vmax, rmin, rmax, omin, omax;
+	int tstart = (int)rec.TStart();
+	if (!rec.Range (ch, t0, t1, vmin, vmax))
+		return (t1 >= tstart ? 1 : 0); // no data only if the window was dropped
+	BruteRange (v, ch, max (t0, tstart), t1, rmin, rmax);
+	BruteRange (v, ch, t0-bin, t1+bin, omin, omax);
+	if (vmin > rmin || vmax < rmax || vmin < omin || vmax > omax) {
+		printf ("  window %d-%d: range %g %g, retained %g %g, outer %g %g\n", t0, t1,
+			vmin, vmax, rmin, rmax, omin, omax);
+		return 1;
+	}
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	int n = 200000, budget = 64;
+	for (int a = 1; a < argc-1; a++) {
+		if      (!strcmp (argv[a], "-n")) n = atoi (argv[++a]);
+		else if (!strcmp (argv[a], "-b")) budget = atoi (argv[++a]);
+	}
+
+	DataRecorder rec (2, budget*1024);
+	std::vector<float> v[2];
+	float val[2];
+	int i, k, ch, bin, nexact = 0, nrange = 0, fail = 0;
+
+	printf ("RecorderCheck: %d samples, budget %d kB, Resample/Range against brute force\n", n, budget);
+	for (i = 0; i < n; i++) {
+		val[0] = Signal (i), val[1] = -val[0];
+		v[0].push_back (val[0]);
+		v[1].push_back (val[1]);
+		rec.Append ((double)i, val);
+		if ((i+1) % (REC_CHUNK*80)) continue;
+
+		// checkpoint at the end of a storage chunk: under the budget, the
+		// finest level retains no more than the current chunk, which is now
+		// full (the last REC_CHUNK samples). The coarsest bins in use span
+		// 4^k samples.
+		for (k = 0, bin = 1; bin*REC_FANOUT <= i+1 && k < REC_MAXLEVEL-1; k++, bin *= REC_FANOUT);
+		for (ch = 0; ch < 2; ch++) {
+			fail += CheckExact (rec, v, ch, i-127, i, 32);           // 4 per column
+			fail += CheckExact (rec, v, ch, i-250, i-51, 50);        // not at the end
+			fail += CheckExact (rec, v, ch, i-101, i-1, 200);        // fewer samples than columns
+			nexact += 3;
+			fail += CheckRange (rec, v, ch, i-1999, i, bin);
+			fail += CheckRange (rec, v, ch, 0, i, bin);                // full history
+			fail += CheckRange (rec, v, ch, i/2-1000, i/2+1000, bin);  // raw samples dropped
+			fail += CheckRange (rec, v, ch, i-5000, i-300, bin);       // just before the raw samples
+			fail += CheckRange (rec, v, ch, i/3, 2*i/3, bin);
+			nrange += 5;
+		}
+	}
+	printf ("  %d exact windows, %d range windows, %d errors, history retained from t = %g\n",
+		nexact, nrange, fail, rec.TStart());
+
+	// timing: a graph appends a sample and queries the range of its window
+	DataRecorder trec (2, budget*1024);
+	LARGE_INTEGER t0, t1;
+	double tapp, trange;
+	QueryPerformanceCounter (&t0);
+	for (i = 0; i < n; i++) {
+		val[0] = v[0][i], val[1] = v[1][i];
+		trec.Append ((double)i, val);
+	}
+	QueryPerformanceCounter (&t1);
+	tapp = Seconds (t0, t1)/n;
+	float vmin, vmax;
+	QueryPerformanceCounter (&t0);
+	for (i = 0; i < n; i++)
+		trec.Range (i & 1, n-200.0, n, vmin, vmax);
+	QueryPerformanceCounter (&t1);
+	trange = Seconds (t0, t1)/n;
+	printf ("  %.3f us per Append, %.3f us per Range (200-sample window)\n", tapp*1e6, trange*1e6);
+
+	return fail;
+}
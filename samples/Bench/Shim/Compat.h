@@ -0,0 +1,15 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Compat.h
+// Forced include for non-Windows builds. MSVC accepts friend and
+// parameter declarations of classes that were not declared before;
+// these forward declarations make the SDK headers valid C++.
+// ==============================================================
+
+class ATMOSPHERE;
+class Instrument_User;
+class AAP;
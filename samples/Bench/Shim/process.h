@@ -0,0 +1,11 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// process.h
+// Non-Windows replacement: _beginthreadex is defined in windows.h
+// ==============================================================
+
+#include "windows.h"
@@ -0,0 +1,476 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// windows.h
+// Minimal non-Windows replacement for the Win32 header, covering
+// the types and functions used by the SDK headers and the sample
+// code compiled into the benchmark runner. Threads, events and
+// critical sections map to pthreads, file mappings to mmap; window
+// and GDI calls do nothing.
+// ==============================================================
+
+#ifndef __BENCH_WINDOWS_H
+#define __BENCH_WINDOWS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ==============================================================
+// Calling conventions and storage classes
+
+#define __declspec(x)
+#define WINAPI
+#define CALLBACK
+#define APIENTRY
+#define __stdcall
+#define __cdecl
+
+// ==============================================================
+// Basic types
+
+typedef unsigned int   DWORD;
+typedef unsigned short WORD;
+typedef unsigned char  BYTE;
+typedef int            BOOL;
+typedef unsigned int   UINT;
+typedef int            INT;
+typedef int            LONG;
+typedef unsigned int   ULONG;
+typedef long long      LONGLONG;
+typedef unsigned long long ULONGLONG;
+#define __int64 long long  // MSVC built-in type
+typedef char           CHAR;
+typedef char           TCHAR;
+typedef char          *LPSTR;
+typedef const char    *LPCSTR;
+typedef const char    *LPCTSTR;
+typedef void          *LPVOID;
+typedef void          *PVOID;
+typedef DWORD         *LPDWORD;
+typedef intptr_t       LONG_PTR;
+typedef uintptr_t      UINT_PTR;
+typedef uintptr_t      DWORD_PTR;
+typedef uintptr_t      WPARAM;
+typedef intptr_t       LPARAM;
+typedef intptr_t       LRESULT;
+typedef DWORD          COLORREF;
+
+typedef union _LARGE_INTEGER {
+	struct { DWORD LowPart; LONG HighPart; };
+	LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+#define MAX_PATH 260
+#define INFINITE 0xFFFFFFFF
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT  258
+
+template<class A, class B> inline A max (A a, B b) { return (a > (A)b ? a : (A)b); }
+template<class A, class B> inline A min (A a, B b) { return (a < (A)b ? a : (A)b); }
+
+#define RGB(r,g,b) ((COLORREF)(((BYTE)(r)|((WORD)((BYTE)(g))<<8))|(((DWORD)(BYTE)(b))<<16)))
+
+// ==============================================================
+// Handles. Windows and GDI objects are opaque; kernel objects are
+// pointers to one of the structures below.
+
+typedef void *HANDLE;
+typedef struct HINSTANCE__ *HINSTANCE;
+typedef HINSTANCE HMODULE;
+typedef struct HWND__ *HWND;
+typedef struct HDC__ *HDC;
+typedef struct HFONT__ *HFONT;
+typedef struct HPEN__ *HPEN;
+typedef struct HBRUSH__ *HBRUSH;
+typedef struct HBITMAP__ *HBITMAP;
+typedef struct HMENU__ *HMENU;
+typedef struct HICON__ *HICON;
+typedef struct HCURSOR__ *HCURSOR;
+typedef void *HGDIOBJ;
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+
+typedef struct tagRECT { LONG left, top, right, bottom; } RECT, *LPRECT;
+typedef struct tagPOINT { LONG x, y; } POINT;
+typedef struct tagSIZE { LONG cx, cy; } SIZE;
+
+typedef LRESULT (*WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef BOOL (*DLGPROC)(HWND, UINT, WPARAM, LPARAM);
+
+// ==============================================================
+// String functions
+
+#define _stricmp strcasecmp
+#define _strnicmp strncasecmp
+#define stricmp strcasecmp
+#define strnicmp strncasecmp
+
+// ==============================================================
+// Timing and threads
+
+inline BOOL QueryPerformanceFrequency (LARGE_INTEGER *f)
+{ f->QuadPart = 1000000000LL; return TRUE; }
+
+inline BOOL QueryPerformanceCounter (LARGE_INTEGER *t)
+{
+	timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	t->QuadPart = (LONGLONG)ts.tv_sec*1000000000LL + ts.tv_nsec;
+	return TRUE;
+}
+
+inline DWORD GetTickCount ()
+{
+	LARGE_INTEGER t;
+	QueryPerformanceCounter (&t);
+	return (DWORD)(t.QuadPart/1000000);
+}
+
+inline void Sleep (DWORD ms) { usleep (ms*1000); }
+
+inline DWORD GetCurrentThreadId () { return (DWORD)(size_t)pthread_self(); }
+
+inline LONG InterlockedExchange (volatile LONG *p, LONG v) { return __atomic_exchange_n (p, v, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedIncrement (volatile LONG *p) { return __sync_add_and_fetch (p, 1); }
+inline LONG InterlockedDecrement (volatile LONG *p) { return __sync_sub_and_fetch (p, 1); }
+inline LONG InterlockedCompareExchange (volatile LONG *p, LONG v, LONG cmp)
+{ return __sync_val_compare_and_swap (p, cmp, v); }
+
+typedef struct _CRITICAL_SECTION { pthread_mutex_t m; } CRITICAL_SECTION;
+
+inline void InitializeCriticalSection (CRITICAL_SECTION *cs)
+{
+	pthread_mutexattr_t a;
+	pthread_mutexattr_init (&a);
+	pthread_mutexattr_settype (&a, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init (&cs->m, &a);
+	pthread_mutexattr_destroy (&a);
+}
+inline void DeleteCriticalSection (CRITICAL_SECTION *cs) { pthread_mutex_destroy (&cs->m); }
+inline void EnterCriticalSection (CRITICAL_SECTION *cs) { pthread_mutex_lock (&cs->m); }
+inline void LeaveCriticalSection (CRITICAL_SECTION *cs) { pthread_mutex_unlock (&cs->m); }
+
+// Kernel objects: events, semaphores, threads, files and file mappings
+struct BenchHandle {
+	enum Type { EVENT, SEMAPHORE, THREAD, FILE, MAPPING } type;
+	pthread_mutex_t m;
+	pthread_cond_t c;
+	bool signalled, manual;
+	LONG count;
+	pthread_t thread;
+	unsigned int (*proc)(void*);
+	void *arg;
+	int fd;
+	BenchHandle *file;
+};
+
+inline BenchHandle *BenchNewHandle (BenchHandle::Type type)
+{
+	BenchHandle *h = new BenchHandle;
+	memset (h, 0, sizeof(BenchHandle));
+	h->type = type;
+	pthread_mutex_init (&h->m, 0);
+	pthread_cond_init (&h->c, 0);
+	h->fd = -1;
+	return h;
+}
+
+inline HANDLE CreateEvent (void *sa, BOOL manual, BOOL initial, LPCSTR name)
+{
+	BenchHandle *h = BenchNewHandle (BenchHandle::EVENT);
+	h->manual = (manual != FALSE);
+	h->signalled = (initial != FALSE);
+	return h;
+}
+#define CreateEventA CreateEvent
+
+inline BOOL SetEvent (HANDLE hEvent)
+{
+	BenchHandle *h = (BenchHandle*)hEvent;
+	pthread_mutex_lock (&h->m);
+	h->signalled = true;
+	pthread_cond_broadcast (&h->c);
+	pthread_mutex_unlock (&h->m);
+	return TRUE;
+}
+
+inline BOOL ResetEvent (HANDLE hEvent)
+{
+	BenchHandle *h = (BenchHandle*)hEvent;
+	pthread_mutex_lock (&h->m);
+	h->signalled = false;
+	pthread_mutex_unlock (&h->m);
+	return TRUE;
+}
+
+inline HANDLE CreateSemaphore (void *sa, LONG initial, LONG maxcount, LPCSTR name)
+{
+	BenchHandle *h = BenchNewHandle (BenchHandle::SEMAPHORE);
+	h->count = initial;
+	h->signalled = (initial > 0);
+	return h;
+}
+#define CreateSemaphoreA CreateSemaphore
+
+inline BOOL ReleaseSemaphore (HANDLE hSem, LONG n, LONG *prev)
+{
+	BenchHandle *h = (BenchHandle*)hSem;
+	pthread_mutex_lock (&h->m);
+	if (prev) *prev = h->count;
+	h->count += n;
+	h->signalled = (h->count > 0);
+	pthread_cond_broadcast (&h->c);
+	pthread_mutex_unlock (&h->m);
+	return TRUE;
+}
+
+inline void *BenchThreadProc (void *arg)
+{
+	BenchHandle *h = (BenchHandle*)arg;
+	h->proc (h->arg);
+	pthread_mutex_lock (&h->m);
+	h->signalled = true; // thread handles are signalled on exit
+	pthread_cond_broadcast (&h->c);
+	pthread_mutex_unlock (&h->m);
+	return 0;
+}
+
+inline uintptr_t _beginthreadex (void *sa, unsigned stack, unsigned (*proc)(void*), void *arg,
+	unsigned flags, unsigned *id)
+{
+	BenchHandle *h = BenchNewHandle (BenchHandle::THREAD);
+	h->proc = proc;
+	h->arg = arg;
+	h->manual = true;
+	if (pthread_create (&h->thread, 0, BenchThreadProc, h)) {
+		delete h;
+		return 0;
+	}
+	if (id) *id = (unsigned)(size_t)h->thread;
+	return (uintptr_t)h;
+}
+
+// The thread function returns right after it, which ends the thread
+inline void _endthreadex (unsigned code) {}
+
+inline DWORD WaitForSingleObject (HANDLE hObj, DWORD ms)
+{
+	BenchHandle *h = (BenchHandle*)hObj;
+	DWORD res = WAIT_OBJECT_0;
+	pthread_mutex_lock (&h->m);
+	if (ms == INFINITE) {
+		while (!h->signalled) pthread_cond_wait (&h->c, &h->m);
+	} else {
+		timespec ts;
+		clock_gettime (CLOCK_REALTIME, &ts);
+		ts.tv_sec += ms/1000;
+		ts.tv_nsec += (ms%1000)*1000000L;
+		if (ts.tv_nsec >= 1000000000L) ts.tv_sec++, ts.tv_nsec -= 1000000000L;
+		while (!h->signalled)
+			if (pthread_cond_timedwait (&h->c, &h->m, &ts) == ETIMEDOUT) break;
+		if (!h->signalled) res = WAIT_TIMEOUT;
+	}
+	if (res == WAIT_OBJECT_0) {
+		if (h->type == BenchHandle::SEMAPHORE) h->signalled = (--h->count > 0);
+		else if (!h->manual) h->signalled = false;
+	}
+	pthread_mutex_unlock (&h->m);
+	return res;
+}
+
+// Only waits for all of the objects, one after the other
+inline DWORD WaitForMultipleObjects (DWORD n, const HANDLE *hObj, BOOL all, DWORD ms)
+{
+	for (DWORD i = 0; i < n; i++)
+		if (WaitForSingleObject (hObj[i], ms) != WAIT_OBJECT_0) return WAIT_TIMEOUT;
+	return WAIT_OBJECT_0;
+}
+
+// ==============================================================
+// Files and file mappings
+
+#define GENERIC_READ          0x80000000
+#define GENERIC_WRITE         0x40000000
+#define FILE_SHARE_READ       0x00000001
+#define CREATE_ALWAYS         2
+#define OPEN_EXISTING         3
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define PAGE_READONLY         0x02
+#define FILE_MAP_READ         0x0004
+
+inline HANDLE CreateFileA (LPCSTR name, DWORD access, DWORD share, void *sa, DWORD disp, DWORD attr, HANDLE tmpl)
+{
+	int flags = ((access & GENERIC_WRITE) ? O_RDWR : O_RDONLY);
+	if (disp == CREATE_ALWAYS) flags |= O_CREAT | O_TRUNC;
+	int fd = open (name, flags, 0644);
+	if (fd < 0) return INVALID_HANDLE_VALUE;
+	BenchHandle *h = BenchNewHandle (BenchHandle::FILE);
+	h->fd = fd;
+	return h;
+}
+#define CreateFile CreateFileA
+
+inline DWORD GetFileSize (HANDLE hFile, LPDWORD hi)
+{
+	struct stat st;
+	if (fstat (((BenchHandle*)hFile)->fd, &st)) return 0xFFFFFFFF;
+	if (hi) *hi = (DWORD)((unsigned long long)st.st_size >> 32);
+	return (DWORD)st.st_size;
+}
+
+inline HANDLE CreateFileMapping (HANDLE hFile, void *sa, DWORD prot, DWORD hi, DWORD lo, LPCSTR name)
+{
+	BenchHandle *h = BenchNewHandle (BenchHandle::MAPPING);
+	h->file = (BenchHandle*)hFile;
+	return h;
+}
+#define CreateFileMappingA CreateFileMapping
+
+// Table of mapped views {address, size}, for UnmapViewOfFile. add=true
+// registers rec, add=false removes and returns the entry for address p.
+inline size_t *BenchMapTable (size_t *p, bool add)
+{
+	static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+	static size_t *tab[256];
+	static int ntab = 0;
+	size_t *rec = 0;
+	pthread_mutex_lock (&m);
+	if (add) {
+		if (ntab < 256) tab[ntab++] = p, rec = p;
+	} else {
+		for (int i = 0; i < ntab; i++)
+			if (tab[i][0] == (size_t)p) {
+				rec = tab[i];
+				tab[i] = tab[--ntab];
+				break;
+			}
+	}
+	pthread_mutex_unlock (&m);
+	return rec;
+}
+
+inline LPVOID MapViewOfFile (HANDLE hMap, DWORD access, DWORD hi, DWORD lo, size_t n)
+{
+	BenchHandle *h = (BenchHandle*)hMap;
+	if (!n) n = GetFileSize (h->file, 0);
+	if (!n) return 0;
+	void *p = mmap (0, n, PROT_READ, MAP_SHARED, h->file->fd, 0);
+	if (p == MAP_FAILED) return 0;
+	size_t *rec = new size_t[2];
+	rec[0] = (size_t)p, rec[1] = n;
+	BenchMapTable (rec, true);
+	return p;
+}
+
+inline BOOL UnmapViewOfFile (const void *p)
+{
+	size_t *rec = BenchMapTable ((size_t*)p, false);
+	if (!rec) return FALSE;
+	munmap ((void*)rec[0], rec[1]);
+	delete []rec;
+	return TRUE;
+}
+
+inline BOOL CloseHandle (HANDLE hObj)
+{
+	BenchHandle *h = (BenchHandle*)hObj;
+	if (!h || h == INVALID_HANDLE_VALUE) return FALSE;
+	if (h->type == BenchHandle::THREAD) pthread_join (h->thread, 0);
+	if (h->type == BenchHandle::FILE && h->fd >= 0) close (h->fd);
+	pthread_mutex_destroy (&h->m);
+	pthread_cond_destroy (&h->c);
+	delete h;
+	return TRUE;
+}
+
+// ==============================================================
+// Windows and GDI. The runner has no windows and draws nothing: panel,
+// dialog and instrument code compiles against these, and the calls do
+// nothing. Objects are never created (null handles).
+
+#define FAR
+#define PASCAL
+#define DLL_PROCESS_DETACH 0
+#define DLL_PROCESS_ATTACH 1
+
+#define MAKEINTRESOURCE(i) ((LPSTR)(uintptr_t)(WORD)(i))
+#define LOWORD(l) ((WORD)((DWORD_PTR)(l) & 0xffff))
+#define HIWORD(l) ((WORD)(((DWORD_PTR)(l) >> 16) & 0xffff))
+
+#define WM_INITDIALOG 0x0110
+#define WM_COMMAND    0x0111
+#define WM_HSCROLL    0x0114
+#define WM_USER       0x0400
+#define IDOK          1
+#define IDCANCEL      2
+#define IDHELP        9
+#define BM_GETCHECK   0x00F0
+#define BM_SETCHECK   0x00F1
+#define BST_UNCHECKED 0
+#define BST_CHECKED   1
+#define SB_LINELEFT   0
+#define SB_LINERIGHT  1
+#define SB_THUMBTRACK 5
+#define SW_HIDE       0
+#define SW_SHOW       5
+#define TRANSPARENT   1
+#define OPAQUE        2
+#define TA_LEFT       0
+#define TA_RIGHT      2
+#define TA_CENTER     6
+#define TA_BASELINE   24
+#define PS_SOLID      0
+#define PS_DOT        2
+#define SRCCOPY       0x00CC0020
+#define BLACK_BRUSH   4
+#define NULL_BRUSH    5
+#define BLACK_PEN     7
+#define NULL_PEN      8
+
+inline HBITMAP LoadBitmap (HINSTANCE hInst, LPCSTR name) { return 0; }
+inline HGDIOBJ SelectObject (HDC hDC, HGDIOBJ obj) { return 0; }
+inline HGDIOBJ GetStockObject (int i) { return 0; }
+inline BOOL DeleteObject (HGDIOBJ obj) { return TRUE; }
+inline HDC CreateCompatibleDC (HDC hDC) { return 0; }
+inline BOOL DeleteDC (HDC hDC) { return TRUE; }
+inline HPEN CreatePen (int style, int width, COLORREF col) { return 0; }
+inline HBRUSH CreateSolidBrush (COLORREF col) { return 0; }
+inline HFONT CreateFont (int h, int w, int esc, int orient, int weight, DWORD italic, DWORD underline,
+	DWORD strikeout, DWORD charset, DWORD outprec, DWORD clipprec, DWORD quality, DWORD pitch, LPCSTR face)
+{ return 0; }
+inline COLORREF SetTextColor (HDC hDC, COLORREF col) { return 0; }
+inline COLORREF SetBkColor (HDC hDC, COLORREF col) { return 0; }
+inline int SetBkMode (HDC hDC, int mode) { return 0; }
+inline UINT SetTextAlign (HDC hDC, UINT align) { return 0; }
+inline BOOL TextOut (HDC hDC, int x, int y, LPCSTR str, int len) { return TRUE; }
+inline BOOL MoveToEx (HDC hDC, int x, int y, POINT *pt) { return TRUE; }
+inline BOOL LineTo (HDC hDC, int x, int y) { return TRUE; }
+inline BOOL Rectangle (HDC hDC, int x0, int y0, int x1, int y1) { return TRUE; }
+inline BOOL Ellipse (HDC hDC, int x0, int y0, int x1, int y1) { return TRUE; }
+inline BOOL Polygon (HDC hDC, const POINT *pt, int n) { return TRUE; }
+inline BOOL Polyline (HDC hDC, const POINT *pt, int n) { return TRUE; }
+inline BOOL BitBlt (HDC hDC, int x, int y, int w, int h, HDC hSrc, int xs, int ys, DWORD rop) { return TRUE; }
+
+inline HWND GetDlgItem (HWND hDlg, int id) { return 0; }
+inline int GetDlgCtrlID (HWND hWnd) { return 0; }
+inline BOOL ShowWindow (HWND hWnd, int cmd) { return FALSE; }
+inline BOOL SetWindowText (HWND hWnd, LPCSTR str) { return TRUE; }
+inline LRESULT SendMessage (HWND hWnd, UINT msg, WPARAM wp, LPARAM lp) { return 0; }
+inline LRESULT SendDlgItemMessage (HWND hDlg, int id, UINT msg, WPARAM wp, LPARAM lp) { return 0; }
+
+#endif // !__BENCH_WINDOWS_H
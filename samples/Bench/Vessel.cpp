@@ -0,0 +1,711 @@
+// ==============================================================
+//                 ORBITER MODULE: Bench
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Vessel.cpp
+// Headless stand-in for the VESSEL, VESSEL2 and VESSEL3 interfaces,
+// implemented on the Vessel bookkeeping class. Only the methods used
+// by the modules built with the benchmark runner are provided; a
+// module calling anything else fails to load with the name of the
+// missing symbol.
+// ==============================================================
+
+#include "Host.h"
+
+const double G0 = 9.81; // standard gravity, for Isp conversions
+
+// ==============================================================
+// class Vessel
+
+Vessel::Vessel (const char *_name, const char *_classname)
+{
+	strncpy (name, _name, 63); name[63] = '\0';
+	strncpy (classname, _classname, 63); classname[63] = '\0';
+	size = 1.0;
+	emptymass = 1.0;
+	pmi = cs = rotdrag = camofs = _V(0,0,0);
+	gpos = gvel = _V(0,0,0);
+	aoa = mach = 0.0;
+	slip = atmtemp = atmpress = dynpress = lift = drag = 0.0;
+	attmode = RCS_ROT;
+	adcmode = 7;
+	navmode = 0;
+	memset (ctrllevel, 0, sizeof(ctrllevel));
+	wbrake[0] = wbrake[1] = 0.0;
+	iface = 0;
+}
+
+Vessel::~Vessel ()
+{
+	size_t i, j;
+	for (i = 0; i < prop.size(); i++) delete prop[i];
+	for (i = 0; i < thr.size(); i++) delete thr[i];
+	for (i = 0; i < thg.size(); i++) delete thg[i];
+	for (i = 0; i < anim.size(); i++) {
+		for (j = 0; j < anim[i]->comp.size(); j++) delete anim[i]->comp[j];
+		delete anim[i];
+	}
+	for (i = 0; i < airfoil.size(); i++) delete airfoil[i];
+	for (i = 0; i < ctrlsurf.size(); i++) delete ctrlsurf[i];
+	for (i = 0; i < light.size(); i++) // no virtual destructor
+		if (light[i]->GetType() == LightEmitter::LT_SPOT) delete (SpotLight*)light[i];
+		else delete (PointLight*)light[i];
+	for (i = 0; i < attach.size(); i++) delete attach[i];
+	for (i = 0; i < mesh.size(); i++) delete []mesh[i];
+}
+
+double Vessel::Mass () const
+{
+	double m = emptymass;
+	for (size_t i = 0; i < prop.size(); i++) m += prop[i]->mass;
+	return m;
+}
+
+void Vessel::Step (double dt, double aoa, double M)
+{
+	size_t i;
+	VECTOR3 F = _V(0,0,0);
+
+	// thrust and propellant consumption
+	for (i = 0; i < thr.size(); i++) {
+		BenchThruster *th = thr[i];
+		if (th->level <= 0.0 || !th->ph || th->ph->mass <= 0.0) continue;
+		double f = th->level*th->max0;
+		double dm = f/(th->isp0*th->ph->efficiency)*dt;
+		if (dm > th->ph->mass) f *= th->ph->mass/dm, dm = th->ph->mass;
+		th->ph->mass -= dm;
+		F -= th->dir*f;
+	}
+
+	// aerodynamic coefficients (results are not applied: the stand-in
+	// has no atmosphere, the call is made for its cost)
+	for (i = 0; i < airfoil.size(); i++) {
+		double cl, cm, cd;
+		BenchAirfoil *af = airfoil[i];
+		if (af->cf) af->cf (iface, aoa, M, 1e7, af->context, &cl, &cm, &cd);
+		else        af->cf0 (aoa, M, 1e7, &cl, &cm, &cd);
+	}
+	this->aoa = aoa;
+	mach = M;
+
+	// translational motion in a field-free frame
+	gvel += F*(dt/Mass());
+	gpos += gvel*dt;
+}
+
+// ==============================================================
+// class VESSEL
+
+VESSEL::VESSEL (OBJHANDLE hVessel, int fmodel)
+{
+	vessel = (Vessel*)hVessel;
+	flightmodel = (short)fmodel;
+	version = 0;
+}
+
+const OBJHANDLE VESSEL::GetHandle () const { return (OBJHANDLE)vessel; }
+char *VESSEL::GetName () const { return vessel->name; }
+char *VESSEL::GetClassName () const { return vessel->classname; }
+
+double VESSEL::GetSize () const { return vessel->size; }
+void VESSEL::SetSize (double size) const { vessel->size = size; }
+double VESSEL::GetEmptyMass () const { return vessel->emptymass; }
+void VESSEL::SetEmptyMass (double m) const { vessel->emptymass = m; }
+double VESSEL::GetMass () const { return vessel->Mass(); }
+void VESSEL::SetPMI (const VECTOR3 &pmi) const { vessel->pmi = pmi; }
+void VESSEL::SetCrossSections (const VECTOR3 &cs) const { vessel->cs = cs; }
+void VESSEL::SetRotDrag (const VECTOR3 &rd) const { vessel->rotdrag = rd; }
+void VESSEL::SetTouchdownPoints (const VECTOR3 &pt1, const VECTOR3 &pt2, const VECTOR3 &pt3) const {}
+void VESSEL::SetDockParams (const VECTOR3 &pos, const VECTOR3 &dir, const VECTOR3 &rot) const {}
+void VESSEL::SetCameraOffset (const VECTOR3 &co) const { vessel->camofs = co; }
+void VESSEL::GetGlobalPos (VECTOR3 &pos) const { pos = vessel->gpos; }
+void VESSEL::GetGlobalVel (VECTOR3 &vel) const { vel = vessel->gvel; }
+
+UINT VESSEL::AddMesh (const char *meshname, const VECTOR3 *ofs) const
+{
+	char *name = new char[strlen(meshname)+1];
+	strcpy (name, meshname);
+	vessel->mesh.push_back (name);
+	return (UINT)vessel->mesh.size()-1;
+}
+
+UINT VESSEL::AddMesh (MESHHANDLE hMesh, const VECTOR3 *ofs) const
+{
+	return AddMesh ("", ofs);
+}
+
+// There is no visual: meshes have no device instance
+void VESSEL::SetMeshVisibilityMode (UINT idx, WORD mode) const {}
+DEVMESHHANDLE VESSEL::GetDevMesh (VISHANDLE vis, UINT idx) const { return 0; }
+void VESSEL::SetVisibilityLimit (double vislimit, double spotlimit) const {}
+void VESSEL::SetAlbedoRGB (const VECTOR3 &albedo) const {}
+void VESSEL::SetCameraDefaultDirection (const VECTOR3 &cd) const {}
+void VESSEL::SetCameraMovement (const VECTOR3 &fpos, double fphi, double ftht, const VECTOR3 &lpos, double lphi, double ltht, const VECTOR3 &rpos, double rphi, double rtht) const {}
+void VESSEL::SetCameraShiftRange (const VECTOR3 &fpos, const VECTOR3 &lpos, const VECTOR3 &rpos) const {}
+
+// --------------------------------------------------------------
+// Flight state. There is no planet: the vessel flies in vacuum, far
+// from any body, with the flow state (angle of attack, Mach number)
+// of the last step, and keeps the attitude of the global frame. The
+// other air data are those set by the caller, 0 by default.
+
+const OBJHANDLE VESSEL::GetSurfaceRef () const { return 0; }
+const OBJHANDLE VESSEL::GetAtmRef () const { return 0; }
+double VESSEL::GetAltitude () const { return length (vessel->gpos); }
+
+OBJHANDLE VESSEL::GetEquPos (double &longitude, double &latitude, double &radius) const
+{
+	longitude = latitude = 0.0;
+	radius = length (vessel->gpos);
+	return 0;
+}
+
+bool VESSEL::GroundContact () const { return false; }
+double VESSEL::GetAOA () const { return vessel->aoa; }
+double VESSEL::GetSlipAngle () const { return vessel->slip; }
+double VESSEL::GetMachNumber () const { return vessel->mach; }
+double VESSEL::GetAirspeed () const { return length (vessel->gvel); }
+
+bool VESSEL::GetHorizonAirspeedVector (VECTOR3 &v) const
+{
+	v = vessel->gvel;
+	return false; // no reference body
+}
+
+double VESSEL::GetDynPressure () const { return vessel->dynpress; }
+double VESSEL::GetAtmDensity () const { return 0.0; }
+double VESSEL::GetAtmPressure () const { return vessel->atmpress; }
+double VESSEL::GetAtmTemperature () const { return vessel->atmtemp; }
+double VESSEL::GetLift () const { return vessel->lift; }
+double VESSEL::GetDrag () const { return vessel->drag; }
+double VESSEL::GetPitch () const { return 0.0; }
+double VESSEL::GetBank () const { return 0.0; }
+double VESSEL::GetYaw () const { return 0.0; }
+void VESSEL::GetAngularVel (VECTOR3 &avel) const { avel = _V(0,0,0); }
+void VESSEL::GetAngularAcc (VECTOR3 &aacc) const { aacc = _V(0,0,0); }
+void VESSEL::GetAngularMoment (VECTOR3 &amom) const { amom = _V(0,0,0); }
+bool VESSEL::SetGravityGradientDamping (double damp) const { return false; }
+void VESSEL::SetSurfaceFrictionCoeff (double mu_lng, double mu_lat) const {}
+int VESSEL::GetDamageModel () const { return 0; }
+
+// --------------------------------------------------------------
+// Control modes. Changes are reported to the module as by Orbiter.
+
+int VESSEL::GetAttitudeMode () const { return vessel->attmode; }
+
+bool VESSEL::SetAttitudeMode (int mode) const
+{
+	if (mode < RCS_NONE || mode > RCS_LIN) return false;
+	if (mode != vessel->attmode) {
+		vessel->attmode = mode;
+		if (version >= 1) ((VESSEL2*)this)->clbkRCSMode (mode);
+	}
+	return true;
+}
+
+int VESSEL::ToggleAttitudeMode () const
+{
+	if (vessel->attmode != RCS_NONE)
+		SetAttitudeMode (vessel->attmode == RCS_ROT ? RCS_LIN : RCS_ROT);
+	return vessel->attmode;
+}
+
+DWORD VESSEL::GetADCtrlMode () const { return vessel->adcmode; }
+
+void VESSEL::SetADCtrlMode (DWORD mode) const
+{
+	if (mode != vessel->adcmode) {
+		vessel->adcmode = mode;
+		if (version >= 1) ((VESSEL2*)this)->clbkADCtrlMode (mode);
+	}
+}
+
+bool VESSEL::GetNavmodeState (int mode)
+{
+	return (vessel->navmode >> mode) & 1;
+}
+
+bool VESSEL::ToggleNavmode (int mode)
+{
+	vessel->navmode ^= 1 << mode;
+	if (version >= 1) ((VESSEL2*)this)->clbkNavMode (mode, GetNavmodeState (mode));
+	return true;
+}
+
+void VESSEL::SetWheelbrakeLevel (double level, int which, bool permanent) const
+{
+	level = max (0.0, min (level, 1.0));
+	if (which != 2) vessel->wbrake[0] = level;
+	if (which != 1) vessel->wbrake[1] = level;
+}
+
+double VESSEL::GetWheelbrakeLevel (int which) const
+{
+	return (which ? vessel->wbrake[which-1] : 0.5*(vessel->wbrake[0]+vessel->wbrake[1]));
+}
+
+void VESSEL::SetMaxWheelbrakeForce (double f) const {}
+void VESSEL::SetNosewheelSteering (bool activate) const {}
+
+// Radios, recording and playback
+void VESSEL::EnableTransponder (bool enable) const {}
+void VESSEL::InitNavRadios (DWORD nnav) const {}
+NAVHANDLE VESSEL::GetNavSource (DWORD n) const { return 0; }
+void VESSEL::ParseScenarioLineEx (char *line, void *status) const {}
+bool VESSEL::Playback () const { return false; }
+void VESSEL::RecordEvent (const char *event_type, const char *event) const {}
+
+// --------------------------------------------------------------
+// Propellant resources
+
+PROPELLANT_HANDLE VESSEL::CreatePropellantResource (double maxmass, double mass, double efficiency) const
+{
+	BenchPropellant *ph = new BenchPropellant;
+	ph->maxmass = maxmass;
+	ph->mass = (mass >= 0.0 ? mass : maxmass);
+	ph->efficiency = efficiency;
+	vessel->prop.push_back (ph);
+	return (PROPELLANT_HANDLE)ph;
+}
+
+DWORD VESSEL::GetPropellantCount () const { return (DWORD)vessel->prop.size(); }
+
+PROPELLANT_HANDLE VESSEL::GetPropellantHandleByIndex (DWORD idx) const
+{
+	return (idx < vessel->prop.size() ? (PROPELLANT_HANDLE)vessel->prop[idx] : 0);
+}
+
+double VESSEL::GetPropellantMaxMass (PROPELLANT_HANDLE ph) const { return ((BenchPropellant*)ph)->maxmass; }
+double VESSEL::GetPropellantMass (PROPELLANT_HANDLE ph) const { return ((BenchPropellant*)ph)->mass; }
+
+void VESSEL::SetPropellantMass (PROPELLANT_HANDLE ph, double mass) const
+{
+	BenchPropellant *p = (BenchPropellant*)ph;
+	p->mass = max (0.0, min (mass, p->maxmass));
+}
+
+void VESSEL::SetPropellantMaxMass (PROPELLANT_HANDLE ph, double maxmass) const
+{
+	BenchPropellant *p = (BenchPropellant*)ph;
+	p->maxmass = max (0.0, maxmass);
+	if (p->mass > p->maxmass) p->mass = p->maxmass;
+}
+
+// Consumption of all thrusters fed by the resource, at their current level
+double VESSEL::GetPropellantFlowrate (PROPELLANT_HANDLE ph) const
+{
+	double rate = 0.0;
+	for (size_t i = 0; i < vessel->thr.size(); i++) {
+		BenchThruster *th = vessel->thr[i];
+		if (th->ph == ph && th->ph->mass > 0.0)
+			rate += th->level*th->max0/(th->isp0*th->ph->efficiency);
+	}
+	return rate;
+}
+
+double VESSEL::GetTotalPropellantMass () const
+{
+	return vessel->Mass() - vessel->emptymass;
+}
+
+// --------------------------------------------------------------
+// Thrusters and thruster groups
+
+THRUSTER_HANDLE VESSEL::CreateThruster (const VECTOR3 &pos, const VECTOR3 &dir, double maxth0,
+	PROPELLANT_HANDLE hp, double isp0, double isp_ref, double p_ref) const
+{
+	BenchThruster *th = new BenchThruster;
+	th->pos = pos;
+	th->dir = dir;
+	th->max0 = maxth0;
+	th->isp0 = (isp0 > 0.0 ? isp0 : G0); // default: 1 s
+	th->level = 0.0;
+	th->ph = (BenchPropellant*)hp;
+	vessel->thr.push_back (th);
+	return (THRUSTER_HANDLE)th;
+}
+
+THRUSTER_HANDLE VESSEL::GetThrusterHandleByIndex (DWORD idx) const
+{
+	return (idx < vessel->thr.size() ? (THRUSTER_HANDLE)vessel->thr[idx] : 0);
+}
+
+PROPELLANT_HANDLE VESSEL::GetThrusterResource (THRUSTER_HANDLE th) const { return ((BenchThruster*)th)->ph; }
+void VESSEL::SetThrusterResource (THRUSTER_HANDLE th, PROPELLANT_HANDLE ph) const { ((BenchThruster*)th)->ph = (BenchPropellant*)ph; }
+double VESSEL::GetThrusterMax0 (THRUSTER_HANDLE th) const { return ((BenchThruster*)th)->max0; }
+double VESSEL::GetThrusterIsp0 (THRUSTER_HANDLE th) const { return ((BenchThruster*)th)->isp0; }
+double VESSEL::GetThrusterLevel (THRUSTER_HANDLE th) const { return ((BenchThruster*)th)->level; }
+void VESSEL::SetThrusterMax0 (THRUSTER_HANDLE th, double maxth0) const { ((BenchThruster*)th)->max0 = maxth0; }
+void VESSEL::SetThrusterIsp (THRUSTER_HANDLE th, double isp) const { ((BenchThruster*)th)->isp0 = isp; }
+void VESSEL::SetThrusterDir (THRUSTER_HANDLE th, const VECTOR3 &dir) const { ((BenchThruster*)th)->dir = dir; }
+void VESSEL::GetThrusterDir (THRUSTER_HANDLE th, VECTOR3 &dir) const { dir = ((BenchThruster*)th)->dir; }
+
+// In vacuum, thrust and Isp are the vacuum ratings
+double VESSEL::GetThrusterMax (THRUSTER_HANDLE th) const { return ((BenchThruster*)th)->max0; }
+double VESSEL::GetThrusterIsp (THRUSTER_HANDLE th) const { return ((BenchThruster*)th)->isp0; }
+
+void VESSEL::SetThrusterLevel (THRUSTER_HANDLE th, double level) const
+{
+	((BenchThruster*)th)->level = max (0.0, min (level, 1.0));
+}
+
+THGROUP_HANDLE VESSEL::CreateThrusterGroup (THRUSTER_HANDLE *th, int nth, THGROUP_TYPE thgt) const
+{
+	BenchThGroup *g = new BenchThGroup;
+	g->type = thgt;
+	for (int i = 0; i < nth; i++) g->th.push_back ((BenchThruster*)th[i]);
+	vessel->thg.push_back (g);
+	return (THGROUP_HANDLE)g;
+}
+
+static BenchThGroup *FindGroup (Vessel *vessel, THGROUP_TYPE thgt)
+{
+	for (size_t i = 0; i < vessel->thg.size(); i++)
+		if (vessel->thg[i]->type == thgt) return vessel->thg[i];
+	return 0;
+}
+
+void VESSEL::SetThrusterGroupLevel (THGROUP_HANDLE thg, double level) const
+{
+	BenchThGroup *g = (BenchThGroup*)thg;
+	for (size_t i = 0; i < g->th.size(); i++)
+		SetThrusterLevel ((THRUSTER_HANDLE)g->th[i], level);
+}
+
+void VESSEL::SetThrusterGroupLevel (THGROUP_TYPE thgt, double level) const
+{
+	BenchThGroup *g = FindGroup (vessel, thgt);
+	if (g) SetThrusterGroupLevel ((THGROUP_HANDLE)g, level);
+}
+
+void VESSEL::IncThrusterLevel (THRUSTER_HANDLE th, double dlevel) const
+{
+	SetThrusterLevel (th, ((BenchThruster*)th)->level + dlevel);
+}
+
+void VESSEL::IncThrusterGroupLevel (THGROUP_HANDLE thg, double dlevel) const
+{
+	BenchThGroup *g = (BenchThGroup*)thg;
+	for (size_t i = 0; i < g->th.size(); i++)
+		IncThrusterLevel ((THRUSTER_HANDLE)g->th[i], dlevel);
+}
+
+double VESSEL::GetThrusterGroupLevel (THGROUP_HANDLE thg) const
+{
+	BenchThGroup *g = (BenchThGroup*)thg;
+	double level = 0.0;
+	for (size_t i = 0; i < g->th.size(); i++) level += g->th[i]->level;
+	return (g->th.size() ? level/g->th.size() : 0.0);
+}
+
+double VESSEL::GetThrusterGroupLevel (THGROUP_TYPE thgt) const
+{
+	BenchThGroup *g = FindGroup (vessel, thgt);
+	return (g ? GetThrusterGroupLevel ((THGROUP_HANDLE)g) : 0.0);
+}
+
+// Visual effects have no headless counterpart
+UINT VESSEL::AddExhaust (THRUSTER_HANDLE th, double lscale, double wscale, SURFHANDLE tex) const { return 0; }
+UINT VESSEL::AddExhaust (THRUSTER_HANDLE th, double lscale, double wscale, double lofs, SURFHANDLE tex) const { return 0; }
+UINT VESSEL::AddExhaust (THRUSTER_HANDLE th, double lscale, double wscale, const VECTOR3 &pos, const VECTOR3 &dir, SURFHANDLE tex) const { return 0; }
+UINT VESSEL::AddExhaust (EXHAUSTSPEC *spec) { return 0; }
+PSTREAM_HANDLE VESSEL::AddExhaustStream (THRUSTER_HANDLE th, PARTICLESTREAMSPEC *pss) const { return 0; }
+PSTREAM_HANDLE VESSEL::AddExhaustStream (THRUSTER_HANDLE th, const VECTOR3 &pos, PARTICLESTREAMSPEC *pss) const { return 0; }
+PSTREAM_HANDLE VESSEL::AddParticleStream (PARTICLESTREAMSPEC *pss, const VECTOR3 &pos, const VECTOR3 &dir, double *lvl) const { return 0; }
+bool VESSEL::DelExhaustStream (PSTREAM_HANDLE ch) const { return false; }
+void VESSEL::AddBeacon (BEACONLIGHTSPEC *bs) {}
+
+// Light sources are kept, so the module can switch them, and deleted
+// with the vessel
+LightEmitter *VESSEL::AddPointLight (const VECTOR3 &pos, double range, double att0, double att1, double att2, COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient) const
+{
+	LightEmitter *le = new PointLight (GetHandle(), pos, range, att0, att1, att2, diffuse, specular, ambient);
+	vessel->light.push_back (le);
+	return le;
+}
+
+LightEmitter *VESSEL::AddSpotLight (const VECTOR3 &pos, const VECTOR3 &dir, double range, double att0, double att1, double att2, double umbra, double penumbra, COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient) const
+{
+	LightEmitter *le = new SpotLight (GetHandle(), pos, dir, range, att0, att1, att2, umbra, penumbra, diffuse, specular, ambient);
+	vessel->light.push_back (le);
+	return le;
+}
+
+// --------------------------------------------------------------
+// Aerodynamics
+
+void VESSEL::CreateAirfoil (AIRFOIL_ORIENTATION align, const VECTOR3 &ref, AirfoilCoeffFunc cf, double c, double S, double A) const
+{
+	BenchAirfoil *af = new BenchAirfoil;
+	af->align = align;
+	af->cf0 = cf;
+	af->cf = 0;
+	af->context = 0;
+	af->c = c, af->S = S, af->A = A;
+	vessel->airfoil.push_back (af);
+}
+
+AIRFOILHANDLE VESSEL::CreateAirfoil3 (AIRFOIL_ORIENTATION align, const VECTOR3 &ref, AirfoilCoeffFuncEx cf, void *context, double c, double S, double A) const
+{
+	BenchAirfoil *af = new BenchAirfoil;
+	af->align = align;
+	af->cf0 = 0;
+	af->cf = cf;
+	af->context = context;
+	af->c = c, af->S = S, af->A = A;
+	vessel->airfoil.push_back (af);
+	return (AIRFOILHANDLE)af;
+}
+
+void VESSEL::EditAirfoil (AIRFOILHANDLE hAirfoil, DWORD flag, const VECTOR3 &ref, AirfoilCoeffFunc cf, double c, double S, double A) const
+{
+	BenchAirfoil *af = (BenchAirfoil*)hAirfoil;
+	if (flag & 0x02) af->cf0 = cf, af->cf = 0;
+	if (flag & 0x04) af->c = c;
+	if (flag & 0x08) af->S = S;
+	if (flag & 0x10) af->A = A;
+}
+
+void VESSEL::ClearAirfoilDefinitions () const
+{
+	for (size_t i = 0; i < vessel->airfoil.size(); i++) delete vessel->airfoil[i];
+	vessel->airfoil.clear();
+}
+
+// Parameters of the legacy flight model, which the stand-in does not have
+void VESSEL::SetCW (double cw_z_pos, double cw_z_neg, double cw_x, double cw_y) const {}
+void VESSEL::SetWingAspect (double aspect) const {}
+void VESSEL::SetWingEffectiveness (double eff) const {}
+void VESSEL::CreateVariableDragElement (double *drag, double factor, const VECTOR3 &ref) const {}
+
+void VESSEL::CreateControlSurface (AIRCTRL_TYPE type, double area, double dCl, const VECTOR3 &ref, int axis, UINT anim) const
+{
+	CreateControlSurface2 (type, area, dCl, ref, axis, anim);
+}
+
+CTRLSURFHANDLE VESSEL::CreateControlSurface2 (AIRCTRL_TYPE type, double area, double dCl, const VECTOR3 &ref, int axis, UINT anim) const
+{
+	BenchCtrlSurf *cs = new BenchCtrlSurf;
+	cs->type = type;
+	cs->area = area, cs->dCl = dCl;
+	cs->anim = anim;
+	vessel->ctrlsurf.push_back (cs);
+	return (CTRLSURFHANDLE)cs;
+}
+
+CTRLSURFHANDLE VESSEL::CreateControlSurface3 (AIRCTRL_TYPE type, double area, double dCl, const VECTOR3 &ref, int axis, double delay, UINT anim) const
+{
+	return CreateControlSurface2 (type, area, dCl, ref, axis, anim);
+}
+
+bool VESSEL::DelControlSurface (CTRLSURFHANDLE hCtrlSurf) const
+{
+	for (size_t i = 0; i < vessel->ctrlsurf.size(); i++)
+		if (vessel->ctrlsurf[i] == hCtrlSurf) {
+			delete vessel->ctrlsurf[i];
+			vessel->ctrlsurf.erase (vessel->ctrlsurf.begin()+i);
+			return true;
+		}
+	return false;
+}
+
+// The level moves the animations of the surfaces of that type at once
+// (no control surface delay)
+void VESSEL::SetControlSurfaceLevel (AIRCTRL_TYPE type, double level) const
+{
+	level = max (-1.0, min (level, 1.0));
+	vessel->ctrllevel[type] = level;
+	for (size_t i = 0; i < vessel->ctrlsurf.size(); i++)
+		if (vessel->ctrlsurf[i]->type == type && vessel->ctrlsurf[i]->anim != (UINT)-1)
+			SetAnimation (vessel->ctrlsurf[i]->anim, 0.5*(level+1.0));
+}
+
+double VESSEL::GetControlSurfaceLevel (AIRCTRL_TYPE type) const
+{
+	return vessel->ctrllevel[type];
+}
+
+// --------------------------------------------------------------
+// Attachment points. Vessels keep the attitude of the global frame,
+// so local and global axes coincide.
+
+ATTACHMENTHANDLE VESSEL::CreateAttachment (bool toparent, const VECTOR3 &pos, const VECTOR3 &dir, const VECTOR3 &rot, const char *id, bool loose) const
+{
+	BenchAttachment *at = new BenchAttachment;
+	at->toparent = toparent;
+	at->pos = pos, at->dir = dir, at->rot = rot;
+	strncpy (at->id, id, 8); at->id[8] = '\0';
+	vessel->attach.push_back (at);
+	return (ATTACHMENTHANDLE)at;
+}
+
+DWORD VESSEL::AttachmentCount (bool toparent) const
+{
+	DWORD n = 0;
+	for (size_t i = 0; i < vessel->attach.size(); i++)
+		if (vessel->attach[i]->toparent == toparent) n++;
+	return n;
+}
+
+ATTACHMENTHANDLE VESSEL::GetAttachmentHandle (bool toparent, DWORD i) const
+{
+	for (size_t j = 0; j < vessel->attach.size(); j++)
+		if (vessel->attach[j]->toparent == toparent && !i--) return (ATTACHMENTHANDLE)vessel->attach[j];
+	return 0;
+}
+
+const char *VESSEL::GetAttachmentId (ATTACHMENTHANDLE attachment) const
+{
+	return ((BenchAttachment*)attachment)->id;
+}
+
+void VESSEL::GetAttachmentParams (ATTACHMENTHANDLE attachment, VECTOR3 &pos, VECTOR3 &dir, VECTOR3 &rot) const
+{
+	BenchAttachment *at = (BenchAttachment*)attachment;
+	pos = at->pos, dir = at->dir, rot = at->rot;
+}
+
+void VESSEL::Local2Global (const VECTOR3 &local, VECTOR3 &global) const
+{
+	global = vessel->gpos + local;
+}
+
+void VESSEL::GlobalRot (const VECTOR3 &rloc, VECTOR3 &rglob) const
+{
+	rglob = rloc;
+}
+
+// Vessels are not attached to or docked with each other
+bool VESSEL::AttachChild (OBJHANDLE child, ATTACHMENTHANDLE attachment, ATTACHMENTHANDLE child_attachment) const { return false; }
+bool VESSEL::DetachChild (ATTACHMENTHANDLE attachment, double vel) const { return false; }
+OBJHANDLE VESSEL::GetAttachmentStatus (ATTACHMENTHANDLE attachment) const { return 0; }
+bool VESSEL::Undock (UINT n, const OBJHANDLE exclude) const { return false; }
+
+// --------------------------------------------------------------
+// Animations
+
+UINT VESSEL::CreateAnimation (double initial_state) const
+{
+	BenchAnimation *a = new BenchAnimation;
+	a->state = a->defstate = initial_state;
+	vessel->anim.push_back (a);
+	return (UINT)vessel->anim.size()-1;
+}
+
+ANIMATIONCOMPONENT_HANDLE VESSEL::AddAnimationComponent (UINT anim, double state0, double state1,
+	MGROUP_TRANSFORM *trans, ANIMATIONCOMPONENT_HANDLE parent) const
+{
+	if (anim >= vessel->anim.size()) return 0;
+	BenchAnimComp *c = new BenchAnimComp;
+	c->state0 = state0;
+	c->state1 = state1;
+	c->trans = trans;
+	c->parent = (BenchAnimComp*)parent;
+	vessel->anim[anim]->comp.push_back (c);
+	return (ANIMATIONCOMPONENT_HANDLE)c;
+}
+
+bool VESSEL::SetAnimation (UINT anim, double state) const
+{
+	if (anim >= vessel->anim.size()) return false;
+	vessel->anim[anim]->state = state;
+	return true;
+}
+
+// ==============================================================
+// class VESSEL2: default callbacks
+
+VESSEL2::VESSEL2 (OBJHANDLE hVessel, int fmodel): VESSEL (hVessel, fmodel) { version = 1; }
+
+void VESSEL2::clbkSetClassCaps (FILEHANDLE cfg) {}
+void VESSEL2::clbkSaveState (FILEHANDLE scn) {}
+void VESSEL2::clbkLoadStateEx (FILEHANDLE scn, void *status)
+{
+	char *line;
+	while (oapiReadScenario_nextline (scn, line));
+}
+void VESSEL2::clbkSetStateEx (const void *status) {}
+void VESSEL2::clbkPostCreation () {}
+void VESSEL2::clbkFocusChanged (bool getfocus, OBJHANDLE hNewVessel, OBJHANDLE hOldVessel) {}
+void VESSEL2::clbkPreStep (double simt, double simdt, double mjd) {}
+void VESSEL2::clbkPostStep (double simt, double simdt, double mjd) {}
+bool VESSEL2::clbkPlaybackEvent (double simt, double event_t, const char *event_type, const char *event) { return false; }
+void VESSEL2::clbkVisualCreated (VISHANDLE vis, int refcount) {}
+void VESSEL2::clbkVisualDestroyed (VISHANDLE vis, int refcount) {}
+void VESSEL2::clbkDrawHUD (int mode, const HUDPAINTSPEC *hps, HDC hDC) {}
+void VESSEL2::clbkRCSMode (int mode) {}
+void VESSEL2::clbkADCtrlMode (DWORD mode) {}
+void VESSEL2::clbkHUDMode (int mode) {}
+void VESSEL2::clbkMFDMode (int mfd, int mode) {}
+void VESSEL2::clbkNavMode (int mode, bool active) {}
+void VESSEL2::clbkDockEvent (int dock, OBJHANDLE mate) {}
+void VESSEL2::clbkAnimate (double simt) {}
+int VESSEL2::clbkConsumeDirectKey (char *kstate) { return 0; }
+int VESSEL2::clbkConsumeBufferedKey (DWORD key, bool down, char *kstate) { return 0; }
+bool VESSEL2::clbkLoadGenericCockpit () { return false; }
+bool VESSEL2::clbkLoadPanel (int id) { return false; }
+bool VESSEL2::clbkPanelMouseEvent (int id, int event, int mx, int my) { return false; }
+bool VESSEL2::clbkPanelRedrawEvent (int id, int event, SURFHANDLE surf) { return false; }
+bool VESSEL2::clbkLoadVC (int id) { return false; }
+bool VESSEL2::clbkVCMouseEvent (int id, int event, VECTOR3 &p) { return false; }
+bool VESSEL2::clbkVCRedrawEvent (int id, int event, SURFHANDLE surf) { return false; }
+
+// ==============================================================
+// class VESSEL3: default callbacks
+
+VESSEL3::VESSEL3 (OBJHANDLE hVessel, int fmodel): VESSEL2 (hVessel, fmodel) { version = 2; }
+
+bool VESSEL3::clbkPanelMouseEvent (int id, int event, int mx, int my, void *context) { return false; }
+bool VESSEL3::clbkPanelRedrawEvent (int id, int event, SURFHANDLE surf, void *context) { return false; }
+int VESSEL3::clbkGeneric (int msgid, int prm, void *context) { return 0; }
+bool VESSEL3::clbkLoadPanel2D (int id, PANELHANDLE hPanel, DWORD viewW, DWORD viewH) { return false; }
+bool VESSEL3::clbkDrawHUD (int mode, const HUDPAINTSPEC *hps, oapi::Sketchpad *skp) { return false; }
+void VESSEL3::clbkRenderHUD (int mode, const HUDPAINTSPEC *hps, SURFHANDLE hDefaultTex) {}
+void VESSEL3::clbkGetRadiationForce (const VECTOR3 &mflux, VECTOR3 &F, VECTOR3 &pos) {}
+
+// 2-D panels are not displayed
+int VESSEL3::SetPanelBackground (PANELHANDLE hPanel, SURFHANDLE *hSurf, DWORD nsurf, MESHHANDLE hMesh, DWORD width, DWORD height, DWORD baseline, DWORD scrollflag) { return 0; }
+int VESSEL3::SetPanelScaling (PANELHANDLE hPanel, double defscale, double extscale) { return 0; }
+int VESSEL3::RegisterPanelArea (PANELHANDLE hPanel, int id, const RECT &pos, int draw_event, int mouse_event, SURFHANDLE surf, void *context) { return 0; }
+int VESSEL3::RegisterPanelMFDGeometry (PANELHANDLE hPanel, int MFD_id, int nmesh, int ngroup) { return 0; }
+
+// ==============================================================
+// Light sources
+
+LightEmitter::LightEmitter (COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient)
+{
+	ltype = LT_NONE;
+	hRef = 0;
+	active = true;
+	col_diff = diffuse, col_spec = specular, col_ambi = ambient;
+	lintens = 1.0;
+	intens = &lintens;
+	lpos = ldir = _V(0,0,0);
+	pos = &lpos, dir = &ldir;
+}
+
+void LightEmitter::Activate (bool act) { active = act; }
+bool LightEmitter::IsActive () const { return active; }
+void LightEmitter::SetIntensity (double in) { lintens = in; intens = &lintens; }
+double LightEmitter::GetIntensity () const { return *intens; }
+void LightEmitter::SetIntensityRef (double *pin) { intens = pin; }
+
+PointLight::PointLight (OBJHANDLE hObj, const VECTOR3 &_pos, double _range, double att0, double att1, double att2, COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient)
+: LightEmitter (diffuse, specular, ambient)
+{
+	ltype = LT_POINT;
+	hRef = hObj;
+	lpos = _pos;
+	range = _range;
+	att[0] = att0, att[1] = att1, att[2] = att2;
+}
+
+SpotLight::SpotLight (OBJHANDLE hObj, const VECTOR3 &_pos, const VECTOR3 &_dir, double _range, double att0, double att1, double att2, double _umbra, double _penumbra, COLOUR4 diffuse, COLOUR4 specular, COLOUR4 ambient)
+: PointLight (hObj, _pos, _range, att0, att1, att2, diffuse, specular, ambient)
+{
+	ltype = LT_SPOT;
+	ldir = _dir;
+	umbra = _umbra, penumbra = _penumbra;
+}
@@ -0,0 +1,135 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Actuator.cpp
+// Data-driven operation of two-state animated systems
+// ==============================================================
+
+#include "Actuator.h"
+#include <stdio.h>
+
+// ==============================================================
+
+ActuatorSet::ActuatorSet ()
+{
+	vessel = 0;
+	context = 0;
+	nactive = 0;
+	for (int i = 0; i < ACT_MAXACTUATOR; i++) {
+		act[i].state.Set (AnimState::CLOSED, 0.0);
+		act[i].speed = 0.0;
+		act[i].anim = ACT_NOANIM;
+		act[i].moved = act[i].done = 0;
+		act[i].active = false;
+	}
+}
+
+// --------------------------------------------------------------
+
+void ActuatorSet::Init (VESSEL *_vessel, void *_context)
+{
+	vessel = _vessel;
+	context = _context;
+}
+
+// --------------------------------------------------------------
+
+void ActuatorSet::Define (int id, double speed, UINT anim, ActuatorClbk moved, ActuatorClbk done)
+{
+	Actuator &a = act[id];
+	a.speed = speed;
+	a.anim = anim;
+	a.moved = moved;
+	a.done = done;
+}
+
+// --------------------------------------------------------------
+
+void ActuatorSet::Operate (int id, AnimState::Action action)
+{
+	Actuator &a = act[id];
+	a.state.action = action;
+	if (action == AnimState::CLOSED || action == AnimState::OPEN) {
+		a.state.pos = (action == AnimState::CLOSED ? 0.0 : 1.0);
+		if (a.anim != ACT_NOANIM) vessel->SetAnimation (a.anim, a.state.pos);
+	} else if (action != AnimState::STOPPED) {
+		Activate (id);
+	}
+	// actuators that came to rest are removed from the list in the next step
+}
+
+// --------------------------------------------------------------
+
+void ActuatorSet::Update ()
+{
+	for (int i = 0; i < ACT_MAXACTUATOR; i++) {
+		Actuator &a = act[i];
+		if (a.state.Moving()) Activate (i);
+		if (a.anim != ACT_NOANIM) vessel->SetAnimation (a.anim, a.state.pos);
+	}
+}
+
+// --------------------------------------------------------------
+
+void ActuatorSet::Activate (int id)
+{
+	if (!act[id].active) {
+		act[id].active = true;
+		active[nactive++] = id;
+	}
+}
+
+// --------------------------------------------------------------
+
+void ActuatorSet::Step (double dt)
+{
+	if (!nactive) return;
+
+	int i, n = 0;
+	int moved[ACT_MAXACTUATOR];
+
+	// advance the active actuators, and drop those at rest
+	for (i = 0; i < nactive;) {
+		Actuator &a = act[active[i]];
+		if (a.state.Move (dt*a.speed)) moved[n++] = active[i];
+		if (a.state.Static()) {
+			a.active = false;
+			active[i] = active[--nactive];
+		} else i++;
+	}
+
+	// apply animation states of the actuators that moved
+	for (i = 0; i < n; i++) {
+		Actuator &a = act[moved[i]];
+		if (a.anim != ACT_NOANIM) vessel->SetAnimation (a.anim, a.state.pos);
+	}
+
+	// notify the owner (callbacks may operate other actuators)
+	for (i = 0; i < n; i++) {
+		Actuator &a = act[moved[i]];
+		if (a.moved) a.moved (context, moved[i], a.state);
+		if (a.done && a.state.Static()) a.done (context, moved[i], a.state);
+	}
+}
+
+// ==============================================================
+
+void sscan_doorstate (const char *str, AnimState &s)
+{
+	int status;
+	double pos;
+	if (sscanf (str, "%d%lf", &status, &pos) == 2 && status >= 0 && status <= 3)
+		s.Set ((AnimState::Action)(status+1), pos);
+}
+
+// --------------------------------------------------------------
+
+void WriteScenario_doorstate (FILEHANDLE scn, char *tag, const AnimState &s)
+{
+	char cbuf[64];
+	sprintf (cbuf, "%d %0.4f", s.action == AnimState::STOPPED ? 0 : s.action-1, s.pos);
+	oapiWriteScenario_string (scn, tag, cbuf);
+}
@@ -0,0 +1,97 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Actuator.h
+// Data-driven operation of doors, landing gear and other two-state
+// animated systems (DeltaGlider, ShuttleA, Atlantis)
+// ==============================================================
+
+#ifndef __ACTUATOR_H
+#define __ACTUATOR_H
+
+#include "orbitersdk.h"
+
+const int ACT_MAXACTUATOR = 16;        // max number of actuators per set
+const UINT ACT_NOANIM = (UINT)-1;      // actuator without a vessel animation
+
+// Actuator callback. Receives the context pointer of the actuator set,
+// the actuator id and the actuator state.
+typedef void (*ActuatorClbk)(void *context, int id, const AnimState &state);
+
+// ==============================================================
+// Actuator set
+//
+// Holds the states of all actuators of a vessel in a single array.
+// Actuators that are in motion are kept in an active list, so that
+// actuators at rest cost nothing per time step. Each step advances the
+// active actuators, applies the animation states of those that moved,
+// and then invokes their callbacks: 'moved' for every step in which
+// the actuator moved, and 'done' once it has reached its end position.
+//
+// The state records are owned by the set. Vessels may keep references
+// to them (see State), but the action of an actuator should only be
+// changed via Operate, or followed by a call to Update.
+
+class ActuatorSet {
+public:
+	ActuatorSet ();
+
+	// Set the vessel owning the animations, and the context pointer
+	// passed to the callbacks
+	void Init (VESSEL *_vessel, void *_context = 0);
+
+	// Define actuator id (0 <= id < ACT_MAXACTUATOR) with its operating
+	// speed [1/s], animation and callbacks
+	void Define (int id, double speed, UINT anim = ACT_NOANIM,
+		ActuatorClbk moved = 0, ActuatorClbk done = 0);
+
+	// State record of actuator id
+	inline AnimState &State (int id) { return act[id].state; }
+	inline const AnimState &State (int id) const { return act[id].state; }
+
+	// Set the action of actuator id. CLOSING and OPENING start the
+	// actuator, CLOSED and OPEN move it to the end position immediately,
+	// and STOPPED halts it at its current position. No callbacks are
+	// invoked.
+	void Operate (int id, AnimState::Action action);
+
+	// Rebuild the active list and apply the animation states of all
+	// actuators after states were modified directly (scenario parsing)
+	void Update ();
+
+	// Advance the active actuators by time step dt
+	void Step (double dt);
+
+	// Number of actuators in motion
+	inline int nActive () const { return nactive; }
+
+private:
+	void Activate (int id);
+
+	struct Actuator {
+		AnimState state;      // action and position (0=closed, 1=open)
+		double speed;         // operating speed [1/s]
+		UINT anim;            // vessel animation (or ACT_NOANIM)
+		ActuatorClbk moved;   // called after each step in motion
+		ActuatorClbk done;    // called when the end position is reached
+		bool active;          // actuator in active list
+	} act[ACT_MAXACTUATOR];
+
+	int active[ACT_MAXACTUATOR]; // ids of actuators in motion
+	int nactive;                 // length of active list
+	VESSEL *vessel;              // vessel owning the animations
+	void *context;               // callback context
+};
+
+// ==============================================================
+// Scenario I/O of actuator states in the door status format used by
+// the DeltaGlider and ShuttleA scenarios: "<status> <position>" with
+// status 0=closed, 1=open, 2=closing, 3=opening
+
+void sscan_doorstate (const char *str, AnimState &s);
+void WriteScenario_doorstate (FILEHANDLE scn, char *tag, const AnimState &s);
+
+#endif // !__ACTUATOR_H
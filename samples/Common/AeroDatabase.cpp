@@ -0,0 +1,249 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AeroDatabase.cpp
+// Airfoil coefficient database loaded from file
+// ==============================================================
+
+#include "AeroDatabase.h"
+#include <xmmintrin.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+AeroDatabase *AeroDatabase::first = 0;
+
+// ==============================================================
+
+AeroDatabase::AeroDatabase ()
+{
+	path[0] = '\0';
+	nref = 0;
+	next = 0;
+	data = 0;
+	size = 0;
+	buf = 0;
+	hFile = hMap = NULL;
+	for (DWORD i = 0; i < AERODB_NTABLE; i++) tab[i] = 0;
+}
+
+// --------------------------------------------------------------
+
+AeroDatabase::~AeroDatabase ()
+{
+	if (buf) delete []buf;
+	else if (data) UnmapViewOfFile (data);
+	if (hMap) CloseHandle (hMap);
+	if (hFile) CloseHandle (hFile);
+}
+
+// --------------------------------------------------------------
+
+AeroDatabase *AeroDatabase::Load (const char *fname)
+{
+	AeroDatabase *db;
+	for (db = first; db; db = db->next)
+		if (!strcmp (db->path, fname)) {
+			db->nref++;
+			return db;
+		}
+
+	// binary files start with the header magic
+	char magic[4] = {0,0,0,0};
+	FILE *f = fopen (fname, "rb");
+	if (!f) return 0;
+	fread (magic, 1, 4, f);
+	fclose (f);
+
+	db = new AeroDatabase;
+	bool ok = (!strncmp (magic, "ADB1", 4) ? db->Map (fname) : db->Parse (fname));
+	if (!ok || !db->Index()) {
+		char cbuf[300];
+		sprintf (cbuf, "AeroDatabase: failed to load %.255s", fname);
+		oapiWriteLog (cbuf);
+		delete db;
+		return 0;
+	}
+	strncpy (db->path, fname, 255); db->path[255] = '\0';
+	db->nref = 1;
+	db->next = first;
+	first = db;
+	return db;
+}
+
+// --------------------------------------------------------------
+
+void AeroDatabase::Release ()
+{
+	if (--nref) return;
+	AeroDatabase **pdb;
+	for (pdb = &first; *pdb != this; pdb = &(*pdb)->next);
+	*pdb = next;
+	delete this;
+}
+
+// --------------------------------------------------------------
+
+bool AeroDatabase::WriteBinary (const char *fname) const
+{
+	FILE *f = fopen (fname, "wb");
+	if (!f) return false;
+	bool ok = (fwrite (data, 1, size, f) == size);
+	fclose (f);
+	return ok;
+}
+
+// --------------------------------------------------------------
+
+bool AeroDatabase::Map (const char *fname)
+{
+	hFile = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		hFile = NULL;
+		return false;
+	}
+	size = GetFileSize (hFile, NULL);
+	if (size < sizeof(AeroDbHeader)) return false;
+	if (!(hMap = CreateFileMapping (hFile, NULL, PAGE_READONLY, 0, 0, NULL))) return false;
+	data = (const char*)MapViewOfFile (hMap, FILE_MAP_READ, 0, 0, 0);
+	return data != 0;
+}
+
+// --------------------------------------------------------------
+
+bool AeroDatabase::Parse (const char *fname)
+{
+	FILE *f = fopen (fname, "rt");
+	if (!f) return false;
+
+	AeroDbTable hdr[AERODB_NTABLE];
+	float *node[AERODB_NTABLE];
+	char line[1024], *tok, *c;
+	DWORD i, t = 0, nval = 0, nexp = 0;
+	bool ok = true;
+	for (i = 0; i < AERODB_NTABLE; i++) node[i] = 0;
+
+	while (ok && fgets (line, 1024, f)) {
+		if ((c = strchr (line, ';'))) *c = '\0';
+		for (tok = strtok (line, " \t\r\n"); tok; tok = strtok (0, " \t\r\n")) {
+			if (nval < nexp) { // coefficient triplet (cl, cm, cd)
+				double v = strtod (tok, &c);
+				if (c == tok || *c) { ok = false; break; } // table too short
+				node[t][(nval/3)*4 + nval%3] = (float)v;
+				nval++;
+				continue;
+			}
+			// table header
+			double a0, a1, m0, m1;
+			int na, nm;
+			if      (!strcmp (tok, "VERTICAL"))   t = AERODB_VERTICAL;
+			else if (!strcmp (tok, "HORIZONTAL")) t = AERODB_HORIZONTAL;
+			else { ok = false; break; }
+			c = strtok (0, "");
+			if (node[t] || !c || sscanf (c, "%lf%lf%d%lf%lf%d", &a0, &a1, &na, &m0, &m1, &nm) != 6 ||
+				na < 2 || nm < 2 || a1 <= a0 || m1 <= m0) { ok = false; break; }
+			AeroDbTable &h = hdr[t];
+			memset (&h, 0, sizeof(AeroDbTable));
+			h.type = t;
+			h.na = na, h.nm = nm;
+			h.a0 = (float)(a0*RAD), h.ida = (float)((na-1)/((a1-a0)*RAD));
+			h.m0 = (float)m0,       h.idm = (float)((nm-1)/(m1-m0));
+			node[t] = new float[na*nm*4];
+			memset (node[t], 0, na*nm*4*sizeof(float));
+			nval = 0, nexp = 3*na*nm;
+			break; // rest of line consumed by header
+		}
+	}
+	fclose (f);
+	if (nval < nexp) ok = false;
+
+	// assemble the image in binary layout
+	if (ok) {
+		DWORD ntab = 0;
+		size = sizeof(AeroDbHeader);
+		for (i = 0; i < AERODB_NTABLE; i++)
+			if (node[i]) {
+				size += sizeof(AeroDbTable) + hdr[i].na*hdr[i].nm*4*sizeof(float);
+				ntab++;
+			}
+		if (ntab) {
+			data = buf = new char[size];
+			AeroDbHeader *h = (AeroDbHeader*)buf;
+			memcpy (h->magic, "ADB1", 4);
+			h->ntable = ntab;
+			h->size = size;
+			h->pad = 0;
+			char *p = buf + sizeof(AeroDbHeader);
+			for (i = 0; i < AERODB_NTABLE; i++)
+				if (node[i]) {
+					DWORD nsize = hdr[i].na*hdr[i].nm*4*sizeof(float);
+					memcpy (p, hdr+i, sizeof(AeroDbTable)); p += sizeof(AeroDbTable);
+					memcpy (p, node[i], nsize); p += nsize;
+				}
+		} else ok = false;
+	}
+	for (i = 0; i < AERODB_NTABLE; i++)
+		if (node[i]) delete []node[i];
+	return ok;
+}
+
+// --------------------------------------------------------------
+
+bool AeroDatabase::Index ()
+{
+	const AeroDbHeader *h = (const AeroDbHeader*)data;
+	if (size < sizeof(AeroDbHeader) || strncmp (h->magic, "ADB1", 4) || h->size != size)
+		return false;
+	DWORD i, nnode, ofs = sizeof(AeroDbHeader);
+	for (i = 0; i < h->ntable; i++) {
+		if (size - ofs < sizeof(AeroDbTable)) return false;
+		const AeroDbTable *t = (const AeroDbTable*)(data+ofs);
+		if (t->type >= AERODB_NTABLE || t->na < 2 || t->nm < 2) return false;
+		ofs += sizeof(AeroDbTable);
+		// node count against the nodes left in the image (na*nm in
+		// DWORD can wrap for a corrupt header)
+		nnode = (size - ofs)/(4*sizeof(float));
+		if (t->na > nnode || t->nm > nnode/t->na) return false;
+		ofs += t->na*t->nm*4*sizeof(float);
+		tab[t->type] = t;
+	}
+	return true;
+}
+
+// ==============================================================
+
+void AeroDbCoeff (VESSEL *v, double aoa, double M, double Re, void *context,
+	double *cl, double *cm, double *cd)
+{
+	const AeroDbTable *t = (const AeroDbTable*)context;
+	int i, j;
+	double fa, fm;
+
+	// grid cell and interpolation weights, clamped to the grid
+	// (the comparisons are written so that NaN inputs map to node 0)
+	fa = (aoa - t->a0)*t->ida;
+	if (!(fa > 0.0)) i = 0, fa = 0.0;
+	else if (fa >= (double)(t->na-1)) i = t->na-2, fa = 1.0;
+	else i = (int)fa, fa -= i;
+	fm = (M - t->m0)*t->idm;
+	if (!(fm > 0.0)) j = 0, fm = 0.0;
+	else if (fm >= (double)(t->nm-1)) j = t->nm-2, fm = 1.0;
+	else j = (int)fm, fm -= j;
+
+	// bilinear interpolation of the {cl, cm, cd} nodes
+	const float *p = t->Node() + 4*(j*t->na + i);
+	const float *q = p + 4*t->na;
+	__m128 wa = _mm_set1_ps ((float)fa);
+	__m128 n0 = _mm_loadu_ps (p), n1 = _mm_loadu_ps (q);
+	__m128 r0 = _mm_add_ps (n0, _mm_mul_ps (_mm_sub_ps (_mm_loadu_ps (p+4), n0), wa));
+	__m128 r1 = _mm_add_ps (n1, _mm_mul_ps (_mm_sub_ps (_mm_loadu_ps (q+4), n1), wa));
+	__m128 r  = _mm_add_ps (r0, _mm_mul_ps (_mm_sub_ps (r1, r0), _mm_set1_ps ((float)fm)));
+	float c[4];
+	_mm_storeu_ps (c, r);
+	*cl = c[0];
+	*cm = c[1];
+	*cd = c[2];
+}
@@ -0,0 +1,104 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AeroDatabase.h
+// Airfoil coefficient database loaded from file, providing lift,
+// moment and drag coefficients over angle of attack (or sideslip)
+// and Mach number
+// ==============================================================
+
+#ifndef __AERODATABASE_H
+#define __AERODATABASE_H
+
+#include "orbitersdk.h"
+
+const DWORD AERODB_VERTICAL   = 0;  // cl, cm, cd over aoa x Mach
+const DWORD AERODB_HORIZONTAL = 1;  // cl, cm, cd over sideslip x Mach
+const DWORD AERODB_NTABLE     = 2;
+
+// ==============================================================
+// File formats
+//
+// Text:
+//   ; comment (to end of line)
+//   VERTICAL <amin> <amax> <na> <mmin> <mmax> <nm>
+//   <cl> <cm> <cd>   ; na*nm triplets, angle index running fastest
+//   HORIZONTAL <bmin> <bmax> <nb> <mmin> <mmax> <nm>
+//   <cl> <cm> <cd>   ; nb*nm triplets
+// Angles are in degrees, nodes are equidistant, na,nm >= 2. Either
+// table is optional. Coefficients outside the grid are clamped to the
+// grid boundary.
+//
+// Binary (written by WriteBinary, memory-mapped on load):
+//   AeroDbHeader, followed by ntable x (AeroDbTable, na*nm nodes),
+//   each node 4 floats {cl, cm, cd, 0}, 16-byte aligned.
+
+struct AeroDbHeader {
+	char magic[4];         // "ADB1"
+	DWORD ntable;          // number of tables
+	DWORD size;            // file size [bytes]
+	DWORD pad;
+};
+
+struct AeroDbTable {
+	DWORD type;            // AERODB_VERTICAL or AERODB_HORIZONTAL
+	DWORD na, nm;          // number of angle and Mach nodes
+	DWORD pad;
+	float a0, ida;         // first angle node [rad], inverse angle step
+	float m0, idm;         // first Mach node, inverse Mach step
+	inline const float *Node () const { return (const float*)(this+1); }
+};
+
+// ==============================================================
+// Aerodynamic database
+//
+// Databases are shared: all vessels loading the same file (e.g. all
+// instances of a vessel class) use a single instance. Load in
+// clbkSetClassCaps, and Release in the vessel destructor.
+
+class AeroDatabase {
+public:
+	// Load database file path (binary or text), or return the
+	// instance already loaded from path. Returns NULL on failure.
+	static AeroDatabase *Load (const char *path);
+
+	// Release a database obtained by Load
+	void Release ();
+
+	// Coefficient table of the given type, or NULL if not defined
+	inline const AeroDbTable *Table (DWORD type) const
+	{ return (type < AERODB_NTABLE ? tab[type] : 0); }
+
+	// Write the database in binary format
+	bool WriteBinary (const char *path) const;
+
+private:
+	AeroDatabase ();
+	~AeroDatabase ();
+	bool Map (const char *path);   // map a binary file
+	bool Parse (const char *path); // read a text file
+	bool Index ();                 // set up table pointers
+
+	char path[256];        // file path
+	int nref;              // reference count
+	AeroDatabase *next;    // next loaded database
+
+	const char *data;      // database image (binary layout)
+	DWORD size;            // image size [bytes]
+	char *buf;             // image buffer for text files
+	HANDLE hFile, hMap;    // file mapping for binary files
+	const AeroDbTable *tab[AERODB_NTABLE];
+
+	static AeroDatabase *first; // list of loaded databases
+};
+
+// Airfoil coefficient callback for CreateAirfoil3, with the table
+// (AeroDatabase::Table) passed as context. Bilinear interpolation
+// over angle and Mach number.
+void AeroDbCoeff (VESSEL *v, double aoa, double M, double Re, void *context,
+	double *cl, double *cm, double *cd);
+
+#endif // !__AERODATABASE_H
@@ -0,0 +1,75 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AeroTable.cpp
+// Precomputed airfoil coefficient tables
+// ==============================================================
+
+#include "AeroTable.h"
+#include <math.h>
+
+// ==============================================================
+
+AeroTable::AeroTable ()
+{
+	aoatab = 0;
+	naoa = 0;
+	iastep = 0.0;
+	wave = 0;
+	nmach = 0;
+	imstep = 0.0;
+}
+
+// --------------------------------------------------------------
+
+AeroTable::~AeroTable ()
+{
+	if (aoatab) delete []aoatab;
+	if (wave) delete []wave;
+}
+
+// --------------------------------------------------------------
+
+void AeroTable::SetLift (int nabsc, const double *aoa, const double *cl, const double *cm,
+	double cd0, double cdk, double A, double e)
+{
+	int i, j;
+	double *a = new double[nabsc];
+	for (i = 0; i < nabsc; i++)
+		a[i] = (aoa ? aoa[i] : -PI + i*(2.0*PI/(nabsc-1)));
+
+	if (aoatab) delete []aoatab;
+	naoa = (int)(2.0*PI/AERO_AOASTEP + 0.5) + 1;
+	iastep = (naoa-1)/(2.0*PI);
+	aoatab = new Node[naoa];
+
+	for (i = j = 0; i < naoa; i++) {
+		double x = -PI + i/iastep;
+		// breakpoint segment (as in the piecewise linear lift functions,
+		// extrapolating from the end segments)
+		while (j < nabsc-2 && a[j+1] < x) j++;
+		double f = (x-a[j]) / (a[j+1]-a[j]);
+		Node &n = aoatab[i];
+		n.cl = cl[j] + (cl[j+1]-cl[j])*f;
+		n.cm = (cm ? cm[j] + (cm[j+1]-cm[j])*f : 0.0);
+		double sx = sin(x);
+		n.cd = cd0 + cdk*sx*sx;
+		if (A) n.cd += oapiGetInducedDrag (n.cl, A, e);
+	}
+	delete []a;
+}
+
+// --------------------------------------------------------------
+
+void AeroTable::SetWaveDrag (double M1, double M2, double M3, double cmax)
+{
+	if (wave) delete []wave;
+	nmach = (int)(AERO_MAXMACH/AERO_MACHSTEP + 0.5) + 1;
+	imstep = (nmach-1)/AERO_MAXMACH;
+	wave = new double[nmach];
+	for (int i = 0; i < nmach; i++)
+		wave[i] = oapiGetWaveDrag (i/imstep, M1, M2, M3, cmax);
+}
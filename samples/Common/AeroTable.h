@@ -0,0 +1,100 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AeroTable.h
+// Precomputed airfoil coefficient tables for the lift, moment and
+// drag callbacks of the sample vessels
+// ==============================================================
+
+#ifndef __AEROTABLE_H
+#define __AEROTABLE_H
+
+#include "orbitersdk.h"
+
+const double AERO_AOASTEP  = 0.5*RAD; // aoa grid step [rad]
+const double AERO_MACHSTEP = 0.01;    // Mach grid step
+const double AERO_MAXMACH  = 30.0;    // upper limit of Mach grid
+
+// ==============================================================
+// Airfoil coefficient table
+//
+// Lift, moment and drag coefficients sampled on a uniform aoa grid
+// over -Pi ... Pi, and wave drag sampled on a uniform Mach grid.
+// The tables are built once (at class caps time) from the breakpoints
+// of a piecewise linear lift/moment profile, with the profile drag,
+// induced drag (oapiGetInducedDrag) and wave drag (oapiGetWaveDrag)
+// folded in. Evaluation is an index computation and one linear
+// interpolation per grid.
+// The aoa grid step is chosen so that breakpoints at integer or half
+// degrees fall on grid nodes, which makes cl and cm exact for such
+// profiles.
+
+class AeroTable {
+public:
+	AeroTable ();
+	~AeroTable ();
+
+	// Build the aoa table from nabsc breakpoints (aoa[i], cl[i], cm[i])
+	// of a piecewise linear profile. aoa = NULL defines nabsc equidistant
+	// breakpoints from -Pi to Pi, cm = NULL a zero moment coefficient.
+	// The profile drag cd0 + cdk*sin^2(aoa) and the induced drag for
+	// aspect ratio A and efficiency factor e (A = 0: no induced drag)
+	// are added to the drag coefficient.
+	void SetLift (int nabsc, const double *aoa, const double *cl, const double *cm = 0,
+		double cd0 = 0.0, double cdk = 0.0, double A = 0.0, double e = 1.0);
+
+	// Build the Mach table of the wave drag, using the characteristic
+	// Mach numbers and maximum coefficient of oapiGetWaveDrag
+	void SetWaveDrag (double M1, double M2, double M3, double cmax);
+
+	inline bool Defined () const { return aoatab != 0; }
+
+	// Coefficients at angle of attack aoa [rad] and Mach number M
+	// (compatible with the AirfoilCoeffFunc interface)
+	inline void Eval (double aoa, double M, double *cl, double *cm, double *cd) const
+	{
+		double x = (aoa+PI)*iastep;
+		int i = (int)x;
+		if (i < 0) i = 0; else if (i > naoa-2) i = naoa-2;
+		double f = x-i;
+		const Node &n0 = aoatab[i], &n1 = aoatab[i+1];
+		*cl = n0.cl + (n1.cl-n0.cl)*f;
+		*cm = n0.cm + (n1.cm-n0.cm)*f;
+		*cd = n0.cd + (n1.cd-n0.cd)*f + WaveDrag (M);
+	}
+
+	// Lift coefficient only (for SetLiftCoeffFunc)
+	inline double Cl (double aoa) const
+	{
+		double x = (aoa+PI)*iastep;
+		int i = (int)x;
+		if (i < 0) i = 0; else if (i > naoa-2) i = naoa-2;
+		return aoatab[i].cl + (aoatab[i+1].cl-aoatab[i].cl)*(x-i);
+	}
+
+	// Wave drag coefficient at Mach number M
+	inline double WaveDrag (double M) const
+	{
+		if (!wave) return 0.0;
+		double x = M*imstep;
+		int i = (int)x;
+		if (i >= nmach-1) return wave[nmach-1];
+		return wave[i] + (wave[i+1]-wave[i])*(x-i);
+	}
+
+private:
+	struct Node {
+		double cl, cm, cd;  // coefficients at grid node
+	} *aoatab;              // aoa table
+	int naoa;               // number of aoa nodes
+	double iastep;          // inverse aoa step
+
+	double *wave;           // wave drag table (NULL if none)
+	int nmach;              // number of Mach nodes
+	double imstep;          // inverse Mach step
+};
+
+#endif // !__AEROTABLE_H
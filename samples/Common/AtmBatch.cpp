@@ -0,0 +1,258 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AtmBatch.cpp
+// Batch evaluation of atmospheric parameters for arrays of points,
+// and an SSE2 reference atmosphere
+// ==============================================================
+
+#include "AtmBatch.h"
+#include <emmintrin.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// ==============================================================
+
+int BatchAtmosphere::clbkParamsBatch (const AtmBatchIn *in, double *T, double *p, double *rho)
+{
+	return ParamsLoop (this, in, T, p, rho);
+}
+
+// --------------------------------------------------------------
+
+int BatchAtmosphere::ParamsLoop (ATMOSPHERE *atm, const AtmBatchIn *in, double *T, double *p, double *rho)
+{
+	PRM_IN prm;
+	PRM_OUT out;
+	int i, ndata = 0;
+
+	prm.flag = (in->alt ? PRM_ALT : 0) | (in->lng ? PRM_LNG : 0) | (in->lat ? PRM_LAT : 0) |
+		(in->f107bar ? PRM_FBR : 0) | (in->f107 ? PRM_F : 0) | (in->ap ? PRM_AP : 0);
+	prm.alt = prm.lng = prm.lat = 0.0;
+	prm.f107bar = prm.f107 = 140.0;
+	prm.ap = 3.0;
+	for (i = 0; i < in->n; i++) {
+		if (in->alt)     prm.alt     = in->alt[i];
+		if (in->lng)     prm.lng     = in->lng[i];
+		if (in->lat)     prm.lat     = in->lat[i];
+		if (in->f107bar) prm.f107bar = in->f107bar[i];
+		if (in->f107)    prm.f107    = in->f107[i];
+		if (in->ap)      prm.ap      = in->ap[i];
+		if (atm->clbkParams (&prm, &out)) {
+			T[i] = out.T, p[i] = out.p, rho[i] = out.rho;
+			ndata++;
+		} else
+			T[i] = p[i] = rho[i] = 0.0;
+	}
+	return ndata;
+}
+
+// --------------------------------------------------------------
+
+int AtmParamsBatch (ATMOSPHERE *atm, const AtmBatchIn *in, double *T, double *p, double *rho)
+{
+	BatchAtmosphere *batm = dynamic_cast<BatchAtmosphere*>(atm);
+	if (batm) return batm->clbkParamsBatch (in, T, p, rho);
+	else      return BatchAtmosphere::ParamsLoop (atm, in, T, p, rho);
+}
+
+// --------------------------------------------------------------
+
+double AtmBatchReport (ATMOSPHERE *atm, int n)
+{
+	double *alt = new double[n*7];
+	double *T0 = alt+n, *p0 = T0+n, *rho0 = p0+n, *T1 = rho0+n, *p1 = T1+n, *rho1 = p1+n;
+	AtmBatchIn in;
+	ATMCONST ac;
+	LARGE_INTEGER f, t0, t1, t2;
+	DWORD seed = 12345;
+	int i;
+
+	memset (&ac, 0, sizeof(ATMCONST));
+	atm->clbkConstants (&ac);
+	double hmax = (ac.altlimit > 0.0 ? ac.altlimit : 1e6);
+	for (i = 0; i < n; i++) {
+		seed = seed*1664525 + 1013904223;
+		alt[i] = hmax*(seed >> 8)/16777216.0;
+	}
+	memset (&in, 0, sizeof(AtmBatchIn));
+	in.n = n;
+	in.alt = alt;
+
+	// repeat until each method has run for at least ~0.1 s
+	QueryPerformanceFrequency (&f);
+	LONGLONG tmin = f.QuadPart/10, tb = 0, tl = 0;
+	double nb = 0.0, nl = 0.0;
+	while (tb < tmin || tl < tmin) {
+		QueryPerformanceCounter (&t0);
+		AtmParamsBatch (atm, &in, T0, p0, rho0);
+		QueryPerformanceCounter (&t1);
+		BatchAtmosphere::ParamsLoop (atm, &in, T1, p1, rho1);
+		QueryPerformanceCounter (&t2);
+		tb += t1.QuadPart-t0.QuadPart, nb += n;
+		tl += t2.QuadPart-t1.QuadPart, nl += n;
+	}
+
+	double d, dmax = 0.0;
+	for (i = 0; i < n; i++) {
+		if (T1[i] > 0.0) {
+			if ((d = fabs (T0[i]/T1[i] - 1.0)) > dmax) dmax = d;
+			if ((d = fabs (p0[i]/p1[i] - 1.0)) > dmax) dmax = d;
+			if ((d = fabs (rho0[i]/rho1[i] - 1.0)) > dmax) dmax = d;
+		} else if (T0[i] != 0.0)
+			dmax = 1.0; // data for a point without data
+	}
+	char cbuf[256];
+	sprintf (cbuf, "AtmBatch (%s): %d points, batch %0.3g points/s, clbkParams loop %0.3g points/s, max. rel. difference %0.2g",
+		atm->clbkName(), n, nb*f.QuadPart/tb, nl*f.QuadPart/tl, dmax);
+	oapiWriteLog (cbuf);
+	delete []alt;
+	return dmax;
+}
+
+// ==============================================================
+// Vector functions
+
+// exp(x) for 2 doubles: x = n ln2 + r, |r| <= ln2/2, exp(r) by its
+// Taylor series to order 13, 2^n by constructing the exponent bits
+static inline __m128d vexp (__m128d x)
+{
+	static const double c[14] = {
+		1.0, 1.0, 1.0/2.0, 1.0/6.0, 1.0/24.0, 1.0/120.0, 1.0/720.0, 1.0/5040.0,
+		1.0/40320.0, 1.0/362880.0, 1.0/3628800.0, 1.0/39916800.0,
+		1.0/479001600.0, 1.0/6227020800.0
+	};
+	x = _mm_min_pd (_mm_max_pd (x, _mm_set1_pd (-708.0)), _mm_set1_pd (708.0));
+	__m128i n = _mm_cvtpd_epi32 (_mm_mul_pd (x, _mm_set1_pd (1.4426950408889634))); // round to nearest
+	__m128d fn = _mm_cvtepi32_pd (n);
+	__m128d r = _mm_sub_pd (x, _mm_mul_pd (fn, _mm_set1_pd (6.93147180369123816490e-01)));
+	r = _mm_sub_pd (r, _mm_mul_pd (fn, _mm_set1_pd (1.90821492927058770002e-10)));
+	__m128d y = _mm_set1_pd (c[13]);
+	for (int k = 12; k >= 0; k--)
+		y = _mm_add_pd (_mm_mul_pd (y, r), _mm_set1_pd (c[k]));
+	// n from int32 lanes 0,1 to the low halves of the int64 lanes
+	__m128i e = _mm_shuffle_epi32 (n, _MM_SHUFFLE(3,1,2,0));
+	e = _mm_slli_epi64 (_mm_add_epi32 (e, _mm_set_epi32 (0, 1023, 0, 1023)), 52);
+	return _mm_mul_pd (y, _mm_castsi128_pd (e));
+}
+
+// ln(y) for 2 doubles close to 1 (0.5 ... 2): 2 atanh(s) with
+// s = (y-1)/(y+1), |s| <= 1/3, by its series to order 23
+static inline __m128d vlog1 (__m128d y)
+{
+	const __m128d one = _mm_set1_pd (1.0);
+	__m128d s = _mm_div_pd (_mm_sub_pd (y, one), _mm_add_pd (y, one));
+	__m128d s2 = _mm_mul_pd (s, s);
+	__m128d a = _mm_set1_pd (1.0/23.0);
+	for (int k = 10; k >= 0; k--)
+		a = _mm_add_pd (_mm_mul_pd (a, s2), _mm_set1_pd (1.0/(2*k+1)));
+	return _mm_mul_pd (_mm_add_pd (s, s), a);
+}
+
+// ==============================================================
+
+StdAtmosphere::StdAtmosphere (CELBODY2 *body, const ATMCONST &atmc, double _g0)
+: BatchAtmosphere (body)
+{
+	// US Standard Atmosphere 1976: layer base altitudes [m] and lapse
+	// rates [K/km] for a ground temperature of 288.15 K
+	static const double hb76[ATMB_NLAYER] = {0.0, 11e3, 20e3, 32e3, 47e3, 51e3, 71e3, 84852.0};
+	static const double L76[ATMB_NLAYER]  = {-6.5, 0.0, 1.0, 2.8, 0.0, -2.8, -2.0, 0.0};
+
+	ac = atmc;
+	g0 = _g0;
+	double T0 = ac.p0/(ac.rho0*ac.R);
+	double scale = T0/288.15;
+	for (int i = 0; i < ATMB_NLAYER; i++) {
+		hb[i] = hb76[i];
+		Lb[i] = L76[i]*1e-3*scale;
+		if (i) {
+			double dh = hb[i]-hb[i-1];
+			Tb[i] = Tb[i-1] + Lb[i-1]*dh;
+			lnpb[i] = lnpb[i-1] + Bb[i-1]*dh + Kb[i-1]*log (Tb[i]/Tb[i-1]);
+		} else {
+			Tb[i] = T0;
+			lnpb[i] = log (ac.p0);
+		}
+		Bb[i] = (Lb[i] ? 0.0 : -g0/(ac.R*Tb[i]));
+		Kb[i] = (Lb[i] ? -g0/(ac.R*Lb[i]) : 0.0);
+	}
+}
+
+// --------------------------------------------------------------
+
+bool StdAtmosphere::clbkConstants (ATMCONST *atmc) const
+{
+	atmc->p0 = ac.p0;
+	atmc->rho0 = ac.rho0;
+	atmc->R = ac.R;
+	atmc->gamma = ac.gamma;
+	atmc->altlimit = ac.altlimit;
+	return true;
+}
+
+// --------------------------------------------------------------
+
+bool StdAtmosphere::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm_out)
+{
+	double h = (prm_in->flag & PRM_ALT ? prm_in->alt : 0.0);
+	double T[2], p[2], rho[2];
+	int valid = Eval2 (h, h, T, p, rho);
+	prm_out->T = T[0], prm_out->p = p[0], prm_out->rho = rho[0];
+	return (valid & 1) != 0;
+}
+
+// --------------------------------------------------------------
+
+int StdAtmosphere::clbkParamsBatch (const AtmBatchIn *in, double *T, double *p, double *rho)
+{
+	const double *alt = in->alt;
+	int i, valid, n = in->n, ndata = 0;
+
+	for (i = 0; i+1 < n; i += 2) {
+		valid = (alt ? Eval2 (alt[i], alt[i+1], T+i, p+i, rho+i) : Eval2 (0.0, 0.0, T+i, p+i, rho+i));
+		ndata += (valid & 1) + (valid >> 1);
+	}
+	if (i < n) { // odd point
+		double T2[2], p2[2], rho2[2], h = (alt ? alt[i] : 0.0);
+		valid = Eval2 (h, h, T2, p2, rho2);
+		T[i] = T2[0], p[i] = p2[0], rho[i] = rho2[0];
+		ndata += valid & 1;
+	}
+	return ndata;
+}
+
+// --------------------------------------------------------------
+
+int StdAtmosphere::Layer (double h) const
+{
+	int i;
+	for (i = ATMB_NLAYER-1; i > 0 && h < hb[i]; i--);
+	return i;
+}
+
+// --------------------------------------------------------------
+
+int StdAtmosphere::Eval2 (double h0, double h1, double *T, double *p, double *rho) const
+{
+	int i0 = Layer (h0), i1 = Layer (h1);
+	__m128d h   = _mm_set_pd (h1, h0);
+	__m128d dh  = _mm_sub_pd (h, _mm_set_pd (hb[i1], hb[i0]));
+	__m128d tb  = _mm_set_pd (Tb[i1], Tb[i0]);
+	__m128d t   = _mm_add_pd (tb, _mm_mul_pd (_mm_set_pd (Lb[i1], Lb[i0]), dh));
+	__m128d lnp = _mm_add_pd (_mm_set_pd (lnpb[i1], lnpb[i0]), _mm_mul_pd (_mm_set_pd (Bb[i1], Bb[i0]), dh));
+	lnp = _mm_add_pd (lnp, _mm_mul_pd (_mm_set_pd (Kb[i1], Kb[i0]), vlog1 (_mm_div_pd (t, tb))));
+	__m128d pr  = vexp (lnp);
+	__m128d r   = _mm_div_pd (pr, _mm_mul_pd (_mm_set1_pd (ac.R), t));
+
+	// no data above the altitude limit
+	__m128d in = _mm_cmple_pd (h, _mm_set1_pd (ac.altlimit));
+	_mm_storeu_pd (T,   _mm_and_pd (t, in));
+	_mm_storeu_pd (p,   _mm_and_pd (pr, in));
+	_mm_storeu_pd (rho, _mm_and_pd (r, in));
+	return _mm_movemask_pd (in);
+}
@@ -0,0 +1,116 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AtmBatch.h
+// Batch evaluation of atmospheric parameters for arrays of points,
+// and an SSE2 reference atmosphere
+// ==============================================================
+
+#ifndef __ATMBATCH_H
+#define __ATMBATCH_H
+
+#include "orbitersdk.h"
+
+const int ATMB_NLAYER = 8;      // layers of the standard profile
+
+// ==============================================================
+// Batch input
+//
+// Structure of arrays of the ATMOSPHERE::PRM_IN fields for n points.
+// A NULL array means that the parameter is not supplied for any point
+// (the PRM_IN flag is cleared, and the model uses its default).
+
+struct AtmBatchIn {
+	int n;                 // number of points
+	const double *alt;     // altitude [m]
+	const double *lng;     // longitude [rad]
+	const double *lat;     // latitude [rad]
+	const double *f107bar; // average F10.7 flux
+	const double *f107;    // current F10.7 flux
+	const double *ap;      // magnetic index
+};
+
+// ==============================================================
+// Atmosphere with batch evaluation
+//
+// Derive an atmosphere model from BatchAtmosphere instead of
+// ATMOSPHERE to provide an optimised clbkParamsBatch. The default
+// implementation calls clbkParams for each point.
+
+class BatchAtmosphere: public ATMOSPHERE {
+public:
+	BatchAtmosphere (CELBODY2 *body): ATMOSPHERE (body) {}
+
+	// Temperature T, pressure p and density rho at the points of in.
+	// Points for which the model returns no data (clbkParams returns
+	// false) are set to 0. Returns the number of points with data.
+	virtual int clbkParamsBatch (const AtmBatchIn *in, double *T, double *p, double *rho);
+
+	// Batch evaluation by calling atm->clbkParams for each point
+	static int ParamsLoop (ATMOSPHERE *atm, const AtmBatchIn *in, double *T, double *p, double *rho);
+};
+
+// Batch evaluation for any atmosphere: uses clbkParamsBatch if atm is
+// a BatchAtmosphere, and calls clbkParams for each point otherwise.
+// The test is a dynamic_cast, so modules calling this function must
+// be compiled with RTTI (/GR, the default of VS2005 projects; VC6
+// projects need it added to the compiler options).
+int AtmParamsBatch (ATMOSPHERE *atm, const AtmBatchIn *in, double *T, double *p, double *rho);
+
+// Evaluate atm at n random altitudes (0 ... altlimit) with
+// AtmParamsBatch and with one clbkParams call per point, and write
+// the throughput of both [points/s] and their largest relative
+// difference to Orbiter.log. Returns the largest relative difference.
+double AtmBatchReport (ATMOSPHERE *atm, int n = 100000);
+
+// ==============================================================
+// Reference atmosphere
+//
+// Piecewise standard atmosphere: the temperature profile of the US
+// Standard Atmosphere 1976 up to 86 km (layers with constant lapse
+// rate, scaled to the ground temperature p0/(rho0 R) of the planet),
+// isothermal above, up to altlimit. Pressure follows from hydrostatic
+// equilibrium with constant gravity g0:
+//   isothermal layer: p = p_b exp(-g0 (h-h_b) / (R T_b))
+//   lapse rate L:     p = p_b (T/T_b)^(-g0/(R L))
+// and density from the gas law rho = p/(R T). Altitudes are taken as
+// geometric. Longitude, latitude and solar/magnetic activity are
+// ignored.
+//
+// clbkParamsBatch evaluates two points per SSE2 instruction, with
+// vector exp/log approximations accurate to about 1e-15.
+
+class StdAtmosphere: public BatchAtmosphere {
+public:
+	// Atmosphere with ground pressure, density, gas constant, gamma and
+	// altitude limit from atmc, and gravitational acceleration g0
+	// [m/s^2] at the mean radius
+	StdAtmosphere (CELBODY2 *body, const ATMCONST &atmc, double g0);
+
+	const char *clbkName () const { return "StdAtm"; }
+	bool clbkConstants (ATMCONST *atmc) const;
+	bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm_out);
+	int clbkParamsBatch (const AtmBatchIn *in, double *T, double *p, double *rho);
+
+private:
+	// Layer of altitude h
+	int Layer (double h) const;
+
+	// Evaluate altitudes h0 and h1 into T[0..1], p[0..1], rho[0..1].
+	// Returns a bit mask of the points below the altitude limit.
+	int Eval2 (double h0, double h1, double *T, double *p, double *rho) const;
+
+	ATMCONST ac;                // atmospheric constants
+	double g0;                  // gravitational acceleration [m/s^2]
+	double hb[ATMB_NLAYER];     // layer base altitude [m]
+	double Lb[ATMB_NLAYER];     // lapse rate [K/m]
+	double Tb[ATMB_NLAYER];     // base temperature [K]
+	double lnpb[ATMB_NLAYER];   // log of base pressure
+	double Bb[ATMB_NLAYER];     // d(ln p)/dh of isothermal layers
+	double Kb[ATMB_NLAYER];     // d(ln p)/d(ln T) of lapse layers
+};
+
+#endif // !__ATMBATCH_H
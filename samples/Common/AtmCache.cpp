@@ -0,0 +1,251 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AtmCache.cpp
+// Altitude table cache for an atmosphere model, serving
+// ATMOSPHERE::clbkParams by interpolation
+// ==============================================================
+
+#include "AtmCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+const DWORD ATMC_KEYFLAG = ATMOSPHERE::PRM_FBR | ATMOSPHERE::PRM_F | ATMOSPHERE::PRM_AP;
+
+// ==============================================================
+
+AtmCache::AtmCache (CELBODY2 *body, ATMOSPHERE *_src, double _tol, int _nlat, int _nlng, double _dtmax)
+: BatchAtmosphere (body)
+{
+	src = _src;
+	tol = _tol;
+	nlat = max (_nlat, 1);
+	nlng = max (_nlng, 1);
+	dtmax = _dtmax;
+
+	ATMCONST ac;
+	memset (&ac, 0, sizeof(ATMCONST));
+	src->clbkConstants (&ac);
+	hmax = (ac.altlimit > 0.0 ? ac.altlimit : 1e6);
+	w = hmax/ATMC_NBAND;
+
+	bin = new Bin[nlat*nlng];
+	for (int i = 0; i < nlat*nlng; i++) {
+		bin[i].built = false;
+		bin[i].t = 0.0;
+		bin[i].v = 0;
+	}
+	scratch = new double[(ATMC_NBAND+2)*(ATMC_MAXSEG+1)*3];
+	nsample = 0;
+	memset (&key, 0, sizeof(PRM_IN));
+	keyflag = 0;
+	haskey = false;
+}
+
+// --------------------------------------------------------------
+
+AtmCache::~AtmCache ()
+{
+	for (int i = 0; i < nlat*nlng; i++)
+		if (bin[i].v) delete []bin[i].v;
+	delete []bin;
+	delete []scratch;
+}
+
+// --------------------------------------------------------------
+
+bool AtmCache::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm_out)
+{
+	// discard the tables if the flux inputs have changed
+	DWORD kf = prm_in->flag & ATMC_KEYFLAG;
+	if (!haskey || kf != keyflag ||
+		((kf & PRM_FBR) && prm_in->f107bar != key.f107bar) ||
+		((kf & PRM_F)   && prm_in->f107    != key.f107) ||
+		((kf & PRM_AP)  && prm_in->ap      != key.ap)) {
+		Invalidate ();
+		key = *prm_in;
+		keyflag = kf;
+		haskey = true;
+	}
+	if (Lookup (prm_in, prm_out)) return true;
+	return src->clbkParams (prm_in, prm_out);
+}
+
+// --------------------------------------------------------------
+
+void AtmCache::Invalidate ()
+{
+	for (int i = 0; i < nlat*nlng; i++)
+		bin[i].built = false;
+}
+
+// --------------------------------------------------------------
+
+bool AtmCache::Lookup (const PRM_IN *prm_in, PRM_OUT *prm_out)
+{
+	double h = (prm_in->flag & PRM_ALT ? prm_in->alt : 0.0);
+	if (!(h >= 0.0 && h < hmax)) return false;
+
+	int ilat = 0, ilng = 0;
+	if (nlat > 1) {
+		double lat = (prm_in->flag & PRM_LAT ? prm_in->lat : 0.0);
+		ilat = (int)((lat+PI05)/PI*nlat);
+		if (ilat < 0) ilat = 0;
+		else if (ilat >= nlat) ilat = nlat-1;
+	}
+	if (nlng > 1) {
+		double lng = (prm_in->flag & PRM_LNG ? fmod (prm_in->lng, PI2) : 0.0);
+		if (lng < 0.0) lng += PI2;
+		ilng = (int)(lng/PI2*nlng);
+		if (ilng >= nlng) ilng = nlng-1;
+	}
+	Bin &bn = bin[ilat*nlng + ilng];
+	if (!bn.built || (dtmax > 0.0 && fabs (oapiGetSimTime() - bn.t) > dtmax))
+		Build (bn, ilat, ilng);
+
+	int b = (int)(h/w);
+	if (b >= ATMC_NBAND) b = ATMC_NBAND-1;
+	int nseg = bn.ofs[b+1] - bn.ofs[b] - 1;
+	double x = (h - b*w)/w*nseg;
+	int i = (int)x;
+	if (i >= nseg) i = nseg-1;
+	double f = x-i;
+	const double *v0 = bn.v + 3*(bn.ofs[b]+i), *v1 = v0+3;
+	if (v0[0] <= 0.0 || v1[0] <= 0.0) return false;
+
+	prm_out->T   = v0[0] + f*(v1[0]-v0[0]);
+	prm_out->p   = exp (v0[1] + f*(v1[1]-v0[1]));
+	prm_out->rho = exp (v0[2] + f*(v1[2]-v0[2]));
+	return true;
+}
+
+// --------------------------------------------------------------
+
+void AtmCache::Sample (double h, int ilat, int ilng, double *v)
+{
+	PRM_IN prm;
+	PRM_OUT out;
+	prm = key;
+	prm.flag = keyflag | PRM_ALT | (nlat > 1 ? PRM_LAT : 0) | (nlng > 1 ? PRM_LNG : 0);
+	prm.alt = h;
+	prm.lat = (ilat+0.5)*PI/nlat - PI05;
+	prm.lng = (ilng+0.5)*PI2/nlng;
+	if (src->clbkParams (&prm, &out) && out.T > 0.0 && out.p > 0.0 && out.rho > 0.0) {
+		v[0] = out.T;
+		v[1] = log (out.p);
+		v[2] = log (out.rho);
+	} else
+		v[0] = v[1] = v[2] = 0.0;
+	nsample++;
+}
+
+// --------------------------------------------------------------
+
+void AtmCache::Build (Bin &bn, int ilat, int ilng)
+{
+	double *acc = scratch;                              // nodes of all bands
+	double *nd  = acc + ATMC_NBAND*(ATMC_MAXSEG+1)*3;   // nodes of the current band
+	double *md  = nd + (ATMC_MAXSEG+1)*3;               // interval midpoints
+	int b, k, n;
+
+	bn.ofs[0] = 0;
+	for (b = 0; b < ATMC_NBAND; b++) {
+		double h0 = b*w;
+		n = ATMC_MINSEG;
+		for (k = 0; k <= n; k++)
+			Sample (h0 + k*w/n, ilat, ilng, nd+3*k);
+		for (;;) {
+			// interpolation error at the midpoints
+			double err = 0.0;
+			for (k = 0; k < n; k++) {
+				const double *a = nd+3*k, *c = nd+3*(k+1), *m = md+3*k;
+				Sample (h0 + (k+0.5)*w/n, ilat, ilng, md+3*k);
+				bool va = (a[0] > 0.0), vc = (c[0] > 0.0), vm = (m[0] > 0.0);
+				if (va && vc && vm) {
+					double e = fabs (0.5*(a[0]+c[0])/m[0] - 1.0);
+					if (e > err) err = e;
+					e = fabs (0.5*(a[1]+c[1]) - m[1]); // ln p: ~relative error of p
+					if (e > err) err = e;
+					e = fabs (0.5*(a[2]+c[2]) - m[2]);
+					if (e > err) err = e;
+				} else if (va != vm || vc != vm)
+					err = 1.0; // edge of the model's data: refine
+			}
+			if (err <= tol || n >= ATMC_MAXSEG) break;
+			// the midpoints become nodes of the refined band
+			for (k = n; k >= 0; k--) {
+				memcpy (nd+3*(2*k), nd+3*k, 3*sizeof(double));
+				if (k < n) memcpy (nd+3*(2*k+1), md+3*k, 3*sizeof(double));
+			}
+			n *= 2;
+		}
+		memcpy (acc + 3*bn.ofs[b], nd, 3*(n+1)*sizeof(double));
+		bn.ofs[b+1] = bn.ofs[b] + n+1;
+	}
+
+	if (bn.v) delete []bn.v;
+	bn.v = new double[3*bn.ofs[ATMC_NBAND]];
+	memcpy (bn.v, acc, 3*bn.ofs[ATMC_NBAND]*sizeof(double));
+	bn.t = oapiGetSimTime();
+	bn.built = true;
+}
+
+// --------------------------------------------------------------
+
+void AtmCache::Report (int n)
+{
+	PRM_IN *prm = new PRM_IN[n];
+	PRM_OUT out, ref;
+	double emax[3] = {0,0,0}, esum[3] = {0,0,0};
+	LARGE_INTEGER f, t0, t1, t2;
+	DWORD seed = 12345;
+	int i, j, nref = 0, nnode = 0;
+
+	// random points below the table limit, with the current flux inputs
+	for (i = 0; i < n; i++) {
+		prm[i] = key;
+		prm[i].flag = keyflag | PRM_ALT | PRM_LAT | PRM_LNG;
+		seed = seed*1664525 + 1013904223; prm[i].alt = hmax*(seed >> 8)/16777216.0;
+		seed = seed*1664525 + 1013904223; prm[i].lat = PI*(seed >> 8)/16777216.0 - PI05;
+		seed = seed*1664525 + 1013904223; prm[i].lng = PI2*(seed >> 8)/16777216.0;
+	}
+
+	// errors (this also builds the tables)
+	for (i = 0; i < n; i++) {
+		bool ok = clbkParams (prm+i, &out);
+		if (!src->clbkParams (prm+i, &ref) || !ok) continue;
+		double e[3] = {fabs (out.T/ref.T - 1.0), fabs (out.p/ref.p - 1.0), fabs (out.rho/ref.rho - 1.0)};
+		for (j = 0; j < 3; j++) {
+			if (e[j] > emax[j]) emax[j] = e[j];
+			esum[j] += e[j]*e[j];
+		}
+		nref++;
+	}
+	for (j = 0; j < 3; j++)
+		esum[j] = (nref ? sqrt (esum[j]/nref) : 0.0);
+
+	// timings
+	QueryPerformanceFrequency (&f);
+	QueryPerformanceCounter (&t0);
+	for (i = 0; i < n; i++) clbkParams (prm+i, &out);
+	QueryPerformanceCounter (&t1);
+	for (i = 0; i < n; i++) src->clbkParams (prm+i, &ref);
+	QueryPerformanceCounter (&t2);
+	double ns = 1e9/((double)f.QuadPart*n);
+
+	for (i = 0; i < nlat*nlng; i++)
+		if (bin[i].built) nnode += bin[i].ofs[ATMC_NBAND];
+
+	char cbuf[256];
+	sprintf (cbuf, "AtmCache (%s): %d points, rel. error max/rms T %0.2g/%0.2g, p %0.2g/%0.2g, rho %0.2g/%0.2g",
+		src->clbkName(), nref, emax[0], esum[0], emax[1], esum[1], emax[2], esum[2]);
+	oapiWriteLog (cbuf);
+	sprintf (cbuf, "AtmCache (%s): %0.0f ns/call (model %0.0f ns/call), %d table nodes, %d model samples",
+		src->clbkName(), (t1.QuadPart-t0.QuadPart)*ns, (t2.QuadPart-t1.QuadPart)*ns, nnode, nsample);
+	oapiWriteLog (cbuf);
+	delete []prm;
+}
@@ -0,0 +1,111 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AtmCache.h
+// Altitude table cache for an atmosphere model, serving
+// ATMOSPHERE::clbkParams by interpolation
+// ==============================================================
+
+#ifndef __ATMCACHE_H
+#define __ATMCACHE_H
+
+#include "AtmBatch.h"
+
+const int ATMC_NBAND  = 16;     // altitude bands
+const int ATMC_MINSEG = 4;      // initial intervals per band
+const int ATMC_MAXSEG = 1024;   // max. intervals per band
+
+// ==============================================================
+// Atmosphere cache
+//
+// For fixed solar flux and geomagnetic inputs, the atmospheric profile
+// is a smooth function of altitude. The cache samples the underlying
+// model at nodes over 0 ... altlimit and interpolates temperature,
+// log pressure and log density linearly between them.
+//
+// The altitude range is divided into ATMC_NBAND bands of equal width,
+// each with its own node spacing: starting with ATMC_MINSEG intervals,
+// a band is refined until the interpolation error at the interval
+// midpoints is below the tolerance (relative error of T, p and rho).
+// Bands are built on the first query.
+//
+// Optionally, the tables are built separately for nlat x nlng
+// latitude/longitude bins (the model is sampled at the bin centres).
+// If dtmax > 0, a bin is rebuilt when the simulation time is more than
+// dtmax seconds away from its build time (in either direction, so
+// time jumps backwards are handled), and day/night variation of the
+// model is followed as the planet rotates.
+//
+// All tables are discarded when the flux/geomagnetic inputs (f107bar,
+// f107, ap and their PRM_IN flags) of a query differ from those the
+// tables were built for. Queries below 0 or above altlimit, or next to
+// nodes where the model returned no data, are passed to the model.
+//
+// Usage, for a body with an atmosphere module:
+//   void MyPlanet::clbkInit (FILEHANDLE cfg)
+//   {
+//     CELBODY2::clbkInit (cfg);     // loads the module
+//     if (atm) atm = cache = new AtmCache (this, src = atm);
+//   }
+//   MyPlanet::~MyPlanet ()
+//   {
+//     if (cache) { atm = src; delete cache; } // module deletes src
+//   }
+
+class AtmCache: public BatchAtmosphere {
+public:
+	// Cache for model src (not deleted by the cache), with relative
+	// tolerance tol, nlat x nlng latitude/longitude bins, and bin
+	// lifetime dtmax [s] (0: unlimited)
+	AtmCache (CELBODY2 *body, ATMOSPHERE *src, double tol = 1e-4, int nlat = 1, int nlng = 1, double dtmax = 0.0);
+	~AtmCache ();
+
+	const char *clbkName () const { return src->clbkName(); }
+	bool clbkConstants (ATMCONST *atmc) const { return src->clbkConstants (atmc); }
+	bool clbkParams (const PRM_IN *prm_in, PRM_OUT *prm_out);
+
+	// Discard all tables
+	void Invalidate ();
+
+	// Compare the cache with the model at nsample points for the
+	// current flux inputs, and write errors, timings and table sizes
+	// to Orbiter.log
+	void Report (int nsample = 10000);
+
+private:
+	struct Bin {
+		bool built;                 // tables are valid
+		double t;                   // build time [simt]
+		int ofs[ATMC_NBAND+1];      // first node of each band
+		double *v;                  // nodes: T, ln p, ln rho (T = 0: no data)
+	};
+
+	// Sample the model at altitude h in bin (ilat, ilng) into v[0..2]
+	void Sample (double h, int ilat, int ilng, double *v);
+
+	// Build the tables of bin (ilat, ilng)
+	void Build (Bin &bin, int ilat, int ilng);
+
+	// Table lookup at prm_in. Returns false if the query must be passed
+	// to the model.
+	bool Lookup (const PRM_IN *prm_in, PRM_OUT *prm_out);
+
+	ATMOSPHERE *src;     // underlying model
+	double tol;          // relative tolerance
+	int nlat, nlng;      // number of latitude/longitude bins
+	double dtmax;        // bin lifetime [s]
+	double hmax;         // top of the tables [m]
+	double w;            // band width [m]
+	Bin *bin;            // nlat x nlng bins
+	double *scratch;     // node buffer for Build
+	DWORD nsample;       // number of model samples taken for the tables
+
+	PRM_IN key;          // flux inputs of the tables
+	DWORD keyflag;       // PRM_FBR | PRM_F | PRM_AP subset of key
+	bool haskey;         // key is set
+};
+
+#endif // !__ATMCACHE_H
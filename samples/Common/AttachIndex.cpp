@@ -0,0 +1,317 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AttachIndex.cpp
+// Spatial index for attachment point candidate searches
+// ==============================================================
+
+#include "AttachIndex.h"
+#include <math.h>
+#include <string.h>
+
+// --------------------------------------------------------------
+// Scan the parent attachment points of a vessel for the closest
+// compatible point to gpos. dmin is the current search radius on
+// entry, and is reduced to the distance of the returned point.
+// --------------------------------------------------------------
+static ATTACHMENTHANDLE ScanVessel (VESSEL *v, const VECTOR3 &gpos, const char *prefix,
+	AttachIndex::Filter filter, void *context, double &dmin)
+{
+	ATTACHMENTHANDLE hBest = 0;
+	VECTOR3 pos, dir, rot, apos;
+	size_t plen = strlen (prefix);
+	DWORD j, nAttach = v->AttachmentCount (true);
+	for (j = 0; j < nAttach; j++) {
+		ATTACHMENTHANDLE hAtt = v->GetAttachmentHandle (true, j);
+		if (strncmp (v->GetAttachmentId (hAtt), prefix, plen)) continue; // not compatible
+		v->GetAttachmentParams (hAtt, pos, dir, rot);
+		v->Local2Global (pos, apos);
+		double d = dist (apos, gpos);
+		if (d >= dmin) continue;
+		if (filter && !filter (v, hAtt, context)) continue;
+		hBest = hAtt;
+		dmin = d;
+	}
+	return hBest;
+}
+
+// ==============================================================
+
+AttachIndex::AttachIndex (HINSTANCE hDLL): oapi::Module (hDLL)
+{
+	entry = 0;
+	nentry = nbuf = 0;
+	bucket = 0;
+	nbucket = 0;
+	cell = 1.0;
+	rmax = 0.0;
+	hAnchor = 0;
+	apos = _V(0,0,0);
+	tupdate = 0.0;
+	nrebin = nrebuild = 0;
+	populated = false;
+	invalid = true;
+}
+
+// --------------------------------------------------------------
+
+AttachIndex::~AttachIndex ()
+{
+	if (nbuf) delete []entry;
+	if (nbucket) delete []bucket;
+}
+
+// --------------------------------------------------------------
+
+void AttachIndex::clbkSimulationStart (RenderMode mode)
+{
+	populated = false; // scenario vessels are not reported via clbkNewVessel
+}
+
+// --------------------------------------------------------------
+
+void AttachIndex::clbkSimulationEnd ()
+{
+	nentry = 0;
+	hAnchor = 0;
+	populated = false;
+	invalid = true;
+}
+
+// --------------------------------------------------------------
+
+void AttachIndex::clbkNewVessel (OBJHANDLE hVessel)
+{
+	if (populated) Add (hVessel);
+}
+
+// --------------------------------------------------------------
+
+void AttachIndex::clbkDeleteVessel (OBJHANDLE hVessel)
+{
+	for (DWORD i = 0; i < nentry; i++) {
+		if (entry[i].hVessel == hVessel) {
+			Remove (i);
+			break;
+		}
+	}
+}
+
+// --------------------------------------------------------------
+
+void AttachIndex::clbkVesselJump (OBJHANDLE hVessel)
+{
+	invalid = true; // rare (scenario editor): start from scratch
+}
+
+// --------------------------------------------------------------
+
+void AttachIndex::Populate ()
+{
+	DWORD i, n = oapiGetVesselCount();
+	nentry = 0;
+	invalid = true;
+	for (i = 0; i < n; i++)
+		Add (oapiGetVesselByIndex (i));
+	populated = true;
+}
+
+// --------------------------------------------------------------
+// Append a vessel. While the grid is valid, the vessel is binned
+// at its current position relative to the anchor.
+// --------------------------------------------------------------
+void AttachIndex::Add (OBJHANDLE hVessel)
+{
+	if (nentry == nbuf) { // grow the entry list
+		Entry *tmp = new Entry[nbuf += 64];
+		if (nentry) {
+			memcpy (tmp, entry, nentry*sizeof(Entry));
+			delete []entry;
+		}
+		entry = tmp;
+	}
+	Entry &e = entry[nentry++];
+	e.hVessel = hVessel;
+	if (invalid) return;
+
+	VECTOR3 gpos, gpos0;
+	oapiGetGlobalPos (hVessel, &gpos);
+	oapiGetGlobalPos (hAnchor, &gpos0);
+	e.rpos = e.rbin = gpos - gpos0;
+	e.size = oapiGetSize (hVessel);
+	Link (nentry-1);
+	if (e.size > rmax) rmax = e.size;
+	if (4.0*rmax > cell || nentry > nbucket) invalid = true; // cells too small or too crowded
+}
+
+// --------------------------------------------------------------
+// Remove entry i. The last entry takes its place.
+// --------------------------------------------------------------
+void AttachIndex::Remove (DWORD i)
+{
+	DWORD last = nentry-1;
+	if (entry[i].hVessel == hAnchor) invalid = true;
+	if (!invalid) {
+		Unlink (i);
+		if (i != last) Unlink (last);
+	}
+	if (i != last) {
+		entry[i] = entry[last];
+		if (!invalid) Link (i);
+	}
+	nentry--;
+}
+
+// --------------------------------------------------------------
+
+DWORD AttachIndex::Bucket (const VECTOR3 &rpos) const
+{
+	return Bucket ((__int64)floor (rpos.x/cell), (__int64)floor (rpos.y/cell), (__int64)floor (rpos.z/cell));
+}
+
+// --------------------------------------------------------------
+
+DWORD AttachIndex::Bucket (__int64 ix, __int64 iy, __int64 iz) const
+{
+	DWORD h = (DWORD)(ix*73856093) ^ (DWORD)(iy*19349663) ^ (DWORD)(iz*83492791);
+	return h & (nbucket-1);
+}
+
+// --------------------------------------------------------------
+
+void AttachIndex::Link (DWORD i)
+{
+	Entry &e = entry[i];
+	e.b = Bucket (e.rbin);
+	e.next = bucket[e.b];
+	bucket[e.b] = (int)i;
+}
+
+// --------------------------------------------------------------
+
+void AttachIndex::Unlink (DWORD i)
+{
+	int *p = &bucket[entry[i].b];
+	while (*p != (int)i) p = &entry[*p].next;
+	*p = entry[i].next;
+}
+
+// --------------------------------------------------------------
+// Read the current vessel positions, and re-bin the vessels that
+// have moved by more than half a cell relative to the anchor since
+// they were binned.
+// --------------------------------------------------------------
+void AttachIndex::Update ()
+{
+	if (invalid) {
+		Rebuild();
+		return;
+	}
+	DWORD i;
+	VECTOR3 gpos;
+	double slack = 0.5*cell;
+
+	oapiGetGlobalPos (hAnchor, &apos);
+	for (i = 0; i < nentry; i++) {
+		Entry &e = entry[i];
+		oapiGetGlobalPos (e.hVessel, &gpos);
+		e.rpos = gpos - apos;
+		e.size = oapiGetSize (e.hVessel);
+		if (e.size > rmax) rmax = e.size;
+		if (dist (e.rpos, e.rbin) > slack) {
+			Unlink (i);
+			e.rbin = e.rpos;
+			Link (i);
+			nrebin++;
+		}
+	}
+	tupdate = oapiGetSimTime();
+	if (4.0*rmax > cell) Rebuild(); // a vessel has grown beyond the cell size
+}
+
+// --------------------------------------------------------------
+// Bin all vessels at their current positions. The cell size is
+// twice the largest vessel diameter, so that a search covering the
+// vessel radius, the grapple range and the half-cell slack only
+// needs to visit the cells adjacent to the search point.
+// --------------------------------------------------------------
+void AttachIndex::Rebuild ()
+{
+	DWORD i, nb;
+	VECTOR3 gpos;
+
+	hAnchor = (nentry ? entry[0].hVessel : 0);
+	if (hAnchor) oapiGetGlobalPos (hAnchor, &apos);
+	rmax = 0.0;
+	for (i = 0; i < nentry; i++) {
+		Entry &e = entry[i];
+		oapiGetGlobalPos (e.hVessel, &gpos);
+		e.rpos = e.rbin = gpos - apos;
+		e.size = oapiGetSize (e.hVessel);
+		if (e.size > rmax) rmax = e.size;
+	}
+	cell = max (4.0*rmax, 1.0);
+
+	for (nb = 16; nb < 2*nentry; nb *= 2);
+	if (nb != nbucket) {
+		if (nbucket) delete []bucket;
+		bucket = new int[nbucket = nb];
+	}
+	for (i = 0; i < nbucket; i++) bucket[i] = -1;
+	for (i = 0; i < nentry; i++) Link (i);
+	tupdate = oapiGetSimTime();
+	invalid = false;
+	nrebuild++;
+}
+
+// --------------------------------------------------------------
+
+ATTACHMENTHANDLE AttachIndex::FindNearest (const VECTOR3 &gpos, double range, const char *prefix,
+	OBJHANDLE hSelf, OBJHANDLE *hVessel, Filter filter, void *context)
+{
+	if (!populated) Populate();
+	if (invalid || oapiGetSimTime() != tupdate) Update();
+	if (!nentry) return 0;
+
+	// binned positions may be off by up to half a cell
+	ATTACHMENTHANDLE hBest = 0;
+	VECTOR3 rpos = gpos - apos;
+	double dmin = range;
+	int j, k;
+	int s = (int)ceil ((rmax+range+0.5*cell)/cell);
+	__int64 cx = (__int64)floor (rpos.x/cell);
+	__int64 cy = (__int64)floor (rpos.y/cell);
+	__int64 cz = (__int64)floor (rpos.z/cell);
+
+	// visit the buckets of the cells around the search point, or each
+	// bucket once if there are fewer buckets than cells
+	int n = 2*s+1;
+	bool all = (s >= 16 || n*n*n >= (int)nbucket);
+	for (k = 0; k < (all ? (int)nbucket : n*n*n); k++) {
+		DWORD b = (all ? k : Bucket (cx + k%n - s, cy + (k/n)%n - s, cz + k/(n*n) - s));
+		for (j = bucket[b]; j >= 0; j = entry[j].next) {
+			const Entry &e = entry[j];
+			if (e.hVessel == hSelf) continue; // we don't want to grapple ourselves ...
+			if (dist (e.rpos, rpos) >= e.size+range) continue; // out of range
+			ATTACHMENTHANDLE hAtt = ScanVessel (oapiGetVesselInterface (e.hVessel),
+				gpos, prefix, filter, context, dmin);
+			if (hAtt) {
+				hBest = hAtt;
+				if (hVessel) *hVessel = e.hVessel;
+			}
+		}
+	}
+	return hBest;
+}
+
+// --------------------------------------------------------------
+
+ATTACHMENTHANDLE AttachIndex::FindOnVessel (OBJHANDLE hVessel, const VECTOR3 &gpos, double range,
+	const char *prefix, Filter filter, void *context) const
+{
+	double dmin = range;
+	return ScanVessel (oapiGetVesselInterface (hVessel), gpos, prefix, filter, context, dmin);
+}
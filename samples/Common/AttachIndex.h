@@ -0,0 +1,104 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// AttachIndex.h
+// Spatial index for attachment point candidate searches
+// (grappling, payload arrest) shared by vessel modules
+// ==============================================================
+
+#ifndef __ATTACHINDEX_H
+#define __ATTACHINDEX_H
+
+#include "orbitersdk.h"
+
+// ==============================================================
+// Attachment point index
+//
+// Keeps a list of the vessels in the simulation, updated via the
+// module vessel creation/deletion callbacks, and bins the vessel
+// positions into a uniform hash grid. A candidate search only
+// inspects the attachment points of vessels in the grid cells around
+// the search point, rather than those of every vessel in the
+// simulation.
+//
+// Positions are binned relative to an anchor vessel, so that vessels
+// moving together (an assembly in orbit) keep their cells. The first
+// query of each time step reads the vessel positions and re-bins only
+// the vessels that have moved by more than half a cell since they
+// were binned (including vessels moved by attaching them to another
+// vessel); the search covers that slack. The grid is only rebuilt
+// when the anchor is deleted or the cells become too small or too
+// crowded.
+//
+// The index is per module: each vessel module DLL using it creates
+// its own instance in InitModule and registers it with
+// oapiRegisterModule, and Orbiter destroys it at module exit.
+// Instances are not shared between DLLs; each one tracks all vessels.
+
+class AttachIndex: public oapi::Module {
+public:
+	AttachIndex (HINSTANCE hDLL);
+	~AttachIndex ();
+
+	void clbkSimulationStart (RenderMode mode);
+	void clbkSimulationEnd ();
+	void clbkNewVessel (OBJHANDLE hVessel);
+	void clbkDeleteVessel (OBJHANDLE hVessel);
+	void clbkVesselJump (OBJHANDLE hVessel);
+
+	// Optional candidate filter. Called for each compatible attachment
+	// point in range; return false to reject the candidate.
+	typedef bool (*Filter)(VESSEL *v, ATTACHMENTHANDLE hAtt, void *context);
+
+	// Returns the parent attachment point closest to global position gpos
+	// within distance 'range', whose id starts with 'prefix', of any vessel
+	// other than hSelf. The owning vessel is returned in hVessel.
+	// Returns 0 if no candidate was found.
+	ATTACHMENTHANDLE FindNearest (const VECTOR3 &gpos, double range, const char *prefix,
+		OBJHANDLE hSelf, OBJHANDLE *hVessel, Filter filter = 0, void *context = 0);
+
+	// As FindNearest, but only considers the attachment points of hVessel.
+	ATTACHMENTHANDLE FindOnVessel (OBJHANDLE hVessel, const VECTOR3 &gpos, double range,
+		const char *prefix, Filter filter = 0, void *context = 0) const;
+
+	// Number of vessels re-binned, and number of grid rebuilds, since
+	// the index was created
+	DWORD RebinCount () const { return nrebin; }
+	DWORD RebuildCount () const { return nrebuild; }
+
+private:
+	void Populate ();
+	void Add (OBJHANDLE hVessel);
+	void Remove (DWORD i);
+	void Update ();
+	void Rebuild ();
+	void Link (DWORD i);
+	void Unlink (DWORD i);
+	DWORD Bucket (const VECTOR3 &rpos) const;
+	DWORD Bucket (__int64 ix, __int64 iy, __int64 iz) const;
+
+	struct Entry {
+		OBJHANDLE hVessel;      // vessel handle
+		VECTOR3 rpos;           // position relative to anchor at last update
+		VECTOR3 rbin;           // position relative to anchor when binned
+		double size;            // vessel radius
+		DWORD b;                // hash bucket
+		int next;               // next entry in the same hash bucket
+	} *entry;
+	DWORD nentry, nbuf;         // number of vessels, buffer length
+	int *bucket;                // hash bucket heads (index into entry, or -1)
+	DWORD nbucket;              // number of hash buckets (power of 2)
+	double cell;                // grid cell size [m]
+	double rmax;                // largest vessel radius
+	OBJHANDLE hAnchor;          // origin of the binned positions
+	VECTOR3 apos;               // global anchor position at last update
+	double tupdate;             // simulation time of last update
+	DWORD nrebin, nrebuild;     // statistics
+	bool populated;             // vessel list has been initialised
+	bool invalid;               // grid must be rebuilt
+};
+
+#endif // !__ATTACHINDEX_H
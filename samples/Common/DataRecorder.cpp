@@ -0,0 +1,320 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// DataRecorder.cpp
+// Multi-resolution data recorder for time series plots
+//
+// Storage chunk layout (level k, REC_CHUNK entries):
+//   double t[REC_CHUNK]                       entry times
+//   float  v[REC_CHUNK][nch][stride]          entry values
+// where stride is 1 for raw samples (value) and 3 for bins
+// (minimum, maximum, mean).
+// ==============================================================
+
+#include "DataRecorder.h"
+#include <float.h>
+#include <string.h>
+
+// --------------------------------------------------------------
+// Add an entry to the accumulators of a resampling column
+// --------------------------------------------------------------
+static inline void Accumulate (float vmin, float vmax, float vmean, double w,
+	float &cmin, float &cmax, double *acc)
+{
+	if (vmin < cmin) cmin = vmin;
+	if (vmax > cmax) cmax = vmax;
+	acc[0] += vmean*w;
+	acc[1] += w;
+}
+
+// ==============================================================
+
+DataRecorder::DataRecorder (int _nch, DWORD _budget)
+{
+	nch = _nch;
+	budget = _budget;
+	used = 0;
+	tlast = 0.0;
+	acc = 0;
+	nacc = 0;
+	for (int k = 0; k < REC_MAXLEVEL; k++) {
+		Level &L = lvl[k];
+		L.stride = (k ? 3 : 1);
+		L.n = L.first = 0;
+		L.chunk = 0;
+		L.chunk0 = L.nchunk = L.nchunkbuf = 0;
+		Pending &P = pend[k];
+		P.t = 0.0;
+		P.cnt = 0;
+		if (k) { // pend[k] builds the bins of level k
+			P.vmin = new float[3*nch];
+			P.vmax = P.vmin + nch;
+			P.vmean = P.vmax + nch;
+			P.vsum = new double[nch];
+		} else {
+			P.vmin = P.vmax = P.vmean = 0;
+			P.vsum = 0;
+		}
+	}
+}
+
+// --------------------------------------------------------------
+
+DataRecorder::~DataRecorder ()
+{
+	Reset();
+	for (int k = 0; k < REC_MAXLEVEL; k++) {
+		if (lvl[k].nchunkbuf) delete []lvl[k].chunk;
+		if (k) {
+			delete []pend[k].vmin;
+			delete []pend[k].vsum;
+		}
+	}
+	if (acc) delete []acc;
+}
+
+// --------------------------------------------------------------
+
+void DataRecorder::Reset ()
+{
+	for (int k = 0; k < REC_MAXLEVEL; k++) {
+		Level &L = lvl[k];
+		for (DWORD i = 0; i < L.nchunk; i++)
+			delete []L.chunk[i];
+		L.n = L.first = 0;
+		L.chunk0 = L.nchunk = 0;
+		pend[k].cnt = 0;
+	}
+	used = 0;
+	tlast = 0.0;
+}
+
+// --------------------------------------------------------------
+
+void DataRecorder::Append (double t, const float *val)
+{
+	tlast = t;
+	Push (0, t, val, val, val);
+}
+
+// --------------------------------------------------------------
+
+double DataRecorder::TStart () const
+{
+	double t = tlast;
+	for (int k = 0; k < REC_MAXLEVEL; k++) {
+		const Level &L = lvl[k];
+		if (L.n > L.first && T(k, L.first) < t) t = T(k, L.first);
+	}
+	return t;
+}
+
+// --------------------------------------------------------------
+
+DWORD DataRecorder::ChunkSize (int k) const
+{
+	return REC_CHUNK * (sizeof(double) + nch*lvl[k].stride*sizeof(float));
+}
+
+// --------------------------------------------------------------
+// Append a storage chunk to level k, and release the oldest chunks
+// of the finest levels until the storage budget is met. The chunk
+// currently written to is never released.
+// --------------------------------------------------------------
+void DataRecorder::AddChunk (int k)
+{
+	Level &L = lvl[k];
+	if (L.nchunk == L.nchunkbuf) { // grow the chunk list
+		char **tmp = new char*[L.nchunkbuf += 16];
+		if (L.nchunk) memcpy (tmp, L.chunk, L.nchunk*sizeof(char*));
+		if (L.chunk) delete []L.chunk;
+		L.chunk = tmp;
+	}
+	DWORD size = ChunkSize (k);
+	L.chunk[L.nchunk++] = new char[size];
+	used += size;
+
+	while (used > budget) {
+		int j;
+		for (j = 0; j < REC_MAXLEVEL && lvl[j].nchunk < 2; j++);
+		if (j == REC_MAXLEVEL) break; // can't go below one chunk per level
+		DropChunk (j);
+	}
+}
+
+// --------------------------------------------------------------
+
+void DataRecorder::DropChunk (int k)
+{
+	Level &L = lvl[k];
+	delete []L.chunk[0];
+	memmove (L.chunk, L.chunk+1, (--L.nchunk)*sizeof(char*));
+	L.first = (++L.chunk0) * REC_CHUNK;
+	used -= ChunkSize (k);
+}
+
+// --------------------------------------------------------------
+// Store an entry in level k and feed it into the bin of level k+1
+// under construction. Completed bins propagate up the pyramid.
+// --------------------------------------------------------------
+void DataRecorder::Push (int k, double t, const float *vmin, const float *vmax, const float *vmean)
+{
+	int ch;
+	Level &L = lvl[k];
+	if (L.n % REC_CHUNK == 0) AddChunk (k);
+	char *c = L.chunk[L.n/REC_CHUNK - L.chunk0];
+	DWORD ofs = L.n % REC_CHUNK;
+	((double*)c)[ofs] = t;
+	float *v = (float*)(c + REC_CHUNK*sizeof(double)) + ofs*nch*L.stride;
+	if (L.stride == 1) {
+		memcpy (v, vmean, nch*sizeof(float));
+	} else {
+		for (ch = 0; ch < nch; ch++, v += 3) {
+			v[0] = vmin[ch];
+			v[1] = vmax[ch];
+			v[2] = vmean[ch];
+		}
+	}
+	L.n++;
+
+	if (k+1 == REC_MAXLEVEL) return;
+	Pending &P = pend[k+1];
+	if (!P.cnt) {
+		P.t = t;
+		for (ch = 0; ch < nch; ch++) {
+			P.vmin[ch] = vmin[ch];
+			P.vmax[ch] = vmax[ch];
+			P.vsum[ch] = vmean[ch];
+		}
+	} else {
+		for (ch = 0; ch < nch; ch++) {
+			if (vmin[ch] < P.vmin[ch]) P.vmin[ch] = vmin[ch];
+			if (vmax[ch] > P.vmax[ch]) P.vmax[ch] = vmax[ch];
+			P.vsum[ch] += vmean[ch];
+		}
+	}
+	if (++P.cnt == REC_FANOUT) {
+		for (ch = 0; ch < nch; ch++)
+			P.vmean[ch] = (float)(P.vsum[ch]/REC_FANOUT);
+		P.cnt = 0;
+		Push (k+1, P.t, P.vmin, P.vmax, P.vmean);
+	}
+}
+
+// --------------------------------------------------------------
+
+double DataRecorder::T (int k, DWORD i) const
+{
+	const Level &L = lvl[k];
+	return ((const double*)L.chunk[i/REC_CHUNK - L.chunk0])[i%REC_CHUNK];
+}
+
+// --------------------------------------------------------------
+
+void DataRecorder::Get (int k, DWORD i, int ch, float &vmin, float &vmax, float &vmean) const
+{
+	const Level &L = lvl[k];
+	const float *v = (const float*)(L.chunk[i/REC_CHUNK - L.chunk0] + REC_CHUNK*sizeof(double))
+		+ ((i%REC_CHUNK)*nch + ch)*L.stride;
+	if (L.stride == 1) {
+		vmin = vmax = vmean = v[0];
+	} else {
+		vmin = v[0], vmax = v[1], vmean = v[2];
+	}
+}
+
+// --------------------------------------------------------------
+// Returns the index of the first retained entry of level k with
+// time > t (or the number of entries if none)
+// --------------------------------------------------------------
+DWORD DataRecorder::Find (int k, double t) const
+{
+	DWORD lo = lvl[k].first, hi = lvl[k].n;
+	while (lo < hi) {
+		DWORD m = (lo+hi)/2;
+		if (T(k, m) <= t) lo = m+1;
+		else              hi = m;
+	}
+	return lo;
+}
+
+// --------------------------------------------------------------
+
+int DataRecorder::Resample (int ch, double t0, double t1, int ncol, float *cmin, float *cmax, float *cmean) const
+{
+	int c, j, k, ntop, nvalid = 0;
+	DWORD i, i0, i1;
+	float vmin, vmax, vmean;
+
+	for (c = 0; c < ncol; c++) {
+		cmin[c] = FLT_MAX;
+		cmax[c] = -FLT_MAX;
+	}
+	if (ncol < 1 || Empty()) return 0;
+
+	// pick the finest level that covers the window with no more than
+	// REC_FANOUT entries per column, or the coarsest level in use
+	double tcover = max (t0, TStart());
+	for (ntop = REC_MAXLEVEL; ntop > 1 && !lvl[ntop-1].n; ntop--);
+	for (k = 0; k < ntop-1; k++) {
+		const Level &L = lvl[k];
+		if (L.n > L.first && T(k, L.first) <= tcover &&
+			Find (k, t1) - Find (k, t0) <= (DWORD)ncol*REC_FANOUT) break;
+	}
+	const Level &L = lvl[k];
+
+	if (ncol > nacc) { // grow the scratch buffer; plots keep the same width
+		if (acc) delete []acc;
+		acc = new double[2*(nacc = ncol)];
+	}
+	memset (acc, 0, 2*ncol*sizeof(double));
+	double scale = (t1 > t0 ? ncol/(t1-t0) : 0.0);
+	double w = 1.0;
+	for (j = 0; j < k; j++) w *= REC_FANOUT; // samples per bin
+
+	i0 = Find (k, t0);
+	i1 = Find (k, t1);
+	if (i0 > L.first && (k || T(k, i0-1) == t0)) i0--; // bin straddling t0
+	for (i = i0; i < i1; i++) {
+		c = max (0, min (ncol-1, (int)((T(k, i)-t0)*scale)));
+		Get (k, i, ch, vmin, vmax, vmean);
+		Accumulate (vmin, vmax, vmean, w, cmin[c], cmax[c], acc+2*c);
+	}
+
+	// the latest samples are still held in the bins under construction
+	for (j = k; j > 0; j--) {
+		w /= REC_FANOUT;
+		const Pending &P = pend[j];
+		if (!P.cnt || P.t > t1) continue;
+		c = max (0, min (ncol-1, (int)((P.t-t0)*scale)));
+		Accumulate (P.vmin[ch], P.vmax[ch], (float)(P.vsum[ch]/P.cnt), w*P.cnt,
+			cmin[c], cmax[c], acc+2*c);
+	}
+
+	for (c = 0; c < ncol; c++) {
+		if (acc[2*c+1]) {
+			cmean[c] = (float)(acc[2*c]/acc[2*c+1]);
+			nvalid++;
+		}
+	}
+	return nvalid;
+}
+
+// --------------------------------------------------------------
+
+bool DataRecorder::Range (int ch, double t0, double t1, float &vmin, float &vmax) const
+{
+	const int ncol = 32;
+	float cmin[ncol], cmax[ncol], cmean[ncol];
+	if (!Resample (ch, t0, t1, ncol, cmin, cmax, cmean)) return false;
+	vmin = FLT_MAX, vmax = -FLT_MAX;
+	for (int c = 0; c < ncol; c++) {
+		if (cmin[c] > cmax[c]) continue;
+		if (cmin[c] < vmin) vmin = cmin[c];
+		if (cmax[c] > vmax) vmax = cmax[c];
+	}
+	return true;
+}
@@ -0,0 +1,97 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// DataRecorder.h
+// Multi-resolution data recorder for time series plots
+// (FlightData, Framerate, CustomMFD)
+// ==============================================================
+
+#ifndef __DATARECORDER_H
+#define __DATARECORDER_H
+
+#include <windows.h>
+
+const int REC_FANOUT   = 4;   // entries of a level combined into one bin of the next level
+const int REC_MAXLEVEL = 10;  // max number of levels, including the raw samples
+const int REC_CHUNK    = 256; // entries per storage chunk
+
+// ==============================================================
+// Data recorder
+//
+// Records every sample of a set of channels, and maintains a pyramid
+// of decimated levels: each bin of level k+1 holds the minimum, maximum
+// and mean of REC_FANOUT entries of level k. A query for a time window
+// picks the finest level that covers the window with not much more than
+// one entry per output column, so plots and autorange of any window
+// cost O(columns) rather than O(samples).
+//
+// Storage is allocated in chunks. When the memory budget is exceeded,
+// the oldest chunk of the finest level is released first, so older
+// history remains available at reduced resolution.
+
+class DataRecorder {
+public:
+	DataRecorder (int _nch, DWORD _budget = 0x100000);
+	~DataRecorder ();
+
+	// discard all recorded data
+	void Reset ();
+
+	// record a sample of all channels at time t (t must not decrease)
+	void Append (double t, const float *val);
+	inline void Append (double t, float val) { Append (t, &val); }
+
+	inline int nChannel () const { return nch; }
+	inline bool Empty () const { return lvl[0].n == 0; }
+
+	// time of the oldest retained and the latest sample
+	double TStart () const;
+	inline double TEnd () const { return tlast; }
+
+	// Resample channel ch over window [t0,t1] into ncol columns of
+	// minimum, maximum and mean values. Columns without data are flagged
+	// by cmin > cmax. Returns the number of columns with data.
+	int Resample (int ch, double t0, double t1, int ncol, float *cmin, float *cmax, float *cmean) const;
+
+	// Value range of channel ch over window [t0,t1].
+	// Returns false if the window contains no data.
+	bool Range (int ch, double t0, double t1, float &vmin, float &vmax) const;
+
+private:
+	struct Level {
+		int stride;         // floats per channel and entry (1: samples, 3: bins)
+		DWORD n;            // number of entries appended
+		DWORD first;        // index of the oldest retained entry
+		char **chunk;       // retained storage chunks
+		DWORD chunk0;       // index of the first retained chunk
+		DWORD nchunk;       // number of retained chunks
+		DWORD nchunkbuf;    // length of the chunk list
+	} lvl[REC_MAXLEVEL];
+
+	struct Pending {        // bin of the next level under construction
+		double t;           // time of the first entry
+		DWORD cnt;          // number of entries combined so far
+		float *vmin, *vmax, *vmean;
+		double *vsum;
+	} pend[REC_MAXLEVEL];
+
+	DWORD ChunkSize (int k) const;
+	void AddChunk (int k);
+	void DropChunk (int k);
+	void Push (int k, double t, const float *vmin, const float *vmax, const float *vmean);
+	double T (int k, DWORD i) const;
+	void Get (int k, DWORD i, int ch, float &vmin, float &vmax, float &vmean) const;
+	DWORD Find (int k, double t) const;
+
+	int nch;                // number of channels
+	DWORD budget;           // storage budget [bytes]
+	DWORD used;             // allocated storage [bytes]
+	double tlast;           // time of the latest sample
+	mutable double *acc;    // Resample scratch: weighted sum of means, sum of weights
+	mutable int nacc;       // number of columns acc can hold
+};
+
+#endif // !__DATARECORDER_H
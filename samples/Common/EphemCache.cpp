@@ -0,0 +1,300 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// EphemCache.cpp
+// Chebyshev segment interpolation of a celestial body's ephemerides
+// ==============================================================
+
+#include "EphemCache.h"
+#include <process.h>
+#include <math.h>
+
+const int EPHC_NNODE = EPHC_ORDER+1;  // number of sampling nodes
+const int EPHC_REQ = EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYPOS | EPHEM_BARYVEL;
+
+// Chebyshev polynomials at the nodes, in order of increasing time:
+// x_k = -cos(th_k), T_j(x_k) = cos(j*(Pi-th_k))
+static struct ChebNodes {
+	double T[EPHC_ORDER+1][EPHC_NNODE];
+	ChebNodes ()
+	{
+		for (int k = 0; k < EPHC_NNODE; k++) {
+			double th = PI - (k+0.5)*PI/EPHC_NNODE;
+			for (int j = 0; j <= EPHC_ORDER; j++)
+				T[j][k] = cos (j*th);
+		}
+	}
+} node;
+
+// ==============================================================
+
+int EphemFit (CELBODY *body, double mjd0, double mjd1, double *c, double *err)
+{
+	double f[EPHC_NNODE][EPHC_NCOMP], ret[EPHC_NCOMP], scale[EPHC_NCOMP];
+	double mjdm = 0.5*(mjd0+mjd1), hh = 0.5*(mjd1-mjd0);
+	int i, j, k, b, flag = 0;
+
+	// sample the ephemerides at the nodes
+	for (k = 0; k < EPHC_NNODE; k++) {
+		for (i = 0; i < EPHC_NCOMP; i++) ret[i] = 0.0;
+		int fk = body->clbkEphemeris (mjdm + hh*node.T[1][k], EPHC_REQ, ret);
+		flag = (k ? flag & (fk | ~EPHC_REQ) : fk); // blocks returned by all nodes
+		for (i = 0; i < EPHC_NCOMP; i++) f[k][i] = ret[i];
+	}
+
+	// unwrap polar longitudes
+	if (flag & EPHEM_POLAR) {
+		for (b = 0; b < 4; b += 2)
+			for (k = 1; k < EPHC_NNODE; k++) {
+				while (f[k][3*b] - f[k-1][3*b] >  PI) f[k][3*b] -= PI2;
+				while (f[k][3*b] - f[k-1][3*b] < -PI) f[k][3*b] += PI2;
+			}
+	}
+
+	// error scale of each component: size of its data block. In polar
+	// blocks, angles and angular rates are converted to lengths and
+	// velocities with the radius of the position block (an angle error
+	// e at radius r is a position error e*r), so all components of a
+	// block are measured in the same units.
+	for (b = 0; b < 4; b++) {
+		int p = 3*(b & ~1);   // position block of b
+		double v2max = 0.0, rmax = 0.0;
+		for (k = 0; k < EPHC_NNODE; k++) {
+			double x = f[k][3*b], y = f[k][3*b+1], z = f[k][3*b+2];
+			if (flag & EPHEM_POLAR) {
+				double r = fabs (f[k][p+2]);
+				if (r > rmax) rmax = r;
+				if (b & 1) x *= r*cos (f[k][p+1]), y *= r; // angular rates
+				else       x = y = 0.0;                    // |position| = r
+			}
+			double v2 = x*x + y*y + z*z;
+			if (v2 > v2max) v2max = v2;
+		}
+		double size = sqrt (v2max);
+		for (i = 3*b; i < 3*b+3; i++) scale[i] = size;
+		if ((flag & EPHEM_POLAR) && rmax > 0.0)
+			scale[3*b] = scale[3*b+1] = size/rmax;
+	}
+
+	// Chebyshev coefficients (discrete cosine transform of the samples)
+	for (i = 0; i < EPHC_NCOMP; i++) {
+		double *ci = c + i*(EPHC_ORDER+1);
+		for (j = 0; j <= EPHC_ORDER; j++) {
+			double cj = 0.0;
+			for (k = 0; k < EPHC_NNODE; k++)
+				cj += f[k][i]*node.T[j][k];
+			ci[j] = cj*(j ? 2.0 : 1.0)/EPHC_NNODE;
+		}
+		// error estimate: size of the last coefficients. If they no
+		// longer decay and are small, the fit has reached the noise of
+		// the samples (e.g. from rounding of the MJD time argument),
+		// and a shorter interval would not improve it.
+		double e = fabs (ci[EPHC_ORDER-1]) + fabs (ci[EPHC_ORDER]);
+		double eprev = fabs (ci[EPHC_ORDER-3]) + fabs (ci[EPHC_ORDER-2]);
+		if (!(flag & (1 << (i/3))) || !scale[i] || (8.0*e > eprev && e < 1e-6*scale[i]))
+			err[i] = 0.0;
+		else
+			err[i] = e/scale[i];
+	}
+	return flag;
+}
+
+// --------------------------------------------------------------
+
+int EphemEval (const double *c, int order, int flag, double x, int req, double *ret)
+{
+	// Chebyshev polynomials at x by recurrence, then one dot product
+	// per component
+	double T[64];
+	int i, j, b;
+	T[0] = 1.0, T[1] = x;
+	for (j = 2; j <= order; j++)
+		T[j] = 2.0*x*T[j-1] - T[j-2];
+
+	int blocks = flag & req & EPHC_REQ;
+	for (b = 0; b < 4; b++) {
+		if (!(blocks & (1 << b))) continue;
+		for (i = 3*b; i < 3*b+3; i++) {
+			const double *ci = c + i*(order+1);
+			double v = 0.0;
+			for (j = 0; j <= order; j++)
+				v += ci[j]*T[j];
+			ret[i] = v;
+		}
+		if ((flag & EPHEM_POLAR) && !(b & 1)) { // longitude to 0 ... 2Pi
+			ret[3*b] = fmod (ret[3*b], PI2);
+			if (ret[3*b] < 0.0) ret[3*b] += PI2;
+		}
+	}
+	return (flag & ~EPHC_REQ) | blocks;
+}
+
+// ==============================================================
+
+EphemCache::EphemCache (CELBODY *_body, double h0, double _tol, bool _async)
+{
+	body = _body;
+	h = h0*86400.0;
+	hmin = h/1024.0;
+	hmax = h*64.0;
+	tol = _tol;
+	first = last = 0;
+	gen = 0;
+	InitializeCriticalSection (&cs);
+	InitializeCriticalSection (&csfit);
+	async = _async;
+	quit = false;
+	hThread = 0;
+	hWake = 0;
+	if (async) {
+		unsigned int id;
+		hWake = CreateEvent (NULL, FALSE, FALSE, NULL);
+		hThread = (HANDLE)_beginthreadex (NULL, 4096, &WorkerProc, this, 0, &id);
+	}
+}
+
+// --------------------------------------------------------------
+
+EphemCache::~EphemCache ()
+{
+	Stop ();
+	DeleteCriticalSection (&cs);
+	DeleteCriticalSection (&csfit);
+}
+
+// --------------------------------------------------------------
+
+void EphemCache::Stop ()
+{
+	if (!hThread) return;
+	quit = true;
+	SetEvent (hWake);
+	WaitForSingleObject (hThread, INFINITE);
+	CloseHandle (hThread);
+	CloseHandle (hWake);
+	hThread = hWake = 0;
+	async = false;
+}
+
+// --------------------------------------------------------------
+
+void EphemCache::Reset ()
+{
+	EnterCriticalSection (&cs);
+	gen++;
+	first = last = 0;
+	LeaveCriticalSection (&cs);
+}
+
+// --------------------------------------------------------------
+
+int EphemCache::Eval (double simt, int req, double *ret)
+{
+	double t = (oapiGetSimMJD() + (simt-oapiGetSimTime())/86400.0)*86400.0;
+	const Segment *s = 0;
+	bool advanced = false;
+
+	EnterCriticalSection (&cs);
+	while (first != last) {
+		const Segment &sg = seg[first % EPHC_NSEG];
+		if (t < sg.t0) break;
+		if (t < sg.t1) { s = &sg; break; }
+		first++; // segment expired
+		advanced = true;
+	}
+	if (!s) {
+		// not covered: fit on the spot, continuing from the previous
+		// segment if t is just past it
+		double t0 = t;
+		if (first == last && last) {
+			const Segment &prev = seg[(last-1) % EPHC_NSEG];
+			if (t >= prev.t1 && t < prev.t1 + h) t0 = prev.t1;
+		}
+		if (t0 == t) { // discontinuity: discard everything
+			gen++;
+			first = last = 0;
+		}
+		Segment &sg = seg[last % EPHC_NSEG];
+		EnterCriticalSection (&csfit);
+		Fit (sg, t0);
+		LeaveCriticalSection (&csfit);
+		last++;
+		s = &sg;
+		advanced = true;
+	}
+	LeaveCriticalSection (&cs);
+	// the worker only writes segments past the current one, so s stays
+	// valid until the next call
+	if (advanced && async) SetEvent (hWake);
+
+	double x = (2.0*t - s->t0 - s->t1)/(s->t1 - s->t0);
+	return EphemEval (s->c[0], EPHC_ORDER, s->flag, x, req, ret);
+}
+
+// --------------------------------------------------------------
+
+void EphemCache::Fit (Segment &s, double t0)
+{
+	double err[EPHC_NCOMP];
+	const double margin = ldexp (1.0, -EPHC_NNODE); // error factor of a doubled segment
+	int i;
+	bool ok, grow;
+
+	for (;;) {
+		s.flag = EphemFit (body, t0/86400.0, (t0+h)/86400.0, s.c[0], err);
+		ok = grow = true;
+		for (i = 0; i < EPHC_NCOMP; i++) {
+			if (err[i] > tol) ok = false;
+			if (err[i] > margin*tol) grow = false;
+		}
+		if (ok || h <= hmin) break;
+		h = max (0.5*h, hmin);
+	}
+	s.t0 = t0;
+	s.t1 = t0 + h;
+	if (grow) h = min (2.0*h, hmax);
+}
+
+// --------------------------------------------------------------
+
+void EphemCache::Refill ()
+{
+	Segment &s = work;
+	while (!quit) {
+		// continue after the last segment, unless the ring is full
+		EnterCriticalSection (&cs);
+		bool need = (last && last-first < EPHC_NSEG);
+		DWORD serial = last, g = gen;
+		double t0 = (need ? seg[(last-1) % EPHC_NSEG].t1 : 0.0);
+		LeaveCriticalSection (&cs);
+		if (!need) break;
+
+		EnterCriticalSection (&csfit);
+		Fit (s, t0);
+		LeaveCriticalSection (&csfit);
+
+		// publish, unless the ring was changed by Eval in the meantime
+		EnterCriticalSection (&cs);
+		if (gen == g && last == serial) {
+			seg[last % EPHC_NSEG] = s;
+			last++;
+		}
+		LeaveCriticalSection (&cs);
+	}
+}
+
+// --------------------------------------------------------------
+
+unsigned int WINAPI EphemCache::WorkerProc (LPVOID context)
+{
+	EphemCache *ec = (EphemCache*)context;
+	for (;;) {
+		WaitForSingleObject (ec->hWake, INFINITE);
+		if (ec->quit) break;
+		ec->Refill ();
+	}
+	return 0;
+}
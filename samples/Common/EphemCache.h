@@ -0,0 +1,122 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// EphemCache.h
+// Chebyshev segment interpolation of a celestial body's ephemerides,
+// for serving CELBODY::clbkFastEphemeris
+// ==============================================================
+
+#ifndef __EPHEMCACHE_H
+#define __EPHEMCACHE_H
+
+#include "orbitersdk.h"
+
+const int EPHC_ORDER = 12;      // Chebyshev polynomial order
+const int EPHC_NSEG  = 4;       // segments held (current + lookahead)
+const int EPHC_NCOMP = 12;      // data components (4 blocks of 3)
+
+// ==============================================================
+// Chebyshev fit of ephemeris data
+//
+// c holds the coefficients of component i (ret[i] of clbkEphemeris)
+// at c[i*(order+1)] ... c[i*(order+1)+order].
+
+// Fit the ephemerides of body over [mjd0, mjd1] with polynomials of
+// order EPHC_ORDER. Returns the flags of clbkEphemeris (data blocks
+// returned at all nodes). err receives the error estimate of each
+// component relative to the size of its data (0 for components not
+// returned, or fitted to the noise level of the samples).
+int EphemFit (CELBODY *body, double mjd0, double mjd1, double *c, double *err);
+
+// Evaluate coefficients c of the given order at x (-1 ... 1 over the
+// fitted interval) for the request flags req, with flag the flags
+// returned by EphemFit. Returns the flags of the data written to ret
+// (interface of clbkEphemeris).
+int EphemEval (const double *c, int order, int flag, double x, int req, double *ret);
+
+// ==============================================================
+// Ephemeris cache
+//
+// The body's ephemerides (clbkEphemeris) are sampled at the Chebyshev
+// nodes of a time segment, and the data blocks returned by the body
+// (true/barycentric position/velocity, cartesian or polar) are fitted
+// with Chebyshev polynomials of order EPHC_ORDER. The segment length
+// adapts to the body: a segment is halved until the error estimate
+// (size of the highest-order coefficients, relative to the size of
+// the data) is below the tolerance, and the next segment is doubled
+// if the estimate is well below it.
+//
+// Eval returns the interpolated data in O(1). Segments are fitted
+// ahead of the simulation time by a background thread, so the series
+// evaluations no longer happen in the frame update. If the simulation
+// time leaves the fitted range (e.g. after a date change), the segment
+// is fitted on the spot.
+//
+// Usage:
+//   class MyPlanet: public CELBODY {
+//     MyPlanet (): CELBODY(), cache (this) {}
+//     int clbkFastEphemeris (double simt, int req, double *ret)
+//     { return cache.Eval (simt, req, ret); }
+//     EphemCache cache;
+//     ...
+//   };
+// With background fitting, clbkEphemeris is called from the worker
+// thread and must be reentrant (no static work buffers).
+
+class EphemCache {
+public:
+	// Cache for body, with initial segment length h0 [days], relative
+	// tolerance tol and background fitting enabled if async is true
+	EphemCache (CELBODY *body, double h0 = 1.0, double tol = 1e-10, bool async = true);
+	~EphemCache ();
+
+	// Interpolated ephemerides at simulation time simt [s]
+	// (interface of clbkFastEphemeris)
+	int Eval (double simt, int req, double *ret);
+
+	// Discard all fitted segments
+	void Reset ();
+
+	// Terminate background fitting (segments are then fitted in Eval).
+	// Call at the start of the body's destructor if clbkEphemeris uses
+	// data released there.
+	void Stop ();
+
+private:
+	struct Segment {
+		double t0, t1;                  // segment range [s since MJD 0]
+		int flag;                       // flags returned by clbkEphemeris
+		double c[EPHC_NCOMP][EPHC_ORDER+1]; // Chebyshev coefficients
+	};
+
+	// Fit segment s starting at t0 [s], adapting the segment length
+	void Fit (Segment &s, double t0);
+
+	// Fit segments ahead of the last one until the ring is full
+	// (worker thread)
+	void Refill ();
+
+	static unsigned int WINAPI WorkerProc (LPVOID context);
+
+	CELBODY *body;
+	double h;                 // current segment length [s]
+	double hmin, hmax;        // segment length limits [s]
+	double tol;               // relative tolerance
+
+	Segment seg[EPHC_NSEG];   // ring of fitted segments
+	Segment work;             // segment being fitted by the worker
+	DWORD first, last;        // serial numbers of current and past-last segment
+	DWORD gen;                // generation, incremented by Reset
+
+	bool async;               // fit on the worker thread
+	bool quit;                // worker termination request
+	HANDLE hThread;           // worker thread
+	HANDLE hWake;             // wakes the worker
+	CRITICAL_SECTION cs;      // protects the ring
+	CRITICAL_SECTION csfit;   // serialises calls to clbkEphemeris
+};
+
+#endif // !__EPHEMCACHE_H
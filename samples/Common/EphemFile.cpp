@@ -0,0 +1,161 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// EphemFile.cpp
+// Precomputed ephemeris file of Chebyshev coefficients
+// ==============================================================
+
+#include "EphemFile.h"
+#include <stdio.h>
+#include <string.h>
+
+// ==============================================================
+
+EphemFile::EphemFile (const char *fname)
+{
+	strncpy (path, fname, 255); path[255] = '\0';
+	hdr = 0;
+	rec = 0;
+	recsize = 0;
+	mjdmax = 0.0;
+	failed = false;
+	writing = nquery = 0;
+	hFile = hMap = NULL;
+	InitializeCriticalSection (&cs);
+}
+
+// --------------------------------------------------------------
+
+EphemFile::~EphemFile ()
+{
+	Close ();
+	DeleteCriticalSection (&cs);
+}
+
+// --------------------------------------------------------------
+
+int EphemFile::Eval (double mjd, int req, double *ret)
+{
+	// the query is counted before writing is tested, and Write sets
+	// writing before it waits for the count: either the query sees
+	// writing, or Write waits until it has finished with the mapping
+	int res = 0;
+	InterlockedIncrement (&nquery);
+	if (!writing) {
+		if (!hdr && !failed) { // map the file on first use
+			EnterCriticalSection (&cs);
+			if (!hdr && !failed) failed = !Open ();
+			LeaveCriticalSection (&cs);
+		}
+		if (hdr && mjd >= hdr->mjd0 && mjd <= mjdmax) {
+			DWORD r = (DWORD)((mjd - hdr->mjd0)/hdr->dt);
+			if (r >= hdr->nrec) r = hdr->nrec-1;
+			const double *d = (const double*)(rec + r*recsize);
+			double x = (2.0*mjd - d[0] - d[1])/(d[1] - d[0]);
+			res = EphemEval (d+2, hdr->order, hdr->flag, x, req, ret);
+		}
+	}
+	InterlockedDecrement (&nquery);
+	return res;
+}
+
+// --------------------------------------------------------------
+
+bool EphemFile::Write (CELBODY *body, double mjd0, double mjd1, double dt)
+{
+	EphemFileHeader h;
+	DWORD r, i, ncoeff = EPHC_NCOMP*(EPHC_ORDER+1);
+	double err[EPHC_NCOMP], *buf = new double[2+ncoeff];
+
+	// block new queries and wait for running ones before unmapping
+	InterlockedExchange (&writing, 1);
+	while (nquery) Sleep (0);
+	EnterCriticalSection (&cs);
+	Close ();
+	failed = false;
+	LeaveCriticalSection (&cs);
+
+	FILE *f = 0;
+	bool ok = (mjd1 > mjd0 && dt > 0.0 && (f = fopen (path, "wb")));
+	if (ok) {
+		memset (&h, 0, sizeof(EphemFileHeader));
+		memcpy (h.magic, "EPH1", 4);
+		h.nrec = (DWORD)((mjd1-mjd0)/dt + 0.999999);
+		h.order = EPHC_ORDER;
+		h.ncomp = EPHC_NCOMP;
+		h.flag = ~0;
+		h.mjd0 = mjd0;
+		h.dt = dt;
+		fwrite (&h, sizeof(EphemFileHeader), 1, f); // rewritten below
+		for (r = 0; r < h.nrec && ok; r++) {
+			buf[0] = mjd0 + r*dt;
+			buf[1] = buf[0] + dt;
+			int flag = EphemFit (body, buf[0], buf[1], buf+2, err);
+			if (r) flag |= ~(EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYPOS | EPHEM_BARYVEL);
+			h.flag &= flag; // data blocks of all records
+			for (i = 0; i < EPHC_NCOMP; i++)
+				if (err[i] > h.maxerr) h.maxerr = err[i];
+			ok = (fwrite (buf, sizeof(double), 2+ncoeff, f) == 2+ncoeff);
+		}
+		fseek (f, 0, SEEK_SET);
+		ok = ok && (fwrite (&h, sizeof(EphemFileHeader), 1, f) == 1);
+		fclose (f);
+	}
+	delete []buf;
+
+	char cbuf[320];
+	if (ok) sprintf (cbuf, "EphemFile: wrote %.200s (%d records, max. rel. error %0.2g)", path, h.nrec, h.maxerr);
+	else    sprintf (cbuf, "EphemFile: failed to write %.200s", path);
+	oapiWriteLog (cbuf);
+
+	InterlockedExchange (&writing, 0);
+	return ok;
+}
+
+// --------------------------------------------------------------
+
+bool EphemFile::Open ()
+{
+	hFile = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		hFile = NULL;
+		return false;
+	}
+	DWORD size = GetFileSize (hFile, NULL);
+	if (size >= sizeof(EphemFileHeader) && (hMap = CreateFileMapping (hFile, NULL, PAGE_READONLY, 0, 0, NULL))) {
+		const EphemFileHeader *h = (const EphemFileHeader*)MapViewOfFile (hMap, FILE_MAP_READ, 0, 0, 0);
+		if (h) {
+			DWORD rsize = (2 + h->ncomp*(h->order+1))*sizeof(double);
+			if (!strncmp (h->magic, "EPH1", 4) && h->ncomp == EPHC_NCOMP &&
+				h->order >= 1 && h->order < 64 && h->nrec && h->dt > 0.0 &&
+				size >= sizeof(EphemFileHeader) + h->nrec*rsize) {
+				recsize = rsize;
+				rec = (const char*)(h+1);
+				mjdmax = h->mjd0 + h->nrec*h->dt;
+				hdr = h; // set last: Eval reads hdr without lock
+				return true;
+			}
+			UnmapViewOfFile (h);
+		}
+	}
+	char cbuf[320];
+	sprintf (cbuf, "EphemFile: invalid file %.200s", path);
+	oapiWriteLog (cbuf);
+	Close ();
+	return false;
+}
+
+// --------------------------------------------------------------
+
+void EphemFile::Close ()
+{
+	if (hdr) UnmapViewOfFile (hdr);
+	if (hMap) CloseHandle (hMap);
+	if (hFile) CloseHandle (hFile);
+	hdr = 0;
+	rec = 0;
+	hMap = hFile = NULL;
+}
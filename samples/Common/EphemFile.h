@@ -0,0 +1,94 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// EphemFile.h
+// Precomputed ephemeris file of Chebyshev coefficients, for serving
+// CELBODY::clbkEphemeris without series evaluation
+// ==============================================================
+
+#ifndef __EPHEMFILE_H
+#define __EPHEMFILE_H
+
+#include "EphemCache.h"
+
+// ==============================================================
+// File format
+//
+//   EphemFileHeader
+//   nrec x record, each
+//     double mjd0, mjd1            ; record interval
+//     double c[ncomp][order+1]     ; Chebyshev coefficients
+// Record r covers mjd0 + r*dt ... mjd0 + (r+1)*dt (as in the JPL DE
+// files). Component i is ret[i] of clbkEphemeris, in the format given
+// by flag (components of blocks not contained in flag are 0). Polar
+// longitudes are continuous within a record.
+
+struct EphemFileHeader {
+	char magic[4];         // "EPH1"
+	DWORD nrec;            // number of records
+	DWORD order;           // polynomial order
+	DWORD ncomp;           // number of components (EPHC_NCOMP)
+	int flag;              // clbkEphemeris flags of the data
+	DWORD pad;
+	double mjd0;           // start of coverage [MJD]
+	double dt;             // record length [days]
+	double maxerr;         // max relative error estimate of the fit
+};
+
+// ==============================================================
+// Ephemeris file
+//
+// The file is opened and memory-mapped on the first query, so the
+// startup cost doesn't depend on the file size, and only the records
+// actually used are paged in. A query is one record lookup and one
+// polynomial evaluation.
+//
+// Usage (fall back to the series outside the file's coverage):
+//   int MyPlanet::clbkEphemeris (double mjd, int req, double *ret)
+//   {
+//     int res = ephfile.Eval (mjd, req, ret);
+//     return (res ? res : SeriesEphemeris (mjd, req, ret));
+//   }
+// The file is created by Write, e.g. in clbkInit if it doesn't exist,
+// or in advance with the ephemtool of the headless bench.
+//
+// Eval may be called from several threads (e.g. the worker of an
+// EphemCache). Running queries are counted: Write blocks new queries
+// and waits for the running ones before it unmaps the file.
+
+class EphemFile {
+public:
+	EphemFile (const char *path);
+	~EphemFile ();
+
+	// Ephemerides at mjd (interface of clbkEphemeris). Returns 0 if mjd
+	// is outside the file's coverage or the file can't be read.
+	int Eval (double mjd, int req, double *ret);
+
+	// Sample the ephemerides of body from mjd0 to mjd1 in records of
+	// dt days, and write them to the file. While writing, Eval returns
+	// 0, so the body's clbkEphemeris is sampled from its own series.
+	// Returns false if the file can't be written. Must not be called
+	// by two threads at once.
+	bool Write (CELBODY *body, double mjd0, double mjd1, double dt);
+
+private:
+	bool Open ();          // map the file
+	void Close ();         // unmap the file
+
+	char path[256];        // file path
+	const EphemFileHeader *hdr; // mapped file (NULL if not mapped)
+	const char *rec;       // first record
+	DWORD recsize;         // record size [bytes]
+	double mjdmax;         // end of coverage [MJD]
+	bool failed;           // file can't be read
+	volatile LONG writing; // file being written: no new queries
+	volatile LONG nquery;  // number of running queries
+	HANDLE hFile, hMap;    // file mapping
+	CRITICAL_SECTION cs;   // protects the lazy open and Close
+};
+
+#endif // !__EPHEMFILE_H
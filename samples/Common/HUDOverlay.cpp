@@ -0,0 +1,134 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// HUDOverlay.cpp
+// Persistent mesh for custom HUD elements
+// ==============================================================
+
+#include "HUDOverlay.h"
+#include <string.h>
+
+DWORD HUDOverlay::nalloc = 0;
+
+// ==============================================================
+
+HUDOverlay::HUDOverlay ()
+{
+	nelem = 0;
+	vtx = 0;
+	idx = 0;
+	nvtx = nidx = 0;
+	hMesh = NULL;
+	vtxdirty = idxdirty = false;
+	nidxvis = 0;
+}
+
+// --------------------------------------------------------------
+
+HUDOverlay::~HUDOverlay ()
+{
+	Clear();
+	if (vtx) delete []vtx;
+	if (idx) delete []idx;
+}
+
+// --------------------------------------------------------------
+
+void HUDOverlay::SetElement (int e, const NTVERTEX *_vtx, DWORD _nvtx, const WORD *_idx, DWORD _nidx)
+{
+	if (e < nelem) { // update vertices of an existing element
+		memcpy (vtx+elem[e].vofs, _vtx, elem[e].nvtx*sizeof(NTVERTEX));
+		vtxdirty = true;
+		return;
+	}
+	if (e != nelem || nelem == HUDOVL_MAXELEM) return;
+
+	// append a new element; the mesh is rebuilt on the next render
+	NTVERTEX *tv = new NTVERTEX[nvtx+_nvtx];
+	if (nvtx) memcpy (tv, vtx, nvtx*sizeof(NTVERTEX));
+	memcpy (tv+nvtx, _vtx, _nvtx*sizeof(NTVERTEX));
+	if (vtx) delete []vtx;
+	vtx = tv;
+
+	WORD *ti = new WORD[nidx+_nidx];
+	if (nidx) memcpy (ti, idx, nidx*sizeof(WORD));
+	for (DWORD i = 0; i < _nidx; i++)
+		ti[nidx+i] = (WORD)(_idx[i]+nvtx);
+	if (idx) delete []idx;
+	idx = ti;
+
+	elem[e].vofs = nvtx, elem[e].nvtx = _nvtx;
+	elem[e].iofs = nidx, elem[e].nidx = _nidx;
+	elem[e].show = false;
+	nvtx += _nvtx;
+	nidx += _nidx;
+	nelem++;
+	Clear();
+}
+
+// --------------------------------------------------------------
+
+void HUDOverlay::Show (int e, bool show)
+{
+	if (e < nelem && elem[e].show != show) {
+		elem[e].show = show;
+		idxdirty = true;
+	}
+}
+
+// --------------------------------------------------------------
+
+void HUDOverlay::Render (SURFHANDLE *hTex)
+{
+	if (!nelem) return;
+	if (!hMesh) {
+		Create();
+	} else if (vtxdirty) {
+		GROUPEDITSPEC ges;
+		ges.flags = GRPEDIT_VTX;
+		ges.Vtx = vtx;
+		ges.nVtx = nvtx;
+		ges.vIdx = NULL;
+		oapiEditMeshGroup (hMesh, 0, &ges);
+		vtxdirty = false;
+	}
+
+	if (idxdirty) { // collect the index lists of the visible elements
+		MESHGROUP *grp = oapiMeshGroup (hMesh, 0);
+		nidxvis = 0;
+		for (int e = 0; e < nelem; e++)
+			if (elem[e].show) {
+				memcpy (grp->Idx+nidxvis, idx+elem[e].iofs, elem[e].nidx*sizeof(WORD));
+				nidxvis += elem[e].nidx;
+			}
+		grp->nIdx = nidxvis;
+		idxdirty = false;
+	}
+
+	if (nidxvis)
+		oapiRenderHUD (hMesh, hTex);
+}
+
+// --------------------------------------------------------------
+
+void HUDOverlay::Create ()
+{
+	MESHGROUP grp = {vtx, idx, nvtx, nidx, 0, 0, 0, 0, 0};
+	hMesh = oapiCreateMesh (1, &grp);
+	nalloc++;
+	vtxdirty = false;
+	idxdirty = true;
+}
+
+// --------------------------------------------------------------
+
+void HUDOverlay::Clear ()
+{
+	if (hMesh) {
+		oapiDeleteMesh (hMesh);
+		hMesh = NULL;
+	}
+}
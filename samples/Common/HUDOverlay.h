@@ -0,0 +1,73 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// HUDOverlay.h
+// Persistent mesh for custom HUD elements rendered from
+// VESSEL3::clbkRenderHUD (DeltaGlider, ShuttleA)
+// ==============================================================
+
+#ifndef __HUDOVERLAY_H
+#define __HUDOVERLAY_H
+
+#include "orbitersdk.h"
+
+const int HUDOVL_MAXELEM = 8;  // max number of elements per overlay
+
+// ==============================================================
+// HUD overlay
+//
+// A set of elements (textured 2-D triangle lists) held in a single
+// mesh group. The mesh is created on first use and kept for the
+// lifetime of the overlay. Vertex changes are applied in place with
+// oapiEditMeshGroup, and elements are shown or hidden by rebuilding
+// the group's index list from the visible elements, so a frame with
+// no visible element has a zero index count and is not rendered.
+
+class HUDOverlay {
+public:
+	HUDOverlay ();
+	~HUDOverlay ();
+
+	// Define element elem (0 <= elem <= number of defined elements).
+	// A new element is appended to the overlay. For an existing element,
+	// the vertices are replaced, and nvtx, idx and nidx must not change.
+	// Index list entries refer to the element's vertex list.
+	void SetElement (int elem, const NTVERTEX *vtx, DWORD nvtx, const WORD *idx, DWORD nidx);
+
+	inline int nElement () const { return nelem; }
+
+	// Set the visibility of an element. Elements are hidden initially.
+	void Show (int elem, bool show);
+
+	// Render the visible elements (call from clbkRenderHUD)
+	void Render (SURFHANDLE *hTex);
+
+	// Number of meshes created by all overlays so far
+	static inline DWORD Allocations () { return nalloc; }
+
+private:
+	void Create ();
+	void Clear ();
+
+	struct Element {
+		DWORD vofs, nvtx;   // range in vertex list
+		DWORD iofs, nidx;   // range in index template
+		bool show;          // visibility flag
+	} elem[HUDOVL_MAXELEM];
+	int nelem;              // number of defined elements
+
+	NTVERTEX *vtx;          // vertex list of all elements
+	WORD *idx;              // index template of all elements
+	DWORD nvtx, nidx;       // vertex and index count
+	MESHHANDLE hMesh;       // overlay mesh (NULL if not yet created)
+	bool vtxdirty;          // vertex list modified since the last mesh update
+	bool idxdirty;          // visibility modified since the last mesh update
+	DWORD nidxvis;          // index count of the visible elements
+
+	static DWORD nalloc;    // mesh allocation counter
+};
+
+#endif // !__HUDOVERLAY_H
@@ -0,0 +1,356 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Kepler.cpp
+// Two-body orbit propagation: conversion between ELEMENTS and state
+// vectors, Kepler equation, and SSE2 batch propagation
+// ==============================================================
+
+#include "Kepler.h"
+#include <emmintrin.h>
+#include <math.h>
+
+const int KEPL_MAXIT = 50;       // max. iterations of the Kepler equation
+
+// ==============================================================
+// Local helpers
+
+static inline double Norm2Pi (double x)
+{
+	x = fmod (x, PI2);
+	return (x < 0.0 ? x + PI2 : x);
+}
+
+// Unit vectors P (to periapsis) and Q (90 deg ahead) of the orbit
+// plane, in Orbiter's frame (ecliptic y and z swapped)
+static void Frame (const ELEMENTS &el, double *P, double *Q)
+{
+	double ci = cos (el.i), si = sin (el.i);
+	double cO = cos (el.theta), sO = sin (el.theta);
+	double w = el.omegab - el.theta, cw = cos (w), sw = sin (w);
+	P[0] =  cO*cw - sO*sw*ci;   P[2] =  sO*cw + cO*sw*ci;   P[1] = sw*si;
+	Q[0] = -cO*sw - sO*cw*ci;   Q[2] = -sO*sw + cO*cw*ci;   Q[1] = cw*si;
+}
+
+// Orbit parameters from elements, mean motion n, mean anomaly M,
+// eccentric/hyperbolic anomaly E and true anomaly nu
+static void SetParams (const ELEMENTS &el, double n, double M, double E, double nu, ORBITPARAM *prm)
+{
+	double a = el.a, e = el.e;
+	if (e < 1.0) {
+		prm->SMi = a*sqrt (1.0-e*e);
+		prm->ApD = a*(1.0+e);
+		prm->MnA = Norm2Pi (M);
+		prm->EcA = Norm2Pi (E);
+		prm->T   = PI2/n;
+		prm->PeT = (PI2 - prm->MnA)/n;
+		prm->ApT = (prm->MnA < PI ? PI - prm->MnA : 3.0*PI - prm->MnA)/n;
+	} else {
+		prm->SMi = -a*sqrt (e*e-1.0);
+		prm->ApD = 0.0;
+		prm->MnA = M;
+		prm->EcA = E;
+		prm->T   = 0.0;
+		prm->PeT = -M/n;
+		prm->ApT = 0.0;
+	}
+	prm->PeD = a*(1.0-e);
+	prm->Lec = fabs (a)*e;
+	prm->TrA = Norm2Pi (nu);
+	prm->MnL = Norm2Pi (M + el.omegab);
+	prm->TrL = Norm2Pi (nu + el.omegab);
+}
+
+// ==============================================================
+
+double EccAnomaly (double M, double e)
+{
+	// reduce to -Pi ... Pi, where the root is bracketed by M and M +/- e
+	double Mr = fmod (M, PI2);
+	if (Mr > PI) Mr -= PI2;
+	else if (Mr < -PI) Mr += PI2;
+	double sg = (Mr < 0.0 ? -1.0 : 1.0);
+	double lo = min (Mr, Mr + sg*e), hi = max (Mr, Mr + sg*e);
+
+	double E = Mr + 0.85*e*sg; // Danby's starting value
+	for (int k = 0; k < KEPL_MAXIT; k++) {
+		double s = e*sin (E), c = e*cos (E);
+		double f = E - s - Mr, f1 = 1.0 - c;
+		double dE = f/(f1 - 0.5*f*s/f1); // Halley step
+		E -= dE;
+		if (E < lo) E = lo; else if (E > hi) E = hi;
+		if (fabs (dE) < 1e-14) break;
+	}
+	return E + (M - Mr);
+}
+
+// --------------------------------------------------------------
+
+double HypAnomaly (double M, double e)
+{
+	// the root is bracketed by asinh(M/e) and asinh(M/(e-1))
+	double sg = (M < 0.0 ? -1.0 : 1.0), Ma = fabs (M);
+	double lo = log (Ma/e + sqrt (Ma*Ma/(e*e) + 1.0));
+	double hi = (Ma < 1e300*(e-1.0) ? log (Ma/(e-1.0) + sqrt (Ma*Ma/((e-1.0)*(e-1.0)) + 1.0)) : 1e3);
+
+	double H = log (2.0*Ma/e + 1.8); // Danby's starting value
+	for (int k = 0; k < KEPL_MAXIT; k++) {
+		double s = e*sinh (H), c = e*cosh (H);
+		double f = s - H - Ma, f1 = c - 1.0;
+		double dH = f/(f1 - 0.5*f*s/f1); // Halley step
+		H -= dH;
+		if (H < lo) H = lo; else if (H > hi) H = hi;
+		if (fabs (dH) < 1e-14*max (1.0, H)) break;
+	}
+	return sg*H;
+}
+
+// --------------------------------------------------------------
+
+void El2State (const ELEMENTS &el, double mu, double dt, VECTOR3 &pos, VECTOR3 &vel, ORBITPARAM *prm)
+{
+	double a = el.a, e = el.e;
+	double n = sqrt (mu/fabs (a*a*a));
+	double M = el.L - el.omegab + n*dt;
+	double E, nu, xp, yp, xv, yv;
+
+	if (e < 1.0) {
+		M = Norm2Pi (M);
+		E = EccAnomaly (M, e);
+		double c = cos (E), s = sin (E), q = sqrt (1.0-e*e);
+		double f = n/(1.0 - e*c);  // a n / r
+		xp = a*(c-e),   yp = a*q*s;
+		xv = -a*f*s,    yv = a*q*f*c;
+		nu = atan2 (q*s, c-e);
+	} else {
+		E = HypAnomaly (M, e);
+		double c = cosh (E), s = sinh (E), q = sqrt (e*e-1.0);
+		double f = n/(e*c - 1.0);  // |a| n / r
+		xp = a*(c-e),   yp = -a*q*s;
+		xv = a*f*s,     yv = -a*q*f*c;
+		nu = atan2 (q*s, e-c);
+	}
+
+	double P[3], Q[3];
+	Frame (el, P, Q);
+	pos = _V(xp*P[0] + yp*Q[0], xp*P[1] + yp*Q[1], xp*P[2] + yp*Q[2]);
+	vel = _V(xv*P[0] + yv*Q[0], xv*P[1] + yv*Q[1], xv*P[2] + yv*Q[2]);
+	if (prm) SetParams (el, n, M, E, nu, prm);
+}
+
+// --------------------------------------------------------------
+
+void State2El (const VECTOR3 &pos, const VECTOR3 &vel, double mu, ELEMENTS &el, ORBITPARAM *prm)
+{
+	// right-handed ecliptic frame
+	VECTOR3 r = _V(pos.x, pos.z, pos.y), v = _V(vel.x, vel.z, vel.y);
+	VECTOR3 h = crossp (r, v);
+	double rm = length (r), hm = length (h), v2 = dotp (v, v), rv = dotp (r, v);
+	VECTOR3 ev = (r*(v2 - mu/rm) - v*rv)/mu;
+	double e = length (ev);
+	double a = -mu/(v2 - 2.0*mu/rm);
+
+	// ascending node N, and the in-plane direction W x N 90 deg ahead of it
+	double i = acos (h.z/hm);
+	double theta = (sqrt (h.x*h.x + h.y*h.y) > 1e-12*hm ? Norm2Pi (atan2 (h.x, -h.y)) : 0.0);
+	VECTOR3 N = _V(cos (theta), sin (theta), 0.0);
+	VECTOR3 M = crossp (h, N)/hm;
+	double w = (e > 1e-12 ? atan2 (dotp (ev, M), dotp (ev, N)) : 0.0);
+	double nu = atan2 (dotp (r, M), dotp (r, N)) - w;
+
+	double E, Mn, sn = sin (nu), cn = cos (nu);
+	if (e < 1.0) {
+		E = atan2 (sqrt (1.0-e*e)*sn, e + cn);
+		Mn = Norm2Pi (E - e*sin (E));
+	} else {
+		double sh = sqrt (e*e-1.0)*sn/(1.0 + e*cn);
+		E = log (sh + sqrt (sh*sh + 1.0));
+		Mn = e*sh - E;
+	}
+
+	el.a = a;
+	el.e = e;
+	el.i = i;
+	el.theta = theta;
+	el.omegab = Norm2Pi (theta + w);
+	el.L = (e < 1.0 ? Norm2Pi (el.omegab + Mn) : el.omegab + Mn);
+	if (prm) SetParams (el, sqrt (mu/fabs (a*a*a)), Mn, E, nu, prm);
+}
+
+// ==============================================================
+// Vector functions
+
+// sin and cos of 2 doubles (|x| < 1e6): reduction by Pi/2 in three
+// parts, Cephes polynomials on -Pi/4 ... Pi/4, then quadrant swap
+static inline void vsincos (__m128d x, __m128d &s, __m128d &c)
+{
+	static const double sc[6] = {
+		 1.58962301576546568060e-10, -2.50507477628578072866e-8,  2.75573136213857245213e-6,
+		-1.98412698295895385996e-4,   8.33333333332211858878e-3, -1.66666666666666307295e-1
+	};
+	static const double cc[6] = {
+		-1.13585365213876817300e-11,  2.08757008419747316778e-9, -2.75573141792967388112e-7,
+		 2.48015872888517045348e-5,  -1.38888888888730564116e-3,  4.16666666666665929218e-2
+	};
+	__m128i q = _mm_cvtpd_epi32 (_mm_mul_pd (x, _mm_set1_pd (0.63661977236758134308)));
+	__m128d fq = _mm_cvtepi32_pd (q);
+	__m128d r = _mm_sub_pd (x, _mm_mul_pd (fq, _mm_set1_pd (1.57079625129699707031)));
+	r = _mm_sub_pd (r, _mm_mul_pd (fq, _mm_set1_pd (7.54978941586159635336e-8)));
+	r = _mm_sub_pd (r, _mm_mul_pd (fq, _mm_set1_pd (5.39030285815811905290e-15)));
+	__m128d z = _mm_mul_pd (r, r);
+	__m128d ps = _mm_set1_pd (sc[0]), pc = _mm_set1_pd (cc[0]);
+	for (int k = 1; k < 6; k++) {
+		ps = _mm_add_pd (_mm_mul_pd (ps, z), _mm_set1_pd (sc[k]));
+		pc = _mm_add_pd (_mm_mul_pd (pc, z), _mm_set1_pd (cc[k]));
+	}
+	__m128d sr = _mm_add_pd (r, _mm_mul_pd (_mm_mul_pd (r, z), ps));
+	__m128d cr = _mm_add_pd (_mm_sub_pd (_mm_set1_pd (1.0), _mm_mul_pd (_mm_set1_pd (0.5), z)), _mm_mul_pd (_mm_mul_pd (z, z), pc));
+
+	// quadrant q: swap sin/cos if q is odd, negate sin if q&2, cos if (q+1)&2
+	__m128i q2 = _mm_shuffle_epi32 (q, _MM_SHUFFLE(1,1,0,0)); // int32 to both halves of the int64 lanes
+	__m128d swap = _mm_castsi128_pd (_mm_cmpeq_epi32 (_mm_and_si128 (q2, _mm_set1_epi32 (1)), _mm_set1_epi32 (1)));
+	__m128d nsin = _mm_castsi128_pd (_mm_slli_epi64 (_mm_and_si128 (q2, _mm_set1_epi32 (2)), 62));
+	__m128d ncos = _mm_castsi128_pd (_mm_slli_epi64 (_mm_and_si128 (_mm_add_epi32 (q2, _mm_set1_epi32 (1)), _mm_set1_epi32 (2)), 62));
+	s = _mm_xor_pd (_mm_or_pd (_mm_and_pd (swap, cr), _mm_andnot_pd (swap, sr)), nsin);
+	c = _mm_xor_pd (_mm_or_pd (_mm_and_pd (swap, sr), _mm_andnot_pd (swap, cr)), ncos);
+}
+
+// ==============================================================
+
+KeplerBatch::KeplerBatch (int _nmax)
+{
+	nmax = _nmax;
+	n = 0;
+	buf = new double[13*nmax];
+	t0  = buf;
+	M0  = buf + nmax;
+	mm  = buf + 2*nmax;
+	sma = buf + 3*nmax;
+	smi = buf + 4*nmax;
+	ecc = buf + 5*nmax;
+	for (int j = 0; j < 3; j++) {
+		P[j] = buf + (6+j)*nmax;
+		Q[j] = buf + (9+j)*nmax;
+	}
+	mu = buf + 12*nmax;
+	el = new ELEMENTS[nmax];
+}
+
+// --------------------------------------------------------------
+
+KeplerBatch::~KeplerBatch ()
+{
+	delete []buf;
+	delete []el;
+}
+
+// --------------------------------------------------------------
+
+int KeplerBatch::Add (const ELEMENTS &_el, double _mu, double mjd_ref)
+{
+	if (n == nmax) return -1;
+	double p[3], q[3];
+	Frame (_el, p, q);
+	t0[n]  = mjd_ref;
+	M0[n]  = Norm2Pi (_el.L - _el.omegab);
+	mm[n]  = sqrt (_mu/fabs (_el.a*_el.a*_el.a));
+	sma[n] = _el.a;
+	smi[n] = (_el.e < 1.0 ? _el.a*sqrt (1.0 - _el.e*_el.e) : 0.0);
+	ecc[n] = _el.e;
+	for (int j = 0; j < 3; j++) {
+		P[j][n] = p[j];
+		Q[j][n] = q[j];
+	}
+	el[n] = _el;
+	mu[n] = _mu;
+	return n++;
+}
+
+// --------------------------------------------------------------
+
+void KeplerBatch::Propagate1 (int i, double dt, double *r, double *v) const
+{
+	VECTOR3 pos, vel;
+	El2State (el[i], mu[i], dt, pos, vel);
+	r[0] = pos.x, r[1] = pos.y, r[2] = pos.z;
+	v[0] = vel.x, v[1] = vel.y, v[2] = vel.z;
+}
+
+// --------------------------------------------------------------
+
+void KeplerBatch::Propagate (const double *mjd, int nt, double *x, double *y, double *z,
+	double *vx, double *vy, double *vz) const
+{
+	const __m128d one = _mm_set1_pd (1.0);
+	const __m128d sgnbit = _mm_set1_pd (-0.0);
+	double *rv[6] = {x, y, z, vx, vy, vz};
+	int i, j, k, m, it;
+
+	for (k = 0; k < nt; k++) {
+		int ofs = k*n;
+		for (i = 0; i < n; i += 2) {
+			j = (i+1 < n ? i+1 : i); // second lane (same orbit for an odd count)
+
+			if (ecc[i] >= 1.0 || ecc[j] >= 1.0) { // hyperbolic: scalar
+				double r[3], v[3];
+				for (it = i; it <= j; it++) {
+					Propagate1 (it, (mjd[k]-t0[it])*86400.0, r, v);
+					for (m = 0; m < 3; m++) {
+						rv[m][ofs+it] = r[m];
+						if (vx) rv[m+3][ofs+it] = v[m];
+					}
+				}
+				continue;
+			}
+
+			// mean anomaly, reduced to -Pi ... Pi
+			__m128d e  = _mm_set_pd (ecc[j], ecc[i]);
+			__m128d dt = _mm_mul_pd (_mm_sub_pd (_mm_set1_pd (mjd[k]), _mm_set_pd (t0[j], t0[i])), _mm_set1_pd (86400.0));
+			__m128d n0 = _mm_set_pd (mm[j], mm[i]);
+			__m128d M  = _mm_add_pd (_mm_set_pd (M0[j], M0[i]), _mm_mul_pd (n0, dt));
+			__m128d rev = _mm_cvtepi32_pd (_mm_cvtpd_epi32 (_mm_mul_pd (M, _mm_set1_pd (1.0/PI2))));
+			M = _mm_sub_pd (M, _mm_mul_pd (rev, _mm_set1_pd (PI2)));
+
+			// Kepler equation: Halley iteration from Danby's starting
+			// value, kept within the bracket M ... M +/- e
+			__m128d se = _mm_xor_pd (e, _mm_and_pd (M, sgnbit)); // e with the sign of M
+			__m128d lo = _mm_min_pd (M, _mm_add_pd (M, se)), hi = _mm_max_pd (M, _mm_add_pd (M, se));
+			__m128d E = _mm_add_pd (M, _mm_mul_pd (_mm_set1_pd (0.85), se));
+			__m128d s, c;
+			for (it = 0; it < KEPL_MAXIT; it++) {
+				vsincos (E, s, c);
+				s = _mm_mul_pd (e, s);
+				c = _mm_mul_pd (e, c);
+				__m128d f  = _mm_sub_pd (_mm_sub_pd (E, s), M);
+				__m128d f1 = _mm_sub_pd (one, c);
+				__m128d dE = _mm_div_pd (f, _mm_sub_pd (f1, _mm_div_pd (_mm_mul_pd (_mm_mul_pd (_mm_set1_pd (0.5), f), s), f1)));
+				E = _mm_min_pd (_mm_max_pd (_mm_sub_pd (E, dE), lo), hi);
+				if (!_mm_movemask_pd (_mm_cmpge_pd (_mm_andnot_pd (sgnbit, dE), _mm_set1_pd (1e-14)))) break;
+			}
+			vsincos (E, s, c);
+
+			// position and velocity in the orbit plane, then in space
+			__m128d a  = _mm_set_pd (sma[j], sma[i]);
+			__m128d b  = _mm_set_pd (smi[j], smi[i]);
+			__m128d xp = _mm_mul_pd (a, _mm_sub_pd (c, e));
+			__m128d yp = _mm_mul_pd (b, s);
+			__m128d f  = _mm_div_pd (n0, _mm_sub_pd (one, _mm_mul_pd (e, c))); // a n / r
+			__m128d xv = _mm_mul_pd (_mm_mul_pd (a, f), _mm_xor_pd (s, sgnbit));
+			__m128d yv = _mm_mul_pd (_mm_mul_pd (b, f), c);
+			for (m = 0; m < 3; m++) {
+				__m128d p = _mm_set_pd (P[m][j], P[m][i]), q = _mm_set_pd (Q[m][j], Q[m][i]);
+				__m128d r = _mm_add_pd (_mm_mul_pd (xp, p), _mm_mul_pd (yp, q));
+				if (j > i) _mm_storeu_pd (rv[m]+ofs+i, r);
+				else       _mm_store_sd (rv[m]+ofs+i, r);
+				if (vx) {
+					__m128d v = _mm_add_pd (_mm_mul_pd (xv, p), _mm_mul_pd (yv, q));
+					if (j > i) _mm_storeu_pd (rv[m+3]+ofs+i, v);
+					else       _mm_store_sd (rv[m+3]+ofs+i, v);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,97 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// Kepler.h
+// Two-body orbit propagation: conversion between ELEMENTS and state
+// vectors, Kepler equation, and SSE2 batch propagation
+// ==============================================================
+
+#ifndef __KEPLER_H
+#define __KEPLER_H
+
+#include "orbitersdk.h"
+
+// ==============================================================
+// Conventions
+//
+// As in VESSEL::GetElements/SetElements: state vectors are in
+// Orbiter's left-handed frame (y axis = north pole of the reference
+// plane), relative to the orbited body; el.L is the mean longitude at
+// the epoch (dt = 0), and el.a < 0 for hyperbolic orbits. Parabolic
+// orbits (e = 1) can't be represented by ELEMENTS. mu is the
+// gravitational parameter G*(M+m) [m^3/s^2].
+
+// Eccentric anomaly E of mean anomaly M for 0 <= e < 1
+// (E - e sin E = M). Valid for any M; E is in the revolution of M.
+double EccAnomaly (double M, double e);
+
+// Hyperbolic anomaly H of mean anomaly M for e > 1 (e sinh H - H = M)
+double HypAnomaly (double M, double e);
+
+// Position and velocity at dt [s] after the epoch of el. If prm is
+// given, it receives the orbit parameters at that time.
+void El2State (const ELEMENTS &el, double mu, double dt, VECTOR3 &pos, VECTOR3 &vel, ORBITPARAM *prm = 0);
+
+// Elements (epoch = time of the state) of position pos and velocity
+// vel. If prm is given, it receives the orbit parameters.
+void State2El (const VECTOR3 &pos, const VECTOR3 &vel, double mu, ELEMENTS &el, ORBITPARAM *prm = 0);
+
+// ==============================================================
+// Batch propagation
+//
+// Holds a set of orbits in structure-of-arrays form, and propagates
+// all of them to a list of times. The Kepler equation of two elliptic
+// orbits is solved per SSE2 instruction (Halley iteration from
+// Danby's starting value, with vector sin/cos); hyperbolic orbits are
+// propagated with El2State.
+//
+// Usage:
+//   KeplerBatch kb (n);
+//   for (i = 0; i < n; i++) kb.Add (el[i], mu, mjd_ref[i]);
+//   kb.Propagate (mjd, nt, x, y, z, vx, vy, vz); // nt*n results each
+
+class KeplerBatch {
+public:
+	// Batch of up to nmax orbits
+	KeplerBatch (int nmax);
+	~KeplerBatch ();
+
+	// Add an orbit with elements el at epoch mjd_ref about a body with
+	// gravitational parameter mu. Returns the index of the orbit, or -1
+	// if the batch is full.
+	int Add (const ELEMENTS &el, double mu, double mjd_ref);
+
+	// Remove all orbits
+	void Clear () { n = 0; }
+
+	// Number of orbits
+	int Count () const { return n; }
+
+	// Positions (and velocities, unless vx is NULL) of all orbits at
+	// times mjd[0] ... mjd[nt-1]. Results of orbit i at time k are
+	// stored in x[k*Count()+i] etc.
+	void Propagate (const double *mjd, int nt, double *x, double *y, double *z,
+		double *vx = 0, double *vy = 0, double *vz = 0) const;
+
+private:
+	// Propagate orbit i by dt [s] (scalar version)
+	void Propagate1 (int i, double dt, double *r, double *v) const;
+
+	int nmax, n;        // capacity, number of orbits
+	double *buf;        // storage of the arrays below
+	double *t0;         // epoch [MJD]
+	double *M0;         // mean anomaly at epoch [rad]
+	double *mm;         // mean motion [rad/s]
+	double *sma;        // semi-major axis [m]
+	double *smi;        // semi-minor axis [m]
+	double *ecc;        // eccentricity
+	double *P[3];       // unit vector to periapsis (Orbiter frame)
+	double *Q[3];       // unit vector 90 deg ahead of P in the orbit plane
+	ELEMENTS *el;       // elements (for the scalar version)
+	double *mu;         // gravitational parameter
+};
+
+#endif // !__KEPLER_H
@@ -0,0 +1,54 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// TermBuffer.cpp
+// Fixed-capacity line buffer for terminal windows
+// ==============================================================
+
+#include "TermBuffer.h"
+#include <string.h>
+
+// ==============================================================
+
+TermBuffer::TermBuffer (DWORD nline, DWORD _nchar)
+{
+	DWORD nbuf;
+	for (nbuf = 1; nbuf < nline; nbuf <<= 1); // capacity rounded up to a power of 2
+	mask = nbuf-1;
+	nchar = _nchar;
+	line = new LineSpec[nbuf];
+	text = new char[nbuf*nchar];
+	first = end = 0;
+}
+
+// --------------------------------------------------------------
+
+TermBuffer::~TermBuffer ()
+{
+	delete []line;
+	delete []text;
+}
+
+// --------------------------------------------------------------
+
+void TermBuffer::Append (const char *str, DWORD attr)
+{
+	DWORD i = end & mask;
+	DWORD len = strlen (str);
+	if (len >= nchar) len = nchar-1;
+	memcpy (text + i*nchar, str, len);
+	text[i*nchar+len] = '\0';
+	line[i].len = len;
+	line[i].attr = attr;
+	if (++end - first > mask+1) first++;
+}
+
+// --------------------------------------------------------------
+
+void TermBuffer::Clear ()
+{
+	first = end;
+}
@@ -0,0 +1,67 @@
+// ==============================================================
+//                 ORBITER MODULE: Common
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// TermBuffer.h
+// Fixed-capacity line buffer for terminal windows (LuaConsole,
+// LuaMFD)
+// ==============================================================
+
+#ifndef __TERMBUFFER_H
+#define __TERMBUFFER_H
+
+#include <windows.h>
+
+// ==============================================================
+// Terminal line buffer
+//
+// A ring of fixed-size lines held in a single allocation. Appending
+// a line is O(1) and drops the oldest line once the buffer is full.
+// Lines are addressed by serial number: the n-th line ever appended
+// has serial n, and the buffered lines are First() ... End()-1.
+// A line never changes once appended, so a display that remembers
+// the End() value of its last repaint only needs to draw the lines
+// appended since.
+
+class TermBuffer {
+public:
+	// Buffer for at least nline lines of up to nchar-1 characters
+	TermBuffer (DWORD nline, DWORD nchar);
+	~TermBuffer ();
+
+	// Append a line with a user-defined attribute (e.g. colour).
+	// Longer lines are truncated.
+	void Append (const char *str, DWORD attr = 0);
+
+	// Remove all lines (serial numbers continue)
+	void Clear ();
+
+	// Serial number of the oldest buffered line
+	inline DWORD First () const { return first; }
+
+	// Serial number following the newest line
+	inline DWORD End () const { return end; }
+
+	// Number of buffered lines
+	inline DWORD nLine () const { return end-first; }
+
+	// Text, length and attribute of the line with serial number n
+	// (First() <= n < End())
+	inline const char *Text (DWORD n) const { return text + (n & mask)*nchar; }
+	inline DWORD Len (DWORD n) const { return line[n & mask].len; }
+	inline DWORD Attr (DWORD n) const { return line[n & mask].attr; }
+
+private:
+	struct LineSpec {
+		DWORD len;          // line length
+		DWORD attr;         // line attribute
+	} *line;                // line records
+	char *text;             // line text (nchar per line)
+	DWORD nchar;            // line size (including terminating 0)
+	DWORD mask;             // ring index mask (capacity-1)
+	DWORD first, end;       // serial numbers of first and past-last line
+};
+
+#endif // !__TERMBUFFER_H
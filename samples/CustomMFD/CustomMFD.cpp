@@ -15,20 +15,24 @@
 #include <math.h>
 #include "orbitersdk.h"
 #include "CustomMFD.h"
+#include "../Common/DataRecorder.h"
 
 // ==============================================================
 // Global variables
 
-const int ndata = 200;  // data points
-const double sample_dt = 5.0; // data point interval
+const int ndata = 200;  // data points displayed
+const DWORD rec_budget = 0x200000; // recorder storage [bytes]
+
+enum { CH_ALT, CH_PITCH, CH_RVEL, CH_TVEL, NCH }; // recorder channels
 
 static struct {  // "Ascent MFD" parameters
 	int mode;      // identifier for new MFD mode
 } g_AscentMFD;
 
 static struct {  // global data storage
-	double tnext;  // time of next sample
-	int   sample;  // current sample index
+	DataRecorder *rec; // recorded samples of every frame
+	double tsync;  // recorder time at last display update
+	int   sample;  // display array offset (always 0)
 	float *time;   // sample time
 	float *alt;    // altitude data
 	float *pitch;  // pitch data
@@ -48,7 +52,8 @@ DLLCLBK void InitModule (HINSTANCE hDLL)
 	spec.context = NULL;
 	spec.msgproc = AscentMFD::MsgProc;
 
-	g_Data.tnext  = 0.0;
+	g_Data.rec    = new DataRecorder (NCH, rec_budget);
+	g_Data.tsync  = -1.0;
 	g_Data.sample = 0;
 	g_Data.time   = new float[ndata];   memset (g_Data.time,  0, ndata*sizeof(float));
 	g_Data.alt    = new float[ndata];   memset (g_Data.alt,   0, ndata*sizeof(float));
@@ -62,6 +67,7 @@ DLLCLBK void InitModule (HINSTANCE hDLL)
 DLLCLBK void ExitModule (HINSTANCE hDLL)
 {
 	oapiUnregisterMFDMode (g_AscentMFD.mode);
+	delete g_Data.rec;
 	delete []g_Data.time;
 	delete []g_Data.alt;
 	delete []g_Data.pitch;
@@ -74,29 +80,53 @@ DLLCLBK void ExitModule (HINSTANCE hDLL)
 
 DLLCLBK void opcPreStep (double simt, double simdt, double mjd)
 {
-	if (simt >= g_Data.tnext) {
-		VESSEL *v = oapiGetFocusInterface();
-		VECTOR3 vel, pos;
-		double a, r2, v2, vr2, vt2;
-		double alt = v->GetAltitude();
-		if (alt > v->GetSize()) { // start recording
-			g_Data.time[g_Data.sample]  = (float)simt;
-			g_Data.alt[g_Data.sample]   = (float)(alt*1e-3);
-			g_Data.pitch[g_Data.sample] = (float)(v->GetPitch()*DEG);
-			v->GetRelativeVel (v->GetSurfaceRef(), vel);
-			// get radial and tangential velocity components
-			v->GetRelativePos (v->GetSurfaceRef(), pos);
-			r2 = pos.x*pos.x + pos.y*pos.y + pos.z*pos.z;
-			v2 = vel.x*vel.x + vel.y*vel.y + vel.z*vel.z;
-			a  = (vel.x*pos.x + vel.y*pos.y + vel.z*pos.z) / r2;
-			vr2 = a*a * r2;
-			vt2 = v2 - vr2;
-			g_Data.rvel[g_Data.sample] = (vr2 >= 0.0 ? a >= 0.0 ? (float)sqrt(vr2) : -(float)sqrt(vr2) : 0.0f)*1e-3f;
-			g_Data.tvel[g_Data.sample] = (vt2 >= 0.0 ? (float)sqrt(vt2) : 0.0f)*1e-3f;
-			g_Data.sample = (g_Data.sample+1) % ndata;
-			g_Data.tnext += sample_dt;
+	VESSEL *v = oapiGetFocusInterface();
+	VECTOR3 vel, pos;
+	double a, r2, v2, vr2, vt2;
+	double alt = v->GetAltitude();
+	if (alt > v->GetSize()) { // start recording
+		float val[NCH];
+		val[CH_ALT]   = (float)(alt*1e-3);
+		val[CH_PITCH] = (float)(v->GetPitch()*DEG);
+		v->GetRelativeVel (v->GetSurfaceRef(), vel);
+		// get radial and tangential velocity components
+		v->GetRelativePos (v->GetSurfaceRef(), pos);
+		r2 = pos.x*pos.x + pos.y*pos.y + pos.z*pos.z;
+		v2 = vel.x*vel.x + vel.y*vel.y + vel.z*vel.z;
+		a  = (vel.x*pos.x + vel.y*pos.y + vel.z*pos.z) / r2;
+		vr2 = a*a * r2;
+		vt2 = v2 - vr2;
+		val[CH_RVEL] = (vr2 >= 0.0 ? a >= 0.0 ? (float)sqrt(vr2) : -(float)sqrt(vr2) : 0.0f)*1e-3f;
+		val[CH_TVEL] = (vt2 >= 0.0 ? (float)sqrt(vt2) : 0.0f)*1e-3f;
+		if (simt < g_Data.rec->TEnd()) g_Data.rec->Reset(); // new simulation session
+		g_Data.rec->Append (simt, val);
+	}
+}
+
+// Resample the recorded history into the display arrays. Columns
+// without samples repeat the previous column.
+
+static void SyncData ()
+{
+	static float cmin[ndata], cmax[ndata];
+	float *data[NCH] = {g_Data.alt, g_Data.pitch, g_Data.rvel, g_Data.tvel};
+	DataRecorder *rec = g_Data.rec;
+	if (rec->Empty() || rec->TEnd() == g_Data.tsync) return; // up to date
+	double t0 = rec->TStart(), t1 = rec->TEnd();
+	int i, c, ch;
+
+	for (ch = 0; ch < NCH; ch++) {
+		rec->Resample (ch, t0, t1, ndata, cmin, cmax, data[ch]);
+		for (c = 0; c < ndata && cmin[c] > cmax[c]; c++);
+		if (c == ndata) continue; // no data
+		for (i = 0; i < ndata; i++) {
+			if (cmin[i] <= cmax[i]) c = i;
+			else data[ch][i] = data[ch][c];
 		}
 	}
+	for (i = 0; i < ndata; i++)
+		g_Data.time[i] = (float)(t0 + (t1-t0)*(i+0.5)/ndata);
+	g_Data.tsync = t1;
 }
 
 // ==============================================================
@@ -224,12 +254,12 @@ int AscentMFD::ButtonMenu (const MFDBUTTONMENU **menu) const
 void AscentMFD::Update (HDC hDC)
 {
 	Title (hDC, "Ascent profile");
+	SyncData ();
 
 	if (alt_auto) {
-		float altmin, altmax, tmp;
-		FindRange (g_Data.alt, ndata, altmin, altmax);
-		if (altmin > altmax)
-			tmp = altmin, altmin = altmax, altmax = tmp;
+		float altmin, altmax;
+		if (!g_Data.rec->Range (CH_ALT, g_Data.rec->TStart(), g_Data.rec->TEnd(), altmin, altmax))
+			altmin = altmax = 0.0f;
 		if (altmin == altmax)
 			altmin -= 0.5, altmax += 0.5;
 		SetRange (0, 1, altmin, altmax);
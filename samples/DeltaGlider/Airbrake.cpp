@@ -64,7 +64,7 @@ bool Airbrake::Redraw2D (SURFHANDLE surf)
 {
 	DeltaGlider* dg = (DeltaGlider*)vessel;
 	DeltaGlider::DoorStatus ds = dg->brake_status;
-	int newstate = (ds == DeltaGlider::DOOR_CLOSED || ds == DeltaGlider::DOOR_CLOSING ? 0 : 1);
+	int newstate = (ds == AnimState::CLOSED || ds == AnimState::CLOSING ? 0 : 1);
 	if (newstate != state) {
 		state = newstate;
 		static const float yp[4] = {bb_y0, bb_y0, bb_y0+bb_dy, bb_y0+bb_dy};
@@ -71,10 +71,10 @@ bool AirlockSwitch::Redraw2D (SURFHANDLE surf)
 	DeltaGlider *dg = (DeltaGlider*)vessel;
 
 	int i, j, state, vofs;
-	for (i = 0; i < nbutton; i++) {
+	for (i = 0; i < (int)nbutton; i++) {
 		switch (i) {
-			case 0: state = (dg->olock_status == DeltaGlider::DOOR_OPEN || dg->olock_status == DeltaGlider::DOOR_OPENING ? 1:0); break;
-			case 1: state = (dg->ilock_status == DeltaGlider::DOOR_OPEN || dg->ilock_status == DeltaGlider::DOOR_OPENING ? 1:0); break;
+			case 0: state = (dg->olock_status == AnimState::OPEN || dg->olock_status == AnimState::OPENING ? 1:0); break;
+			case 1: state = (dg->ilock_status == AnimState::OPEN || dg->ilock_status == AnimState::OPENING ? 1:0); break;
 			case 2: state = 0; break;
 		}
 		if (state != btnstate[i]) {
@@ -98,8 +98,8 @@ bool AirlockSwitch::ProcessMouse2D (int event, int mx, int my)
 	state = (my < 19 ? 0:1);
 	if (state != btnstate[btn]) {
 		switch (btn) {
-			case 0: dg->ActivateOuterAirlock (state == 0 ? DeltaGlider::DOOR_CLOSING : DeltaGlider::DOOR_OPENING); return true;
-			case 1: dg->ActivateInnerAirlock (state == 0 ? DeltaGlider::DOOR_CLOSING : DeltaGlider::DOOR_OPENING); return true;
+			case 0: dg->ActivateOuterAirlock (state == 0 ? AnimState::CLOSING : AnimState::OPENING); return true;
+			case 1: dg->ActivateInnerAirlock (state == 0 ? AnimState::CLOSING : AnimState::OPENING); return true;
 			case 2: return false;
 		}
 	}
@@ -94,10 +94,10 @@ DeltaGlider *lua_toDG (lua_State *L, int idx)
 }
 
 static DeltaGlider::DoorStatus DGaction[4] = {
-	DeltaGlider::DOOR_CLOSING,
-	DeltaGlider::DOOR_OPENING,
-	DeltaGlider::DOOR_CLOSING,
-	DeltaGlider::DOOR_OPENING
+	AnimState::CLOSING,
+	AnimState::OPENING,
+	AnimState::CLOSING,
+	AnimState::OPENING
 };
 
 static int dgGear (lua_State *L)
@@ -35,6 +35,7 @@
 #include "AirlockSwitch.h"
 #include "Wheelbrake.h"
 #include "MwsButton.h"
+#include "../Common/AeroTable.h"
 #include "ScnEditorAPI.h"
 #include "DlgCtrl.h"
 #include "meshres.h"
@@ -65,43 +66,55 @@ void UpdateCtrlDialog (DeltaGlider *dg, HWND hWnd = 0);
 //BOOL CALLBACK Damage_DlgProc (HWND, UINT, WPARAM, LPARAM);
 //void UpdateDamageDialog (DeltaGlider *dg, HWND hWnd = 0);
 
+// switch position (0=close, 1=open) for an actuator action
+static inline int SwitchState (AnimState::Action action)
+{
+	return (action == AnimState::OPEN || action == AnimState::OPENING ? 1 : 0);
+}
+
 // ==============================================================
 // Airfoil coefficient functions
 // Return lift, moment and zero-lift drag coefficients as a
 // function of angle of attack (alpha or beta)
 // ==============================================================
 
+// Coefficient tables, shared by all DeltaGlider instances.
+// Built by DefineAirfoilTables at class caps time.
+static AeroTable vlift, hlift;
+
 // 1. vertical lift component (wings and body)
 
 void VLiftCoeff (VESSEL *v, double aoa, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	int i;
-	const int nabsc = 9;
-	static const double AOA[nabsc] = {-180*RAD,-60*RAD,-30*RAD, -2*RAD, 15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
-	static const double CL[nabsc]  = {       0,      0,   -0.4,      0,    0.7,     1,   0.8,     0,      0};
-	static const double CM[nabsc]  = {       0,      0,  0.014, 0.0039, -0.006,-0.008,-0.010,     0,      0};
-	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
-	double f = (aoa-AOA[i]) / (AOA[i+1]-AOA[i]);
-	*cl = CL[i] + (CL[i+1]-CL[i]) * f;  // aoa-dependent lift coefficient
-	*cm = CM[i] + (CM[i+1]-CM[i]) * f;  // aoa-dependent moment coefficient
-	double saoa = sin(aoa);
-	double pd = 0.015 + 0.4*saoa*saoa;  // profile drag
-	*cd = pd + oapiGetInducedDrag (*cl, 1.5, 0.7) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
-	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+	vlift.Eval (aoa, M, cl, cm, cd);
 }
 
 // 2. horizontal lift component (vertical stabilisers and body)
 
 void HLiftCoeff (VESSEL *v, double beta, double M, double Re, void *context, double *cl, double *cm, double *cd)
 {
-	int i;
-	const int nabsc = 8;
-	static const double BETA[nabsc] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
-	static const double CL[nabsc]   = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
-	for (i = 0; i < nabsc-1 && BETA[i+1] < beta; i++);
-	*cl = CL[i] + (CL[i+1]-CL[i]) * (beta-BETA[i]) / (BETA[i+1]-BETA[i]);
-	*cm = 0.0;
-	*cd = 0.015 + oapiGetInducedDrag (*cl, 1.5, 0.6) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+	hlift.Eval (beta, M, cl, cm, cd);
+}
+
+// 3. table definitions (once per class)
+// drag: profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+
+static void DefineAirfoilTables ()
+{
+	if (vlift.Defined()) return;
+
+	const int nvabsc = 9;
+	static const double AOA[nvabsc] = {-180*RAD,-60*RAD,-30*RAD, -2*RAD, 15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
+	static const double VCL[nvabsc] = {       0,      0,   -0.4,      0,    0.7,     1,   0.8,     0,      0};
+	static const double VCM[nvabsc] = {       0,      0,  0.014, 0.0039, -0.006,-0.008,-0.010,     0,      0};
+	vlift.SetLift (nvabsc, AOA, VCL, VCM, 0.015, 0.4, 1.5, 0.7);
+	vlift.SetWaveDrag (0.75, 1.0, 1.1, 0.04);
+
+	const int nhabsc = 8;
+	static const double BETA[nhabsc] = {-180*RAD,-135*RAD,-90*RAD,-45*RAD,45*RAD,90*RAD,135*RAD,180*RAD};
+	static const double HCL[nhabsc]  = {       0,    +0.3,      0,   -0.3,  +0.3,     0,   -0.3,      0};
+	hlift.SetLift (nhabsc, BETA, HCL, 0, 0.015, 0.0, 1.5, 0.6);
+	hlift.SetWaveDrag (0.75, 1.0, 1.1, 0.04);
 }
 
 // ==============================================================
@@ -112,7 +125,17 @@ void HLiftCoeff (VESSEL *v, double beta, double M, double Re, void *context, dou
 // Constructor
 // --------------------------------------------------------------
 DeltaGlider::DeltaGlider (OBJHANDLE hObj, int fmodel)
-: VESSEL3 (hObj, fmodel)
+: VESSEL3 (hObj, fmodel),
+  nose_status (act.State(ACT_NOSE).action), ladder_status (act.State(ACT_LADDER).action),
+  gear_status (act.State(ACT_GEAR).action), rcover_status (act.State(ACT_RCOVER).action),
+  olock_status (act.State(ACT_OLOCK).action), ilock_status (act.State(ACT_ILOCK).action),
+  hatch_status (act.State(ACT_HATCH).action), radiator_status (act.State(ACT_RADIATOR).action),
+  brake_status (act.State(ACT_BRAKE).action),
+  nose_proc (act.State(ACT_NOSE).pos), ladder_proc (act.State(ACT_LADDER).pos),
+  gear_proc (act.State(ACT_GEAR).pos), rcover_proc (act.State(ACT_RCOVER).pos),
+  olock_proc (act.State(ACT_OLOCK).pos), ilock_proc (act.State(ACT_ILOCK).pos),
+  hatch_proc (act.State(ACT_HATCH).pos), radiator_proc (act.State(ACT_RADIATOR).pos),
+  brake_proc (act.State(ACT_BRAKE).pos)
 {
 	int i, j;
 
@@ -120,33 +143,17 @@ DeltaGlider::DeltaGlider (OBJHANDLE hObj, int fmodel)
 	aoa_ind = PI;
 	slip_ind = PI*0.5;
 	load_ind = PI;
-	gear_status       = DOOR_CLOSED;
-	gear_proc         = 0.0;
-	rcover_status     = DOOR_CLOSED;
-	rcover_proc       = 0.0;
-	nose_status       = DOOR_CLOSED;
-	nose_proc         = 0.0;
-	ladder_status     = DOOR_CLOSED;
-	ladder_proc       = 0.0;
-	olock_status      = DOOR_CLOSED;
-	olock_proc        = 0.0;
-	ilock_status      = DOOR_CLOSED;
-	ilock_proc        = 0.0;
-	hatch_status      = DOOR_CLOSED;
-	hatch_proc        = 0.0;
-	brake_status      = DOOR_CLOSED;
-	brake_proc        = 0.0;
-	radiator_status   = DOOR_CLOSED;
-	radiator_proc     = 0.0;
 	visual            = NULL;
 	exmesh            = NULL;
 	vcmesh            = NULL;
 	vcmesh_tpl        = NULL;
 	scramjet          = NULL;
+	aerodb            = NULL;
 	hatch_vent        = NULL;
 	insignia_tex      = NULL;
 	contrail_tex      = NULL;
 	hPanelMesh        = NULL;
+	hudscl            = 0;
 	campos            = CAM_GENERIC;
 	th_main_level     = 0.0;
 
@@ -185,6 +192,7 @@ DeltaGlider::DeltaGlider (OBJHANDLE hObj, int fmodel)
 	for (i = 0; i < 4; i++) aileronfail[i] = false;
 
 	DefineAnimations();
+	DefineActuators();
 	for (i = 0; i < nsurf; i++) srf[i] = 0;
 }
 
@@ -202,6 +210,7 @@ DeltaGlider::~DeltaGlider ()
 	delete []instr;
 
 	delete aap;
+	if (aerodb) aerodb->Release();
 
 	if (insignia_tex) oapiDestroySurface(insignia_tex);
 
@@ -675,6 +684,50 @@ void DeltaGlider::DefineAnimations ()
 	AddAnimationComponent (anim_radiatorswitch, 0, 1, &RadiatorSwitch);
 }
 
+// --------------------------------------------------------------
+// Define the door, gear and airbrake actuators
+// --------------------------------------------------------------
+void DeltaGlider::DefineActuators ()
+{
+	act.Init (this, this);
+	act.Define (ACT_GEAR,     GEAR_OPERATING_SPEED,     anim_gear,     ActuatorMoved);
+	act.Define (ACT_RCOVER,   RCOVER_OPERATING_SPEED,   anim_rcover,   ActuatorMoved, ActuatorDone);
+	act.Define (ACT_NOSE,     NOSE_OPERATING_SPEED,     anim_nose,     ActuatorMoved);
+	act.Define (ACT_LADDER,   LADDER_OPERATING_SPEED,   anim_ladder);
+	act.Define (ACT_OLOCK,    AIRLOCK_OPERATING_SPEED,  anim_olock,    ActuatorMoved);
+	act.Define (ACT_ILOCK,    AIRLOCK_OPERATING_SPEED,  anim_ilock,    ActuatorMoved);
+	act.Define (ACT_HATCH,    HATCH_OPERATING_SPEED,    anim_hatch,    ActuatorMoved);
+	act.Define (ACT_RADIATOR, RADIATOR_OPERATING_SPEED, anim_radiator, ActuatorMoved);
+	act.Define (ACT_BRAKE,    AIRBRAKE_OPERATING_SPEED, anim_brake,    ActuatorMoved);
+}
+
+// --------------------------------------------------------------
+// Actuator callback: update gear parameters and indicators
+// --------------------------------------------------------------
+void DeltaGlider::ActuatorMoved (void *context, int id, const AnimState &state)
+{
+	DeltaGlider *dg = (DeltaGlider*)context;
+	switch (id) {
+	case ACT_GEAR:
+		dg->SetGearParameters (state.pos);
+		oapiTriggerRedrawArea (0, 0, AID_GEARINDICATOR);
+		break;
+	case ACT_NOSE:
+		oapiTriggerRedrawArea (0, 0, AID_NOSECONEINDICATOR);
+		break;
+	}
+	dg->UpdateStatusIndicators();
+}
+
+// --------------------------------------------------------------
+// Actuator callback: enable retro thrusters when the covers are open
+// --------------------------------------------------------------
+void DeltaGlider::ActuatorDone (void *context, int id, const AnimState &state)
+{
+	if (id == ACT_RCOVER && state.Open())
+		((DeltaGlider*)context)->EnableRetroThrusters (true);
+}
+
 // --------------------------------------------------------------
 // Apply custom skin to the current mesh instance
 // --------------------------------------------------------------
@@ -840,7 +893,7 @@ bool DeltaGlider::clbkDrawHUD (int mode, const HUDPAINTSPEC *hps, oapi::Sketchpa
 	int cx = hps->CX, cy = hps->CY;
 
 	// show gear deployment status
-	if (gear_status == DOOR_OPEN || (gear_status >= DOOR_CLOSING && fmod (oapiGetSimTime(), 1.0) < 0.5)) {
+	if (gear_status == AnimState::OPEN || (gear_status >= AnimState::CLOSING && fmod (oapiGetSimTime(), 1.0) < 0.5)) {
 		int d = hps->Markersize/2;
 		if (cx >= -d*3 && cx < hps->W+d*3 && cy >= d && cy < hps->H+d*5) {
 			skp->Rectangle (cx-d/2, cy-d*5, cx+d/2, cy-d*4);
@@ -860,10 +913,10 @@ bool DeltaGlider::clbkDrawHUD (int mode, const HUDPAINTSPEC *hps, oapi::Sketchpa
 	}
 
 	if (oapiGetHUDMode() == HUD_DOCKING) {
-		if (nose_status != DOOR_OPEN) {
+		if (nose_status != AnimState::OPEN) {
 			int d = hps->Markersize*5;
 			double tmp;
-			if (nose_status == DOOR_CLOSED || modf (oapiGetSimTime(), &tmp) < 0.5) {
+			if (nose_status == AnimState::CLOSED || modf (oapiGetSimTime(), &tmp) < 0.5) {
 				skp->Line (cx-d,cy-d,cx+d,cy+d);
 				skp->Line (cx-d,cy+d,cx+d,cy-d);
 			}
@@ -881,13 +934,7 @@ void DeltaGlider::clbkRenderHUD (int mode, const HUDPAINTSPEC *hps, SURFHANDLE h
 
 	static float texw = 512.0f, texh = 256.0f;
 	float cx = (float)hps->CX, cy = (float)hps->CY;
-	int i, nvtx = 0, nidx = 0;
-	static NTVERTEX vtx[12+16+4];
-	static WORD idx[18+36+6];
-	static float scl = 0;
-	static NTVERTEX vgear[12];
-	static NTVERTEX vnose[16];
-	static NTVERTEX vbrk[4];
+	int i;
 	static WORD igear[18] = {
 		0,3,1, 3,0,2,
 		4,7,5, 7,4,6,
@@ -905,8 +952,11 @@ void DeltaGlider::clbkRenderHUD (int mode, const HUDPAINTSPEC *hps, SURFHANDLE h
 		0,3,1, 0,2,3
 	};
 
-	if (scl != hps->Markersize*0.25f) { // resize
-		scl = hps->Markersize*0.25f;
+	if (hudscl != hps->Markersize*0.25f) { // resize
+		float scl = hudscl = hps->Markersize*0.25f;
+		NTVERTEX vgear[12];
+		NTVERTEX vnose[16];
+		NTVERTEX vbrk[4];
 		memset (vgear, 0, 12*sizeof(NTVERTEX));
 		float x[12] = {-4,-2,-4,-2,2,4,2,4,-1,1,-1,1};
 		float y[12] = {-2,-2,-4,-4,-2,-2,-4,-4,-6,-6,-8,-8};
@@ -938,56 +988,35 @@ void DeltaGlider::clbkRenderHUD (int mode, const HUDPAINTSPEC *hps, SURFHANDLE h
 			vbrk[i].tu = ub[i]/texw;
 			vbrk[i].tv = vb[i]/texh;
 		}
+		hudovl.SetElement (HUDELEM_GEAR, vgear, 12, igear, 18);
+		hudovl.SetElement (HUDELEM_NOSE, vnose, 16, inose, 36);
+		hudovl.SetElement (HUDELEM_BRAKE, vbrk, 4, ibrk, 6);
 	}
 
+	double tmp, blink = modf (oapiGetSimTime(), &tmp);
+
 	// show gear deployment status
-	if (gear_status == DOOR_OPEN || (gear_status >= DOOR_CLOSING && fmod (oapiGetSimTime(), 1.0) < 0.5)) {
-		memcpy (vtx+nvtx, vgear, 12*sizeof(NTVERTEX));
-		for (i = 0; i < 18; i++) idx[nidx+i] = igear[i]+nvtx;
-		nvtx += 12;
-		nidx += 18;
-	}
+	hudovl.Show (HUDELEM_GEAR, gear_status == AnimState::OPEN || (gear_status >= AnimState::CLOSING && blink < 0.5));
 
 	// show nosecone status
-	if (oapiGetHUDMode() == HUD_DOCKING && nose_status != DOOR_OPEN) {
-		double tmp;
-		if (nose_status == DOOR_CLOSED || modf (oapiGetSimTime(), &tmp) < 0.5) {
-			memcpy (vtx+nvtx, vnose, 16*sizeof(NTVERTEX));
-			for (i = 0; i < 36; i++) idx[nidx+i] = inose[i]+nvtx;
-			nvtx += 16;
-			nidx += 36;
-		}
-	}
+	hudovl.Show (HUDELEM_NOSE, oapiGetHUDMode() == HUD_DOCKING && nose_status != AnimState::OPEN &&
+		(nose_status == AnimState::CLOSED || blink < 0.5));
 
 	// show airbrake status
-	if (brake_status != DOOR_CLOSED) {
-		double tmp;
-		if (brake_status == DOOR_OPEN || modf (oapiGetSimTime(), &tmp) < 0.5) {
-			memcpy (vtx+nvtx, vbrk, 4*sizeof(NTVERTEX));
-			for (i = 0; i < 6; i++) idx[nidx+i] = ibrk[i]+nvtx;
-			nvtx += 4;
-			nidx += 6;
-		}
-	}
+	hudovl.Show (HUDELEM_BRAKE, brake_status != AnimState::CLOSED &&
+		(brake_status == AnimState::OPEN || blink < 0.5));
 
-	if (nvtx) {
-		MESHGROUP grp = {vtx, idx, nvtx, nidx, 0, 0, 0, 0, 0};
-		MESHHANDLE hmesh = oapiCreateMesh (1, &grp);
-		oapiRenderHUD (hmesh, &hTex);
-		oapiDeleteMesh (hmesh);
-	}
+	hudovl.Render (&hTex);
 }
 
 void DeltaGlider::ActivateLandingGear (DoorStatus action)
 {
-	if (action == DOOR_OPENING && GroundContact()) return;
+	if (action == AnimState::OPENING && GroundContact()) return;
 	// we cannot deploy the landing gear if we are already sitting on the ground
 
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	gear_status = action;
-	if (action <= DOOR_OPEN) {
-		gear_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_gear, gear_proc);
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_GEAR, action);
+	if (action <= AnimState::OPEN) {
 		UpdateStatusIndicators();
 		SetGearParameters (gear_proc);
 	}
@@ -999,8 +1028,8 @@ void DeltaGlider::ActivateLandingGear (DoorStatus action)
 
 void DeltaGlider::RevertLandingGear ()
 {
-	ActivateLandingGear (gear_status == DOOR_CLOSED || gear_status == DOOR_CLOSING ?
-						 DOOR_OPENING : DOOR_CLOSING);
+	ActivateLandingGear (gear_status == AnimState::CLOSED || gear_status == AnimState::CLOSING ?
+						 AnimState::OPENING : AnimState::CLOSING);
 	UpdateCtrlDialog (this);
 }
 
@@ -1019,14 +1048,11 @@ void DeltaGlider::SetGearParameters (double state)
 
 void DeltaGlider::ActivateRCover (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	rcover_status = action;
-	if (action <= DOOR_OPEN) {
-		rcover_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_rcover, rcover_proc);
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_RCOVER, action);
+	if (action <= AnimState::OPEN)
 		UpdateStatusIndicators();
-	}
-	EnableRetroThrusters (action == DOOR_OPEN);
+	EnableRetroThrusters (action == AnimState::OPEN);
 	oapiTriggerPanelRedrawArea (0, AID_SWITCHARRAY);
 	SetAnimation (anim_retroswitch, close ? 0:1);
 	UpdateCtrlDialog (this);
@@ -1035,18 +1061,15 @@ void DeltaGlider::ActivateRCover (DoorStatus action)
 
 void DeltaGlider::ActivateDockingPort (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	nose_status = action;
-	if (action <= DOOR_OPEN) {
-		nose_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_nose, nose_proc);
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_NOSE, action);
+	if (action <= AnimState::OPEN)
 		UpdateStatusIndicators();
-	}
 	oapiTriggerPanelRedrawArea (0, AID_NOSECONELEVER);
 	oapiTriggerRedrawArea (0, 0, AID_NOSECONEINDICATOR);
 	SetAnimation (anim_nconelever, close ? 0:1);
 
-	if (close && ladder_status != DOOR_CLOSED)
+	if (close && ladder_status != AnimState::CLOSED)
 		ActivateLadder (action); // retract ladder before closing the nose cone
 
 	UpdateCtrlDialog (this);
@@ -1055,14 +1078,14 @@ void DeltaGlider::ActivateDockingPort (DoorStatus action)
 
 void DeltaGlider::RevertDockingPort ()
 {
-	ActivateDockingPort (nose_status == DOOR_CLOSED || nose_status == DOOR_CLOSING ?
-						 DOOR_OPENING : DOOR_CLOSING);
+	ActivateDockingPort (nose_status == AnimState::CLOSED || nose_status == AnimState::CLOSING ?
+						 AnimState::OPENING : AnimState::CLOSING);
 }
 
 void DeltaGlider::ActivateHatch (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	if (hatch_status == DOOR_CLOSED && !close && !hatch_vent && GetAtmPressure() < 10e3) {
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	if (hatch_status == AnimState::CLOSED && !close && !hatch_vent && GetAtmPressure() < 10e3) {
 		static PARTICLESTREAMSPEC airvent = {
 			0, 1.0, 15, 0.5, 0.3, 2, 0.3, 1.0, PARTICLESTREAMSPEC::EMISSIVE,
 			PARTICLESTREAMSPEC::LVL_LIN, 0.1, 0.1,
@@ -1075,12 +1098,9 @@ void DeltaGlider::ActivateHatch (DoorStatus action)
 		hatch_vent_t = oapiGetSimTime();
 	}
 
-	hatch_status = action;
-	if (action <= DOOR_OPEN) {
-		hatch_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_hatch, hatch_proc);
+	act.Operate (ACT_HATCH, action);
+	if (action <= AnimState::OPEN)
 		UpdateStatusIndicators();
-	}
 	oapiTriggerPanelRedrawArea (0, AID_SWITCHARRAY);
 	SetAnimation (anim_hatchswitch, close ? 0:1);
 	UpdateCtrlDialog (this);
@@ -1089,21 +1109,17 @@ void DeltaGlider::ActivateHatch (DoorStatus action)
 
 void DeltaGlider::RevertHatch ()
 {
-	ActivateHatch (hatch_status == DOOR_CLOSED || hatch_status == DOOR_CLOSING ?
-				   DOOR_OPENING : DOOR_CLOSING);
+	ActivateHatch (hatch_status == AnimState::CLOSED || hatch_status == AnimState::CLOSING ?
+				   AnimState::OPENING : AnimState::CLOSING);
 }
 
 void DeltaGlider::ActivateLadder (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	if (!close && nose_status != DOOR_OPEN) return;
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	if (!close && nose_status != AnimState::OPEN) return;
 	// don't extend ladder if nose cone is closed
 
-	ladder_status = action;
-	if (action <= DOOR_OPEN) {
-		ladder_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_ladder, ladder_proc);
-	}
+	act.Operate (ACT_LADDER, action);
 	oapiTriggerPanelRedrawArea (0, AID_SWITCHARRAY);
 	SetAnimation (anim_ladderswitch, close ? 0:1);
 	UpdateCtrlDialog (this);
@@ -1112,19 +1128,16 @@ void DeltaGlider::ActivateLadder (DoorStatus action)
 
 void DeltaGlider::RevertLadder ()
 {
-	ActivateLadder (ladder_status == DOOR_CLOSED || ladder_status == DOOR_CLOSING ?
-					DOOR_OPENING : DOOR_CLOSING);
+	ActivateLadder (ladder_status == AnimState::CLOSED || ladder_status == AnimState::CLOSING ?
+					AnimState::OPENING : AnimState::CLOSING);
 }
 
 void DeltaGlider::ActivateOuterAirlock (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	olock_status = action;
-	if (action <= DOOR_OPEN) {
-		olock_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_olock, olock_proc);
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_OLOCK, action);
+	if (action <= AnimState::OPEN)
 		UpdateStatusIndicators();
-	}
 	oapiTriggerPanelRedrawArea (1, AID_AIRLOCKSWITCH);
 	SetAnimation (anim_olockswitch, close ? 0:1);
 	UpdateCtrlDialog (this);
@@ -1133,19 +1146,16 @@ void DeltaGlider::ActivateOuterAirlock (DoorStatus action)
 
 void DeltaGlider::RevertOuterAirlock ()
 {
-	ActivateOuterAirlock (olock_status == DOOR_CLOSED || olock_status == DOOR_CLOSING ?
-		                  DOOR_OPENING : DOOR_CLOSING);
+	ActivateOuterAirlock (olock_status == AnimState::CLOSED || olock_status == AnimState::CLOSING ?
+		                  AnimState::OPENING : AnimState::CLOSING);
 }
 
 void DeltaGlider::ActivateInnerAirlock (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	ilock_status = action;
-	if (action <= DOOR_OPEN) {
-		ilock_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_ilock, ilock_proc);
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_ILOCK, action);
+	if (action <= AnimState::OPEN)
 		UpdateStatusIndicators();
-	}
 	oapiTriggerPanelRedrawArea (1, AID_AIRLOCKSWITCH);
 	SetAnimation (anim_ilockswitch, close ? 0:1);
 	UpdateCtrlDialog (this);
@@ -1154,32 +1164,29 @@ void DeltaGlider::ActivateInnerAirlock (DoorStatus action)
 
 void DeltaGlider::RevertInnerAirlock ()
 {
-	ActivateInnerAirlock (ilock_status == DOOR_CLOSED || ilock_status == DOOR_CLOSING ?
-		                  DOOR_OPENING : DOOR_CLOSING);
+	ActivateInnerAirlock (ilock_status == AnimState::CLOSED || ilock_status == AnimState::CLOSING ?
+		                  AnimState::OPENING : AnimState::CLOSING);
 }
 
 void DeltaGlider::ActivateAirbrake (DoorStatus action)
 {
-	brake_status = action;
+	act.Operate (ACT_BRAKE, action);
 	oapiTriggerPanelRedrawArea (0, AID_AIRBRAKE);
-	RecordEvent ("AIRBRAKE", action == DOOR_CLOSING ? "CLOSE" : "OPEN");
+	RecordEvent ("AIRBRAKE", action == AnimState::CLOSING ? "CLOSE" : "OPEN");
 }
 
 void DeltaGlider::RevertAirbrake (void)
 {
-	ActivateAirbrake (brake_status == DOOR_CLOSED || brake_status == DOOR_CLOSING ?
-		DOOR_OPENING : DOOR_CLOSING);
+	ActivateAirbrake (brake_status == AnimState::CLOSED || brake_status == AnimState::CLOSING ?
+		AnimState::OPENING : AnimState::CLOSING);
 }
 
 void DeltaGlider::ActivateRadiator (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	radiator_status = action;
-	if (action <= DOOR_OPEN) {
-		radiator_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_radiator, radiator_proc);
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_RADIATOR, action);
+	if (action <= AnimState::OPEN)
 		UpdateStatusIndicators();
-	}
 	oapiTriggerPanelRedrawArea (0, AID_SWITCHARRAY);
 	SetAnimation (anim_radiatorswitch, close ? 0:1);
 	UpdateCtrlDialog (this);
@@ -1188,8 +1195,8 @@ void DeltaGlider::ActivateRadiator (DoorStatus action)
 
 void DeltaGlider::RevertRadiator (void)
 {
-	ActivateRadiator (radiator_status == DOOR_CLOSED || radiator_status == DOOR_CLOSING ?
-		DOOR_OPENING : DOOR_CLOSING);
+	ActivateRadiator (radiator_status == AnimState::CLOSED || radiator_status == AnimState::CLOSING ?
+		AnimState::OPENING : AnimState::CLOSING);
 }
 
 void DeltaGlider::SetNavlight (bool on)
@@ -1913,7 +1920,7 @@ void DeltaGlider::RedrawPanel_MFDButton (SURFHANDLE surf, int mfd, int side)
 	int y = (isVC ? 0:3);
 
 	for (int bt = 0; bt < 6; bt++) {
-		if (label = oapiMFDButtonLabel (mfd, bt+side*6)) {
+		if ((label = oapiMFDButtonLabel (mfd, bt+side*6))) {
 			TextOut (hDC, x, y, label, strlen (label));
 			if (isVC) x += 24;
 			else      y += 41;
@@ -2029,9 +2036,9 @@ bool DeltaGlider::RedrawPanel_HoverBalanceDisp (SURFHANDLE surf)
 bool DeltaGlider::RedrawPanel_GearIndicator (SURFHANDLE surf)
 {
 	switch (gear_status) {
-	case DOOR_CLOSED: oapiBlt (surf, srf[9], 0,  0, 0,  0, 29, 5); break;
-	case DOOR_OPEN:   oapiBlt (surf, srf[9], 0, 26, 0,  5, 29, 5); break;
-	default:          oapiBlt (surf, srf[9], 0, 13, 0, 20, 29, 5); break;
+	case AnimState::CLOSED: oapiBlt (surf, srf[9], 0,  0, 0,  0, 29, 5); break;
+	case AnimState::OPEN:   oapiBlt (surf, srf[9], 0, 26, 0,  5, 29, 5); break;
+	default:                oapiBlt (surf, srf[9], 0, 13, 0, 20, 29, 5); break;
 	}
 	return true;
 }
@@ -2039,9 +2046,9 @@ bool DeltaGlider::RedrawPanel_GearIndicator (SURFHANDLE surf)
 bool DeltaGlider::RedrawPanel_NoseconeIndicator (SURFHANDLE surf)
 {
 	switch (nose_status) {
-	case DOOR_CLOSED: oapiBlt (surf, srf[9], 0,  0, 0, 10, 29, 5); break;
-	case DOOR_OPEN:   oapiBlt (surf, srf[9], 0, 26, 0, 15, 29, 5); break;
-	default:          oapiBlt (surf, srf[9], 0, 13, 0, 20, 29, 5); break;
+	case AnimState::CLOSED: oapiBlt (surf, srf[9], 0,  0, 0, 10, 29, 5); break;
+	case AnimState::OPEN:   oapiBlt (surf, srf[9], 0, 26, 0, 15, 29, 5); break;
+	default:                oapiBlt (surf, srf[9], 0, 13, 0, 20, 29, 5); break;
 	}
 	return true;
 }
@@ -2061,35 +2068,35 @@ void DeltaGlider::UpdateStatusIndicators ()
 	ges.Vtx = vtx;
 
 	// gear indicator
-	x = (gear_status == DOOR_CLOSED ? xoff : gear_status == DOOR_OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
+	x = (gear_status == AnimState::CLOSED ? xoff : gear_status == AnimState::OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
 	vtx[0].tu = vtx[1].tu = x;
 
 	// retro cover indicator
-	x = (rcover_status == DOOR_CLOSED ? xoff : rcover_status == DOOR_OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
+	x = (rcover_status == AnimState::CLOSED ? xoff : rcover_status == AnimState::OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
 	vtx[2].tu = vtx[3].tu = x;
 
 	// airbrake indicator
-	x = (brake_status == DOOR_CLOSED ? xoff : brake_status == DOOR_OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
+	x = (brake_status == AnimState::CLOSED ? xoff : brake_status == AnimState::OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
 	vtx[4].tu = vtx[5].tu = x;
 
 	// nose cone indicator
-	x = (nose_status == DOOR_CLOSED ? xoff : nose_status == DOOR_OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
+	x = (nose_status == AnimState::CLOSED ? xoff : nose_status == AnimState::OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
 	vtx[6].tu = vtx[7].tu = x;
 
 	// top hatch indicator
-	x = (hatch_status == DOOR_CLOSED ? xoff : hatch_status == DOOR_OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
+	x = (hatch_status == AnimState::CLOSED ? xoff : hatch_status == AnimState::OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
 	vtx[8].tu = vtx[9].tu = x;
 
 	// radiator indicator
-	x = (radiator_status == DOOR_CLOSED ? xoff : radiator_status == DOOR_OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
+	x = (radiator_status == AnimState::CLOSED ? xoff : radiator_status == AnimState::OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
 	vtx[10].tu = vtx[11].tu = x;
 
 	// outer airlock indicator
-	x = (olock_status == DOOR_CLOSED ? xoff : olock_status == DOOR_OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
+	x = (olock_status == AnimState::CLOSED ? xoff : olock_status == AnimState::OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
 	vtx[12].tu = vtx[13].tu = x;
 
 	// inner airlock indicator
-	x = (ilock_status == DOOR_CLOSED ? xoff : ilock_status == DOOR_OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
+	x = (ilock_status == AnimState::CLOSED ? xoff : ilock_status == AnimState::OPEN ? xon : modf (oapiGetSimTime(), &d) < 0.5 ? xon : xoff);
 	vtx[14].tu = vtx[15].tu = x;
 
 	oapiEditMeshGroup (vcmesh, MESHGRP_VC_STATUSIND, &ges);
@@ -2131,7 +2138,6 @@ void DeltaGlider::SetDamageVisuals ()
 	int i, j;
 
 	// ailerons
-	static UINT LAileronGrp[4] = {29,51,30,52};
 	for (i = 0; i < 4; i++) {
 		for (j = 0; j < 2; j++)
 			if (aileronfail[i]) {
@@ -2284,7 +2290,6 @@ void DeltaGlider::clbkSetClassCaps (FILEHANDLE cfg)
 		scramjet = new Ramjet (this);
 
 	VESSEL3::SetEmptyMass (scramjet ? EMPTY_MASS_SC : EMPTY_MASS);
-	VECTOR3 r[2] = {{0,0,6}, {0,0,-4}};
 	SetSize (10.0);
 	SetVisibilityLimit (7.5e-4, 1.5e-3);
 	SetAlbedoRGB (_V(0.77,0.20,0.13));
@@ -2300,7 +2305,6 @@ void DeltaGlider::clbkSetClassCaps (FILEHANDLE cfg)
 	SetDockParams (_V(0,-0.49,10.076), _V(0,0,1), _V(0,1,0));
 	SetTouchdownPoints (_V(0,-2.57,10), _V(-3.5,-2.57,-3), _V(3.5,-2.57,-3));
 	EnableTransponder (true);
-	bool render_cockpit = true;
 
 	// ******************** NAV radios **************************
 
@@ -2472,10 +2476,21 @@ void DeltaGlider::clbkSetClassCaps (FILEHANDLE cfg)
 
 	// ********************* aerodynamics ***********************
 
-	hwing = CreateAirfoil3 (LIFT_VERTICAL, _V(0,0,-0.3), VLiftCoeff, 0, 5, 90, 1.5);
+	// coefficients from an aerodynamic database, if the class config
+	// provides one (AeroDatabase = <path>), otherwise built-in
+	char cbuf[256];
+	if (!aerodb && oapiReadItem_string (cfg, "AeroDatabase", cbuf))
+		aerodb = AeroDatabase::Load (cbuf);
+	const AeroDbTable *vtab = (aerodb ? aerodb->Table (AERODB_VERTICAL) : 0);
+	const AeroDbTable *htab = (aerodb ? aerodb->Table (AERODB_HORIZONTAL) : 0);
+	DefineAirfoilTables();
+
+	if (vtab) hwing = CreateAirfoil3 (LIFT_VERTICAL, _V(0,0,-0.3), AeroDbCoeff, (void*)vtab, 5, 90, 1.5);
+	else      hwing = CreateAirfoil3 (LIFT_VERTICAL, _V(0,0,-0.3), VLiftCoeff, 0, 5, 90, 1.5);
 	// wing and body lift+drag components
 
-	CreateAirfoil3 (LIFT_HORIZONTAL, _V(0,0,-4), HLiftCoeff, 0, 5, 15, 1.5);
+	if (htab) CreateAirfoil3 (LIFT_HORIZONTAL, _V(0,0,-4), AeroDbCoeff, (void*)htab, 5, 15, 1.5);
+	else      CreateAirfoil3 (LIFT_HORIZONTAL, _V(0,0,-4), HLiftCoeff, 0, 5, 15, 1.5);
 	// vertical stabiliser and body lift and drag components
 
 	CreateControlSurface3 (AIRCTRL_ELEVATOR,     1.4, 1.5, _V(   0,0,-7.2), AIRCTRL_AXIS_XPOS, 1.0, anim_elevator);
@@ -2539,23 +2554,23 @@ void DeltaGlider::clbkLoadStateEx (FILEHANDLE scn, void *vs)
 
 	while (oapiReadScenario_nextline (scn, line)) {
         if (!_strnicmp (line, "NOSECONE", 8)) {
-			sscanf (line+8, "%d%lf", &nose_status, &nose_proc);
+			sscan_doorstate (line+8, act.State(ACT_NOSE));
 		} else if (!_strnicmp (line, "GEAR", 4)) {
-			sscanf (line+4, "%d%lf", &gear_status, &gear_proc);
+			sscan_doorstate (line+4, act.State(ACT_GEAR));
 		} else if (!_strnicmp (line, "RCOVER", 6)) {
-			sscanf (line+6, "%d%lf", &rcover_status, &rcover_proc);
+			sscan_doorstate (line+6, act.State(ACT_RCOVER));
 		} else if (!_strnicmp (line, "AIRLOCK", 7)) {
-			sscanf (line+7, "%d%lf", &olock_status, &olock_proc);
+			sscan_doorstate (line+7, act.State(ACT_OLOCK));
 		} else if (!_strnicmp (line, "IAIRLOCK", 8)) {
-			sscanf (line+8, "%d%lf", &ilock_status, &ilock_proc);
+			sscan_doorstate (line+8, act.State(ACT_ILOCK));
 		} else if (!_strnicmp (line, "AIRBRAKE", 8)) {
-			sscanf (line+8, "%d%lf", &brake_status, &brake_proc);
+			sscan_doorstate (line+8, act.State(ACT_BRAKE));
 		} else if (!_strnicmp (line, "RADIATOR", 8)) {
-			sscanf (line+8, "%d%lf", &radiator_status, &radiator_proc);
+			sscan_doorstate (line+8, act.State(ACT_RADIATOR));
 		} else if (!_strnicmp (line, "LADDER", 6)) {
-			sscanf (line+6, "%d%lf", &ladder_status, &ladder_proc);
+			sscan_doorstate (line+6, act.State(ACT_LADDER));
 		} else if (!_strnicmp (line, "HATCH", 5)) {
-			sscanf (line+5, "%d%lf", &hatch_status, &hatch_proc);
+			sscan_doorstate (line+5, act.State(ACT_HATCH));
 		} else if (!_strnicmp (line, "TRIM", 4)) {
 			double trim;
 			sscanf (line+4, "%lf", &trim);
@@ -2625,42 +2640,24 @@ void DeltaGlider::clbkSaveState (FILEHANDLE scn)
 	VESSEL3::clbkSaveState (scn);
 
 	// Write custom parameters
-	if (gear_status) {
-		sprintf (cbuf, "%d %0.4f", gear_status, gear_proc);
-		oapiWriteScenario_string (scn, "GEAR", cbuf);
-	}
-	if (rcover_status) {
-		sprintf (cbuf, "%d %0.4f", rcover_status, rcover_proc);
-		oapiWriteScenario_string (scn, "RCOVER", cbuf);
-	}
-	if (nose_status) {
-		sprintf (cbuf, "%d %0.4f", nose_status, nose_proc);
-		oapiWriteScenario_string (scn, "NOSECONE", cbuf);
-	}
-	if (olock_status) {
-		sprintf (cbuf, "%d %0.4f", olock_status, olock_proc);
-		oapiWriteScenario_string (scn, "AIRLOCK", cbuf);
-	}
-	if (ilock_status) {
-		sprintf (cbuf, "%d %0.4f", ilock_status, ilock_proc);
-		oapiWriteScenario_string (scn, "IAIRLOCK", cbuf);
-	}
-	if (brake_status) {
-		sprintf (cbuf, "%d %0.4f", brake_status, brake_proc);
-		oapiWriteScenario_string (scn, "AIRBRAKE", cbuf);
-	}
-	if (radiator_status) {
-		sprintf (cbuf, "%d %0.4f", radiator_status, radiator_proc);
-		oapiWriteScenario_string (scn, "RADIATOR", cbuf);
-	}
-	if (ladder_status) {
-		sprintf (cbuf, "%d %0.4f", ladder_status, ladder_proc);
-		oapiWriteScenario_string (scn, "LADDER", cbuf);
-	}
-	if (hatch_status) {
-		sprintf (cbuf, "%d %0.4lf", hatch_status, hatch_proc);
-		oapiWriteScenario_string (scn, "HATCH", cbuf);
-	}
+	if (!act.State(ACT_GEAR).Closed())
+		WriteScenario_doorstate (scn, "GEAR", act.State(ACT_GEAR));
+	if (!act.State(ACT_RCOVER).Closed())
+		WriteScenario_doorstate (scn, "RCOVER", act.State(ACT_RCOVER));
+	if (!act.State(ACT_NOSE).Closed())
+		WriteScenario_doorstate (scn, "NOSECONE", act.State(ACT_NOSE));
+	if (!act.State(ACT_OLOCK).Closed())
+		WriteScenario_doorstate (scn, "AIRLOCK", act.State(ACT_OLOCK));
+	if (!act.State(ACT_ILOCK).Closed())
+		WriteScenario_doorstate (scn, "IAIRLOCK", act.State(ACT_ILOCK));
+	if (!act.State(ACT_BRAKE).Closed())
+		WriteScenario_doorstate (scn, "AIRBRAKE", act.State(ACT_BRAKE));
+	if (!act.State(ACT_RADIATOR).Closed())
+		WriteScenario_doorstate (scn, "RADIATOR", act.State(ACT_RADIATOR));
+	if (!act.State(ACT_LADDER).Closed())
+		WriteScenario_doorstate (scn, "LADDER", act.State(ACT_LADDER));
+	if (!act.State(ACT_HATCH).Closed())
+		WriteScenario_doorstate (scn, "HATCH", act.State(ACT_HATCH));
 	for (i = 0; i < 4; i++)
 		if (psngr[i]) {
 			sprintf (cbuf, "%d", i+1);
@@ -2693,28 +2690,20 @@ void DeltaGlider::clbkSaveState (FILEHANDLE scn)
 // --------------------------------------------------------------
 void DeltaGlider::clbkPostCreation ()
 {
-	EnableRetroThrusters (rcover_status == DOOR_OPEN);
+	EnableRetroThrusters (rcover_status == AnimState::OPEN);
 	SetGearParameters (gear_proc);
 	SetEmptyMass ();
 
-	// update animation states
-	SetAnimation (anim_gear, gear_proc);
-	SetAnimation (anim_rcover, rcover_proc);
-	SetAnimation (anim_nose, nose_proc);
-	SetAnimation (anim_ladder, ladder_proc);
-	SetAnimation (anim_olock, olock_proc);
-	SetAnimation (anim_ilock, ilock_proc);
-	SetAnimation (anim_hatch, hatch_proc);
-	SetAnimation (anim_radiator, radiator_proc);
-	SetAnimation (anim_brake, brake_proc);
-	SetAnimation (anim_gearlever, gear_status & 1);
-	SetAnimation (anim_nconelever, nose_status & 1);
-	SetAnimation (anim_olockswitch, olock_status & 1);
-	SetAnimation (anim_ilockswitch, ilock_status & 1);
-	SetAnimation (anim_retroswitch, rcover_status & 1);
-	SetAnimation (anim_radiatorswitch, radiator_status & 1);
-	SetAnimation (anim_hatchswitch, hatch_status & 1);
-	SetAnimation (anim_ladderswitch, ladder_status & 1);
+	// update animation states, and resume actuators in motion
+	act.Update();
+	SetAnimation (anim_gearlever, SwitchState (gear_status));
+	SetAnimation (anim_nconelever, SwitchState (nose_status));
+	SetAnimation (anim_olockswitch, SwitchState (olock_status));
+	SetAnimation (anim_ilockswitch, SwitchState (ilock_status));
+	SetAnimation (anim_retroswitch, SwitchState (rcover_status));
+	SetAnimation (anim_radiatorswitch, SwitchState (radiator_status));
+	SetAnimation (anim_hatchswitch, SwitchState (hatch_status));
+	SetAnimation (anim_ladderswitch, SwitchState (ladder_status));
 
 	if (insignia_tex)
 		PaintMarkings (insignia_tex);
@@ -2726,31 +2715,31 @@ void DeltaGlider::clbkPostCreation ()
 bool DeltaGlider::clbkPlaybackEvent (double simt, double event_t, const char *event_type, const char *event)
 {
 	if (!_stricmp (event_type, "GEAR")) {
-		ActivateLandingGear (!_stricmp (event, "UP") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateLandingGear (!_stricmp (event, "UP") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "NOSECONE")) {
-		ActivateDockingPort (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateDockingPort (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "RCOVER")) {
-		ActivateRCover (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateRCover (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "RADIATOR")) {
-		ActivateRadiator (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateRadiator (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "AIRBRAKE")) {
-		ActivateAirbrake(!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateAirbrake(!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "HATCH")) {
-		ActivateHatch (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateHatch (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "OLOCK")) {
-		ActivateOuterAirlock (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateOuterAirlock (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "ILOCK")) {
-		ActivateInnerAirlock (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateInnerAirlock (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "LADDER")) {
-		ActivateLadder (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateLadder (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	}
 	return false;
@@ -2859,186 +2848,8 @@ void DeltaGlider::clbkPostStep (double simt, double simdt, double mjd)
 	if (spmode) AdjustScramGimbal (spmode);
 	if (hbmode) AdjustHoverBalance (hbmode);
 
-	// animate landing gear
-	if (gear_status >= DOOR_CLOSING) {
-		double da = simdt * GEAR_OPERATING_SPEED;
-		if (gear_status == DOOR_CLOSING) {
-			if (gear_proc > 0.0)
-				gear_proc = max (0.0, gear_proc-da);
-			else {
-				gear_status = DOOR_CLOSED;
-				//oapiTriggerRedrawArea (2, 0, AID_GEARINDICATOR);
-			}
-		} else  { // door opening
-			if (gear_proc < 1.0)
-				gear_proc = min (1.0, gear_proc+da);
-			else {
-				gear_status = DOOR_OPEN;
-				//oapiTriggerRedrawArea (2, 0, AID_GEARINDICATOR);
-			}
-		}
-		SetAnimation (anim_gear, gear_proc);
-		SetGearParameters (gear_proc);
-		oapiTriggerRedrawArea (0, 0, AID_GEARINDICATOR);
-		UpdateStatusIndicators();
-	}
-
-	// animate retro covers
-	if (rcover_status >= DOOR_CLOSING) {
-		double da = simdt * RCOVER_OPERATING_SPEED;
-		if (rcover_status == DOOR_CLOSING) {
-			if (rcover_proc > 0.0)
-				rcover_proc = max (0.0, rcover_proc-da);
-			else {
-				rcover_status = DOOR_CLOSED;
-			}
-		} else {
-			if (rcover_proc < 1.0)
-				rcover_proc = min (1.0, rcover_proc+da);
-			else {
-				rcover_status = DOOR_OPEN;
-				EnableRetroThrusters (true);
-			}
-		}
-		SetAnimation (anim_rcover, rcover_proc);
-		UpdateStatusIndicators();
-	}
-
-	// animate nose cone
-	if (nose_status >= DOOR_CLOSING) {
-		double da = simdt * NOSE_OPERATING_SPEED;
-		if (nose_status == DOOR_CLOSING) {
-			if (nose_proc > 0.0)
-				nose_proc = max (0.0, nose_proc-da);
-			else {
-				nose_status = DOOR_CLOSED;
-			}
-		} else { // door opening
-			if (nose_proc < 1.0)
-				nose_proc = min (1.0, nose_proc+da);
-			else {
-				nose_status = DOOR_OPEN;
-			}
-		}
-		SetAnimation (anim_nose, nose_proc);
-		oapiTriggerRedrawArea (0, 0, AID_NOSECONEINDICATOR);
-		UpdateStatusIndicators();
-	}
-
-	// animate escape ladder
-	if (ladder_status >= DOOR_CLOSING) {
-		double da = simdt * LADDER_OPERATING_SPEED;
-		if (ladder_status == DOOR_CLOSING) {
-			if (ladder_proc > 0.0)
-				ladder_proc = max (0.0, ladder_proc-da);
-			else {
-				ladder_status = DOOR_CLOSED;
-				//oapiTriggerPanelRedrawArea (2, AID_NOSECONEINDICATOR);
-			}
-		} else {
-			if (ladder_proc < 1.0)
-				ladder_proc = min (1.0, ladder_proc+da);
-			else {
-				ladder_status = DOOR_OPEN;
-				//oapiTriggerPanelRedrawArea (2, AID_NOSECONEINDICATOR);
-			}
-		}
-		SetAnimation (anim_ladder, ladder_proc);
-	}
-
-	// animate top hatch
-	if (hatch_status >= DOOR_CLOSING) {
-		double da = simdt * HATCH_OPERATING_SPEED;
-		if (hatch_status == DOOR_CLOSING) {
-			if (hatch_proc > 0.0)
-				hatch_proc = max (0.0, hatch_proc-da);
-			else {
-				hatch_status = DOOR_CLOSED;
-				//oapiTriggerPanelRedrawArea (2, AID_NOSECONEINDICATOR);
-			}
-		} else {
-			if (hatch_proc < 1.0)
-				hatch_proc = min (1.0, hatch_proc+da);
-			else {
-				hatch_status = DOOR_OPEN;
-				//oapiTriggerPanelRedrawArea (2, AID_NOSECONEINDICATOR);
-			}
-		}
-		SetAnimation (anim_hatch, hatch_proc);
-		UpdateStatusIndicators();
-	}
-
-	// animate outer airlock
-	if (olock_status >= DOOR_CLOSING) {
-		double da = simdt * AIRLOCK_OPERATING_SPEED;
-		if (olock_status == DOOR_CLOSING) {
-			if (olock_proc > 0.0)
-				olock_proc = max (0.0, olock_proc-da);
-			else {
-				olock_status = DOOR_CLOSED;
-				//oapiTriggerPanelRedrawArea (1, AID_AIRLOCKINDICATOR);
-			}
-		} else { // door opening
-			if (olock_proc < 1.0)
-				olock_proc = min (1.0, olock_proc+da);
-			else {
-				olock_status = DOOR_OPEN;
-				//oapiTriggerPanelRedrawArea (1, AID_AIRLOCKINDICATOR);
-			}
-		}
-		SetAnimation (anim_olock, olock_proc);
-		UpdateStatusIndicators();
-	}
-
-	// animate inner airlock
-	if (ilock_status >= DOOR_CLOSING) {
-		double da = simdt * AIRLOCK_OPERATING_SPEED;
-		if (ilock_status == DOOR_CLOSING) {
-			if (ilock_proc > 0.0)
-				ilock_proc = max (0.0, ilock_proc-da);
-			else {
-				ilock_status = DOOR_CLOSED;
-				//oapiTriggerPanelRedrawArea (1, AID_AIRLOCKINDICATOR);
-			}
-		} else { // door opening
-			if (ilock_proc < 1.0)
-				ilock_proc = min (1.0, ilock_proc+da);
-			else {
-				ilock_status = DOOR_OPEN;
-				//oapiTriggerPanelRedrawArea (1, AID_AIRLOCKINDICATOR);
-			}
-		}
-		SetAnimation (anim_ilock, ilock_proc);
-		UpdateStatusIndicators();
-	}
-
-	// animate radiator
-	if (radiator_status >= DOOR_CLOSING) {
-		double da = simdt * RADIATOR_OPERATING_SPEED;
-		if (radiator_status == DOOR_CLOSING) { // retract radiator
-			if (radiator_proc > 0.0) radiator_proc = max (0.0, radiator_proc-da);
-			else                     radiator_status = DOOR_CLOSED;
-		} else {                               // deploy radiator
-			if (radiator_proc < 1.0) radiator_proc = min (1.0, radiator_proc+da);
-			else                     radiator_status = DOOR_OPEN;
-		}
-		SetAnimation (anim_radiator, radiator_proc);
-		UpdateStatusIndicators();
-	}
-
-	// animate airbrake
-	if (brake_status >= DOOR_CLOSING) {
-		double da = simdt * AIRBRAKE_OPERATING_SPEED;
-		if (brake_status == DOOR_CLOSING) { // retract brake
-			if (brake_proc > 0.0) brake_proc = max (0.0, brake_proc-da);
-			else                  brake_status = DOOR_CLOSED;
-		} else {                            // deploy brake
-			if (brake_proc < 1.0) brake_proc = min (1.0, brake_proc+da);
-			else                  brake_status = DOOR_OPEN;
-		}
-		SetAnimation (anim_brake, brake_proc);
-		UpdateStatusIndicators();
-	}
+	// animate doors, landing gear and airbrake
+	act.Step (simdt);
 
 	if (hatch_vent && simt > hatch_vent_t + 1.0) {
 		DelExhaustStream (hatch_vent);
@@ -3249,8 +3060,8 @@ void DeltaGlider::DefinePanelMain (PANELHANDLE hPanel)
 
 	const DWORD NVTX = 4, NIDX = 6;
 	const DWORD texw = PANEL2D_TEXW, texh = PANEL2D_TEXH;
-	const DWORD panelw = PANEL2D_WIDTH, panelh = 572, panely0 = PANEL2D_TEXH-572;
-	int xofs, g = 0;
+	const DWORD panelw = PANEL2D_WIDTH, panelh = 572;
+	int xofs;
 
 	// panel billboard definition
 	static NTVERTEX VTX[NVTX] = {
@@ -3836,52 +3647,52 @@ bool DeltaGlider::clbkVCMouseEvent (int id, int event, VECTOR3 &p)
 			oapiGetSimStep() * (p.y < 0.5 ? -0.2:0.2));
 		return true;
 	case AID_GEARDOWN:
-		ActivateLandingGear (DOOR_OPENING);
+		ActivateLandingGear (AnimState::OPENING);
 		return true;
 	case AID_GEARUP:
-		ActivateLandingGear (DOOR_CLOSING);
+		ActivateLandingGear (AnimState::CLOSING);
 		return true;
 	case AID_NCONEOPEN:
-		ActivateDockingPort (DOOR_OPENING);
+		ActivateDockingPort (AnimState::OPENING);
 		return true;
 	case AID_NCONECLOSE:
-		ActivateDockingPort (DOOR_CLOSING);
+		ActivateDockingPort (AnimState::CLOSING);
 		return true;
 	case AID_OLOCKOPEN:
-		ActivateOuterAirlock (DOOR_OPENING);
+		ActivateOuterAirlock (AnimState::OPENING);
 		return true;
 	case AID_OLOCKCLOSE:
-		ActivateOuterAirlock (DOOR_CLOSING);
+		ActivateOuterAirlock (AnimState::CLOSING);
 		return true;
 	case AID_ILOCKOPEN:
-		ActivateInnerAirlock (DOOR_OPENING);
+		ActivateInnerAirlock (AnimState::OPENING);
 		return true;
 	case AID_ILOCKCLOSE:
-		ActivateInnerAirlock (DOOR_CLOSING);
+		ActivateInnerAirlock (AnimState::CLOSING);
 		return true;
 	case AID_RCOVEROPEN:
-		ActivateRCover (DOOR_OPENING);
+		ActivateRCover (AnimState::OPENING);
 		return true;
 	case AID_RCOVERCLOSE:
-		ActivateRCover (DOOR_CLOSING);
+		ActivateRCover (AnimState::CLOSING);
 		return true;
 	case AID_RADIATOREX:
-		ActivateRadiator (DOOR_OPENING);
+		ActivateRadiator (AnimState::OPENING);
 		return true;
 	case AID_RADIATORIN:
-		ActivateRadiator (DOOR_CLOSING);
+		ActivateRadiator (AnimState::CLOSING);
 		return true;
 	case AID_HATCHOPEN:
-		ActivateHatch (DOOR_OPENING);
+		ActivateHatch (AnimState::OPENING);
 		return true;
 	case AID_HATCHCLOSE:
-		ActivateHatch (DOOR_CLOSING);
+		ActivateHatch (AnimState::CLOSING);
 		return true;
 	case AID_LADDEREX:
-		ActivateLadder (DOOR_OPENING);
+		ActivateLadder (AnimState::OPENING);
 		return true;
 	case AID_LADDERIN:
-		ActivateLadder (DOOR_CLOSING);
+		ActivateLadder (AnimState::CLOSING);
 		return true;
 	case AID_HUDCOLOUR:
 		oapiToggleHUDColour ();
@@ -4211,7 +4022,7 @@ DLLCLBK void ovcExit (VESSEL *vessel)
 DeltaGlider *GetDG (HWND hDlg)
 {
 	// retrieve DG interface from scenario editor
-	OBJHANDLE hVessel;
+	OBJHANDLE hVessel = 0;
 	SendMessage (hDlg, WM_SCNEDITOR, SE_GETVESSEL, (LPARAM)&hVessel);
 	return (DeltaGlider*)oapiGetVesselInterface (hVessel);
 }
@@ -4244,52 +4055,52 @@ BOOL CALLBACK EdPg1Proc (HWND hTab, UINT uMsg, WPARAM wParam, LPARAM lParam)
 			oapiOpenHelp (&g_hc);
 			return TRUE;
 		case IDC_GEAR_UP:
-			GetDG(hTab)->ActivateLandingGear (DeltaGlider::DOOR_CLOSED);
+			GetDG(hTab)->ActivateLandingGear (AnimState::CLOSED);
 			return TRUE;
 		case IDC_GEAR_DOWN:
-			GetDG(hTab)->ActivateLandingGear (DeltaGlider::DOOR_OPEN);
+			GetDG(hTab)->ActivateLandingGear (AnimState::OPEN);
 			return TRUE;
 		case IDC_RETRO_CLOSE:
-			GetDG(hTab)->ActivateRCover (DeltaGlider::DOOR_CLOSED);
+			GetDG(hTab)->ActivateRCover (AnimState::CLOSED);
 			return TRUE;
 		case IDC_RETRO_OPEN:
-			GetDG(hTab)->ActivateRCover (DeltaGlider::DOOR_OPEN);
+			GetDG(hTab)->ActivateRCover (AnimState::OPEN);
 			return TRUE;
 		case IDC_OLOCK_CLOSE:
-			GetDG(hTab)->ActivateOuterAirlock (DeltaGlider::DOOR_CLOSED);
+			GetDG(hTab)->ActivateOuterAirlock (AnimState::CLOSED);
 			return TRUE;
 		case IDC_OLOCK_OPEN:
-			GetDG(hTab)->ActivateOuterAirlock (DeltaGlider::DOOR_OPEN);
+			GetDG(hTab)->ActivateOuterAirlock (AnimState::OPEN);
 			return TRUE;
 		case IDC_ILOCK_CLOSE:
-			GetDG(hTab)->ActivateInnerAirlock (DeltaGlider::DOOR_CLOSED);
+			GetDG(hTab)->ActivateInnerAirlock (AnimState::CLOSED);
 			return TRUE;
 		case IDC_ILOCK_OPEN:
-			GetDG(hTab)->ActivateInnerAirlock (DeltaGlider::DOOR_OPEN);
+			GetDG(hTab)->ActivateInnerAirlock (AnimState::OPEN);
 			return TRUE;
 		case IDC_NCONE_CLOSE:
-			GetDG(hTab)->ActivateDockingPort (DeltaGlider::DOOR_CLOSED);
+			GetDG(hTab)->ActivateDockingPort (AnimState::CLOSED);
 			return TRUE;
 		case IDC_NCONE_OPEN:
-			GetDG(hTab)->ActivateDockingPort (DeltaGlider::DOOR_OPEN);
+			GetDG(hTab)->ActivateDockingPort (AnimState::OPEN);
 			return TRUE;
 		case IDC_LADDER_RETRACT:
-			GetDG(hTab)->ActivateLadder (DeltaGlider::DOOR_CLOSED);
+			GetDG(hTab)->ActivateLadder (AnimState::CLOSED);
 			return TRUE;
 		case IDC_LADDER_EXTEND:
-			GetDG(hTab)->ActivateLadder (DeltaGlider::DOOR_OPEN);
+			GetDG(hTab)->ActivateLadder (AnimState::OPEN);
 			return TRUE;
 		case IDC_HATCH_CLOSE:
-			GetDG(hTab)->ActivateHatch (DeltaGlider::DOOR_CLOSED);
+			GetDG(hTab)->ActivateHatch (AnimState::CLOSED);
 			return TRUE;
 		case IDC_HATCH_OPEN:
-			GetDG(hTab)->ActivateHatch (DeltaGlider::DOOR_OPEN);
+			GetDG(hTab)->ActivateHatch (AnimState::OPEN);
 			return TRUE;
 		case IDC_RADIATOR_RETRACT:
-			GetDG(hTab)->ActivateRadiator (DeltaGlider::DOOR_CLOSED);
+			GetDG(hTab)->ActivateRadiator (AnimState::CLOSED);
 			return TRUE;
 		case IDC_RADIATOR_EXTEND:
-			GetDG(hTab)->ActivateRadiator (DeltaGlider::DOOR_OPEN);
+			GetDG(hTab)->ActivateRadiator (AnimState::OPEN);
 			return TRUE;
 		}
 		break;
@@ -4420,52 +4231,52 @@ BOOL CALLBACK Ctrl_DlgProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 			oapiCloseDialog (hWnd);
 			return TRUE;
 		case IDC_GEAR_UP:
-			dg->ActivateLandingGear (DeltaGlider::DOOR_CLOSING);
+			dg->ActivateLandingGear (AnimState::CLOSING);
 			return 0;
 		case IDC_GEAR_DOWN:
-			dg->ActivateLandingGear (DeltaGlider::DOOR_OPENING);
+			dg->ActivateLandingGear (AnimState::OPENING);
 			return 0;
 		case IDC_RETRO_CLOSE:
-			dg->ActivateRCover (DeltaGlider::DOOR_CLOSING);
+			dg->ActivateRCover (AnimState::CLOSING);
 			return 0;
 		case IDC_RETRO_OPEN:
-			dg->ActivateRCover (DeltaGlider::DOOR_OPENING);
+			dg->ActivateRCover (AnimState::OPENING);
 			return 0;
 		case IDC_NCONE_CLOSE:
-			dg->ActivateDockingPort (DeltaGlider::DOOR_CLOSING);
+			dg->ActivateDockingPort (AnimState::CLOSING);
 			return 0;
 		case IDC_NCONE_OPEN:
-			dg->ActivateDockingPort (DeltaGlider::DOOR_OPENING);
+			dg->ActivateDockingPort (AnimState::OPENING);
 			return 0;
 		case IDC_OLOCK_CLOSE:
-			dg->ActivateOuterAirlock (DeltaGlider::DOOR_CLOSING);
+			dg->ActivateOuterAirlock (AnimState::CLOSING);
 			return 0;
 		case IDC_OLOCK_OPEN:
-			dg->ActivateOuterAirlock (DeltaGlider::DOOR_OPENING);
+			dg->ActivateOuterAirlock (AnimState::OPENING);
 			return 0;
 		case IDC_ILOCK_CLOSE:
-			dg->ActivateInnerAirlock (DeltaGlider::DOOR_CLOSING);
+			dg->ActivateInnerAirlock (AnimState::CLOSING);
 			return 0;
 		case IDC_ILOCK_OPEN:
-			dg->ActivateInnerAirlock (DeltaGlider::DOOR_OPENING);
+			dg->ActivateInnerAirlock (AnimState::OPENING);
 			return 0;
 		case IDC_LADDER_RETRACT:
-			dg->ActivateLadder (DeltaGlider::DOOR_CLOSING);
+			dg->ActivateLadder (AnimState::CLOSING);
 			return 0;
 		case IDC_LADDER_EXTEND:
-			dg->ActivateLadder (DeltaGlider::DOOR_OPENING);
+			dg->ActivateLadder (AnimState::OPENING);
 			return 0;
 		case IDC_HATCH_CLOSE:
-			dg->ActivateHatch (DeltaGlider::DOOR_CLOSING);
+			dg->ActivateHatch (AnimState::CLOSING);
 			return 0;
 		case IDC_HATCH_OPEN:
-			dg->ActivateHatch (DeltaGlider::DOOR_OPENING);
+			dg->ActivateHatch (AnimState::OPENING);
 			return 0;
 		case IDC_RADIATOR_RETRACT:
-			dg->ActivateRadiator (DeltaGlider::DOOR_CLOSING);
+			dg->ActivateRadiator (AnimState::CLOSING);
 			return 0;
 		case IDC_RADIATOR_EXTEND:
-			dg->ActivateRadiator (DeltaGlider::DOOR_OPENING);
+			dg->ActivateRadiator (AnimState::OPENING);
 			return 0;
 		case IDC_NAVLIGHT:
 			dg->SetNavlight (SendDlgItemMessage (hWnd, IDC_NAVLIGHT, BM_GETCHECK, 0, 0) == BST_CHECKED);
@@ -4497,35 +4308,35 @@ void UpdateCtrlDialog (DeltaGlider *dg, HWND hWnd)
 
 	int op;
 
-	op = dg->gear_status & 1;
+	op = SwitchState (dg->gear_status);
 	SendDlgItemMessage (hWnd, IDC_GEAR_DOWN, BM_SETCHECK, bstatus[op], 0);
 	SendDlgItemMessage (hWnd, IDC_GEAR_UP, BM_SETCHECK, bstatus[1-op], 0);
 
-	op = dg->rcover_status & 1;
+	op = SwitchState (dg->rcover_status);
 	SendDlgItemMessage (hWnd, IDC_RETRO_OPEN, BM_SETCHECK, bstatus[op], 0);
 	SendDlgItemMessage (hWnd, IDC_RETRO_CLOSE, BM_SETCHECK, bstatus[1-op], 0);
 
-	op = dg->nose_status & 1;
+	op = SwitchState (dg->nose_status);
 	SendDlgItemMessage (hWnd, IDC_NCONE_OPEN, BM_SETCHECK, bstatus[op], 0);
 	SendDlgItemMessage (hWnd, IDC_NCONE_CLOSE, BM_SETCHECK, bstatus[1-op], 0);
 
-	op = dg->olock_status & 1;
+	op = SwitchState (dg->olock_status);
 	SendDlgItemMessage (hWnd, IDC_OLOCK_OPEN, BM_SETCHECK, bstatus[op], 0);
 	SendDlgItemMessage (hWnd, IDC_OLOCK_CLOSE, BM_SETCHECK, bstatus[1-op], 0);
 
-	op = dg->ilock_status & 1;
+	op = SwitchState (dg->ilock_status);
 	SendDlgItemMessage (hWnd, IDC_ILOCK_OPEN, BM_SETCHECK, bstatus[op], 0);
 	SendDlgItemMessage (hWnd, IDC_ILOCK_CLOSE, BM_SETCHECK, bstatus[1-op], 0);
 
-	op = dg->ladder_status & 1;
+	op = SwitchState (dg->ladder_status);
 	SendDlgItemMessage (hWnd, IDC_LADDER_EXTEND, BM_SETCHECK, bstatus[op], 0);
 	SendDlgItemMessage (hWnd, IDC_LADDER_RETRACT, BM_SETCHECK, bstatus[1-op], 0);
 
-	op = dg->hatch_status & 1;
+	op = SwitchState (dg->hatch_status);
 	SendDlgItemMessage (hWnd, IDC_HATCH_OPEN, BM_SETCHECK, bstatus[op], 0);
 	SendDlgItemMessage (hWnd, IDC_HATCH_CLOSE, BM_SETCHECK, bstatus[1-op], 0);
 
-	op = dg->radiator_status & 1;
+	op = SwitchState (dg->radiator_status);
 	SendDlgItemMessage (hWnd, IDC_RADIATOR_EXTEND, BM_SETCHECK, bstatus[op], 0);
 	SendDlgItemMessage (hWnd, IDC_RADIATOR_RETRACT, BM_SETCHECK, bstatus[1-op], 0);
 
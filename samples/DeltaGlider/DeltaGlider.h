@@ -23,6 +23,9 @@
 #include "orbitersdk.h"
 #include "Ramjet.h"
 #include "Instrument.h"
+#include "../Common/HUDOverlay.h"
+#include "../Common/Actuator.h"
+#include "../Common/AeroDatabase.h"
 #include "resource.h"
 
 #define LOADBMP(id) (LoadBitmap (g_Param.hDLL, MAKEINTRESOURCE (id)))
@@ -179,6 +182,7 @@ public:
 	void SetEmptyMass () const;
 	void CreatePanelElements ();
 	void DefineAnimations ();
+	void DefineActuators ();
 	void ReleaseSurfaces();
 	void InitPanel (int panel);
 	void InitVC (int vc);
@@ -291,8 +295,10 @@ public:
 	int hatchfail;
 	bool aileronfail[4];
 
-	enum DoorStatus { DOOR_CLOSED, DOOR_OPEN, DOOR_CLOSING, DOOR_OPENING }
-		nose_status, ladder_status, gear_status, rcover_status, olock_status, ilock_status, hatch_status, radiator_status, brake_status;
+	enum { ACT_GEAR, ACT_RCOVER, ACT_NOSE, ACT_LADDER, ACT_OLOCK, ACT_ILOCK, ACT_HATCH, ACT_RADIATOR, ACT_BRAKE, NACTUATOR };
+	ActuatorSet act;        // door, gear and airbrake actuators
+	typedef AnimState::Action DoorStatus;
+	DoorStatus &nose_status, &ladder_status, &gear_status, &rcover_status, &olock_status, &ilock_status, &hatch_status, &radiator_status, &brake_status;
 	void ActivateLandingGear (DoorStatus action);
 	void ActivateRCover (DoorStatus action);
 	void ActivateDockingPort (DoorStatus action);
@@ -311,7 +317,7 @@ public:
 	void RevertAirbrake ();
 	void RevertRadiator ();
 	void SetGearParameters (double state);
-	double nose_proc, ladder_proc, gear_proc, rcover_proc, olock_proc, ilock_proc, hatch_proc, radiator_proc, brake_proc;     // logical status
+	double &nose_proc, &ladder_proc, &gear_proc, &rcover_proc, &olock_proc, &ilock_proc, &hatch_proc, &radiator_proc, &brake_proc;     // logical status (references into act)
 	UINT anim_gear;         // handle for landing gear animation
 	UINT anim_rcover;       // handle for retro cover animation
 	UINT anim_nose;         // handle for nose cone animation
@@ -373,6 +379,8 @@ public:
 	int Lua_InitInstance (void *context);
 
 private:
+	static void ActuatorMoved (void *context, int id, const AnimState &state);
+	static void ActuatorDone (void *context, int id, const AnimState &state);
 	bool RedrawPanel_IndicatorPair (SURFHANDLE surf, int *p, int range);
 	bool RedrawPanel_Number (SURFHANDLE surf, int x, int y, char *num);
 	void ApplySkin();                            // apply custom skin
@@ -382,6 +390,7 @@ private:
 	void ScramjetThrust ();                      // scramjet thrust calculation
 
 	AAP *aap;                                    // atmospheric autopilot
+	AeroDatabase *aerodb;                        // aerodynamic database (NULL = built-in coefficients)
 
 	PanelElement **instr;                        // panel instrument objects
 	DWORD ninstr;                                // total number of instruments
@@ -395,6 +404,9 @@ private:
 	VISHANDLE visual;                            // handle to DG visual representation
 	SURFHANDLE skin[3];                          // custom skin textures, if applicable
 	MESHHANDLE hPanelMesh;                       // 2-D instrument panel mesh handle
+	HUDOverlay hudovl;                           // custom HUD elements
+	float hudscl;                                // HUD element scale of the current overlay
+	enum { HUDELEM_GEAR, HUDELEM_NOSE, HUDELEM_BRAKE }; // HUD overlay element ids
 	char skinpath[32];                           // skin directory, if applicable
 	PROPELLANT_HANDLE ph_main, ph_rcs, ph_scram; // propellant resource handles
 	THRUSTER_HANDLE th_main[2];                  // main engine handles
@@ -440,7 +452,7 @@ private:
 
 class DGPanelElement: public PanelElement {
 public:
-	DGPanelElement (DeltaGlider *_dg): PanelElement (dg), dg(_dg) {}
+	DGPanelElement (DeltaGlider *_dg): PanelElement (_dg), dg(_dg) {}
 
 protected:
 	DeltaGlider *dg;
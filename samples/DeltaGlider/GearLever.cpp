@@ -53,7 +53,7 @@ bool GearLever::Redraw2D (SURFHANDLE surf)
 {
 	DeltaGlider *dg = (DeltaGlider*)vessel;
 	DeltaGlider::DoorStatus action = dg->gear_status;
-	bool leverdown = (action == DeltaGlider::DOOR_OPENING || action == DeltaGlider::DOOR_OPEN);
+	bool leverdown = (action == AnimState::OPENING || action == AnimState::OPEN);
 	float y = (leverdown ? bb_y0+tx_dx : bb_y0);
 	grp->Vtx[vtxofs+2].y = grp->Vtx[vtxofs+3].y = y;
 	return false;
@@ -65,10 +65,10 @@ bool GearLever::ProcessMouse2D (int event, int mx, int my)
 {
 	DeltaGlider *dg = (DeltaGlider*)vessel;
 	DeltaGlider::DoorStatus action = dg->gear_status;
-	if (action == DeltaGlider::DOOR_CLOSED || action == DeltaGlider::DOOR_CLOSING) {
-		if (my < 151) dg->ActivateLandingGear (DeltaGlider::DOOR_OPENING);
+	if (action == AnimState::CLOSED || action == AnimState::CLOSING) {
+		if (my < 151) dg->ActivateLandingGear (AnimState::OPENING);
 	} else {
-		if (my >  46) dg->ActivateLandingGear (DeltaGlider::DOOR_CLOSING);
+		if (my >  46) dg->ActivateLandingGear (AnimState::CLOSING);
 	}
 	return false;
 }
@@ -117,8 +117,8 @@ bool GearIndicator::Redraw2D (SURFHANDLE surf)
 	double d;
 	DeltaGlider::DoorStatus action = ((DeltaGlider*)vessel)->gear_status;
 	switch (action) {
-		case DeltaGlider::DOOR_CLOSED: xofs = 1018; break;
-		case DeltaGlider::DOOR_OPEN:   xofs = 1030; break;
+		case AnimState::CLOSED: xofs = 1018; break;
+		case AnimState::OPEN:   xofs = 1030; break;
 		default: xofs = (modf (oapiGetSimTime()+tofs, &d) < 0.5 ? 1042 : 1020); break;
 	}
 	for (i = 0; i < 3; i++) {
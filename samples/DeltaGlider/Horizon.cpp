@@ -172,7 +172,7 @@ bool InstrAtt::Redraw2D (SURFHANDLE surf)
 		double sinb = sin(bank), cosb = cos(bank);
 
 		static double texw = PANEL2D_TEXW, texh = PANEL2D_TEXH;
-		static double scaleh = 900.0, scalew = 154.0;
+		static double scaleh = 900.0;
 		static const double horzx2 = (double)(texw-312);
 
 		// transform articfical horizon
@@ -246,7 +246,6 @@ NTVERTEX *InstrAtt::MeshDataVC ()
 	const float horzw = 154.0f, horzx = (float)(texw-1)-horzw;
 	const float horzx2 = (float)(texw-312);
 	const float out_y0 = (texh-20.5f)/(float)texh, out_y1 = (texh-3.5f)/(float)texh;
-	const float xcnt = 0, ycnt = 0;
 	const DWORD NVTX =  80;
 	static bool need_transform = true;
 	static NTVERTEX VTX[NVTX] = {
@@ -451,7 +450,7 @@ bool InstrAtt::RedrawVC (DEVMESHHANDLE hMesh, SURFHANDLE surf)
 		double sinb = sin(bank), cosb = cos(bank);
 
 		static double texw = INSTR3D_TEXW, texh = INSTR3D_TEXH;
-		static double scaleh = 900.0, scalew = 154.0;
+		static double scaleh = 900.0;
 		static const double horzx2 = (double)(texw-312);
 
 		// transform articfical horizon
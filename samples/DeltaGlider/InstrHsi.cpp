@@ -148,7 +148,7 @@ bool InstrHSI::Redraw2D (SURFHANDLE surf)
 			nv = NULL;
 	}
 	if (nv != nav) {
-		if (nav = nv) {
+		if ((nav = nv)) {
 			navRef = vessel->GetSurfaceRef();
 			navType = tp;
 			if (navRef) {
@@ -88,23 +88,22 @@ MFDButtonCol::~MFDButtonCol ()
 
 bool MFDButtonCol::Redraw2D (SURFHANDLE surf)
 {
-	int btn, x, y, len, i, w;
+	int btn, x, len, i, w;
 	const char *label;
 
 	// write labels
 	x = tx_w/2;
-	y = 4;
 	for (btn = 0; btn < 6; btn++)
 		oapiBlt (surf, surf, xcnt-14, lbly[btn], 773, 22, 28, CHH); // blank label
 
 	for (btn = 0; btn < 6; btn++) {
-		if (label = oapiMFDButtonLabel (mfdid, btn+lr*6)) {
+		if ((label = oapiMFDButtonLabel (mfdid, btn+lr*6))) {
 			len = strlen(label);
-			for (w = i = 0; i < len; i++) w += CHW[label[i]];
+			for (w = i = 0; i < len; i++) w += CHW[(BYTE)label[i]];
 			for (i = 0, x = xcnt-w/2; i < len; i++) {
-				w = CHW[label[i]];
+				w = CHW[(BYTE)label[i]];
 				if (w) {
-					oapiBlt (surf, surf, x, lbly[btn], CHX[label[i]], CHY, w, CHH);
+					oapiBlt (surf, surf, x, lbly[btn], CHX[(BYTE)label[i]], CHY, w, CHH);
 					x += w;
 				}
 			}
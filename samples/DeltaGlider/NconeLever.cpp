@@ -44,7 +44,7 @@ void NoseconeLever::AddMeshData2D (MESHHANDLE hMesh, DWORD grpidx)
 bool NoseconeLever::Redraw2D (SURFHANDLE surf)
 {
 	DeltaGlider::DoorStatus action = dg->nose_status;
-	bool leverdown = (action == DeltaGlider::DOOR_OPENING || action == DeltaGlider::DOOR_OPEN);
+	bool leverdown = (action == AnimState::OPENING || action == AnimState::OPEN);
 
 	float y0, dy, tv0;
 	if (leverdown) y0 = 400.5f, dy = 21.0f, tv0 = texh-677.5f;
@@ -62,10 +62,10 @@ bool NoseconeLever::Redraw2D (SURFHANDLE surf)
 bool NoseconeLever::ProcessMouse2D (int event, int mx, int my)
 {
 	DeltaGlider::DoorStatus action = dg->nose_status;
-	if (action == DeltaGlider::DOOR_CLOSED || action == DeltaGlider::DOOR_CLOSING) {
-		if (my < 58) dg->ActivateDockingPort (DeltaGlider::DOOR_OPENING);
+	if (action == AnimState::CLOSED || action == AnimState::CLOSING) {
+		if (my < 58) dg->ActivateDockingPort (AnimState::OPENING);
 	} else {
-		if (my > 36) dg->ActivateDockingPort (DeltaGlider::DOOR_CLOSING);
+		if (my > 36) dg->ActivateDockingPort (AnimState::CLOSING);
 	}
 	return false;
 }
@@ -114,8 +114,8 @@ bool NoseconeIndicator::Redraw2D (SURFHANDLE surf)
 	double d;
 	DeltaGlider::DoorStatus action = dg->nose_status;
 	switch (action) {
-		case DeltaGlider::DOOR_CLOSED: xofs = 1014; break;
-		case DeltaGlider::DOOR_OPEN:   xofs = 1027; break;
+		case AnimState::CLOSED: xofs = 1014; break;
+		case AnimState::OPEN:   xofs = 1027; break;
 		default: xofs = (modf (oapiGetSimTime()+tofs, &d) < 0.5 ? 1040 : 1014); break;
 	}
 	for (i = 0; i < 4; i++) {
@@ -57,14 +57,12 @@ void Ramjet::Thrust (double *F) const
 
 	if (atm) { // atmospheric parameters available
 		
-		double M, Fs, T0, Td, Tb, Tb0, Te, p0, pd, D, rho, cp, v0, ve, tr, lvl, dma, dmf, precov, dmafac;
-		const double eps = 1e-4;
+		double M, Fs, T0, Td, Tb, Tb0, Te, p0, pd, D, cp, v0, ve, tr, lvl, dma, dmf, precov, dmafac;
 		const double dma_scale = 2.7e-4;
 
 		M   = vessel->GetMachNumber();                     // Mach number
 		T0  = vessel->GetAtmTemperature();                 // freestream temperature
 		p0  = vessel->GetAtmPressure();                    // freestream pressure
-		rho = vessel->GetAtmDensity();                     // freestream density
 		cp  = atm->gamma * atm->R / (atm->gamma-1.0);      // specific heat (pressure)
 		v0  = M * sqrt (atm->gamma * atm->R * T0);         // freestream velocity
 		tr  = (1.0 + 0.5*(atm->gamma-1.0) * M*M);          // temperature ratio
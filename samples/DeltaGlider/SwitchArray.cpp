@@ -72,16 +72,16 @@ bool SwitchArray::Redraw2D (SURFHANDLE surf)
 	DeltaGlider *dg = (DeltaGlider*)vessel;
 
 	int i, j, state, vofs;
-	for (i = 0; i < nbutton; i++) {
+	for (i = 0; i < (int)nbutton; i++) {
 		switch (i) {
 			case 0:
 			case 1:
 			case 2:
 			case 3: state = (dg->GetBeaconState(i) ? 1:0); break;
-			case 4: state = (dg->radiator_status == DeltaGlider::DOOR_OPEN || dg->radiator_status == DeltaGlider::DOOR_OPENING ? 1:0); break;
-			case 5: state = (dg->rcover_status == DeltaGlider::DOOR_OPEN || dg->rcover_status == DeltaGlider::DOOR_OPENING ? 1:0); break;
-			case 6: state = (dg->hatch_status == DeltaGlider::DOOR_OPEN || dg->hatch_status == DeltaGlider::DOOR_OPENING ? 1:0); break;
-			case 7: state = (dg->ladder_status == DeltaGlider::DOOR_OPEN || dg->ladder_status == DeltaGlider::DOOR_OPENING ? 1:0); break;
+			case 4: state = (dg->radiator_status == AnimState::OPEN || dg->radiator_status == AnimState::OPENING ? 1:0); break;
+			case 5: state = (dg->rcover_status == AnimState::OPEN || dg->rcover_status == AnimState::OPENING ? 1:0); break;
+			case 6: state = (dg->hatch_status == AnimState::OPEN || dg->hatch_status == AnimState::OPENING ? 1:0); break;
+			case 7: state = (dg->ladder_status == AnimState::OPEN || dg->ladder_status == AnimState::OPENING ? 1:0); break;
 		}
 		if (state != btnstate[i]) {
 			btnstate[i] = state;
@@ -108,10 +108,10 @@ bool SwitchArray::ProcessMouse2D (int event, int mx, int my)
 			case 1: dg->SetBeacon (state != 0);   return true;
 			case 2: dg->SetStrobe (state != 0);   return true;
 			case 3: dg->SetDockingLight (state != 0); return true;
-			case 4: dg->ActivateRadiator (state == 0 ? DeltaGlider::DOOR_CLOSING : DeltaGlider::DOOR_OPENING); return true;
-			case 5: dg->ActivateRCover (state == 0 ? DeltaGlider::DOOR_CLOSING : DeltaGlider::DOOR_OPENING); return true;
-			case 6: dg->ActivateHatch (state == 0 ? DeltaGlider::DOOR_CLOSING : DeltaGlider::DOOR_OPENING); return true;
-			case 7: dg->ActivateLadder (state == 0 ? DeltaGlider::DOOR_CLOSING : DeltaGlider::DOOR_OPENING); return true;
+			case 4: dg->ActivateRadiator (state == 0 ? AnimState::CLOSING : AnimState::OPENING); return true;
+			case 5: dg->ActivateRCover (state == 0 ? AnimState::CLOSING : AnimState::OPENING); return true;
+			case 6: dg->ActivateHatch (state == 0 ? AnimState::CLOSING : AnimState::OPENING); return true;
+			case 7: dg->ActivateLadder (state == 0 ? AnimState::CLOSING : AnimState::OPENING); return true;
 		}
 	}
 	return false;
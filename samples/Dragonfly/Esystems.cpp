@@ -3,9 +3,11 @@
 #include <stdio.h>
 
 e_object::e_object()
-{next=NULL;};
+{next=NULL;moves_gas=0;next_mover=NULL;};
 void e_object::refresh(double dt)
 {};
+double e_object::Rate()
+{return 0;};
 
 void e_object::PLOAD(float amp)
 {};
@@ -19,6 +21,7 @@ void e_object::Load(FILEHANDLE scn)
 {};
 E_system::E_system()
 {List.next=NULL;
+ Movers=NULL;RateCache=0;StateSeen=-1;
 };
 
 E_system::~E_system()
@@ -36,14 +39,37 @@ e_object* E_system::AddSystem(e_object *object)
  while (runner->next) runner=runner->next;
  runner->next=object;
  object->next=NULL;
+ if (object->moves_gas) {e_object **mover=&Movers;
+						 while (*mover) mover=&(*mover)->next_mover;
+						 *mover=object;
+						 object->next_mover=NULL;}
+ H_system::StateChanges++;
  return object;
 };
 
-void E_system::Refresh(double dt)
+double E_system::Rate()
+{ e_object *runner;
+  double r;
+ if (StateSeen!=H_system::StateChanges)
+	{RateCache=0;
+	 for (runner=Movers;runner;runner=runner->next_mover)
+		if ((r=runner->Rate())>RateCache) RateCache=r;
+	 StateSeen=H_system::StateChanges;
+	}
+ return RateCache;
+};
+
+void E_system::Refresh(double dt,int movers)
 { e_object *runner;
  runner=List.next;
- while (runner){ runner->refresh(dt);
+ while (runner){ if ((movers)||(!runner->moves_gas)) runner->refresh(dt);
 				 runner=runner->next;}
+};
+
+void E_system::Step(double dt)
+{ e_object *runner;
+ for (runner=Movers;runner;runner=runner->next_mover)
+	runner->refresh(dt);
 };	
 void E_system::Save(FILEHANDLE scn)
 { e_object *runner;
@@ -109,6 +135,7 @@ FCell::FCell(vector3 i_pos,Valve *o2,Valve *h2,VentValve *vent,Tank* waste,float
   reaction=0; //no chemical react.
   SRC=NULL; //for now a FCell cannot have a source
   H2_flow=0;O2_flow=0;
+  moves_gas=1;
 }
 void FCell::PLOAD(float amp)
 { power_load+=amp;};
@@ -511,25 +538,40 @@ void Heater::Save(FILEHANDLE scn)
 Fan::Fan(Valve *ih_SRC,Tank *i_TRG,float i_max,float i_amps,e_object *i_SRC)
 {h_SRC=ih_SRC;TRG=i_TRG;MaxP=i_max;amp_cons=i_amps,SRC=i_SRC;
 start_handle=0;on=0;
+moves_gas=1;
 };
 void Fan::refresh(double dt)
 { float power;
 if ((on)&&(start_handle==-1)) {on=0;
 							  SRC->PUNLOAD(amp_cons);
+							  H_system::StateChanges++;
 								};
 if((!on)&&(start_handle==1)) {on=1;	
 							SRC->PLOAD(amp_cons);
+							H_system::StateChanges++;
 							};
 if ((on)&&(SRC->Volts))
 		{ 
 		if ((power=h_SRC->Press-TRG->Press)>MaxP) { power=h_SRC->MaxF*(SRC->Volts/28.8);
 												//	power=power/MaxP;
+													if ((TRG->clamp_flow)&&(TRG->Press>0))
+														{//grams that bring the target to the set point
+														 float m_eq=(h_SRC->Press-MaxP-TRG->Press)*TRG->mass/TRG->Press;
+														 if (power*dt>m_eq) power=m_eq/dt;
+														}
 													power=h_SRC->Flow(power,dt);
 											   TRG->PutMass(power*dt,h_SRC->Temp);
 												}
 		};
 if ((on) &&(!SRC->Volts)) start_handle=-1;
 };
+//at full speed the fan raises the target pressure by MaxF*P/m kPa per
+//second (ideal gas); a step should not push it past the set point
+double Fan::Rate()
+{ if ((!on)||(!SRC->Volts)||(TRG->mass<=0)) return 0;
+  double dp=h_SRC->MaxF*(SRC->Volts/28.8)*TRG->Press/TRG->mass;
+  return dp/(fabs(MaxP)>1?fabs(MaxP):1);
+};
 void Fan::Load(FILEHANDLE scn)
 {
    char *line;
@@ -548,7 +590,7 @@ Boiler::Boiler(int i_open,int ct,float i_maxf, Valve *i_src,float temps,float i_
  boil_Temp=i_boil;
 };
 void Boiler::refresh(double dt)
-{double need_e;
+{double need_e=0;
 if (e_SRC->Volts)
 {  need_e=(trg_Temp>SRC->Temp?trg_Temp-SRC->Temp:0);	//delta temp in K
            need_e*=c*mass;					//convert this into Joules
@@ -601,5 +643,6 @@ void Clock::UpdateChar()
   int mm=((timer-hh*3600)/60);
   int ss=(timer-hh*3600-mm*60);
   if (hh>23) while (hh>23) hh-=24;
-  sprintf(time,"%2i:%2i:%2i",hh,mm,ss);
+  while (hh<0) hh+=24;
+  sprintf(time,"%2u:%2u:%2u",(unsigned)hh%24,(unsigned)mm%60,(unsigned)ss%60);
 };
\ No newline at end of file
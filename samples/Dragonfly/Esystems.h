@@ -17,22 +17,34 @@ class e_object:public therm_obj
 	int atrip_handle;	//handles for auto-shut-down
 	int reset_handle;	
 	e_object *next;
+	int moves_gas;		//refreshed with every sub-step of the H_system
+	e_object *next_mover;
 	e_object();
+	virtual ~e_object() {};
 	virtual void PLOAD(float amp);
 	virtual void PUNLOAD(float amp);
 	virtual void connect(e_object *new_src);
 	virtual void refresh(double dt);
+	virtual double Rate();	//as h_object::Rate, for objects that move gas
 	virtual void Load(FILEHANDLE scn);
 	virtual void Save(FILEHANDLE scn);
 };
 
+//objects that move gas (fans, fuel cells) make the H_system they work on
+//sub-step: take H_system::SubSteps(dt,E_system::Rate()) steps, each
+//H_system::Step and E_system::Step, then E_system::Refresh(dt,0) for the rest
 class E_system
 { public:
     e_object List;
+	e_object *Movers;	//the objects that move gas, chained by next_mover
+	double RateCache;	//as H_system::RateCache
+	int StateSeen;
 	E_system();
 	~E_system();
 	e_object* AddSystem(e_object *object);
-	void Refresh(double dt);
+	double Rate();		//fastest rate of all objects
+	void Refresh(double dt,int movers=1);	//movers=0: all but the objects that move gas
+	void Step(double dt);	//the objects that move gas only
 	void Load (FILEHANDLE scn);
 	void Save (FILEHANDLE scn);
 };
@@ -149,6 +161,7 @@ class Fan:public e_object
   int start_handle;
   Fan(Valve *ih_SRC,Tank *i_TRG,float i_max,float i_amps,e_object *i_SRC);
   virtual void refresh(double dt);
+  virtual double Rate();
   virtual void Load(FILEHANDLE scn);
   virtual void Save(FILEHANDLE scn);
 };
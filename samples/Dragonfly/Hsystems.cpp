@@ -2,19 +2,25 @@
 #include "hsystems.h"
 #include "orbitersdk.h"
 #include <stdio.h>
+#include <math.h>
 
 const float CONST_R=8.31904f/1000.0f;
 const float TEMP_PRESS_RATIO=0.07;
 
 
 h_object::h_object()
-{next=NULL;};
+{next=NULL;clamp_flow=0;};
 
 void h_object::refresh(double dt)
 {};
+double h_object::Rate()
+{return 0;};
 H_system::H_system()
 {List.next=NULL;
+ Integrator=H_EXPLICIT;Courant=0.5;MaxSubSteps=H_MAXSUBSTEPS;
+ RateCache=0;StateSeen=-1;
 };
+int H_system::StateChanges=0;
 void h_object::Save(FILEHANDLE scn)
 {};
 void h_object::Load(FILEHANDLE scn)
@@ -35,10 +41,56 @@ h_object* H_system::AddSystem(h_object *object)
  while (runner->next) runner=runner->next;
  runner->next=object;
  object->next=NULL;
+ object->clamp_flow=(Integrator==H_SUBSTEP);
+ StateChanges++;
  return object;
 };
 
+//H_SUBSTEP splits a frame into as many steps as the stiffest object needs:
+//every object reports how fast it relaxes (Rate, 1/sec: the share of its
+//pressure difference it moves per second), and no step may go further than
+//courant times that. The steps per frame grow with the frame length, so
+//with the time acceleration, up to max_sub. Beyond that the steps are
+//longer than the stability bound, and only limited by flux: every object
+//clamps each transfer at the point where the pressures meet, so it cannot
+//overshoot and swing negative, but relaxes more slowly than it should.
+//The rates change with the temperatures and volumes too, but slowly: they
+//are only looked at again when an object opened, closed, started or
+//stopped, or the system changed
+void H_system::SetIntegrator(int mode,double courant,int max_sub)
+{ h_object *runner;
+ Integrator=mode;
+ Courant=(courant>0?courant:0.5);
+ MaxSubSteps=(max_sub>0?max_sub:0);
+ for (runner=List.next;runner;runner=runner->next)
+	 runner->clamp_flow=(mode==H_SUBSTEP);
+ StateChanges++;
+};
+
+int H_system::SubSteps(double dt,double rate)
+{ h_object *runner;
+  double r;
+ if (Integrator!=H_SUBSTEP) return 1;
+ if (StateSeen!=StateChanges)
+	{RateCache=0;
+	 for (runner=List.next;runner;runner=runner->next)
+		if ((r=runner->Rate())>RateCache) RateCache=r;
+	 StateSeen=StateChanges;
+	}
+ if (RateCache>rate) rate=RateCache;
+ double n=ceil(dt*rate/Courant);
+ if (!(n<1e6)) n=1e6;	//no rate is that fast, but a broken tank could be NaN
+ if ((MaxSubSteps)&&(n>MaxSubSteps)) n=MaxSubSteps;
+ return (n<1?1:(int)n);
+};
+
 void H_system::Refresh(double dt)
+{ int n=SubSteps(dt);
+  double h=dt/n;
+ for (int i=0;i<n;i++) Step(h);
+};
+
+void H_system::Step(double dt)
 { h_object *runner;
  runner=List.next;
  while (runner){ runner->refresh(dt);
@@ -55,6 +107,7 @@ void H_system::Load(FILEHANDLE scn)
  runner=List.next;
  while (runner){ runner->Load(scn);
 				 runner=runner->next;}
+ StateChanges++;
 };
 //------------------------------------ NORMAL BASIC VALVE ------------------
 Valve::Valve()
@@ -98,13 +151,13 @@ if ((open_handle !=2)&&(open_handle!=open)) //we've been asked to do somethinh
 if (pz<0)
 { pz+=dt; 
 	if (pz>0) {pz=0.0;
-				open=0;Press=0.0;} //we cut the pressure when  closed;temp is freezed (constant)
+				open=0;Press=0.0;H_system::StateChanges++;} //we cut the pressure when  closed;temp is freezed (constant)
 }
 
 if (pz>0)
 {pz-=dt;
 if (pz<0){ pz=0.0;
-			open=1;}
+			open=1;H_system::StateChanges++;}
 }
 if (open)
 {if (SRC->open) Temp=SRC->Temp;
@@ -152,13 +205,13 @@ if ((open_handle !=2)&&(open_handle!=open)) //we've been asked to do somethinh
 if (pz<0)
 { pz+=dt; 
 	if (pz>0) {pz=0.0;
-				open=0;Press=0.0;} //we cut the pressure when  closed;temp is freezed (constant)
+				open=0;Press=0.0;H_system::StateChanges++;} //we cut the pressure when  closed;temp is freezed (constant)
 }
 
 if (pz>0)
 {pz-=dt;
 if (pz<0){ pz=0.0;
-			open=1;}
+			open=1;H_system::StateChanges++;}
 }
 if (open)
 {if (SRC->open) Temp=SRC->Temp;
@@ -183,7 +236,6 @@ SRC1=src1;SRC2=src2;SRC3=src3;
 double CrossValve::Flow(double _need, float dt)
 {
 double flow;
-int num_SRC;
 double t_P;
 flow=(_need>MaxF?MaxF:_need);
 
@@ -208,8 +260,7 @@ mass+=f1;
 return f1;
 }
 void CrossValve::refresh(double dt)
-{ int num_SRC;
-  float new_Temp;
+{ float new_Temp;
 if ((open_handle !=2)&&(open_handle!=open)) //we've been asked to do somethinh
 	{	pz+=ClosingTime*open_handle; 
 		open_handle=2;
@@ -218,13 +269,13 @@ if ((open_handle !=2)&&(open_handle!=open)) //we've been asked to do somethinh
 if (pz<0)
 { pz+=dt; 
 	if (pz>0) {pz=0.0;
-				open=0;Press=0.0;}
+				open=0;Press=0.0;H_system::StateChanges++;}
 }
 
 if (pz>0)
 {pz-=dt;
 if (pz<0){ pz=0.0;
-			open=1;}
+			open=1;H_system::StateChanges++;}
 }
 if (open)
 {	if (SRC1->open) {	
@@ -232,7 +283,7 @@ if (open)
 			if (SRC1->mass<0) //is it comming in or out?
 			    Temp=((SRC->Temp*f1)+(SRC1->Temp*(f2+f3)))/mass;
 			else Temp=SRC->Temp;
-			 num_SRC=0;Press=0;
+			 Press=0;
 			 Press=(SRC2->Press>SRC3->Press?SRC2->Press:SRC3->Press);
 			if (SRC->Press*SRC->open>Press) Press=SRC->Press; //get max pres?
 			if (mass){new_Temp=Temp+energy/mass/c; 
@@ -337,11 +388,11 @@ Tank::Tank(vector3 i_pos,float volm)
 };
 void Tank::Set(vector3 i_pos,float volm)
 { pos=i_pos; Volm=volm;ClosingTime=3;open_handle=2;Freezing=0.0;
-  pz=0.0;open=1;energy=0.0;
+  pz=0.0;open=1;energy=0.0;MassRest=0.0;
 };
 
 void Tank::FillTank(float i_c,float i_kg,float temp,float moln,float min,float max,float fl)
-{ c=i_c;Mn=moln;mass=i_kg;MinP=min;MaxP=max;
+{ c=i_c;Mn=moln;mass=i_kg;MassRest=0.0;MinP=min;MaxP=max;
   SetTemp(temp);MaxF=fl;Temp=temp;
   Mols=mass/Mn;
   Press=Mols*CONST_R*GetTemp()/Volm;
@@ -354,7 +405,8 @@ double Tank::Flow(double _need,float dt)
   flow=(_need>flow?flow:_need);
   if (Temp<Freezing) flow=0;
   if (flow<0) flow=0; //nothing!!
-  mass-=flow*dt; //then substract the mass :-)]
+  if ((clamp_flow)&&(flow*dt>mass)) flow=mass/dt; //cannot give more than we have
+  AddMass(-flow*dt); //then substract the mass :-)]
   return flow;
 }
 
@@ -368,14 +420,14 @@ if ((open_handle !=2)&&(open_handle!=open)) //we've been asked to do somethinh
 if (pz<0)
 { pz+=dt; 
 if (pz>0) {pz=0.0;
-			open=0;
+			open=0;H_system::StateChanges++;
 			}
 }
 
 if (pz>0)
 {pz-=dt;
 if (pz<0) {pz=0.0;
-			open=1;
+			open=1;H_system::StateChanges++;
 			}
 }
 //but also with some press computations;
@@ -388,11 +440,25 @@ if (pz<0) {pz=0.0;
  Press=Mols*CONST_R*Temp/Volm;		 //now we can calculate true pressure
 };
 
+//drawn at full flow, the pressure falls as P/MaxP*MaxF grams per second
+double Tank::Rate()
+{ if ((!open)||(Volm<=0)||(MaxP<=0)||(mass<=0)) return 0;
+  return MaxF/MaxP*CONST_R*Temp/(Mn*Volm);
+};
+
 void Tank::PutMass(double i_mass, double i_temp) //add this much subst, at this temp;
 {double t_mass;
  t_mass=(i_mass*i_temp+mass*Temp) / (mass+i_mass);
  Temp=t_mass;
- mass+=i_mass;
+ AddMass(i_mass);
+};
+
+//mass is a float: at short steps, what a step moves can be below its
+//resolution, and would be lost. keep what rounding leaves out for later
+void Tank::AddMass(double i_mass)
+{double m=mass+MassRest+i_mass;
+ mass=(float)m;
+ MassRest=m-mass;
 };
 
 void Tank::Save(FILEHANDLE scn)
@@ -405,6 +471,7 @@ void Tank::Load(FILEHANDLE scn)
    char *line;
    oapiReadScenario_nextline (scn, line);
    sscanf (line,"    TANK %i %f %f %f", &open,&pz,&mass,&Temp);
+   MassRest=0.0;
 
 }
 
@@ -428,7 +495,6 @@ void VentValve::Set(VESSEL *i_vessel,vector3 i_p,vector3 i_dir,float w,float h ,
 
 void VentValve::refresh(double dt)
 { Valve::refresh(dt);
-  float flow;
   mass=0.0;
   if (open)  mass=SRC->Flow(MaxF,dt);
   
@@ -456,17 +522,29 @@ void PressValve::refresh(double dt)
 float dv;
 	if ((open) && (tTRG->Volm>0.01) && (tTRG->Press<tSRC->Press))
 		{ dv=dt*MaxF*(tSRC->Press - tTRG->Press)/101.325;
+		if (clamp_flow)
+			{//P*V stays constant in both, so the pressures meet at about
+			 float dv_eq=(tSRC->Press-tTRG->Press)/(tSRC->Press/tSRC->Volm+tTRG->Press/tTRG->Volm);
+			 if (dv>dv_eq) dv=dv_eq;
+			 if (dv>tTRG->Volm-0.01) dv=tTRG->Volm-0.01;
+			}
 		tSRC->Volm+=dv;
 		tTRG->Volm-=dv;
 		}
 
 };
 
+//pressure valve: P*V stays constant in both tanks
+double PressValve::Rate()
+{ if ((!open)||(tSRC->Volm<=0.01)||(tTRG->Volm<=0.01)) return 0;
+  return MaxF/101.325*(tSRC->Press/tSRC->Volm+tTRG->Press/tTRG->Volm);
+};
+
 Room::Room(vector3 i_pos,float volm,Valve *i_SRC):Tank(i_pos,volm)
 {SRC=i_SRC;
 };
 void Room::FillTank(float i_c,float i_kg,float temp,float moln,float min,float max,float fl)
-{ c=i_c;Mn=moln;mass=i_kg;MinP=min;MaxP=max;
+{ c=i_c;Mn=moln;mass=i_kg;MassRest=0.0;MinP=min;MaxP=max;
   SetTemp(temp);MaxF=fl;Temp=temp;
   Mols=mass/Mn;
   Press=Mols*CONST_R*GetTemp()/Volm;
@@ -481,14 +559,14 @@ void Room::refresh(double dt)
 if (pz<0)
 { pz+=dt; 
 if (pz>0) {pz=0.0;
-			open=0;
+			open=0;H_system::StateChanges++;
 			}
 }
 
 if (pz>0)
 {pz-=dt;
 if (pz<0) {pz=0.0;
-			open=1;
+			open=1;H_system::StateChanges++;
 			}
 }
 //but also with some press computations;
@@ -500,8 +578,21 @@ if (pz<0) {pz=0.0;
   energy=0.0;
  Press=Mols*CONST_R*Temp/Volm;		 //now we can calculate true pressure
  if (Press<SRC->Press) {	//we can flow some stuff
-						P2=SRC->Flow(SRC->MaxF*((SRC->Press-Press)/101.3)/10,dt);
+						P2=SRC->MaxF*((SRC->Press-Press)/101.3)/10;
+						if (clamp_flow)
+							{//grams that bring us up to the source pressure
+							 float m_eq=(SRC->Press-Press)*Volm*Mn/(CONST_R*Temp);
+							 if (P2*dt>m_eq) P2=m_eq/dt;
+							}
+						P2=SRC->Flow(P2,dt);
 					//mass+=P2*dt;
 						PutMass(P2*dt,SRC->Temp);
 						};
-};
\ No newline at end of file
+};
+//a room drains like a tank, and fills from its source at
+//SRC->MaxF/1013 grams per second and kPa of difference
+double Room::Rate()
+{ double r=Tank::Rate();
+  if ((SRC)&&(Volm>0)&&(mass>0)) r+=SRC->MaxF/1013.0*CONST_R*Temp/(Mn*Volm);
+  return r;
+};
@@ -16,14 +16,22 @@
 #define N2_MMASS				28
 #define CO2_MMASS			44
 
+//integration modes for H_system
+#define H_EXPLICIT			0	//one explicit step per frame
+#define H_SUBSTEP			1	//sub-stepped, with flows clamped at equilibrium
+#define H_MAXSUBSTEPS		64	//default limit on sub-steps per frame
+
 #include "thermal.h"
 #include "orbitersdk.h"
 //base class for hydraulical objects
 class h_object:public therm_obj
 { public:
 	h_object *next;
+	int clamp_flow;	//never move more than it takes to reach equilibrium
 	h_object();
+	virtual ~h_object() {};
 	virtual void refresh(double dt);
+	virtual double Rate();	//fastest relaxation rate (1/sec), for the sub-steps
 	virtual void Load(FILEHANDLE scn);
 	virtual void Save(FILEHANDLE scn);
 };
@@ -31,10 +39,19 @@ class h_object:public therm_obj
 class H_system
 { public:
     h_object List;
+	int Integrator;		//H_EXPLICIT or H_SUBSTEP
+	double Courant;		//largest rate*step of a sub-step
+	int MaxSubSteps;	//limit on sub-steps per frame, 0 for none
+	double RateCache;	//fastest rate of all objects, as of StateSeen
+	int StateSeen;
+	static int StateChanges;	//bumped whenever an object opens, closes, starts or stops
 	H_system();
 	~H_system();
 	h_object* AddSystem(h_object *object);
+	void SetIntegrator(int mode,double courant=0.5,int max_sub=H_MAXSUBSTEPS);
+	int SubSteps(double dt,double rate=0);	//sub-steps for a frame, rate: from coupled systems
 	void Refresh(double dt);
+	void Step(double dt);	//one pass over all objects
 	void Load (FILEHANDLE scn);
 	void Save (FILEHANDLE scn);
 };
@@ -106,13 +123,16 @@ public:
 	float Mols;					//Number of mols of substance in the tank
 	float MinP,MaxP;			//operating pressure of the valve
 	float Freezing;				//freezing energy
+	double MassRest;			//what rounding left out of mass, booked with the next change
 	Tank();
 	Tank(vector3 i_pos, float volm); //where is the tank, what material, how heavy
 	virtual void FillTank(float i_c, float kg, float temp, float moln,float min,float max,float fl); //fill it up
 	virtual double Flow(double _need,float dt);
 	void Set(vector3 i_pos, float volm); //where is the tank, what material, how heavy
 	void refresh(double dt);
+	virtual double Rate();
 	void PutMass(double i_mass, double i_temp);
+	void AddMass(double i_mass);
 	virtual void Load(FILEHANDLE scn);
 	virtual void Save(FILEHANDLE scn);
 };	
@@ -140,12 +160,14 @@ public:
 	PressValve(int i_open,int ct,float i_maxf,Tank* i_SRC, Tank* I_TRG);
 	void Set(int i_open,int ct,float i_maxf,Tank* i_SRC, Tank* I_TRG);
 	void refresh(double dt);
+	virtual double Rate();
 };
 
 class Room:public Tank		//room is a kinda of a tank w/ source
 { public:
 	Room(vector3 i_pos, float volm,Valve *i_SRC); //where is the tank, what material, how heavy
     void refresh(double dt);
+	virtual double Rate();
 	virtual void FillTank(float i_c, float kg, float temp, float moln,float min,float max,float fl); //fill it up
 };
 
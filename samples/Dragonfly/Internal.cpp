@@ -667,6 +667,10 @@ H_systems.AddSystem(Valves[23]=new PValve(1,5,23.0,20.0,120,Valves[22])); //then
   //DC[1]->PLOAD(80);
   AC[0]->PLOAD(30);
 
+  //the life support rooms are stiff, so sub-step them to stay stable
+  //under time acceleration
+  H_systems.SetIntegrator(H_SUBSTEP,0.5,H_MAXSUBSTEPS);
+
   mjd_d=1;
 };
 
@@ -675,9 +679,16 @@ H_systems.AddSystem(Valves[23]=new PValve(1,5,23.0,20.0,120,Valves[22])); //then
 
 
 void ShipInternal::Refresh(double dt)
-{ 
-  H_systems.Refresh(dt);
-  E_systems.Refresh(dt);
+{ //the fans and fuel cells move gas too, so they take the same sub-steps
+  int n=H_systems.SubSteps(dt,E_systems.Rate());
+  double h=dt/n;
+  for (int i=0;i<n;i++) {H_systems.Step(h);
+						 E_systems.Step(h);
+						 //2 crew members use 0.075 grams of O2/sec
+						 float Lungs=Tanks[10]->Flow(0.075,h);
+						 Tanks[12]->PutMass(Lungs*h,Tanks[10]->Temp);
+						}
+  E_systems.Refresh(dt,0);
   if (mjd_d==1) {
   double mjd=oapiGetSimMJD();
   mjd=mjd-(int)mjd;
@@ -690,9 +701,6 @@ void ShipInternal::Refresh(double dt)
   int ss=(mjd-hh*3600-mm*60);
   sprintf(Clk->time,"%2i:%2i:%2i",hh,mm,ss);
   };
-//2 crew members use 0.075 grams of O2/sec
-  float Lungs=Tanks[10]->Flow(0.075,dt);
-  Tanks[12]->PutMass(Lungs*dt,Tanks[10]->Temp);
 	//cabin related stuff  
   float temp_press;
   Cabin_temp=(Tanks[10]->Temp+Tanks[12]->Temp+Tanks[11]->Temp)/3-273.3;
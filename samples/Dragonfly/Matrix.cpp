@@ -31,7 +31,6 @@ temp.p[_FF]=p[_FX]*m.p[_XF]+p[_FY]*m.p[_YF]+p[_FZ]*m.p[_ZF]+p[_FF]*m.p[_FF];
 
 vector3 matrix::operator * (vector3 &v)
 { vector3 temp;
-  double t1,t2,t3,t4;
  temp.x=p[_XX]*v.x+p[_XY]*v.y+p[_XZ]*v.z+p[_XF];
  temp.y=p[_YX]*v.x+p[_YY]*v.y+p[_YZ]*v.z+p[_XF];
  temp.z=p[_ZX]*v.x+p[_ZY]*v.y+p[_ZZ]*v.z+p[_ZF];
@@ -126,9 +125,9 @@ return det;
 void matrix::trans(float ax,float ay,float az)
 {
 identity();
-p[14]=az;
-p[15]=ay;
-p[16]=ax;
+p[_XF]=ax;
+p[_YF]=ay;
+p[_ZF]=az;
 }
 
 void matrix::setrot(float theta,vector3 axis)
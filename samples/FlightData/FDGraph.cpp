@@ -14,92 +14,77 @@
 
 extern VESSEL *g_VESSEL;
 
-void FlightDataGraph::AppendDataPoint (FILE *f)
+// log column headers and formats for each data type
+static const FDLogChannel fdchannel[9][2] = {
+	{{"_______ALT", " %10.4f"}},                               // altitude
+	{{"_AIRSPEED", " %9.2f"}},                                 // airspeed
+	{{"__MACH", " %6.2f"}},                                    // Mach number
+	{{"___TEMP", " %7.1f"}},                                   // temperature
+	{{"_______STP", " %10.4f"}, {"_______DNP", " %10.4f"}},    // pressure
+	{{"____AOA", " %7.1f"}, {"___SLIP", " %7.1f"}},            // AOA
+	{{"_____LIFT", " %9.2f"}, {"_____DRAG", " %9.2f"}},        // lift and drag
+	{{"_____L/D", " %8.3f"}},                                  // L/D
+	{{"____MASS", " %8.0f"}}                                   // mass
+};
+
+int FlightDataGraph::AppendDataPoint (double *val)
 {
-	double dp;
+	double dp = 0.0;
 	float dp2[2];
 
 	switch (dtype) {
 	case 0: // altitude
 		dp = g_VESSEL->GetAltitude() * 0.001;
-		if (f) fprintf (f, " %10.4f", dp);
-		Graph::AppendDataPoint ((float)dp);
-		return;
+		break;
 	case 1: // airspeed
 		dp = g_VESSEL->GetAirspeed();
-		if (f) fprintf (f, " %9.2f", dp);
-		Graph::AppendDataPoint ((float)dp);
-		return;
+		break;
 	case 2: // Mach number
 		dp = g_VESSEL->GetMachNumber();
-		if (f) fprintf (f, " %6.2f", dp);
-		Graph::AppendDataPoint ((float)dp);
-		return;
+		break;
 	case 3: // temperature
 		dp = g_VESSEL->GetAtmTemperature();
-		if (f) fprintf (f, " %7.1f", dp);
-		Graph::AppendDataPoint ((float)dp);
-		return;
+		break;
 	case 4: // pressure
 		dp2[0] = (float)(g_VESSEL->GetAtmPressure() * 0.001);
 		dp2[1] = (float)(g_VESSEL->GetDynPressure() * 0.001);
-		if (f) fprintf (f, " %10.4f %10.4f", dp2[0], dp2[1]);
-		Graph::AppendDataPoints (dp2);
-		return;
+		break;
 	case 5: // AOA
 		dp2[0] = (float)(g_VESSEL->GetAOA()*DEG);
 		dp2[1] = (float)(g_VESSEL->GetSlipAngle()*DEG);
-		if (f) fprintf (f, " %7.1f %7.1f", dp2[0], dp2[1]);
-		Graph::AppendDataPoints (dp2);
-		return;
+		break;
 	case 6: // lift and drag
 		dp2[0] = (float)(g_VESSEL->GetLift() * 0.001);
 		dp2[1] = (float)(g_VESSEL->GetDrag() * 0.001);
-		if (f) fprintf (f, " %9.2f %9.2f", dp2[0], dp2[1]);
-		Graph::AppendDataPoints (dp2);
-		return;
+		break;
 	case 7: // L/D
 		dp = (g_VESSEL->GetDrag() ? g_VESSEL->GetLift()/g_VESSEL->GetDrag() : 0.0);
-		if (f) fprintf (f, " %8.3f", dp);
-		Graph::AppendDataPoint ((float)dp);
-		return;
+		break;
 	case 8: // Mass
 		dp = g_VESSEL->GetMass();
-		if (f) fprintf (f, " %8.0f", dp);
+		break;
+	default:
+		return 0;
+	}
+
+	switch (dtype) {
+	case 4:
+	case 5:
+	case 6:
+		if (val) val[0] = dp2[0], val[1] = dp2[1];
+		Graph::AppendDataPoints (dp2);
+		return 2;
+	default:
+		if (val) val[0] = dp;
 		Graph::AppendDataPoint ((float)dp);
-		return;
+		return 1;
 	}
 }
 
-void FlightDataGraph::WriteHeader (FILE *f)
+int FlightDataGraph::GetChannels (FDLogChannel *ch) const
 {
-	switch (dtype) {
-	case 0: // altitude
-		fprintf (f, " _______ALT");
-		return;
-	case 1: // airspeed
-		fprintf (f, " _AIRSPEED");
-		return;
-	case 2: // Mach number
-		fprintf (f, " __MACH");
-		return;
-	case 3: // temperature
-		fprintf (f, " ___TEMP");
-		return;
-	case 4: // pressure
-		fprintf (f, " _______STP _______DNP");
-		return;
-	case 5: // AOA
-		fprintf (f, " ____AOA ___SLIP");
-		return;
-	case 6: // lift and drag
-		fprintf (f, " _____LIFT _____DRAG");
-		return;
-	case 7: // L/D
-		fprintf (f, " _____L/D");
-		return;
-	case 8: // mass
-		fprintf (f, " ____MASS");
-		return;
-	}
+	if (dtype < 0 || dtype >= 9) return 0;
+	int n = (fdchannel[dtype][1].label[0] ? 2 : 1);
+	memcpy (ch, fdchannel[dtype], n*sizeof(FDLogChannel));
+	return n;
 }
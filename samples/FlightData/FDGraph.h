@@ -12,14 +12,18 @@
 #define __FDGRAPH_H
 
 #include "Graph.h"
-#include "stdio.h"
+#include "FDLog.h"
 
 class FlightDataGraph: public Graph {
 public:
-	FlightDataGraph (int _dtype, int _nplot = 1): Graph (_nplot), dtype(_dtype) {}
+	FlightDataGraph (int _dtype, int _nplot = 1, DWORD _budget = GRAPH_BUDGET)
+		: Graph (_nplot, _budget), dtype(_dtype) {}
 	int DType() const { return dtype; }
-	void AppendDataPoint (FILE *f = 0);
-	void WriteHeader (FILE *f);
+	// sample the vessel, append to the graph and store the sampled
+	// values in val (if provided); returns the number of values
+	int AppendDataPoint (double *val = 0);
+	// log column descriptions; returns the number of columns
+	int GetChannels (FDLogChannel *ch) const;
 
 private:
 	int dtype;
@@ -0,0 +1,300 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData
+//                  Part of the ORBITER SDK
+//            Copyright (C) 2003 Martin Schweiger
+//                   All rights reserved
+//
+// FDLog.cpp
+// Flight data log file writer implementation.
+//
+// Binary log format:
+//   file header:    char[8] "FDLOGBIN"
+//   segment start:  DWORD 1, DWORD namelen, char name[namelen],
+//                   DWORD nch, FDLogChannel ch[nch]
+//   sample:         DWORD 2, double simt, double val[nch]
+//   segment end:    DWORD 3, DWORD namelen, char name[namelen]
+// Names are truncated to FDLOG_MAXNAME characters in both formats, so
+// a converted binary log is identical to the text log.
+// ==============================================================
+
+#include "FDLog.h"
+#include <process.h>
+#include <string.h>
+
+static const char binmagic[8] = {'F','D','L','O','G','B','I','N'};
+
+#define TAG_BEGIN 1
+#define TAG_DATA  2
+#define TAG_END   3
+
+// ==============================================================
+
+FlightDataLog::FlightDataLog (DWORD _nbuf)
+{
+	nbuf = _nbuf;
+	buf = new FDLogRecord[nbuf];
+	head = tail = 0;
+	ndropped = 0;
+	hThread = 0;
+	hData = CreateEvent (NULL, FALSE, FALSE, NULL);
+	hDrained = CreateEvent (NULL, FALSE, FALSE, NULL);
+	quit = false;
+	f = 0;
+	binary = false;
+	nch = 0;
+}
+
+// --------------------------------------------------------------
+
+FlightDataLog::~FlightDataLog ()
+{
+	Close();
+	CloseHandle (hData);
+	CloseHandle (hDrained);
+	delete []buf;
+}
+
+// --------------------------------------------------------------
+
+bool FlightDataLog::Open (const char *fname, bool _binary, bool reset)
+{
+	if (f) Close();
+	binary = _binary;
+	if (binary) f = fopen (fname, reset ? "wb":"ab");
+	else        f = fopen (fname, reset ? "wt":"at");
+	if (!f) return false;
+	if (reset) {
+		if (binary) fwrite (binmagic, 1, 8, f);
+		else        WritePreamble (f);
+	}
+
+	head = tail = 0;
+	ndropped = 0;
+	nch = 0;
+	quit = false;
+	unsigned int id;
+	hThread = (HANDLE)_beginthreadex (NULL, 4096, &WriterProc, this, 0, &id);
+	return true;
+}
+
+// --------------------------------------------------------------
+
+void FlightDataLog::Close ()
+{
+	if (!f) return;
+	quit = true;
+	SetEvent (hData);
+	WaitForSingleObject (hThread, INFINITE); // writer drains the queue before exiting
+	CloseHandle (hThread);
+	hThread = 0;
+	fclose (f);
+	f = 0;
+}
+
+// --------------------------------------------------------------
+
+void FlightDataLog::BeginSegment (const char *vessel, DWORD _nch, const FDLogChannel *_ch)
+{
+	if (!f) return;
+	Flush();
+	nch = min (_nch, (DWORD)FDLOG_MAXCHANNEL);
+	memcpy (ch, _ch, nch*sizeof(FDLogChannel));
+
+	DWORD i;
+	if (binary) {
+		DWORD tag = TAG_BEGIN, len = min ((DWORD)strlen (vessel), (DWORD)FDLOG_MAXNAME);
+		fwrite (&tag, sizeof(DWORD), 1, f);
+		fwrite (&len, sizeof(DWORD), 1, f);
+		fwrite (vessel, 1, len, f);
+		fwrite (&nch, sizeof(DWORD), 1, f);
+		fwrite (ch, sizeof(FDLogChannel), nch, f);
+	} else {
+		fprintf (f, "# Log started for %.255s\n", vessel);
+		fprintf (f, "# ____TIME");
+		for (i = 0; i < nch; i++)
+			fprintf (f, " %s", ch[i].label);
+		fprintf (f, "\n");
+	}
+	fflush (f);
+}
+
+// --------------------------------------------------------------
+
+void FlightDataLog::EndSegment (const char *vessel)
+{
+	if (!f) return;
+	Flush();
+	if (binary) {
+		DWORD tag = TAG_END, len = min ((DWORD)strlen (vessel), (DWORD)FDLOG_MAXNAME);
+		fwrite (&tag, sizeof(DWORD), 1, f);
+		fwrite (&len, sizeof(DWORD), 1, f);
+		fwrite (vessel, 1, len, f);
+	} else {
+		fprintf (f, "# Log stopped for %.255s\n", vessel);
+	}
+	fflush (f);
+}
+
+// --------------------------------------------------------------
+
+bool FlightDataLog::Push (double simt, const double *val)
+{
+	LONG h = head;
+	if (h - tail >= (LONG)nbuf) { // queue full
+		ndropped++;
+		return false;
+	}
+	FDLogRecord &rec = buf[h % nbuf];
+	rec.simt = simt;
+	memcpy (rec.val, val, nch*sizeof(double));
+	InterlockedExchange (&head, h+1); // publish the record
+	SetEvent (hData);
+	return true;
+}
+
+// --------------------------------------------------------------
+// Wait until the writer thread has written all queued samples
+// --------------------------------------------------------------
+void FlightDataLog::Flush ()
+{
+	while (tail != head) {
+		SetEvent (hData);
+		WaitForSingleObject (hDrained, INFINITE);
+	}
+}
+
+// --------------------------------------------------------------
+
+void FlightDataLog::WriteRecord (const FDLogRecord &rec)
+{
+	DWORD i;
+	if (binary) {
+		DWORD tag = TAG_DATA;
+		fwrite (&tag, sizeof(DWORD), 1, f);
+		fwrite (&rec.simt, sizeof(double), 1, f);
+		fwrite (rec.val, sizeof(double), nch, f);
+	} else {
+		fprintf (f, "%10.2f", rec.simt);
+		for (i = 0; i < nch; i++)
+			fprintf (f, ch[i].fmt, rec.val[i]);
+		fprintf (f, "\n");
+	}
+}
+
+// --------------------------------------------------------------
+
+unsigned int WINAPI FlightDataLog::WriterProc (LPVOID context)
+{
+	FlightDataLog *log = (FlightDataLog*)context;
+	for (;;) {
+		WaitForSingleObject (log->hData, 100);
+		bool done = log->quit;     // read before draining, so no sample is left behind
+		LONG t = log->tail;
+		if (t != log->head) {
+			do {
+				log->WriteRecord (log->buf[t % log->nbuf]);
+				InterlockedExchange (&log->tail, ++t);
+			} while (t != log->head);
+			fflush (log->f);
+			SetEvent (log->hDrained);
+		}
+		if (done) break;
+	}
+	return 0;
+}
+
+// --------------------------------------------------------------
+
+void FlightDataLog::WritePreamble (FILE *f)
+{
+	fprintf (f, "Orbiter Flight Data Log Record\n");
+	fprintf (f, "==============================\n");
+	fprintf (f, "Columns:\n");
+	fprintf (f, "\tTIME:     simulation time (seconds)\n");
+	fprintf (f, "\tALT:      altitude (km)\n");
+	fprintf (f, "\tAIRSPEED: airspeed (m/s)\n");
+	fprintf (f, "\tMACH:     Mach number\n");
+	fprintf (f, "\tTEMP:     freestream temperature (K)\n");
+	fprintf (f, "\tSTP:      static pressure (kPa)\n");
+	fprintf (f, "\tDNP:      dynamic pressure (kPa)\n");
+	fprintf (f, "\tAOA:      angle of attack (deg)\n");
+	fprintf (f, "\tSLIP:     horizontal slip angle (deg)\n");
+	fprintf (f, "\tLIFT:     total lift force (kN)\n");
+	fprintf (f, "\tDRAG:     total drag force (kN)\n");
+	fprintf (f, "\tL/D:      lift/drag ratio\n");
+	fprintf (f, "\tMASS:     vessel mass (kg)\n\n");
+}
+
+// --------------------------------------------------------------
+// Reads a binary log and writes it in the format of the text log
+// --------------------------------------------------------------
+bool FlightDataLog::Convert (const char *binfile, const char *txtfile)
+{
+	char magic[8], name[FDLOG_MAXNAME+1];
+	DWORD i, tag, n = 0;
+	FDLogChannel c[FDLOG_MAXCHANNEL];
+	double t, v[FDLOG_MAXCHANNEL];
+	bool ok = true;
+
+	FILE *fb = fopen (binfile, "rb");
+	if (!fb) return false;
+	if (fread (magic, 1, 8, fb) != 8 || memcmp (magic, binmagic, 8)) {
+		fclose (fb);
+		return false;
+	}
+	FILE *ft = fopen (txtfile, "wt");
+	if (!ft) {
+		fclose (fb);
+		return false;
+	}
+	WritePreamble (ft);
+
+	while (ok && fread (&tag, sizeof(DWORD), 1, fb) == 1) {
+		switch (tag) {
+		case TAG_BEGIN:
+			if (!(ok = ReadName (fb, name))) break;
+			if (!(ok = (fread (&n, sizeof(DWORD), 1, fb) == 1 && n <= FDLOG_MAXCHANNEL &&
+				fread (c, sizeof(FDLogChannel), n, fb) == n))) break;
+			for (i = 0; i < n; i++) // labels and formats must be terminated
+				c[i].label[15] = c[i].fmt[15] = '\0';
+			fprintf (ft, "# Log started for %s\n", name);
+			fprintf (ft, "# ____TIME");
+			for (i = 0; i < n; i++)
+				fprintf (ft, " %s", c[i].label);
+			fprintf (ft, "\n");
+			break;
+		case TAG_DATA:
+			if (!(ok = (fread (&t, sizeof(double), 1, fb) == 1 &&
+				fread (v, sizeof(double), n, fb) == n))) break;
+			fprintf (ft, "%10.2f", t);
+			for (i = 0; i < n; i++)
+				fprintf (ft, c[i].fmt, v[i]);
+			fprintf (ft, "\n");
+			break;
+		case TAG_END:
+			if (!(ok = ReadName (fb, name))) break;
+			fprintf (ft, "# Log stopped for %s\n", name);
+			break;
+		default: // corrupt file
+			ok = false;
+			break;
+		}
+	}
+	fclose (fb);
+	fclose (ft);
+	return ok;
+}
+
+// --------------------------------------------------------------
+// Reads a length-prefixed vessel name written by BeginSegment or
+// EndSegment. Lengths beyond FDLOG_MAXNAME can't have been written
+// by the logger and indicate a corrupt file.
+// --------------------------------------------------------------
+bool FlightDataLog::ReadName (FILE *f, char *name)
+{
+	DWORD len;
+	if (fread (&len, sizeof(DWORD), 1, f) != 1 || len > FDLOG_MAXNAME ||
+		fread (name, 1, len, f) != len) return false;
+	name[len] = '\0';
+	return true;
+}
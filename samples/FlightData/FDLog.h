@@ -0,0 +1,102 @@
+// ==============================================================
+//                 ORBITER MODULE: FlightData
+//                  Part of the ORBITER SDK
+//            Copyright (C) 2003 Martin Schweiger
+//                   All rights reserved
+//
+// FDLog.h
+// Flight data log file writer interface.
+// ==============================================================
+
+#ifndef __FDLOG_H
+#define __FDLOG_H
+
+#include <windows.h>
+#include <stdio.h>
+
+const int FDLOG_MAXCHANNEL = 16;  // max number of data columns per record
+const int FDLOG_MAXNAME    = 255; // max vessel name length stored in the log
+
+// ==============================================================
+// Description of a log column
+
+struct FDLogChannel {
+	char label[16];   // column header (without leading separator)
+	char fmt[16];     // printf format for the text log, including separator
+};
+
+// ==============================================================
+// A single sample
+
+struct FDLogRecord {
+	double simt;                    // simulation time
+	double val[FDLOG_MAXCHANNEL];   // channel values
+};
+
+// ==============================================================
+// Flight data log writer
+//
+// Samples are queued by the simulation thread in a single-producer,
+// single-consumer ring buffer without locking, and written to file by
+// a background thread. The log is either written in the text format,
+// or in a binary format of fixed-size records that can be converted
+// to the text format later (see Convert).
+//
+// Header functions (BeginSegment, EndSegment) wait until the queue is
+// drained and then write directly, so header and sample lines appear
+// in the file in the order in which they were issued.
+
+class FlightDataLog {
+public:
+	FlightDataLog (DWORD _nbuf = 4096);
+	~FlightDataLog ();
+
+	// Open the log file and start the writer thread. If reset is true,
+	// the file is overwritten and the file header is written, otherwise
+	// the log is appended to an existing file.
+	bool Open (const char *fname, bool _binary, bool reset);
+
+	// Drain the queue, stop the writer thread and close the file.
+	void Close ();
+
+	inline bool IsOpen () const { return f != 0; }
+
+	// Start a new log segment for a vessel with the given data columns
+	void BeginSegment (const char *vessel, DWORD _nch, const FDLogChannel *_ch);
+
+	// Terminate the current log segment
+	void EndSegment (const char *vessel);
+
+	// Queue a sample of the current segment (simulation thread).
+	// Returns false if the queue is full and the sample was dropped.
+	bool Push (double simt, const double *val);
+
+	// Number of samples dropped because of a full queue
+	inline DWORD Dropped () const { return ndropped; }
+
+	// Convert a binary log file to the text log format
+	static bool Convert (const char *binfile, const char *txtfile);
+
+private:
+	void Flush ();
+	void WriteRecord (const FDLogRecord &rec);
+	static void WritePreamble (FILE *f);
+	static bool ReadName (FILE *f, char *name);
+	static unsigned int WINAPI WriterProc (LPVOID context);
+
+	FDLogRecord *buf;          // sample queue
+	DWORD nbuf;                // queue length
+	volatile LONG head;        // number of samples queued (producer)
+	volatile LONG tail;        // number of samples written (consumer)
+	DWORD ndropped;            // samples dropped on full queue
+	HANDLE hThread;            // writer thread
+	HANDLE hData;              // signalled when samples were queued
+	HANDLE hDrained;           // signalled when the writer has written queued samples
+	volatile bool quit;        // writer thread termination flag
+	FILE *f;                   // log file
+	bool binary;               // binary log format
+	DWORD nch;                 // number of channels in the current segment
+	FDLogChannel ch[FDLOG_MAXCHANNEL]; // channels of the current segment
+};
+
+#endif // !__FDLOG_H
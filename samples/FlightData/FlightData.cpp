@@ -16,6 +16,7 @@
 #include "orbitersdk.h"
 #include "resource.h"
 #include "FDGraph.h"
+#include "FDLog.h"
 
 #define NGRAPH 9
 #define NRATE 4
@@ -34,14 +35,21 @@ double g_DT;                // sample interval
 bool g_bRecording;          // recorder on/off
 bool g_bLogging;            // log to file on/off
 static bool g_bResetLog = true;
+static bool g_bBinaryLog = false;   // write binary log, convert to text at end of session
+static bool g_bBinaryWritten = false;
+static DWORD g_RecBudget = GRAPH_BUDGET; // recorder storage per graph [bytes]
+FlightDataLog g_Log;                // log file writer
 
 static char *desc = "Open a window to track flight parameters of a spacecraft.";
 static char *logfile = "FlightData.log";
+static char *binfile = "FlightData.bin";
+static char *cfgfile = "FlightData.cfg";
 
 // ==============================================================
 // Local prototypes
 
 void OpenDlgClbk (void *context);
+void WriteLogHeader (bool start);
 BOOL CALLBACK MsgProc (HWND, UINT, WPARAM, LPARAM);
 long FAR PASCAL Graph_WndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
@@ -70,6 +78,16 @@ DLLCLBK void InitModule (HINSTANCE hDLL)
 	RegisterClass (&wndClass);
 
 	Graph::InitGDI();
+
+	// read module configuration
+	FILEHANDLE hFile = oapiOpenFile (cfgfile, FILE_IN, CONFIG);
+	if (hFile) {
+		int budget;
+		oapiReadItem_bool (hFile, "BinaryLog", g_bBinaryLog);
+		if (oapiReadItem_int (hFile, "RecorderBudget", budget) && budget > 0)
+			g_RecBudget = (DWORD)budget * 1024; // [kB]
+		oapiCloseFile (hFile, FILE_IN);
+	}
 }
 
 DLLCLBK void ExitModule (HINSTANCE hDLL)
@@ -89,25 +107,31 @@ DLLCLBK void opcPreStep (double simt, double simdt, double mjd)
 
 	if (syst >= g_T+g_DT) {
 
-		FILE *f = 0;
-		if (g_bLogging) {
-			f = fopen (logfile, "at");
-			fprintf (f, "%10.2f", simt);
-		}
+		double val[FDLOG_MAXCHANNEL];
+		DWORD i, n;
+		for (i = n = 0; i < g_nGraph; i++)
+			n += g_Graph[i]->AppendDataPoint (val+n);
 
-		for (DWORD i = 0; i < g_nGraph; i++)
-			g_Graph[i]->AppendDataPoint (f);
-
-		if (f) {
-			fprintf (f, "\n");
-			fclose (f);
-		}
+		if (g_Log.IsOpen())
+			g_Log.Push (simt, val);
 
 		g_T = syst;
 		InvalidateRect (GetDlgItem (g_hDlg, IDC_GRAPH), NULL, TRUE);
 	}
 }
 
+DLLCLBK void opcCloseRenderViewport ()
+{
+	// terminate a running log before the dialog is destroyed
+	if (g_Log.IsOpen()) WriteLogHeader (false);
+
+	// produce the text log from the binary log of this session
+	if (g_bBinaryWritten) {
+		FlightDataLog::Convert (binfile, logfile);
+		g_bBinaryWritten = false;
+	}
+}
+
 void OpenDlgClbk (void *context)
 {
 	HWND hDlg = oapiOpenDialog (g_hInst, IDD_FLIGHTDATA, MsgProc);
@@ -167,9 +191,9 @@ void AddGraph (HWND hDlg, int which)
 	case 4:
 	case 5:
 	case 6:
-		g_Graph[g_nGraph] = new FlightDataGraph (which, 2); break;
+		g_Graph[g_nGraph] = new FlightDataGraph (which, 2, g_RecBudget); break;
 	default:
-		g_Graph[g_nGraph] = new FlightDataGraph (which); break;
+		g_Graph[g_nGraph] = new FlightDataGraph (which, 1, g_RecBudget); break;
 	}
 	LoadString (g_hInst, IDS_DATA+which, cbuf, 256);
 	g_Graph[g_nGraph]->SetTitle (cbuf);
@@ -213,36 +237,19 @@ void DelGraph (HWND hDlg, int which)
 
 void WriteLogHeader (bool start)
 {
-	FILE *f = fopen (logfile, g_bResetLog ? "wt":"at");
-	if (g_bResetLog) {
-		fprintf (f, "Orbiter Flight Data Log Record\n");
-		fprintf (f, "==============================\n");
-		fprintf (f, "Columns:\n");
-		fprintf (f, "\tTIME:     simulation time (seconds)\n");
-		fprintf (f, "\tALT:      altitude (km)\n");
-		fprintf (f, "\tAIRSPEED: airspeed (m/s)\n");
-		fprintf (f, "\tMACH:     Mach number\n");
-		fprintf (f, "\tTEMP:     freestream temperature (K)\n");
-		fprintf (f, "\tSTP:      static pressure (kPa)\n");
-		fprintf (f, "\tDNP:      dynamic pressure (kPa)\n");
-		fprintf (f, "\tAOA:      angle of attack (deg)\n");
-		fprintf (f, "\tSLIP:     horizontal slip angle (deg)\n");
-		fprintf (f, "\tLIFT:     total lift force (kN)\n");
-		fprintf (f, "\tDRAG:     total drag force (kN)\n");
-		fprintf (f, "\tL/D:      lift/drag ratio\n");
-		fprintf (f, "\tMASS:     vessel mass (kg)\n\n");
-		g_bResetLog = false;
-	}
 	if (start) {
-		fprintf (f, "# Log started for %s\n", g_VESSEL->GetName());
-		fprintf (f, "# ____TIME");
-		for (DWORD i = 0; i < g_nGraph; i++)
-			g_Graph[i]->WriteHeader (f);
-		fprintf (f, "\n");
+		FDLogChannel ch[FDLOG_MAXCHANNEL];
+		DWORD i, n;
+		if (!g_Log.Open (g_bBinaryLog ? binfile : logfile, g_bBinaryLog, g_bResetLog)) return;
+		if (g_bBinaryLog) g_bBinaryWritten = true;
+		g_bResetLog = false;
+		for (i = n = 0; i < g_nGraph; i++)
+			n += g_Graph[i]->GetChannels (ch+n);
+		g_Log.BeginSegment (g_VESSEL->GetName(), n, ch);
 	} else {
-		fprintf (f, "# Log stopped for %s\n", g_VESSEL->GetName());
+		g_Log.EndSegment (g_VESSEL->GetName());
+		g_Log.Close ();
 	}
-	fclose (f);
 }
 
 // =================================================================================
@@ -363,6 +370,11 @@ long FAR PASCAL Graph_WndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 			EndPaint (hWnd, &ps);
 		}
 		break;
+	case WM_RBUTTONUP: // toggle between recent samples and full recorded history
+		for (DWORD i = 0; i < g_nGraph; i++)
+			g_Graph[i]->SetWindow (g_Graph[i]->GetWindow() ? 0 : NDATA);
+		InvalidateRect (hWnd, NULL, TRUE);
+		return 0;
 	}
 	return DefWindowProc (hWnd, uMsg, wParam, lParam);
 }
@@ -19,11 +19,10 @@ using namespace std;
 
 static COLORREF plotcol[MAXPLOT] = {0x0000ff, 0xff0000, 0x00ff00};
 
-Graph::Graph (int _nplot): nplot(_nplot)
+Graph::Graph (int _nplot, DWORD _budget): nplot(_nplot)
 {
-	data = new float*[nplot];
-	for (int i = 0; i < nplot; i++)
-		data[i] = new float[NDATA];
+	rec = new DataRecorder (nplot, _budget);
+	window = NDATA;
 	ResetData();
 	title = 0;
 	xlabel = 0;
@@ -34,9 +33,7 @@ Graph::Graph (int _nplot): nplot(_nplot)
 
 Graph::~Graph()
 {
-	for (int i = 0; i < nplot; i++)
-		delete []data[i];
-	delete []data;
+	delete rec;
 
 	if (title) delete []title;
 	if (xlabel) delete []xlabel;
@@ -100,16 +97,15 @@ void Graph::SetLegend (const char *_legend)
 
 void Graph::ResetData ()
 {
-	ndata = idx = 0;
+	rec->Reset();
+	nsample = 0;
 	vmin = vmax = data_tickmin = 0.0;
 	data_dtick = 1.0;
 }
 
 void Graph::AppendDataPoint (float val)
 {
-	data[0][idx] = val;
-	idx = (idx+1)%NDATA;
-	if (ndata < NDATA) ndata++;
+	rec->Append ((double)nsample++, &val);
 	float vmn = vmin, vmx = vmax;
 	SetAutoRange ();
 	if (vmn != vmin || vmx != vmax) SetAutoTicks();
@@ -117,27 +113,41 @@ void Graph::AppendDataPoint (float val)
 
 void Graph::AppendDataPoints (float *val)
 {
-	for (int p = 0; p < nplot; p++)
-		data[p][idx] = val[p];
-	idx = (idx+1)%NDATA;
-	if (ndata < NDATA) ndata++;
+	rec->Append ((double)nsample++, val);
 	float vmn = vmin, vmx = vmax;
 	SetAutoRange ();
 	if (vmn != vmin || vmx != vmax) SetAutoTicks();
 }
 
-void Graph::SetAutoRange ()
+void Graph::SetWindow (DWORD _window)
+{
+	window = _window;
+	float vmn = vmin, vmx = vmax;
+	SetAutoRange ();
+	if (vmn != vmin || vmx != vmax) SetAutoTicks();
+}
+
+// sample range displayed by the graph
+void Graph::TimeWindow (double &t0, double &t1) const
 {
-	int p, i;
+	t1 = rec->TEnd();
+	t0 = (window ? t1-window : rec->TStart());
+}
 
-	vmin = (ndata ? data[0][0] : 0.0f);
-	vmax = (ndata ? data[0][0] : 0.0f);
+void Graph::SetAutoRange ()
+{
+	int p;
+	float pmin, pmax;
+	double t0, t1;
+	bool valid = false;
 
+	vmin = vmax = 0.0f;
+	TimeWindow (t0, t1);
 	for (p = 0; p < nplot; p++) {
-		for (i = 0; i < ndata; i++) {
-			if (data[p][i] < vmin) vmin = data[p][i];
-			if (data[p][i] > vmax) vmax = data[p][i];
-		}
+		if (!rec->Range (p, t0, t1, pmin, pmax)) continue;
+		if (!valid || pmin < vmin) vmin = pmin;
+		if (!valid || pmax > vmax) vmax = pmax;
+		valid = true;
 	}
 
 	if (vmax-vmin < 1e-6) vmin -= 0.5f, vmax += 0.5f;
@@ -174,7 +184,7 @@ void Graph::Refresh (HDC hDC, int w, int h)
 
 	HFONT pfont = (HFONT)SelectObject (hDC, gdi.font[0]);
 
-	if (ndata >= 2) {
+	if (nsample >= 2) {
 		float f, ys = dy/(vmax-vmin);
 		SelectObject (hDC, gdi.pen[0]);
 
@@ -201,16 +211,28 @@ void Graph::Refresh (HDC hDC, int w, int h)
 				}
 			}
 		}
-		// draw data
+		// draw data: one column of the displayed window per pixel, with
+		// the mean connected and the min/max range of the column marked
+		double t0, t1;
+		TimeWindow (t0, t1);
+		float *cmin = new float[3*dx], *cmax = cmin+dx, *cmean = cmax+dx;
 		for (p = 0; p < nplot; p++) {
 			SelectObject (hDC, gdi.pen[(p%MAXPLOT)+2]);
-			int j, i = idx-1; if (i < 0) i += NDATA;
-			MoveToEx (hDC, x1, y0 - (int)((data[p][i]-vmin)*ys+0.5), NULL);
-			for (j = 1; j < ndata; j++) {
-				i = idx-j-1; if (i < 0) i += NDATA;
-				LineTo (hDC, x1 - (dx*j)/NDATA, y0 - (int)((data[p][i]-vmin)*ys+0.5));
+			rec->Resample (p, t0, t1, dx, cmin, cmax, cmean);
+			bool start = true;
+			for (i = 0; i < dx; i++) {
+				if (cmin[i] > cmax[i]) continue; // no data in this column
+				y = y0 - (int)((cmean[i]-vmin)*ys+0.5);
+				if (start) MoveToEx (hDC, x0+i, y, NULL), start = false;
+				else       LineTo (hDC, x0+i, y);
+				if (cmax[i] > cmin[i]) {
+					MoveToEx (hDC, x0+i, y0 - (int)((cmin[i]-vmin)*ys+0.5), NULL);
+					LineTo (hDC, x0+i, y0 - (int)((cmax[i]-vmin)*ys+0.5)-1);
+					MoveToEx (hDC, x0+i, y, NULL);
+				}
 			}
 		}
+		delete []cmin;
 	}
 
 	// Draw axes
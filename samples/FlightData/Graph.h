@@ -12,9 +12,11 @@
 #define __GRAPH_H
 
 #include "windows.h"
+#include "../Common/DataRecorder.h"
 
 const int MAXPLOT = 3;
-const int NDATA = 200;
+const int NDATA = 200;              // samples displayed in the default window
+const DWORD GRAPH_BUDGET = 0x100000; // default recorder storage per graph [bytes]
 
 struct GDIres {
 	HFONT font[2];
@@ -23,7 +25,7 @@ struct GDIres {
 
 class Graph {
 public:
-	Graph (int _nplot = 1);
+	Graph (int _nplot = 1, DWORD _budget = GRAPH_BUDGET);
 	~Graph();
 	static void InitGDI ();
 	static void FreeGDI ();
@@ -34,22 +36,26 @@ public:
 	void ResetData();
 	void AppendDataPoint (float val);
 	void AppendDataPoints (float *val);
+	// number of most recent samples displayed (0: full recorded history)
+	void SetWindow (DWORD _window);
+	inline DWORD GetWindow () const { return window; }
 	void Refresh (HDC hDC, int w, int h);
 
 protected:
 	void SetAutoRange ();
 	void SetAutoTicks ();
+	void TimeWindow (double &t0, double &t1) const;
 
 private:
 	int nplot;
-	float **data;
+	DataRecorder *rec; // recorded samples of all plots
 	float vmin, vmax;
 	float data_tickscale;
 	float data_dtick;
 	float data_tickmin;
 	int data_minortick;
-	int ndata;
-	int idx;
+	DWORD nsample;     // number of samples appended
+	DWORD window;      // number of samples displayed (0: all)
 	char *title;
 	char *xlabel, *ylabel;
 	char *legend;
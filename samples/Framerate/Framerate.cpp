@@ -208,6 +208,11 @@ long FAR PASCAL Graph_WndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 		if (bShowGraph[idx]) g_Graph[idx]->Refresh (hDC, gw, gh);
 		EndPaint (hWnd, &ps);
 		} break;
+	case WM_RBUTTONUP: { // toggle between recent samples and full recorded history
+		int idx = GetWindowLong (hWnd, 0);
+		if (g_Graph[idx]) g_Graph[idx]->SetWindow (g_Graph[idx]->GetWindow() ? 0 : NDATA);
+		InvalidateRect (hWnd, NULL, TRUE);
+		} return 0;
 	}
 	return DefWindowProc (hWnd, uMsg, wParam, lParam);
 }
@@ -0,0 +1,185 @@
+// ==============================================================
+//                 ORBITER MODULE: KeplerPlanet
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// KeplerPlanet.cpp
+// Sample planet module: unperturbed two-body ephemerides from
+// orbital elements, returned in polar format, and a standard
+// atmosphere with batch evaluation.
+//
+// Notes:
+// The two-body solution stands in for the series solutions (VSOP87,
+// ELP2000) of real planet modules. clbkEphemeris returns the data of
+// the ephemeris file within its coverage and evaluates the solution
+// otherwise, and clbkFastEphemeris returns the interpolated data of
+// an EphemCache, which samples clbkEphemeris on a background thread
+// ahead of the simulation time.
+// ==============================================================
+
+#define STRICT
+#define ORBITER_MODULE
+
+#include "KeplerPlanet.h"
+#include "../Common/Kepler.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// ==============================================================
+// Default orbit: Mars, mean J2000 ecliptic elements
+// ==============================================================
+const double KP_SMA   = 2.27939186e11;    // semi-major axis [m]
+const double KP_ECC   = 0.09341233;       // eccentricity
+const double KP_INC   = 1.85061;          // inclination [deg]
+const double KP_LAN   = 49.57854;         // longitude of ascending node [deg]
+const double KP_LPE   = 336.04084;        // longitude of periapsis [deg]
+const double KP_MNL   = 355.45332;        // mean longitude at epoch [deg]
+const double KP_EPOCH = 51544.5;          // epoch [MJD]
+const double KP_GM    = 1.32712440018e20; // sun [m^3/s^2]
+
+// ==============================================================
+// Default atmosphere: Mars-like standard profile
+// ==============================================================
+const double KP_P0    = 610.0;            // ground pressure [Pa]
+const double KP_RHO0  = 0.020;            // ground density [kg/m^3]
+const double KP_R     = 188.92;           // specific gas constant [J/(K kg)]
+const double KP_GAMMA = 1.2941;           // ratio of specific heats
+const double KP_HMAX   = 200e3;           // altitude limit [m]
+const double KP_G0    = 3.711;            // surface gravity [m/s^2]
+
+// ==============================================================
+// KeplerPlanet class implementation
+// ==============================================================
+
+KeplerPlanet::KeplerPlanet (OBJHANDLE hBody): CELBODY2 (hBody)
+{
+	el.a      = KP_SMA;
+	el.e      = KP_ECC;
+	el.i      = KP_INC*RAD;
+	el.theta  = KP_LAN*RAD;
+	el.omegab = KP_LPE*RAD;
+	el.L      = KP_MNL*RAD;
+	mjd_el    = KP_EPOCH;
+	mu        = KP_GM;
+	cache     = 0;
+	ephfile   = 0;
+	atmcache  = 0;
+	atmsrc    = 0;
+
+	ATMCONST ac;
+	memset (&ac, 0, sizeof(ATMCONST));
+	ac.p0       = KP_P0;
+	ac.rho0     = KP_RHO0;
+	ac.R        = KP_R;
+	ac.gamma    = KP_GAMMA;
+	ac.altlimit = KP_HMAX;
+	SetAtmosphere (new StdAtmosphere (this, ac, KP_G0));
+}
+
+// --------------------------------------------------------------
+
+KeplerPlanet::~KeplerPlanet ()
+{
+	if (cache) delete cache; // stops the worker before ephfile goes
+	if (ephfile) delete ephfile;
+	// ATMOSPHERE has no virtual destructor, so the models are deleted
+	// here through their own classes rather than by the base class
+	StdAtmosphere *model = (StdAtmosphere*)(atmcache ? atmsrc : atm);
+	if (atmcache) delete atmcache;
+	if (model) delete model;
+	atm = 0;
+}
+
+// --------------------------------------------------------------
+
+void KeplerPlanet::clbkInit (FILEHANDLE cfg)
+{
+	char cbuf[256];
+	double tol = 1e-10;
+	bool report = false;
+
+	CELBODY2::clbkInit (cfg);
+	if (cfg) {
+		if (oapiReadItem_string (cfg, "Elements", cbuf)) {
+			double a, e, i, theta, omegab, L;
+			if (sscanf (cbuf, "%lf%lf%lf%lf%lf%lf", &a, &e, &i, &theta, &omegab, &L) == 6) {
+				el.a = a, el.e = e, el.i = i*RAD;
+				el.theta = theta*RAD, el.omegab = omegab*RAD, el.L = L*RAD;
+			}
+		}
+		oapiReadItem_float (cfg, "ElementsMJD", mjd_el);
+		oapiReadItem_float (cfg, "GM", mu);
+		oapiReadItem_float (cfg, "EphemTol", tol);
+		oapiReadItem_bool (cfg, "AtmReport", report);
+		if (!ephfile && oapiReadItem_string (cfg, "EphemFile", cbuf))
+			ephfile = new EphemFile (cbuf);
+		if (atm && !atmcache && oapiReadItem_string (cfg, "AtmCache", cbuf)) {
+			double atol = 1e-4, dtmax = 0.0;
+			int nlat = 1, nlng = 1;
+			if (sscanf (cbuf, "%lf%d%d%lf", &atol, &nlat, &nlng, &dtmax) >= 1)
+				atm = atmcache = new AtmCache (this, atmsrc = atm, atol, nlat, nlng, dtmax);
+		}
+	}
+	if (report && atm) {
+		AtmBatchReport (atm);
+		if (atmcache) atmcache->Report ();
+	}
+	if (cache) delete cache;
+	cache = new EphemCache (this, 1.0, tol);
+}
+
+// --------------------------------------------------------------
+
+int KeplerPlanet::clbkEphemeris (double mjd, int req, double *ret)
+{
+	int res = (ephfile ? ephfile->Eval (mjd, req, ret) : 0);
+	return (res ? res : TwoBody (mjd, ret));
+}
+
+// --------------------------------------------------------------
+
+int KeplerPlanet::TwoBody (double mjd, double *ret)
+{
+	// Orbiter frame: x and z span the ecliptic, y points north.
+	// Longitude from x towards z, latitude from the ecliptic.
+	VECTOR3 pos, vel;
+	El2State (el, mu, (mjd-mjd_el)*86400.0, pos, vel);
+	double r2xz = pos.x*pos.x + pos.z*pos.z, rxz = sqrt (r2xz);
+	double r = sqrt (r2xz + pos.y*pos.y);
+	double rdot = dotp (pos, vel)/r;
+
+	ret[0] = atan2 (pos.z, pos.x);
+	if (ret[0] < 0.0) ret[0] += PI2;
+	ret[1] = atan2 (pos.y, rxz);
+	ret[2] = r/AU;
+	ret[3] = (pos.x*vel.z - pos.z*vel.x)/r2xz;
+	ret[4] = (vel.y - pos.y*rdot/r)/rxz;
+	ret[5] = rdot/AU;
+	return EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYISTRUE | EPHEM_POLAR;
+}
+
+// --------------------------------------------------------------
+
+int KeplerPlanet::clbkFastEphemeris (double simt, int req, double *ret)
+{
+	if (!cache) return clbkEphemeris (oapiGetSimMJD() + (simt-oapiGetSimTime())/86400.0, req, ret);
+	return cache->Eval (simt, req, ret);
+}
+
+// ==============================================================
+// API interface
+// ==============================================================
+
+DLLCLBK CELBODY *InitInstance (OBJHANDLE hBody)
+{
+	return new KeplerPlanet (hBody);
+}
+
+// --------------------------------------------------------------
+
+DLLCLBK void ExitInstance (CELBODY *body)
+{
+	if (body) delete (KeplerPlanet*)body;
+}
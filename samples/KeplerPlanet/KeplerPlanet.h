@@ -0,0 +1,60 @@
+// ==============================================================
+//                 ORBITER MODULE: KeplerPlanet
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2008 Martin Schweiger
+//                   All rights reserved
+//
+// KeplerPlanet.h
+// Sample planet module: unperturbed two-body ephemerides from
+// orbital elements, returned in polar format. clbkFastEphemeris is
+// served by the Chebyshev segment cache, clbkEphemeris optionally by
+// a precomputed ephemeris file. The atmosphere is a StdAtmosphere
+// (batch evaluation with AtmParamsBatch), optionally served from the
+// altitude tables of an AtmCache.
+// ==============================================================
+
+#ifndef __KEPLERPLANET_H
+#define __KEPLERPLANET_H
+
+#include "orbitersdk.h"
+#include "../Common/EphemFile.h"
+#include "../Common/AtmCache.h"
+
+// ==============================================================
+// Planet class interface
+//
+// Config file items (defaults: heliocentric orbit of Mars at J2000):
+//   Elements    = a[m] e i[deg] theta[deg] omegab[deg] L[deg]
+//   ElementsMJD = <epoch of the elements [MJD]>
+//   GM          = <gravitational parameter of the parent [m^3/s^2]>
+//   EphemTol    = <relative tolerance of the ephemeris cache>
+//   EphemFile   = <ephemeris file, relative to the Orbiter root>
+//   AtmCache    = <tolerance> [<nlat> <nlng> <lifetime [s]>]: serve
+//                 the atmosphere from an AtmCache
+//   AtmReport   = TRUE: log the atmosphere throughput (and the cache
+//                 errors) at startup
+// ==============================================================
+
+class KeplerPlanet: public CELBODY2 {
+public:
+	KeplerPlanet (OBJHANDLE hBody);
+	~KeplerPlanet ();
+	bool bEphemeris () const { return true; }
+	void clbkInit (FILEHANDLE cfg);
+	int  clbkEphemeris (double mjd, int req, double *ret);
+	int  clbkFastEphemeris (double simt, int req, double *ret);
+
+private:
+	// Two-body solution at mjd (interface of clbkEphemeris)
+	int TwoBody (double mjd, double *ret);
+
+	ELEMENTS el;         // orbital elements (Orbiter frame)
+	double mjd_el;       // epoch of the elements [MJD]
+	double mu;           // gravitational parameter of the parent [m^3/s^2]
+	EphemCache *cache;   // interpolated ephemerides for clbkFastEphemeris
+	EphemFile *ephfile;  // precomputed ephemerides (NULL if none)
+	AtmCache *atmcache;  // atmosphere cache (NULL if none)
+	ATMOSPHERE *atmsrc;  // atmosphere model behind the cache
+};
+
+#endif // !__KEPLERPLANET_H
@@ -18,12 +18,14 @@ char cConsoleCmd[1024] = "\0";
 // ==============================================================
 // class LuaConsole
 
-LuaConsole::LuaConsole (HINSTANCE hDLL): Module (hDLL)
+LuaConsole::LuaConsole (HINSTANCE hDLL): Module (hDLL), term (NLINE, NCHAR)
 {
 	hWnd = NULL;
 	hThread = NULL;
 	interp = NULL;
 	bRefresh = false;
+	bRepaint = true;
+	trefresh = 0.0;
 	fW = 0;
 
 	SetParams (); // may not be necessary here
@@ -33,15 +35,10 @@ LuaConsole::LuaConsole (HINSTANCE hDLL): Module (hDLL)
 		"Open a Lua script interpreter window.",
 		OpenDlgClbk, this);
 
-	// terminal history buffer
-	for (DWORD i = 0; i < NLINE; i++) {
-		line[i].buf = NULL;
-		line[i].isInp = true;
-	}
-	line0 = 0;
-	nline = 0;
+	// terminal display
 	tline = 0;
-	topline = 0;
+	topline = hline = 0;
+	drawtop = drawend = 0;
 
 	// input buffer
 	inp = new char[1024];
@@ -74,10 +71,6 @@ LuaConsole::~LuaConsole ()
 	// Unregister the terminal window class
 	UnregisterClass ("ConsoleDsp", hModule);
 
-	// Delete terminal buffer
-	for (DWORD i = 0; i < NLINE; i++)
-		if (line[i].buf) delete []line[i].buf;
-
 	// Delete input buffer
 	delete []inp;
 }
@@ -131,15 +124,21 @@ void LuaConsole::clbkSimulationEnd ()
 void LuaConsole::clbkPostStep (double simt, double simdt, double mjd)
 {
 	if (interp) {
-		if (interp->IsBusy() || cConsoleCmd[0] || interp->nJobs()) { // let the interpreter do some work
+		if (interp->IsScheduled()) {
+			Interpreter::Schedule(); // run scheduled interpreters (calls InterpreterCycle)
+		} else if (interp->IsBusy() || cConsoleCmd[0] || interp->nJobs()) { // let the interpreter do some work
 			interp->EndExec();        // orbiter hands over control
 			// At this point the interpreter is performing one cycle
 			interp->WaitExec();   // orbiter waits to get back control
 		}
-		if (bRefresh) {
-			UpdateScrollbar();
-			RefreshTerminal();
-			bRefresh = false;
+		if (bRefresh) { // rate-limited, so that scripts printing every frame don't stall the simulation
+			double t = oapiGetSysTime();
+			if (t-trefresh >= REFRESH_DT || t < trefresh) {
+				UpdateScrollbar();
+				UpdateTerminal();
+				bRefresh = false;
+				trefresh = t;
+			}
 		}
 		interp->PostStep (simt, simdt, mjd);
 	}
@@ -179,6 +178,7 @@ void LuaConsole::Close ()
 	hWnd = NULL;
 	hTerm = NULL;
 	tline = 0;
+	bRepaint = true;
 }
 
 // ==============================================================
@@ -244,52 +244,80 @@ void LuaConsole::SetTermGeometry (HWND hTerm)
 	GetClientRect (hTerm, &rc);
 	int w = rc.right, h = rc.bottom;
 	tline = h/fH; // terminal lines
+	bRepaint = true;
 }
 
 // ==============================================================
 
 void LuaConsole::RefreshTerminal ()
 {
+	// full repaint
 	if (hTerm) {
 		InvalidateRect (hTerm, NULL, TRUE);
 		UpdateWindow (hTerm);
 		PaintTerminal ();
+		bRepaint = false;
+	}
+}
+
+// ==============================================================
+
+void LuaConsole::UpdateTerminal ()
+{
+	// Incremental repaint: lines don't change once added, so the rows
+	// still in view are scrolled into place, and only the rows from the
+	// prompt of the last paint downwards (new lines, input) are drawn.
+	if (!hTerm || !tline) return;
+	// If the last painted line has scrolled out of view, there is no
+	// retained row to erase from, so repaint the whole window.
+	if (bRepaint || topline < drawtop || topline-drawtop >= tline || drawend <= topline) {
+		RefreshTerminal();
+		return;
 	}
+	DWORD shift = topline-drawtop;
+	if (shift)
+		ScrollWindowEx (hTerm, 0, -(int)(shift*fH), NULL, NULL, NULL, NULL, 0);
+	PaintTerminal (drawend-topline);
 }
 
 // ==============================================================
 
-void LuaConsole::PaintTerminal ()
+void LuaConsole::PaintTerminal (DWORD row0)
 {
 	if (!tline) return;
 
 	bool bPrompt = !interp->IsBusy();
-	DWORD i, idx, x0, x, y;
-	DWORD nnline = nline;
-	if (bPrompt) nnline++;
+	DWORD i, n, x0, x, y;
+	DWORD end = term.End();
+	if (topline < term.First()) topline = term.First();
+	DWORD ndisp = min (end-topline, tline-1);
 	HFONT pFont;
 	HDC hDC = GetDC (hTerm);
+	x0 = x = 2; y = 1 + row0*fH;
+	if (row0) { // erase the rows to be repainted
+		RECT rc;
+		GetClientRect (hTerm, &rc);
+		rc.top = y;
+		FillRect (hDC, &rc, (HBRUSH)GetStockObject (WHITE_BRUSH));
+	}
 	SelectObject (hDC, GetStockObject (NULL_BRUSH));
 	SelectObject (hDC, GetStockObject (BLACK_PEN));
 	pFont = (HFONT)SelectObject (hDC, hFont);
 	SetTextColor (hDC, colIn);
 	bool pIn = true;
 	SetBkMode (hDC, TRANSPARENT);
-	x0 = x = 2; y = 1;
-	int dtop = (topline-line0+NLINE)%NLINE;
-	DWORD ndisp = min (nline-dtop,tline-1);
-	for (i = 0; i < ndisp; i++) {
-		idx = (topline+i)%NLINE;
-		if (!i || line[idx].isInp != pIn) {
-			pIn = line[idx].isInp;
+	for (i = row0; i < ndisp; i++) {
+		n = topline+i;
+		if (i == row0 || (term.Attr(n) != 0) != pIn) {
+			pIn = (term.Attr(n) != 0);
 			SetTextColor (hDC, pIn ? colIn : colOut);
 			x = (pIn ? x0+fW : x0);
 		}
 		if (pIn) TextOut (hDC, x0, y, "%", 1);
-		TextOut (hDC, x, y, line[idx].buf, strlen(line[idx].buf));
+		TextOut (hDC, x, y, term.Text(n), term.Len(n));
 		y += fH;
 	}
-	if (bPrompt && nline-dtop >= 0 && nline-dtop < tline) {
+	if (bPrompt && end-topline < tline) {
 		x = x0+fW;
 		if (!pIn) SetTextColor (hDC, colIn);
 		TextOut (hDC, x0, y, "%", 1);
@@ -302,24 +330,16 @@ void LuaConsole::PaintTerminal ()
 
 	SelectObject (hDC, pFont);
 	ReleaseDC (hTerm, hDC);
+	drawtop = topline;
+	drawend = end;
 }
 
 // ==============================================================
 
 void LuaConsole::AddLine (const char *str, bool isIn)
 {
-	int idx = (line0+nline)%NLINE;
-	LineSpec *ln = line + idx;
-	if (ln->buf) delete []ln->buf;
-	int ncol = strlen(str);
-	ln->isInp = isIn;
-	ln->buf = new char[ncol+1];
-	strcpy (ln->buf, str);
-	int dtop = (topline-line0+NLINE)%NLINE;
-	int ddsp = nline-dtop;
-	bool vis = (ddsp >= 0 && ddsp < tline);
-	if (nline == NLINE) line0 = (line0+1)%NLINE;
-	else nline++;
+	bool vis = (term.End()-topline < tline); // new line in view
+	term.Append (str, isIn ? 1:0);
 	if (isIn || vis) AutoScroll();
 	bRefresh = true;
 }
@@ -329,11 +349,11 @@ void LuaConsole::AddLine (const char *str, bool isIn)
 void LuaConsole::AutoScroll ()
 {
 	if (!tline) return;
-	int dtop = (topline-line0+NLINE)%NLINE;
-	if (nline < dtop) {
-		ScrollTo ((line0+dtop)%NLINE);
-	} else if (nline-dtop >= tline) {
-		ScrollTo ((line0+nline-tline+1)%NLINE);
+	DWORD end = term.End();
+	if (topline < term.First()) {
+		ScrollTo (0);
+	} else if (end-topline >= tline) {
+		ScrollTo (end-tline+1-term.First());
 	}
 }
 
@@ -341,10 +361,10 @@ void LuaConsole::AutoScroll ()
 
 void LuaConsole::ScrollTo (int pos)
 {
-	pos = max (0, min (nline-1, pos));
-	pos = (pos+line0)%NLINE;
-	if (pos != topline) {
-		topline = pos;
+	pos = max (0, min ((int)term.nLine()-1, pos));
+	DWORD top = term.First()+pos;
+	if (top != topline) {
+		topline = top;
 		bRefresh = true;
 	}
 }
@@ -353,9 +373,7 @@ void LuaConsole::ScrollTo (int pos)
 
 void LuaConsole::ScrollBy (int dpos)
 {
-	int dtop = (topline-line0+NLINE)%NLINE;
-	int pos = dtop+dpos;
-	ScrollTo (pos);
+	ScrollTo ((int)(topline-term.First())+dpos);
 }
 
 // ==============================================================
@@ -368,8 +386,8 @@ void LuaConsole::UpdateScrollbar ()
 		SIF_POS | SIF_RANGE,
 		0, 0, 0, 0, 0
 	};
-	si.nMax = max (0, nline-1);
-	si.nPos = (topline-line0+NLINE)%NLINE;
+	si.nMax = max (0, (int)term.nLine()-1);
+	si.nPos = topline-term.First();
 	SetScrollInfo (hTerm, SB_VERT, &si, TRUE);
 }
 
@@ -378,7 +396,7 @@ void LuaConsole::UpdateScrollbar ()
 void LuaConsole::InputLine (const char *str)
 {
 	AddLine (str, true);
-	hline = nline;
+	hline = term.End();
 	strcpy (cConsoleCmd, str);
 }
 
@@ -386,29 +404,20 @@ void LuaConsole::InputLine (const char *str)
 
 bool LuaConsole::ScanHistory (int step)
 {
-	DWORD ln = nline, phline = hline;
+	DWORD first = term.First(), end = term.End(), phline = hline;
 	bool found = false;
+	if (hline < first) hline = first;
 	if (step < 0) { // step back
-		if (!hline) return false;
-		for (--hline; hline != (DWORD)-1; hline--) {
-			ln = (line0+hline)%NLINE;
-			if (line[ln].isInp && line[ln].buf) { found = true; break; }
-		}
+		while (hline > first)
+			if (term.Attr(--hline)) { found = true; break; }
 	} else { // step forward
-		if (hline == nline) return false;
-		for (++hline; hline != nline; hline++) {
-			ln = (line0+hline)%NLINE;
-			if (line[ln].isInp && line[ln].buf) { found = true; break; }
-		}
+		if (hline == end) return false;
+		while (++hline < end)
+			if (term.Attr(hline)) { found = true; break; }
 	}
 	if (found) {
-		if (ln == nline) {
-			inp[0] = '\0';
-			ninp = caret = 0;
-		} else {
-			strncpy (inp, line[ln].buf, 1024);
-			ninp = caret = min (strlen (line[ln].buf), 1024);
-		}
+		strncpy (inp, term.Text(hline), 1024);
+		ninp = caret = term.Len(hline);
 	} else if (step > 0) {
 		inp[0] = '\0';
 		ninp = caret = 0;
@@ -453,7 +462,7 @@ LRESULT WINAPI LuaConsole::TermProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM
 			break;
 		}
 		AutoScroll();
-		RefreshTerminal();
+		UpdateTerminal();
 		return 0;
 	case WM_KEYDOWN:
 		switch (wParam) {
@@ -476,7 +485,7 @@ LRESULT WINAPI LuaConsole::TermProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM
 		//	return 0;
 		}
 		AutoScroll();
-		RefreshTerminal();
+		UpdateTerminal();
 		return 0;
 	case WM_VSCROLL:
 		switch (LOWORD(wParam)) {
@@ -576,7 +585,10 @@ Interpreter *LuaConsole::CreateInterpreter ()
 	termInterp = false;
 	interp = new ConsoleInterpreter (this);
 	interp->Initialise();
-	hThread = (HANDLE)_beginthreadex (NULL, 4096, &InterpreterThreadProc, this, 0, &id);
+	if (Interpreter::UseScheduler())
+		interp->SetScheduled (InterpreterCycle, this);
+	else
+		hThread = (HANDLE)_beginthreadex (NULL, 4096, &InterpreterThreadProc, this, 0, &id);
 	return interp;
 }
 // Interpreter thread function
@@ -600,3 +612,14 @@ unsigned int WINAPI LuaConsole::InterpreterThreadProc (LPVOID context)
 	_endthreadex(0);
 	return 0;
 }
+// Interpreter cycle in scheduler mode (called from the orbiter thread)
+void LuaConsole::InterpreterCycle (void *context)
+{
+	LuaConsole *console = (LuaConsole*)context;
+	Interpreter *interp = console->interp;
+	if (interp->Status() == 1) return; // terminated
+	if (!interp->IsBusy() && !cConsoleCmd[0] && !interp->nJobs()) return; // nothing to do
+	int res = interp->RunChunk (cConsoleCmd, strlen (cConsoleCmd));
+	if (!interp->IsBusy()) cConsoleCmd[0] = '\0'; // command completed: free buffer
+	console->bRefresh = (res != -1); // signal terminal refresh
+}
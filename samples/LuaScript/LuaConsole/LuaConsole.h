@@ -4,8 +4,11 @@
 #include "OrbiterAPI.h"
 #include "ModuleAPI.h"
 #include "ConsoleInterpreter.h"
+#include "../../Common/TermBuffer.h"
 
 #define NLINE 100 // number of buffered lines
+#define NCHAR 256 // max characters per buffered line
+#define REFRESH_DT 0.05 // min. interval between terminal refreshes [s]
 
 class LuaConsole: public oapi::Module {
 	friend class ConsoleInterpreter;
@@ -24,7 +27,8 @@ public:
 	void SetFontSize (DWORD size);
 	void Resize (DWORD w, DWORD h);
 	void RefreshTerminal ();
-	void PaintTerminal ();
+	void UpdateTerminal ();
+	void PaintTerminal (DWORD row0 = 0);
 
 protected:
 	bool SetParams ();
@@ -40,6 +44,7 @@ private:
 	static BOOL CALLBACK DlgProc (HWND, UINT, WPARAM, LPARAM);
 	static LRESULT WINAPI TermProcHook (HWND, UINT, WPARAM, LPARAM);
 	static unsigned int WINAPI InterpreterThreadProc (LPVOID context);
+	static void InterpreterCycle (void *context); // scheduler mode
 	static void OpenDlgClbk (void *context); // called when user requests console window
 	Interpreter *CreateInterpreter ();
 	void AddLine (const char *str, bool isIn = false); // add line to buffer
@@ -55,19 +60,18 @@ private:
 	DWORD fW, fH;   // font width, height
 	DWORD dwCmd;    // custom command id
 
-	struct LineSpec { // terminal history buffer
-		char *buf;
-		bool isInp;
-	} line[NLINE];
+	TermBuffer term; // terminal history buffer (line attribute: 1=input)
 	char *inp;      // input buffer
-	int line0;      // buffer index of first line
-	int hline;      // current history scan line
-	int nline;      // number of lines in input buffer
+	DWORD topline;  // topmost displayed line (buffer serial)
+	DWORD hline;    // current history scan line (buffer serial)
+	DWORD drawtop;  // topmost displayed line at last paint
+	DWORD drawend;  // buffer end at last paint
 	int ninp;       // number of characters in input buffer
-	int tline;      // number of lines visible in terminal window
-	int topline;    // topmost displayed line
+	DWORD tline;    // number of lines visible in terminal window
 	int caret;      // caret position in input buffer
 	bool bRefresh;  // display refresh flag
+	bool bRepaint;  // full repaint flag
+	double trefresh; // system time of last refresh
 	COLORREF colIn, colOut; // colour for input/output text
 };
 
@@ -59,7 +59,10 @@ Interpreter *InterpreterList::Environment::CreateInterpreter ()
 	termInterp = false;
 	interp = new Interpreter ();
 	interp->Initialise();
-	hThread = (HANDLE)_beginthreadex (NULL, 4096, &InterpreterThreadProc, this, 0, &id);
+	if (Interpreter::UseScheduler())
+		interp->SetScheduled (InterpreterCycle, this);
+	else
+		hThread = (HANDLE)_beginthreadex (NULL, 4096, &InterpreterThreadProc, this, 0, &id);
 	return interp;
 }
 
@@ -88,6 +91,29 @@ unsigned int WINAPI InterpreterList::Environment::InterpreterThreadProc (LPVOID
 	return 0;
 }
 
+// Interpreter cycle in scheduler mode (called from the orbiter thread).
+// The command buffer is released as soon as the command has been started,
+// so that asynchronous requests arriving in the meantime are queued for
+// the next command.
+void InterpreterList::Environment::InterpreterCycle (void *context)
+{
+	InterpreterList::Environment *env = (InterpreterList::Environment*)context;
+	Interpreter *interp = env->interp;
+	if (env->termInterp || interp->Status() == 1) return;
+	if (interp->IsBusy()) {
+		interp->RunChunk ("", 0); // resume current command
+	} else if (env->cmd) {
+		interp->RunChunk (env->cmd, strlen (env->cmd)); // start command from buffer
+		delete []env->cmd;
+		env->cmd = 0;
+	} else if (interp->nJobs()) {
+		interp->RunChunk ("", 0); // idle loop
+		return;
+	} else return;
+	if (env->singleCmd && !interp->IsBusy())
+		interp->Terminate();
+}
+
 
 // ==============================================================
 // class InterpreterList: implementation
@@ -114,11 +140,13 @@ void InterpreterList::clbkPostStep (double simt, double simdt, double mjd)
 		if (!list[i]->interp) DelInterpreter (list[i--]);
 
 	for (i = 0; i < nlist; i++) { // let the interpreter do some work
+		if (list[i]->interp->IsScheduled()) continue; // served by Interpreter::Schedule
 		if (list[i]->interp->IsBusy() || list[i]->cmd || list[i]->interp->nJobs()) {
 			list[i]->interp->EndExec();
 			list[i]->interp->WaitExec();
 		}
 	}
+	Interpreter::Schedule();
 }
 
 InterpreterList::Environment *InterpreterList::AddInterpreter ()
@@ -226,7 +254,13 @@ DLLCLBK bool opcExecScriptCmd (INTERPRETERHANDLE hInterp, const char *cmd)
 	if (env->cmd) // asynchronous request is waiting
 		cmd_async = env->cmd;
 	env->cmd = str;
-	while (env->cmd) {
+	if (env->interp->IsScheduled()) {
+		// run cycles until the command has been started and completed
+		while (env->cmd || env->interp->IsBusy()) {
+			if (env->interp->Status() == 1) break;
+			InterpreterList::Environment::InterpreterCycle (env);
+		}
+	} else while (env->cmd) {
 		// wait until command has been executed
 		env->interp->EndExec();
 		env->interp->WaitExec();
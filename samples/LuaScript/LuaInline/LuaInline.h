@@ -37,6 +37,7 @@ public:
 		bool singleCmd;       // terminate after single command
 		char *cmd;            // interpreter command
 		static unsigned int WINAPI InterpreterThreadProc (LPVOID context);
+		static void InterpreterCycle (void *context); // scheduler mode
 	};
 
 	InterpreterList (HINSTANCE hDLL);
@@ -2,9 +2,60 @@
 #include "VesselAPI.h"
 #include "MFDAPI.h"
 #include "DrawAPI.h"
+#include <stdlib.h>
+#include <stdio.h>
 
 VESSEL *vfocus = (VESSEL*)0x1;
 NOTEHANDLE Interpreter::hnote = NULL;
+Interpreter **Interpreter::sched = NULL;
+DWORD Interpreter::nsched = 0;
+DWORD Interpreter::nschedbuf = 0;
+DWORD Interpreter::schednext = 0;
+double Interpreter::schedbudget = 2e-3;
+bool Interpreter::schedmode = false;
+bool Interpreter::profmode = false;
+int Interpreter::profinterval = 1000;
+DWORD Interpreter::instrbudget = 0;
+
+// ============================================================================
+// Execution profile
+//
+// Lua functions are sampled by a count hook, and identified by their chunk
+// source and definition line.
+
+const DWORD PROF_NSLOT = 256;   // function hash table size
+const DWORD PROF_MAXFUNC = 192; // max number of recorded functions
+
+struct Interpreter::ProfileData {
+	struct Func {
+		const char *source;  // chunk source (key, with line)
+		int line;            // line where the function is defined
+		char src[48];        // chunk name for display
+		char name[32];       // function name, if known
+		DWORD samples;       // instruction samples
+		DWORD calls;         // number of calls
+	} func[PROF_NSLOT];
+	DWORD nfunc;             // number of recorded functions
+	DWORD nsample;           // total number of samples
+	DWORD other;             // samples of unrecorded functions (table full)
+	DWORD nrun;              // number of RunChunk and PostStep calls
+	LONGLONG ticks;          // wall time spent in RunChunk and PostStep
+	DWORD nsuspend, nabort;  // instruction budget overruns
+
+	// Fill idx with the recorded functions in order of decreasing samples.
+	// Returns the number of functions.
+	DWORD Sort (DWORD *idx) const
+	{
+		DWORD i, j, n = 0;
+		for (i = 0; i < PROF_NSLOT; i++) {
+			if (!func[i].source) continue;
+			for (j = n++; j && func[idx[j-1]].samples < func[i].samples; j--)
+				idx[j] = idx[j-1];
+			idx[j] = i;
+		}
+		return n;
+	}
+};
 
 // ============================================================================
 // class Interpreter
@@ -19,17 +70,51 @@ Interpreter::Interpreter ()
 	term_verbose = 0;     // verbosity level
 	postfunc = 0;
 	postcontext = 0;
+	co = 0;
+	coref = LUA_NOREF;
+	cycle = 0;
+	cyclecontext = 0;
 	// store interpreter context in the registry
 	lua_pushlightuserdata (L, this);
 	lua_setfield (L, LUA_REGISTRYINDEX, "interp");
 
 	hExecMutex = CreateMutex (NULL, TRUE, NULL);
 	hWaitMutex = CreateMutex (NULL, FALSE, NULL);
+
+	skppt = 0;
+	nskppt = 0;
+	skpnpt = 0;
+	nskpnpt = 0;
+
+	// profiling and instruction budget
+	prof = 0;
+	ninstr = 0;
+	tbudget = -1.0;
+	mainthread = GetCurrentThreadId();
+	ReadConfig ();
+	if (profmode) {
+		prof = new ProfileData;
+		memset (prof, 0, sizeof(ProfileData));
+	}
 }
 
 Interpreter::~Interpreter ()
 {
+	if (cycle) { // remove from scheduler list
+		for (DWORD i = 0; i < nsched; i++)
+			if (sched[i] == this) {
+				memmove (sched+i, sched+i+1, (--nsched-i)*sizeof(Interpreter*));
+				if (schednext > i) schednext--;
+				break;
+			}
+	}
+	if (prof) {
+		WriteProfile ();
+		delete prof;
+	}
 	lua_close (L);
+	if (skppt) delete []skppt;
+	if (skpnpt) delete []skpnpt;
 
 	if (hExecMutex) CloseHandle (hExecMutex);
 	if (hWaitMutex) CloseHandle (hWaitMutex);
@@ -45,6 +130,10 @@ void Interpreter::Initialise ()
 	LoadSketchpadAPI ();  // load Sketchpad methods
 	LoadAnnotationAPI (); // load screen annotation methods
 	LoadStartupScript (); // load default initialisation script
+
+	// profile and instruction budget hook (inherited by coroutines)
+	if (profmode || instrbudget)
+		lua_sethook (L, ProfileHook, LUA_MASKCOUNT | (profmode ? LUA_MASKCALL : 0), profinterval);
 }
 
 int Interpreter::Status () const
@@ -65,9 +154,12 @@ void Interpreter::Terminate ()
 void Interpreter::PostStep (double simt, double simdt, double mjd)
 {
 	if (postfunc) {
+		LARGE_INTEGER t0;
+		if (prof) QueryPerformanceCounter (&t0);
 		postfunc (postcontext);
 		postfunc = 0;
 		postcontext = 0;
+		if (prof) ProfileRun (t0.QuadPart);
 	}
 }
 
@@ -132,19 +224,44 @@ const char *Interpreter::lua_tostringex (lua_State *L, int idx, char *cbuf)
 	}
 }
 
+// ============================================================================
+// Vectors and matrices are passed to scripts as full userdata carrying a
+// VECTOR3 or MATRIX3, with a shared metatable per type. The metatables are
+// stored in the registry under light userdata keys, so a type check is a
+// metatable identity comparison rather than a walk over table fields.
+// Tables with fields x,y,z and m11..m33 are still accepted as input.
+
+static char vec_mtkey = 'v'; // registry key for the vector metatable
+static char mat_mtkey = 'm'; // registry key for the matrix metatable
+
+// returns true if stack entry idx is a full userdata with the metatable
+// stored under registry key 'key'
+static bool lua_isudtype (lua_State *L, int idx, void *key)
+{
+	if (lua_type (L, idx) != LUA_TUSERDATA || !lua_getmetatable (L, idx)) return false;
+	lua_pushlightuserdata (L, key);
+	lua_rawget (L, LUA_REGISTRYINDEX);
+	bool res = (lua_rawequal (L, -1, -2) != 0);
+	lua_pop (L, 2);
+	return res;
+}
+
 void Interpreter::lua_pushvector (lua_State *L, const VECTOR3 &vec)
 {
-	lua_createtable (L, 0, 3);
-	lua_pushnumber (L, vec.x);
-	lua_setfield (L, -2, "x");
-	lua_pushnumber (L, vec.y);
-	lua_setfield (L, -2, "y");
-	lua_pushnumber (L, vec.z);
-	lua_setfield (L, -2, "z");
+	VECTOR3 *v = (VECTOR3*)lua_newuserdata (L, sizeof(VECTOR3));
+	*v = vec;
+	lua_pushlightuserdata (L, &vec_mtkey);
+	lua_rawget (L, LUA_REGISTRYINDEX);
+	lua_pushvalue (L, -1);
+	lua_setfenv (L, -3);      // no extra fields yet, see vec_newindex
+	lua_setmetatable (L, -2);
 }
 
 VECTOR3 Interpreter::lua_tovector (lua_State *L, int idx)
 {
+	if (lua_isudtype (L, idx, &vec_mtkey))
+		return *(VECTOR3*)lua_touserdata (L, idx);
+
 	VECTOR3 vec;
 	lua_getfield (L, idx, "x");
 	vec.x = lua_tonumber (L, -1); lua_pop (L,1);
@@ -157,6 +274,7 @@ VECTOR3 Interpreter::lua_tovector (lua_State *L, int idx)
 
 int Interpreter::lua_isvector (lua_State *L, int idx)
 {
+	if (lua_isudtype (L, idx, &vec_mtkey)) return 1;
 	if (!lua_istable (L, idx)) return 0;
 	static char fieldname[3] = {'x','y','z'};
 	static char field[2] = "x";
@@ -184,20 +302,18 @@ int Interpreter::lua_isvector (lua_State *L, int idx)
 
 void Interpreter::lua_pushmatrix (lua_State *L, const MATRIX3 &mat)
 {
-	lua_createtable(L,0,9);
-	lua_pushnumber(L,mat.m11);  lua_setfield(L,-2,"m11");
-	lua_pushnumber(L,mat.m12);  lua_setfield(L,-2,"m12");
-	lua_pushnumber(L,mat.m13);  lua_setfield(L,-2,"m13");
-	lua_pushnumber(L,mat.m21);  lua_setfield(L,-2,"m21");
-	lua_pushnumber(L,mat.m22);  lua_setfield(L,-2,"m22");
-	lua_pushnumber(L,mat.m23);  lua_setfield(L,-2,"m23");
-	lua_pushnumber(L,mat.m31);  lua_setfield(L,-2,"m31");
-	lua_pushnumber(L,mat.m32);  lua_setfield(L,-2,"m32");
-	lua_pushnumber(L,mat.m33);  lua_setfield(L,-2,"m33");
+	MATRIX3 *m = (MATRIX3*)lua_newuserdata (L, sizeof(MATRIX3));
+	*m = mat;
+	lua_pushlightuserdata (L, &mat_mtkey);
+	lua_rawget (L, LUA_REGISTRYINDEX);
+	lua_setmetatable (L, -2);
 }
 
 MATRIX3 Interpreter::lua_tomatrix (lua_State *L, int idx)
 {
+	if (lua_isudtype (L, idx, &mat_mtkey))
+		return *(MATRIX3*)lua_touserdata (L, idx);
+
 	MATRIX3 mat;
 	lua_getfield (L, idx, "m11");  mat.m11 = lua_tonumber (L, -1);  lua_pop (L,1);
 	lua_getfield (L, idx, "m12");  mat.m12 = lua_tonumber (L, -1);  lua_pop (L,1);
@@ -213,6 +329,7 @@ MATRIX3 Interpreter::lua_tomatrix (lua_State *L, int idx)
 
 int Interpreter::lua_ismatrix (lua_State *L, int idx)
 {
+	if (lua_isudtype (L, idx, &mat_mtkey)) return 1;
 	if (!lua_istable (L, idx)) return 0;
 	static char *fieldname[9] = {"m11","m12","m13","m21","m22","m23","m31","m32","m33"};
 	int i, ii, n;
@@ -381,10 +498,467 @@ void Interpreter::frameskip (lua_State *L)
 	if (status == 1) { // termination request
 		lua_pushboolean(L, 1);
 		lua_setfield (L, LUA_GLOBALSINDEX, "wait_exit");
-	} else {
+	} else if (!cycle) {
 		EndExec();
 		WaitExec();
 	}
+	// in scheduler mode, the command coroutine is suspended by procFrameskip
+}
+
+void Interpreter::SetScheduled (void (*_cycle)(void*), void *context)
+{
+	if (!cycle) { // add to scheduler list
+		if (nsched == nschedbuf) {
+			Interpreter **tmp = new Interpreter*[nschedbuf += 16];
+			if (nsched) {
+				memcpy (tmp, sched, nsched*sizeof(Interpreter*));
+				delete []sched;
+			}
+			sched = tmp;
+		}
+		sched[nsched++] = this;
+	}
+	cycle = _cycle;
+	cyclecontext = context;
+
+	// dofile is a C function, which can't be suspended. Replace it with
+	// a Lua version, so that scripts run from file can call proc.skip
+	luaL_dostring (L, "function dofile(fname) return assert(loadfile(fname))() end");
+}
+
+void Interpreter::ReadConfig ()
+{
+	static bool done = false;
+	if (done) return;
+	done = true;
+
+	FILEHANDLE hFile = oapiOpenFile ("LuaInterpreter.cfg", FILE_IN, CONFIG);
+	if (hFile) {
+		double ms;
+		int n;
+		oapiReadItem_bool (hFile, "Scheduler", schedmode);
+		if (oapiReadItem_float (hFile, "SchedulerBudget", ms) && ms > 0.0)
+			schedbudget = ms*1e-3;
+		oapiReadItem_bool (hFile, "Profile", profmode);
+		if (oapiReadItem_int (hFile, "ProfileInterval", n) && n > 0)
+			profinterval = n;
+		if (oapiReadItem_int (hFile, "InstructionBudget", n) && n > 0)
+			instrbudget = n;
+		oapiCloseFile (hFile, FILE_IN);
+	}
+}
+
+bool Interpreter::UseScheduler ()
+{
+	ReadConfig ();
+	return schedmode;
+}
+
+void Interpreter::Schedule ()
+{
+	static double tsched = -1.0;
+	double t = oapiGetSysTime();
+	if (t == tsched) return; // already served in this frame
+	tsched = t;
+
+	LARGE_INTEGER freq, t0, t1;
+	QueryPerformanceFrequency (&freq);
+	QueryPerformanceCounter (&t0);
+	LONGLONG tmax = t0.QuadPart + (LONGLONG)(schedbudget*freq.QuadPart);
+	for (DWORD i = 0, n = nsched; i < n && nsched; i++) {
+		if (schednext >= nsched) schednext = 0;
+		Interpreter *interp = sched[schednext++];
+		interp->cycle (interp->cyclecontext);
+		QueryPerformanceCounter (&t1);
+		if (t1.QuadPart >= tmax) break; // budget used up
+	}
+}
+
+void Interpreter::ProfileHook (lua_State *L, lua_Debug *ar)
+{
+	Interpreter *interp = GetInterpreter (L);
+	if (ar->event != LUA_HOOKCOUNT) { // function call (profiling only)
+		interp->ProfileRecord (L, ar, true);
+		return;
+	}
+	if (interp->prof)
+		interp->ProfileRecord (L, ar, false);
+	if (instrbudget) {
+		double t = oapiGetSysTime();
+		if (t != interp->tbudget) { // new frame
+			interp->tbudget = t;
+			interp->ninstr = 0;
+		}
+		if ((interp->ninstr += profinterval) > instrbudget)
+			interp->BudgetExceeded (L);
+	}
+}
+
+void Interpreter::ProfileRecord (lua_State *L, lua_Debug *ar, bool call)
+{
+	if (!lua_getinfo (L, "S", ar) || ar->what[0] == 'C') return;
+
+	ProfileData::Func *f;
+	DWORD h = (((DWORD)(size_t)ar->source >> 4) ^ ((DWORD)ar->linedefined * 31)) & (PROF_NSLOT-1);
+	for (;; h = (h+1) & (PROF_NSLOT-1)) {
+		f = prof->func + h;
+		if (f->source == ar->source && f->line == ar->linedefined) break;
+		if (!f->source) { // first encounter
+			if (prof->nfunc == PROF_MAXFUNC) {
+				if (!call) prof->other++, prof->nsample++;
+				return;
+			}
+			prof->nfunc++;
+			f->source = ar->source;
+			f->line = ar->linedefined;
+			strncpy (f->src, ar->short_src, 47);
+			bool mainchunk = (ar->what[0] == 'm');
+			lua_getinfo (L, "n", ar);
+			strncpy (f->name, ar->name ? ar->name : mainchunk ? "(main)" : "?", 31);
+			break;
+		}
+	}
+	if (call) f->calls++;
+	else      f->samples++, prof->nsample++;
+}
+
+void Interpreter::ProfileRun (LONGLONG t0)
+{
+	LARGE_INTEGER t1;
+	QueryPerformanceCounter (&t1);
+	prof->ticks += t1.QuadPart - t0;
+	prof->nrun++;
+}
+
+void Interpreter::BudgetExceeded (lua_State *L)
+{
+	if (status == 1) return; // terminating anyway
+
+	if (cycle) {
+		if (L == co) { // scheduler mode: suspend the command until the next cycle
+			if (!CanYield (L, 0))
+				return; // inside dofile, pcall etc.: keep going, suspend later
+			if (prof) prof->nsuspend++;
+			lua_yield (L, 0);
+			return;
+		}
+	} else if (GetCurrentThreadId() != mainthread) {
+		// interpreter thread: hand control to orbiter for one frame
+		if (prof) prof->nsuspend++;
+		frameskip (L);
+		return;
+	}
+	// code called from the orbiter thread can't be suspended. All entry
+	// points from the orbiter thread (commands, background jobs, script
+	// callbacks) use lua_pcall, so this error is reported, not fatal.
+	if (prof) prof->nabort++;
+	luaL_error (L, "instruction budget exceeded (%d per frame)", instrbudget);
+}
+
+bool Interpreter::CanYield (lua_State *L, int level)
+{
+	// A coroutine can't yield while a C function is active below the
+	// current frame (dofile, pcall, table.sort comparators, ...): Lua
+	// raises "attempt to yield across C-call boundary" instead. Walk the
+	// call stack from the given level and check for C frames.
+	lua_Debug ar;
+	for (; lua_getstack (L, level, &ar); level++) {
+		if (!lua_getinfo (L, "S", &ar) || ar.what[0] == 'C') return false;
+	}
+	return true;
+}
+
+void Interpreter::WriteProfile ()
+{
+	if (!prof) return;
+
+	char cbuf[256];
+	DWORD idx[PROF_NSLOT], i, n = prof->Sort (idx);
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency (&freq);
+	double ns = (prof->nsample ? 100.0/prof->nsample : 0.0);
+
+	sprintf (cbuf, "Lua profile: %0.3f ms in %d runs, %d samples (%d instructions), %d suspended, %d aborted",
+		prof->ticks*1e3/freq.QuadPart, prof->nrun, prof->nsample, profinterval, prof->nsuspend, prof->nabort);
+	oapiWriteLog (cbuf);
+	oapiWriteLog ("  samples        calls  function");
+	for (i = 0; i < n; i++) {
+		const ProfileData::Func &f = prof->func[idx[i]];
+		sprintf (cbuf, "  %7d %5.1f%% %7d  %s (%s:%d)", f.samples, f.samples*ns, f.calls, f.name, f.src, f.line);
+		oapiWriteLog (cbuf);
+	}
+	if (prof->other) {
+		sprintf (cbuf, "  %7d %5.1f%%          (other functions)", prof->other, prof->other*ns);
+		oapiWriteLog (cbuf);
+	}
+}
+
+// ============================================================================
+// Precompiled chunk cache
+//
+// Process-wide cache of compiled Lua chunks (lua_dump output), shared by all
+// interpreter instances. Script files are keyed by path and revalidated
+// against the file's modification time and size, command strings are keyed
+// by their text. Cached chunks are loaded with luaL_loadbuffer, which
+// recognises precompiled chunks and skips the parser.
+// With 'ChunkCache = TRUE' in Config\LuaInterpreter.cfg, file chunks are also
+// stored in Script\cache, so that they are reused in later sessions.
+
+const DWORD CHUNK_NBUCKET = 256;     // hash table size
+const DWORD CHUNK_MAXSTRING = 256;   // max number of cached command strings
+
+class ChunkCache {
+public:
+	ChunkCache ();
+	~ChunkCache ();
+
+	// Load a command string (as luaL_loadbuffer)
+	int LoadString (lua_State *L, const char *chunk, int n, const char *name);
+
+	// Load a script file (as luaL_loadfile)
+	int LoadFile (lua_State *L, const char *fname);
+
+private:
+	struct Entry {
+		char *key;           // file path or command string
+		DWORD nkey;          // key length
+		DWORD hash;          // key hash
+		bool isfile;         // file chunk?
+		FILETIME mtime;      // file modification time (file chunks)
+		DWORD fsize;         // file size (file chunks)
+		char *code;          // precompiled chunk
+		DWORD ncode;         // chunk size
+		Entry *next;         // next entry in bucket
+	} *bucket[CHUNK_NBUCKET];
+	DWORD nstring;           // number of cached command strings
+	int persist;             // disk cache enabled? (-1: not yet known)
+	CRITICAL_SECTION cs;
+
+	struct DumpBuf {
+		char *data;
+		DWORD n, nbuf;
+	};
+	static int DumpWriter (lua_State *L, const void *p, size_t sz, void *ud);
+	static DWORD Hash (const char *key, DWORD n);
+	Entry *Find (const char *key, DWORD n, DWORD hash, bool isfile);
+	Entry *Add (const char *key, DWORD n, DWORD hash, bool isfile, lua_State *L);
+	bool Persist ();
+	bool ReadPersistent (lua_State *L, const char *fname, DWORD hash, const WIN32_FILE_ATTRIBUTE_DATA &fad);
+	void WritePersistent (const Entry *e);
+} g_ChunkCache;
+
+ChunkCache::ChunkCache ()
+{
+	for (DWORD i = 0; i < CHUNK_NBUCKET; i++) bucket[i] = 0;
+	nstring = 0;
+	persist = -1;
+	InitializeCriticalSection (&cs);
+}
+
+ChunkCache::~ChunkCache ()
+{
+	for (DWORD i = 0; i < CHUNK_NBUCKET; i++) {
+		while (bucket[i]) {
+			Entry *e = bucket[i];
+			bucket[i] = e->next;
+			delete []e->key;
+			delete []e->code;
+			delete e;
+		}
+	}
+	DeleteCriticalSection (&cs);
+}
+
+int ChunkCache::LoadString (lua_State *L, const char *chunk, int n, const char *name)
+{
+	DWORD hash = Hash (chunk, n);
+	EnterCriticalSection (&cs);
+	Entry *e = Find (chunk, n, hash, false);
+	int res = (e ? luaL_loadbuffer (L, e->code, e->ncode, name) : -1);
+	if (res < 0) {
+		res = luaL_loadbuffer (L, chunk, n, name);
+		if (!res && nstring < CHUNK_MAXSTRING && Add (chunk, n, hash, false, L))
+			nstring++;
+	}
+	LeaveCriticalSection (&cs);
+	return res;
+}
+
+int ChunkCache::LoadFile (lua_State *L, const char *fname)
+{
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	if (!GetFileAttributesExA (fname, GetFileExInfoStandard, &fad))
+		return luaL_loadfile (L, fname); // let Lua generate the error message
+
+	char name[256];
+	_snprintf (name, 255, "@%s", fname); name[255] = '\0';
+	DWORD n = strlen (fname), hash = Hash (fname, n);
+	EnterCriticalSection (&cs);
+	Entry *e = Find (fname, n, hash, true);
+	if (e && (CompareFileTime (&e->mtime, &fad.ftLastWriteTime) || e->fsize != fad.nFileSizeLow)) {
+		// file was modified: drop the stale chunk
+		Entry **pe;
+		for (pe = bucket + (hash % CHUNK_NBUCKET); *pe != e; pe = &(*pe)->next);
+		*pe = e->next;
+		delete []e->key;
+		delete []e->code;
+		delete e;
+		e = 0;
+	}
+	int res;
+	if (e) {
+		res = luaL_loadbuffer (L, e->code, e->ncode, name);
+	} else if (Persist() && ReadPersistent (L, fname, hash, fad)) {
+		res = 0;
+	} else {
+		res = luaL_loadfile (L, fname);
+		if (!res && (e = Add (fname, n, hash, true, L))) {
+			e->mtime = fad.ftLastWriteTime;
+			e->fsize = fad.nFileSizeLow;
+			if (Persist()) WritePersistent (e);
+		}
+	}
+	LeaveCriticalSection (&cs);
+	return res;
+}
+
+int ChunkCache::DumpWriter (lua_State *L, const void *p, size_t sz, void *ud)
+{
+	DumpBuf *buf = (DumpBuf*)ud;
+	if (buf->n + sz > buf->nbuf) {
+		DWORD nbuf = max (buf->nbuf*2, (DWORD)(buf->n+sz));
+		char *tmp = new char[nbuf];
+		if (buf->n) memcpy (tmp, buf->data, buf->n);
+		if (buf->data) delete []buf->data;
+		buf->data = tmp;
+		buf->nbuf = nbuf;
+	}
+	memcpy (buf->data + buf->n, p, sz);
+	buf->n += sz;
+	return 0;
+}
+
+DWORD ChunkCache::Hash (const char *key, DWORD n)
+{
+	DWORD h = 2166136261u; // FNV-1a
+	for (DWORD i = 0; i < n; i++)
+		h = (h ^ (unsigned char)key[i]) * 16777619u;
+	return h;
+}
+
+ChunkCache::Entry *ChunkCache::Find (const char *key, DWORD n, DWORD hash, bool isfile)
+{
+	for (Entry *e = bucket[hash % CHUNK_NBUCKET]; e; e = e->next)
+		if (e->hash == hash && e->isfile == isfile && e->nkey == n && !memcmp (e->key, key, n))
+			return e;
+	return 0;
+}
+
+ChunkCache::Entry *ChunkCache::Add (const char *key, DWORD n, DWORD hash, bool isfile, lua_State *L)
+{
+	// the compiled chunk is on top of the stack
+	DumpBuf buf = {0, 0, 0};
+	if (lua_dump (L, DumpWriter, &buf) || !buf.n) {
+		if (buf.data) delete []buf.data;
+		return 0;
+	}
+	Entry *e = new Entry;
+	e->key = new char[n+1];
+	memcpy (e->key, key, n); e->key[n] = '\0';
+	e->nkey = n;
+	e->hash = hash;
+	e->isfile = isfile;
+	e->fsize = 0;
+	e->code = buf.data;
+	e->ncode = buf.n;
+	e->next = bucket[hash % CHUNK_NBUCKET];
+	bucket[hash % CHUNK_NBUCKET] = e;
+	return e;
+}
+
+bool ChunkCache::Persist ()
+{
+	if (persist < 0) {
+		bool b = false;
+		FILEHANDLE hFile = oapiOpenFile ("LuaInterpreter.cfg", FILE_IN, CONFIG);
+		if (hFile) {
+			oapiReadItem_bool (hFile, "ChunkCache", b);
+			oapiCloseFile (hFile, FILE_IN);
+		}
+		if (b) CreateDirectoryA ("Script\\cache", NULL);
+		persist = (b ? 1 : 0);
+	}
+	return persist != 0;
+}
+
+// Disk cache file: header, file path, precompiled chunk
+struct ChunkFileHeader {
+	char magic[4];     // "LCC1"
+	FILETIME mtime;    // modification time of the script file
+	DWORD fsize;       // size of the script file
+	DWORD npath;       // length of the script path
+	DWORD ncode;       // size of the precompiled chunk
+};
+
+bool ChunkCache::ReadPersistent (lua_State *L, const char *fname, DWORD hash, const WIN32_FILE_ATTRIBUTE_DATA &fad)
+{
+	char cpath[32];
+	sprintf (cpath, "Script\\cache\\%08x.luac", hash);
+	FILE *f = fopen (cpath, "rb");
+	if (!f) return false;
+	ChunkFileHeader hdr;
+	DWORD n = strlen (fname);
+	char *path = 0, *code = 0;
+	bool ok = (fread (&hdr, sizeof(hdr), 1, f) == 1 && !memcmp (hdr.magic, "LCC1", 4) &&
+		!CompareFileTime (&hdr.mtime, &fad.ftLastWriteTime) && hdr.fsize == fad.nFileSizeLow &&
+		hdr.npath == n && hdr.ncode > 0);
+	if (ok) {
+		path = new char[n];
+		code = new char[hdr.ncode];
+		ok = (fread (path, 1, n, f) == n && !memcmp (path, fname, n) &&
+			fread (code, 1, hdr.ncode, f) == hdr.ncode);
+	}
+	fclose (f);
+	if (ok) {
+		char name[256];
+		_snprintf (name, 255, "@%s", fname); name[255] = '\0';
+		ok = !luaL_loadbuffer (L, code, hdr.ncode, name);
+		if (!ok) lua_pop (L, 1); // chunk from another Lua build: recompile
+	}
+	if (ok) { // keep the chunk in memory
+		Entry *e = new Entry;
+		e->key = new char[n+1];
+		memcpy (e->key, fname, n); e->key[n] = '\0';
+		e->nkey = n;
+		e->hash = hash;
+		e->isfile = true;
+		e->mtime = hdr.mtime;
+		e->fsize = hdr.fsize;
+		e->code = code;
+		e->ncode = hdr.ncode;
+		e->next = bucket[hash % CHUNK_NBUCKET];
+		bucket[hash % CHUNK_NBUCKET] = e;
+	} else if (code) delete []code;
+	if (path) delete []path;
+	return ok;
+}
+
+void ChunkCache::WritePersistent (const Entry *e)
+{
+	char cpath[32];
+	sprintf (cpath, "Script\\cache\\%08x.luac", e->hash);
+	FILE *f = fopen (cpath, "wb");
+	if (!f) return;
+	ChunkFileHeader hdr;
+	memcpy (hdr.magic, "LCC1", 4);
+	hdr.mtime = e->mtime;
+	hdr.fsize = e->fsize;
+	hdr.npath = e->nkey;
+	hdr.ncode = e->ncode;
+	fwrite (&hdr, sizeof(hdr), 1, f);
+	fwrite (e->key, 1, e->nkey, f);
+	fwrite (e->code, 1, e->ncode, f);
+	fclose (f);
 }
 
 int Interpreter::ProcessChunk (const char *chunk, int n)
@@ -398,27 +972,50 @@ int Interpreter::ProcessChunk (const char *chunk, int n)
 int Interpreter::RunChunk (const char *chunk, int n)
 {
 	int res = 0;
-	if (chunk[0]) {
+	LARGE_INTEGER t0;
+	if (prof) QueryPerformanceCounter (&t0);
+	if (chunk[0] || co) {
 		is_busy = true;
-		// run command
-		luaL_loadbuffer (L, chunk, n, "line");
-		res = lua_pcall (L, 0, 0, 0);
+		if (!cycle) {
+			// run command
+			g_ChunkCache.LoadString (L, chunk, n, "line");
+			res = lua_pcall (L, 0, 0, 0);
+		} else {
+			// scheduler mode: run command as a coroutine, which is suspended
+			// by proc.Frameskip and resumed by the next call
+			if (!co) {
+				co = lua_newthread (L);
+				coref = luaL_ref (L, LUA_REGISTRYINDEX); // anchor the coroutine
+				res = g_ChunkCache.LoadString (co, chunk, n, "line");
+			}
+			if (!res) res = lua_resume (co, 0);
+			if (res == LUA_YIELD) {
+				if (prof) ProfileRun (t0.QuadPart);
+				return res;
+			}
+			luaL_unref (L, LUA_REGISTRYINDEX, coref);
+			coref = LUA_NOREF;
+			co = 0;
+		}
 		if (res && is_term)
 			term_strout ("Execution error.");
 		// check for leftover background jobs
 		lua_getfield (L, LUA_GLOBALSINDEX, "_nbranch");
-		lua_call (L, 0, 1);
-		jobs = lua_tointeger (L, -1);
+		jobs = (lua_pcall (L, 0, 1, 0) ? 0 : lua_tointeger (L, -1));
 		lua_pop (L, 1);
 		is_busy = false;
 	} else {
 		// idle loop: execute background jobs
 		lua_getfield (L, LUA_GLOBALSINDEX, "_idle");
-		lua_call (L, 0, 1);
-		jobs = lua_tointeger (L, -1);
+		if (lua_pcall (L, 0, 1, 0)) {
+			if (is_term) term_strout (lua_tostring (L, -1));
+			jobs = 0;
+		} else
+			jobs = lua_tointeger (L, -1);
 		lua_pop (L, 1);
 		res = -1;
 	}
+	if (prof) ProfileRun (t0.QuadPart);
 	return res;
 }
 
@@ -433,6 +1030,8 @@ void Interpreter::LoadAPI ()
 	// Load global functions
 	static const struct luaL_reg glob[] = {
 		{"help", help},
+		{"loadfile", chunkLoadfile},
+		{"dofile", chunkDofile},
 		//{"api", help_api},
 		{NULL, NULL}
 	};
@@ -466,6 +1065,35 @@ void Interpreter::LoadAPI ()
 	};
 	luaL_openlib (L, "mat", matLib, 0);
 
+	// Vector and matrix userdata metatables
+	static const struct luaL_reg vecMeta[] = {
+		{"__add", vec_add},
+		{"__sub", vec_sub},
+		{"__mul", vec_mul},
+		{"__div", vec_div},
+		{"__unm", vec_unm},
+		{"__index", vec_index},
+		{"__newindex", vec_newindex},
+		{"__tostring", vec_tostring},
+		{NULL, NULL}
+	};
+	lua_pushlightuserdata (L, &vec_mtkey);
+	lua_newtable (L);
+	luaL_openlib (L, NULL, vecMeta, 0);
+	lua_rawset (L, LUA_REGISTRYINDEX);
+
+	static const struct luaL_reg matMeta[] = {
+		{"__mul", mat_mulop},
+		{"__index", mat_index},
+		{"__newindex", mat_newindex},
+		{"__tostring", mat_tostring},
+		{NULL, NULL}
+	};
+	lua_pushlightuserdata (L, &mat_mtkey);
+	lua_newtable (L);
+	luaL_openlib (L, NULL, matMeta, 0);
+	lua_rawset (L, LUA_REGISTRYINDEX);
+
 	// Load the process library
 	static const struct luaL_reg procLib[] = {
 		{"Frameskip", procFrameskip},
@@ -504,6 +1132,9 @@ void Interpreter::LoadAPI ()
 		{"equ_to_global", oapi_equ_to_global},
 		{"orthodome", oapi_orthodome},
 
+		// script profile
+		{"profile", oapi_profile},
+
 		// body functions
 		{"get_size", oapi_get_size},
 		{"get_mass", oapi_get_mass},
@@ -748,6 +1379,7 @@ void Interpreter::LoadVesselAPI ()
 		{"get_relativepos", v_get_relativepos},
 		{"get_relativevel", v_get_relativevel},
 		{"get_rotationmatrix", v_get_rotationmatrix},
+		{"get_state", v_get_state},
 
 		// atmospheric parameters
 		{"get_atmref", v_get_atmref},
@@ -1107,6 +1739,7 @@ void Interpreter::LoadSketchpadAPI ()
 		{"ellipse", skp_ellipse},
 		{"polygon", skp_polygon},
 		{"polyline", skp_polyline},
+		{"polylines", skp_polylines},
 		{"set_origin", skp_set_origin},
 		{"set_textalign", skp_set_textalign},
 		{"set_textcolor", skp_set_textcolor},
@@ -1155,7 +1788,8 @@ void Interpreter::LoadAnnotationAPI ()
 
 void Interpreter::LoadStartupScript ()
 {
-	luaL_dofile (L, "Script\\oapi_init.lua");
+	if (!g_ChunkCache.LoadFile (L, "Script\\oapi_init.lua"))
+		lua_pcall (L, 0, LUA_MULTRET, 0);
 }
 
 bool Interpreter::InitialiseVessel (lua_State *L, VESSEL *v)
@@ -1309,6 +1943,24 @@ int Interpreter::help_api (lua_State *L)
 	return 0;
 }
 
+int Interpreter::chunkLoadfile (lua_State *L)
+{
+	const char *fname = luaL_checkstring (L, 1);
+	if (!g_ChunkCache.LoadFile (L, fname)) return 1;
+	lua_pushnil (L);
+	lua_insert (L, -2); // nil, error message
+	return 2;
+}
+
+int Interpreter::chunkDofile (lua_State *L)
+{
+	const char *fname = luaL_checkstring (L, 1);
+	int n = lua_gettop (L);
+	if (g_ChunkCache.LoadFile (L, fname)) lua_error (L);
+	lua_call (L, 0, LUA_MULTRET);
+	return lua_gettop (L) - n;
+}
+
 // ============================================================================
 // vector library functions
 
@@ -1527,6 +2179,125 @@ int Interpreter::mat_mmul (lua_State *L)
 	return 1;
 }
 
+// ============================================================================
+// vector and matrix userdata metamethods
+
+int Interpreter::vec_unm (lua_State *L)
+{
+	lua_pushvector (L, -lua_tovector (L,1));
+	return 1;
+}
+
+// Fields other than x, y and z, which scripts used to be able to add to
+// vector tables, live in a table in the environment of the userdata.
+// Until the first one is set, the environment is the vector metatable,
+// which has none of them.
+
+int Interpreter::vec_index (lua_State *L)
+{
+	size_t len;
+	const char *key = (lua_type (L,2) == LUA_TSTRING ? lua_tolstring (L, 2, &len) : NULL);
+	if (key && len == 1 && key[0] >= 'x' && key[0] <= 'z') {
+		VECTOR3 *v = (VECTOR3*)lua_touserdata (L,1);
+		lua_pushnumber (L, v->data[key[0]-'x']);
+	} else {
+		lua_getfenv (L,1);
+		lua_getmetatable (L,1);
+		if (lua_rawequal (L,-1,-2)) {
+			lua_pushnil (L);
+		} else {
+			lua_pop (L,1);
+			lua_pushvalue (L,2);
+			lua_rawget (L,-2);
+		}
+	}
+	return 1;
+}
+
+int Interpreter::vec_newindex (lua_State *L)
+{
+	size_t len;
+	const char *key = (lua_type (L,2) == LUA_TSTRING ? lua_tolstring (L, 2, &len) : NULL);
+	if (key && len == 1 && key[0] >= 'x' && key[0] <= 'z') {
+		VECTOR3 *v = (VECTOR3*)lua_touserdata (L,1);
+		v->data[key[0]-'x'] = luaL_checknumber (L,3);
+	} else {
+		lua_getfenv (L,1);
+		lua_getmetatable (L,1);
+		if (lua_rawequal (L,-1,-2)) { // first extra field
+			lua_pop (L,2);
+			lua_newtable (L);
+			lua_pushvalue (L,-1);
+			lua_setfenv (L,1);
+		} else
+			lua_pop (L,1);
+		lua_pushvalue (L,2);
+		lua_pushvalue (L,3);
+		lua_rawset (L,-3);
+	}
+	return 0;
+}
+
+int Interpreter::vec_tostring (lua_State *L)
+{
+	lua_pushstring (L, lua_tostringex (L,1));
+	return 1;
+}
+
+int Interpreter::mat_mulop (lua_State *L)
+{
+	ASSERT_SYNTAX(lua_ismatrix(L,1), "Argument 1: expected matrix");
+	if (lua_ismatrix(L,2)) {
+		lua_pushmatrix (L, mul(lua_tomatrix(L,1), lua_tomatrix(L,2)));
+	} else if (lua_isvector(L,2)) {
+		lua_pushvector (L, mul(lua_tomatrix(L,1), lua_tovector(L,2)));
+	} else {
+		ASSERT_SYNTAX (lua_isnumber(L,2), "Argument 2: expected matrix, vector or number");
+		MATRIX3 m = lua_tomatrix(L,1);
+		double f = lua_tonumber(L,2);
+		for (int i = 0; i < 9; i++) m.data[i] *= f;
+		lua_pushmatrix (L, m);
+	}
+	return 1;
+}
+
+// returns the element index 0..8 for matrix field names "m11" ... "m33", or -1
+static int mat_field (lua_State *L, int idx)
+{
+	size_t len;
+	const char *key = lua_tolstring (L, idx, &len);
+	if (!key || len != 3 || key[0] != 'm' ||
+		key[1] < '1' || key[1] > '3' || key[2] < '1' || key[2] > '3') return -1;
+	return (key[1]-'1')*3 + (key[2]-'1');
+}
+
+int Interpreter::mat_index (lua_State *L)
+{
+	int i = mat_field (L,2);
+	if (i >= 0) {
+		MATRIX3 *m = (MATRIX3*)lua_touserdata (L,1);
+		lua_pushnumber (L, m->data[i]);
+	} else
+		lua_pushnil (L);
+	return 1;
+}
+
+int Interpreter::mat_newindex (lua_State *L)
+{
+	int i = mat_field (L,2);
+	if (i < 0)
+		return luaL_error (L, "invalid matrix field (expected m11 ... m33)");
+	MATRIX3 *m = (MATRIX3*)lua_touserdata (L,1);
+	m->data[i] = luaL_checknumber (L,3);
+	return 0;
+}
+
+int Interpreter::mat_tostring (lua_State *L)
+{
+	lua_pushstring (L, lua_tostringex (L,1));
+	return 1;
+}
+
 // ============================================================================
 // process library functions
 
@@ -1536,6 +2307,14 @@ int Interpreter::procFrameskip (lua_State *L)
 	// This should be called in the loop of any "wait"-type function
 
 	Interpreter *interp = GetInterpreter(L);
+	if (L == interp->co && interp->status != 1) {
+		// scheduler mode: resumed by the next cycle. Level 0 is this function.
+		// A wait loop can't make progress without yielding, so report a
+		// clear error rather than spinning in the orbiter thread.
+		if (!CanYield (L, 1))
+			return luaL_error (L, "proc.skip: can't suspend inside a C call (dofile, pcall); use loadfile");
+		return lua_yield (L, 0);
+	}
 	interp->frameskip (L);
 	return 0;
 }
@@ -1786,6 +2565,41 @@ int Interpreter::oapi_orthodome (lua_State *L)
 	return 1;
 }
 
+int Interpreter::oapi_profile (lua_State *L)
+{
+	Interpreter *interp = GetInterpreter (L);
+	ProfileData *prof = interp->prof;
+	if (!prof) { // profiling disabled
+		lua_pushnil (L);
+		return 1;
+	}
+	if (lua_toboolean (L, 1)) interp->WriteProfile ();
+
+	DWORD idx[PROF_NSLOT], i, n = prof->Sort (idx);
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency (&freq);
+	lua_createtable (L, 0, 7);
+	lua_pushnumber (L, (double)prof->ticks/freq.QuadPart); lua_setfield (L, -2, "time");
+	lua_pushnumber (L, prof->nrun);       lua_setfield (L, -2, "runs");
+	lua_pushnumber (L, prof->nsample);    lua_setfield (L, -2, "samples");
+	lua_pushnumber (L, profinterval);     lua_setfield (L, -2, "interval");
+	lua_pushnumber (L, prof->nsuspend);   lua_setfield (L, -2, "suspended");
+	lua_pushnumber (L, prof->nabort);     lua_setfield (L, -2, "aborted");
+	lua_createtable (L, n, 0);
+	for (i = 0; i < n; i++) {
+		const ProfileData::Func &f = prof->func[idx[i]];
+		lua_createtable (L, 0, 5);
+		lua_pushstring (L, f.name);       lua_setfield (L, -2, "name");
+		lua_pushstring (L, f.src);        lua_setfield (L, -2, "source");
+		lua_pushnumber (L, f.line);       lua_setfield (L, -2, "line");
+		lua_pushnumber (L, f.samples);    lua_setfield (L, -2, "samples");
+		lua_pushnumber (L, f.calls);      lua_setfield (L, -2, "calls");
+		lua_rawseti (L, -2, i+1);
+	}
+	lua_setfield (L, -2, "functions");
+	return 1;
+}
+
 int Interpreter::oapi_get_size (lua_State *L)
 {
 	OBJHANDLE hObj;
@@ -2766,7 +3580,15 @@ void AirfoilFunc (VESSEL *v, double aoa, double M, double Re,
 	lua_pushnumber (L, Re);                     // Reynolds number
 	
 	// call the script callback function
-	lua_call (L, 4, 3); // 4 arguments, 3 results
+	if (lua_pcall (L, 4, 3, 0)) { // 4 arguments, 3 results
+		// report the error and return zero coefficients
+		char cbuf[256];
+		sprintf (cbuf, "Airfoil callback %s: %.200s", ac->funcname, lua_tostring (L,-1));
+		oapiWriteLog (cbuf);
+		lua_pop(L,1);
+		*cl = *cm = *cd = 0.0;
+		return;
+	}
 
 	// retrieve results
 	*cl = lua_tonumber (L,-3);
@@ -2838,6 +3660,147 @@ int Interpreter::v_get_rotationmatrix (lua_State *L)
 	return 1;
 }
 
+// ============================================================================
+// Batched vessel state queries
+//
+// v:get_state(fields [,res]) returns several state parameters of a vessel in
+// one call. 'fields' is a list of parameter names; the values are stored in
+// table 'res' (or a new table) under the same names. Passing the same result
+// table every frame avoids allocating a new table. Vectors and matrices are
+// always stored as new objects, so values a script has kept from an earlier
+// call are not changed behind its back.
+//
+// Values are read from a per-vessel snapshot that is filled on demand and is
+// valid for the current simulation time, so all scripts polling the same
+// vessel within a time step share a single set of queries to the core.
+
+enum {
+	// scalar parameters
+	VS_ALT, VS_PITCH, VS_BANK, VS_YAW, VS_AIRSPEED, VS_AOA, VS_SLIP, VS_MACH,
+	VS_DYNPRESSURE, VS_ATMDENSITY, VS_ATMPRESSURE, VS_ATMTEMP, VS_MASS,
+	// vector parameters
+	VS_GLOBALPOS, VS_GLOBALVEL, VS_ANGVEL, VS_SHIPAIRSPEED, VS_HORIZONAIRSPEED,
+	// matrix parameters
+	VS_ROTMAT,
+	VS_NFIELD
+};
+#define VS_NSCALAR VS_GLOBALPOS
+#define VS_NVECTOR (VS_ROTMAT-VS_GLOBALPOS)
+
+struct VSField {
+	const char *name;
+	int id;
+};
+
+// field names, in alphabetical order for bsearch
+static const VSField vsfield[] = {
+	{"airspeed", VS_AIRSPEED},
+	{"alt", VS_ALT},
+	{"angvel", VS_ANGVEL},
+	{"aoa", VS_AOA},
+	{"atmdensity", VS_ATMDENSITY},
+	{"atmpressure", VS_ATMPRESSURE},
+	{"atmtemp", VS_ATMTEMP},
+	{"bank", VS_BANK},
+	{"dynpressure", VS_DYNPRESSURE},
+	{"globalpos", VS_GLOBALPOS},
+	{"globalvel", VS_GLOBALVEL},
+	{"horizonairspeed", VS_HORIZONAIRSPEED},
+	{"mach", VS_MACH},
+	{"mass", VS_MASS},
+	{"pitch", VS_PITCH},
+	{"rotmat", VS_ROTMAT},
+	{"shipairspeed", VS_SHIPAIRSPEED},
+	{"slip", VS_SLIP},
+	{"yaw", VS_YAW}
+};
+static const int nvsfield = sizeof(vsfield)/sizeof(VSField);
+
+static int vsfield_cmp (const void *key, const void *elem)
+{
+	return strcmp ((const char*)key, ((const VSField*)elem)->name);
+}
+
+struct VesselSnapshot {
+	VESSEL *v;                  // vessel the snapshot refers to
+	double simt;                // simulation time of the snapshot
+	DWORD valid;                // bit flags of fields queried at simt
+	double sval[VS_NSCALAR];    // scalar parameters
+	VECTOR3 vval[VS_NVECTOR];   // vector parameters
+	MATRIX3 rot;                // rotation matrix
+};
+
+// Snapshot cache, hashed by vessel pointer. A slot is reused by a different
+// vessel on collision, so this only costs a repeated query, never a wrong value.
+// Scripts are executed one at a time, so the cache needs no locking.
+#define NSNAPSHOT 64
+static VesselSnapshot vsnap[NSNAPSHOT];
+
+static VesselSnapshot *GetSnapshot (VESSEL *v)
+{
+	double simt = oapiGetSimTime();
+	VesselSnapshot *s = vsnap + (((size_t)v >> 4) & (NSNAPSHOT-1));
+	if (s->v != v || s->simt != simt) {
+		s->v = v;
+		s->simt = simt;
+		s->valid = 0;
+	}
+	return s;
+}
+
+static void FillSnapshot (VesselSnapshot *s, int id)
+{
+	VESSEL *v = s->v;
+	switch (id) {
+	case VS_ALT:             s->sval[id] = v->GetAltitude(); break;
+	case VS_PITCH:           s->sval[id] = v->GetPitch(); break;
+	case VS_BANK:            s->sval[id] = v->GetBank(); break;
+	case VS_YAW:             s->sval[id] = v->GetYaw(); break;
+	case VS_AIRSPEED:        s->sval[id] = v->GetAirspeed(); break;
+	case VS_AOA:             s->sval[id] = v->GetAOA(); break;
+	case VS_SLIP:            s->sval[id] = v->GetSlipAngle(); break;
+	case VS_MACH:            s->sval[id] = v->GetMachNumber(); break;
+	case VS_DYNPRESSURE:     s->sval[id] = v->GetDynPressure(); break;
+	case VS_ATMDENSITY:      s->sval[id] = v->GetAtmDensity(); break;
+	case VS_ATMPRESSURE:     s->sval[id] = v->GetAtmPressure(); break;
+	case VS_ATMTEMP:         s->sval[id] = v->GetAtmTemperature(); break;
+	case VS_MASS:            s->sval[id] = v->GetMass(); break;
+	case VS_GLOBALPOS:       v->GetGlobalPos (s->vval[id-VS_NSCALAR]); break;
+	case VS_GLOBALVEL:       v->GetGlobalVel (s->vval[id-VS_NSCALAR]); break;
+	case VS_ANGVEL:          v->GetAngularVel (s->vval[id-VS_NSCALAR]); break;
+	case VS_SHIPAIRSPEED:    v->GetShipAirspeedVector (s->vval[id-VS_NSCALAR]); break;
+	case VS_HORIZONAIRSPEED: v->GetHorizonAirspeedVector (s->vval[id-VS_NSCALAR]); break;
+	case VS_ROTMAT:          v->GetRotationMatrix (s->rot); break;
+	}
+	s->valid |= (1 << id);
+}
+
+int Interpreter::v_get_state (lua_State *L)
+{
+	VESSEL *v = lua_tovessel (L,1);
+	ASSERT_SYNTAX(v, "Invalid vessel object");
+	ASSERT_SYNTAX(lua_istable(L,2), "Argument 1: invalid type (expected table)");
+	int i, n = lua_objlen (L,2);
+	if (lua_istable (L,3)) lua_pushvalue (L,3);
+	else                   lua_createtable (L, 0, n);
+
+	VesselSnapshot *s = GetSnapshot (v);
+	for (i = 1; i <= n; i++) {
+		lua_rawgeti (L, 2, i);                             // field name
+		const char *name = lua_tostring (L,-1);
+		const VSField *f = (name ? (const VSField*)bsearch (name, vsfield, nvsfield, sizeof(VSField), vsfield_cmp) : 0);
+		ASSERT_SYNTAX(f, "Argument 1: unknown state parameter");
+		int id = f->id;
+		if (!(s->valid & (1 << id))) FillSnapshot (s, id);
+
+		if (id < VS_NSCALAR)     lua_pushnumber (L, s->sval[id]);
+		else if (id < VS_ROTMAT) lua_pushvector (L, s->vval[id-VS_NSCALAR]);
+		else                     lua_pushmatrix (L, s->rot);
+		lua_rawset (L,-3);                                 // res[name] = value
+	}
+	return 1;
+}
+
 int Interpreter::v_get_atmref (lua_State *L)
 {
 	VESSEL *v = lua_tovessel (L,1);
@@ -5397,71 +6360,118 @@ int Interpreter::skp_ellipse (lua_State *L)
 	return 0;
 }
 
-int Interpreter::skp_polygon (lua_State *L)
+void Interpreter::SkpReserve (int npt)
 {
-	oapi::IVECTOR2 *pt = 0;
-	int i, npt = 0, nbuf = 0;
-	oapi::Sketchpad *skp = lua_tosketchpad (L,1);
-	ASSERT_SYNTAX(skp, "Invalid sketchpad object");
-	ASSERT_MTDTABLE(L,2);
-	lua_pushnil(L);
-	while(lua_next(L,2)) {
-		ASSERT_TABLE(L,-1);
-		if (npt == nbuf) { // grow buffer
-			oapi::IVECTOR2 *tmp = new oapi::IVECTOR2[nbuf+=32];
-			if (npt) {
-				memcpy (tmp, pt, npt*sizeof(oapi::IVECTOR2));
-				delete []pt;
+	if (npt > nskppt) { // grow the vertex arena, preserving its contents
+		int nbuf;
+		for (nbuf = (nskppt ? nskppt*2 : 64); nbuf < npt; nbuf *= 2);
+		oapi::IVECTOR2 *tmp = new oapi::IVECTOR2[nbuf];
+		if (nskppt) {
+			memcpy (tmp, skppt, nskppt*sizeof(oapi::IVECTOR2));
+			delete []skppt;
+		}
+		skppt = tmp;
+		nskppt = nbuf;
+	}
+}
+
+int Interpreter::SkpReadPoints (lua_State *L, int idx, int ofs)
+{
+	// Read the vertex list at (absolute) stack position idx into the arena,
+	// starting at vertex ofs. The list is either flat {x1,y1,x2,y2,...} or
+	// nested {{x1,y1},{x2,y2},...}. Returns the number of vertices, or -1
+	// if the list is malformed.
+	if (!lua_istable (L,idx)) return -1;
+	int i, n = (int)lua_objlen (L,idx);
+	lua_rawgeti (L,idx,1);
+	bool flat = (lua_type (L,-1) == LUA_TNUMBER);
+	lua_pop (L,1);
+	if (flat) {
+		if (n & 1) return -1;
+		n /= 2;
+		SkpReserve (ofs+n);
+		oapi::IVECTOR2 *pt = skppt+ofs;
+		for (i = 0; i < n; i++) {
+			lua_rawgeti (L,idx,2*i+1);
+			lua_rawgeti (L,idx,2*i+2);
+			if (!lua_isnumber (L,-2) || !lua_isnumber (L,-1)) {
+				lua_pop (L,2);
+				return -1;
 			}
-			pt = tmp;
+			pt[i].x = (long)lua_tointeger(L,-2);
+			pt[i].y = (long)lua_tointeger(L,-1);
+			lua_pop (L,2);
 		}
-		lua_pushnil(L);
-		for (i = 0; i < 2; i++) {
-			ASSERT_SYNTAX(lua_next(L,-2),"Inconsistent vertex array");
-			pt[npt].data[i] = (long)lua_tointeger(L,-1);
-			lua_pop(L,1);
+	} else {
+		SkpReserve (ofs+n);
+		oapi::IVECTOR2 *pt = skppt+ofs;
+		for (i = 0; i < n; i++) {
+			lua_rawgeti (L,idx,i+1);
+			if (!lua_istable (L,-1)) {
+				lua_pop (L,1);
+				return -1;
+			}
+			lua_rawgeti (L,-1,1);
+			lua_rawgeti (L,-2,2);
+			if (!lua_isnumber (L,-2) || !lua_isnumber (L,-1)) { // missing coordinate
+				lua_pop (L,3);
+				return -1;
+			}
+			pt[i].x = (long)lua_tointeger(L,-2);
+			pt[i].y = (long)lua_tointeger(L,-1);
+			lua_pop (L,3);
 		}
-		npt++;
-		lua_pop(L,2); // pop last key and table
-	}
-	if (npt) {
-		skp->Polygon (pt, npt);
-		delete []pt;
 	}
+	return n;
+}
+
+int Interpreter::skp_polygon (lua_State *L)
+{
+	oapi::Sketchpad *skp = lua_tosketchpad (L,1);
+	ASSERT_SYNTAX(skp, "Invalid sketchpad object");
+	ASSERT_MTDTABLE(L,2);
+	Interpreter *interp = GetInterpreter(L);
+	int npt = interp->SkpReadPoints (L,2,0);
+	ASSERT_SYNTAX(npt >= 0, "Inconsistent vertex array");
+	if (npt) skp->Polygon (interp->skppt, npt);
 	return 0;
 }
 
 int Interpreter::skp_polyline (lua_State *L)
 {
-	oapi::IVECTOR2 *pt = 0;
-	int i, npt = 0, nbuf = 0;
 	oapi::Sketchpad *skp = lua_tosketchpad (L,1);
 	ASSERT_SYNTAX(skp, "Invalid sketchpad object");
 	ASSERT_MTDTABLE(L,2);
-	lua_pushnil(L);
-	while(lua_next(L,2)) {
-		ASSERT_TABLE(L,-1);
-		if (npt == nbuf) { // grow buffer
-			oapi::IVECTOR2 *tmp = new oapi::IVECTOR2[nbuf+=32];
-			if (npt) {
-				memcpy (tmp, pt, npt*sizeof(oapi::IVECTOR2));
-				delete []pt;
-			}
-			pt = tmp;
-		}
-		lua_pushnil(L);
-		for (i = 0; i < 2; i++) {
-			ASSERT_SYNTAX(lua_next(L,-2),"Inconsistent vertex array");
-			pt[npt].data[i] = (long)lua_tointeger(L,-1);
-			lua_pop(L,1);
-		}
-		npt++;
-		lua_pop(L,2); // pop last key and table
+	Interpreter *interp = GetInterpreter(L);
+	int npt = interp->SkpReadPoints (L,2,0);
+	ASSERT_SYNTAX(npt >= 0, "Inconsistent vertex array");
+	if (npt) skp->Polyline (interp->skppt, npt);
+	return 0;
+}
+
+int Interpreter::skp_polylines (lua_State *L)
+{
+	// skp:polylines{line1, line2, ...}: draw a set of polylines, each given
+	// as a vertex list in the format accepted by skp:polyline, with a
+	// single PolyPolyline call
+	oapi::Sketchpad *skp = lua_tosketchpad (L,1);
+	ASSERT_SYNTAX(skp, "Invalid sketchpad object");
+	ASSERT_MTDTABLE(L,2);
+	Interpreter *interp = GetInterpreter(L);
+	int i, n, npt = 0, nline = (int)lua_objlen (L,2);
+	if (nline > interp->nskpnpt) {
+		if (interp->skpnpt) delete []interp->skpnpt;
+		interp->skpnpt = new int[interp->nskpnpt = nline+16];
 	}
-	if (npt) {
-		skp->Polyline (pt, npt);
-		delete []pt;
+	for (i = 0; i < nline; i++) {
+		lua_rawgeti (L,2,i+1);
+		n = interp->SkpReadPoints (L,lua_gettop(L),npt);
+		lua_pop (L,1);
+		ASSERT_SYNTAX(n >= 0, "Inconsistent vertex array");
+		interp->skpnpt[i] = n;
+		npt += n;
 	}
+	if (npt) skp->PolyPolyline (interp->skppt, interp->skpnpt, nline);
 	return 0;
 }
 
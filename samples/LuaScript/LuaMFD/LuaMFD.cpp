@@ -163,19 +163,17 @@ void ScriptMFD::Update (HDC hDC)
 		nchar = (W-fw/2)/fw;
 		nline = (H-yofs-fh/2)/fh;
 	}
-	DWORD nbuf = env->interp->LineCount();
-	MFDInterpreter::LineSpec *ls = env->interp->FirstLine();
+	const TermBuffer &term = env->interp->Term();
+	DWORD i = term.First(), end = term.End();
 	int xofs = fw/2;
 	COLORREF col = 0;
-	for (; ls && nbuf > nline; ls = ls->next) { // skip lines scrolled out of sight
-		nbuf--;
-	}
-	for (; ls; ls = ls->next) {
-		if (ls->col != col) {
-			col = ls->col;
+	if (end-i > nline) i = end-nline; // skip lines scrolled out of sight
+	for (; i < end; i++) {
+		if (term.Attr(i) != col) {
+			col = term.Attr(i);
 			SetTextColor (hDC, col);
 		}
-		TextOut (hDC, xofs, yofs, ls->buf, min(strlen(ls->buf),nchar));
+		TextOut (hDC, xofs, yofs, term.Text(i), min(term.Len(i),nchar));
 		yofs += fh;
 	}
 	SelectObject (hDC, oFont);
@@ -4,11 +4,9 @@
 // ==============================================================
 // MFD interpreter class implementation
 
-MFDInterpreter::MFDInterpreter (): Interpreter ()
+MFDInterpreter::MFDInterpreter (): Interpreter (), term (NLINE, NCHAR)
 {
 	is_term = true;
-	lineFirst = lineLast = NULL;
-	nline = 0;
 }
 
 void MFDInterpreter::SetSelf (OBJHANDLE hV)
@@ -78,21 +76,7 @@ int MFDInterpreter::termSetVerbosity (lua_State *L)
 
 void MFDInterpreter::AddLine (const char *line, COLORREF col)
 {
-	LineSpec *ls = new LineSpec;
-	strncpy (ls->buf, line, NCHAR);
-	ls->buf[NCHAR-1] = '\0';
-	ls->col = col;
-	ls->prev = lineLast;
-	ls->next = NULL;
-	if (lineLast) lineLast->next = ls;
-	lineLast = ls;
-	if (!lineFirst) lineFirst = ls;
-	if (++nline > NLINE) {   // max line buffer size reached: drop first line
-		LineSpec *tmp = lineFirst;
-		lineFirst = lineFirst->next;
-		delete tmp;
-		nline--;
-	}
+	term.Append (line, col);
 }
 
 
@@ -102,6 +86,7 @@ void MFDInterpreter::AddLine (const char *line, COLORREF col)
 InterpreterList::Environment::Environment (OBJHANDLE hV)
 {
 	cmd[0] = '\0';
+	hThread = NULL;
 	interp = CreateInterpreter (hV);
 }
 
@@ -127,7 +112,10 @@ MFDInterpreter *InterpreterList::Environment::CreateInterpreter (OBJHANDLE hV)
 	interp = new MFDInterpreter ();
 	interp->Initialise();
 	interp->SetSelf (hV);
-	hThread = (HANDLE)_beginthreadex (NULL, 4096, &InterpreterThreadProc, this, 0, &id);
+	if (Interpreter::UseScheduler())
+		interp->SetScheduled (InterpreterCycle, this);
+	else
+		hThread = (HANDLE)_beginthreadex (NULL, 4096, &InterpreterThreadProc, this, 0, &id);
 	return interp;
 }
 
@@ -151,6 +139,17 @@ unsigned int WINAPI InterpreterList::Environment::InterpreterThreadProc (LPVOID
 	return 0;
 }
 
+// Interpreter cycle in scheduler mode (called from the orbiter thread)
+void InterpreterList::Environment::InterpreterCycle (void *context)
+{
+	InterpreterList::Environment *env = (InterpreterList::Environment*)context;
+	MFDInterpreter *interp = (MFDInterpreter*)env->interp;
+	if (interp->Status() == 1) return; // terminated
+	if (!interp->IsBusy() && !env->cmd[0] && !interp->nJobs()) return; // nothing to do
+	interp->RunChunk (env->cmd, strlen (env->cmd));
+	if (!interp->IsBusy()) env->cmd[0] = '\0'; // command completed: free buffer
+}
+
 // ==============================================================
 // Interpreter repository implementation
 
@@ -170,13 +169,15 @@ void InterpreterList::Update (double simt, double simdt, double mjd)
 	for (i = 0; i < nlist; i++) {
 		for (j = 0; j < list[i].nenv; j++) {
 			Environment *env = list[i].env[j];
-			if (env->interp->IsBusy() || env->cmd[0] || env->interp->nJobs()) { // let the interpreter do some work
+			if (!env->interp->IsScheduled() && // scheduled interpreters are served by Interpreter::Schedule
+				(env->interp->IsBusy() || env->cmd[0] || env->interp->nJobs())) { // let the interpreter do some work
 				env->interp->EndExec();
 				env->interp->WaitExec();
 			}
 			env->interp->PostStep (simt, simdt, mjd);
 		}
 	}
+	Interpreter::Schedule();
 }
 
 InterpreterList::Environment *InterpreterList::AddInterpreter (OBJHANDLE hV)
@@ -2,6 +2,7 @@
 #define __MFDINTERPRETER_H
 
 #include "Interpreter.h"
+#include "../../Common/TermBuffer.h"
 
 #define NCHAR 80 // characters per line in console buffer
 #define NLINE 50 // number of buffered lines
@@ -13,18 +14,11 @@ class InterpreterList;
 
 class MFDInterpreter: public Interpreter {
 public:
-	struct LineSpec {
-		char buf[NCHAR];
-		COLORREF col;
-		LineSpec *prev, *next;
-	};
-
 	MFDInterpreter ();
 	void SetSelf (OBJHANDLE hV);
 	void LoadAPI();
 	void AddLine (const char *line, COLORREF col);
-	inline LineSpec *FirstLine() const { return lineFirst; }
-	inline DWORD LineCount() const { return nline; }
+	inline const TermBuffer &Term() const { return term; } // line attribute: colour
 	void term_strout (const char *str);
 	void term_out (lua_State *L);
 
@@ -34,8 +28,7 @@ protected:
 	static int termSetVerbosity (lua_State *L);
 
 private:
-	LineSpec *lineFirst, *lineLast;
-	DWORD nline;
+	TermBuffer term;
 };
 
 // ==============================================================
@@ -51,6 +44,7 @@ public:
 		HANDLE hThread;
 		char cmd[1024];
 		static unsigned int WINAPI InterpreterThreadProc (LPVOID context);
+		static void InterpreterCycle (void *context); // scheduler mode
 	};
 	struct VesselInterp {
 		OBJHANDLE hVessel;
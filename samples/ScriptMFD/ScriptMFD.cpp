@@ -38,6 +38,25 @@ int nvinterp = 0;
 
 static char *cfgfile = "Config\\MFD\\ScriptMFD.cfg";
 
+// ==============================================================
+// Call a script callback with nargs arguments on the stack above
+// the function. Errors (including an exceeded instruction budget)
+// are logged rather than terminating the simulation. In that case
+// nres nil values are left on the stack in place of the results.
+
+static bool CallClbk (lua_State *L, int clbk, int nargs, int nres)
+{
+	if (lua_pcall (L, nargs, nres, 0)) {
+		char cbuf[256];
+		sprintf (cbuf, "ScriptMFD: %s: %.200s", CLBKNAME[clbk], lua_tostring (L, -1));
+		oapiWriteLog (cbuf);
+		lua_pop (L, 1);
+		for (int i = 0; i < nres; i++) lua_pushnil (L);
+		return false;
+	}
+	return true;
+}
+
 // ==============================================================
 // API interface
 
@@ -116,7 +135,7 @@ DLLCLBK void opcPreStep (double simt, double simdt, double mjd)
 			lua_pushnumber(L,simt);
 			lua_pushnumber(L,simdt);
 			lua_pushnumber(L,mjd);
-			lua_call (L, 3, 0);
+			CallClbk (L, PRESTEP, 3, 0);
 		}
 	}
 }
@@ -131,7 +150,7 @@ DLLCLBK void opcPostStep (double simt, double simdt, double mjd)
 			lua_pushnumber(L,simt);
 			lua_pushnumber(L,simdt);
 			lua_pushnumber(L,mjd);
-			lua_call (L, 3, 0);
+			CallClbk (L, POSTSTEP, 3, 0);
 		}
 	}
 }
@@ -203,7 +222,7 @@ ScriptMFD::ScriptMFD (DWORD w, DWORD h, VESSEL *vessel, const SCRIPTMFDMODESPEC
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[SETUP]);
 		lua_pushnumber(L, w);
 		lua_pushnumber(L, h);
-		lua_call (L, 2, 0);
+		CallClbk (L, SETUP, 2, 0);
 	}
 }
 
@@ -221,7 +240,7 @@ bool ScriptMFD::ConsumeButton (int bt, int event)
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[CONSUMEBUTTON]);
 		lua_pushnumber (L, bt);
 		lua_pushnumber (L, event);
-		lua_call (L, 2, 1);
+		CallClbk (L, CONSUMEBUTTON, 2, 1);
 		bool consumed = (lua_toboolean (L, -1) ? true : false);
 		lua_pop (L, 1);
 		return consumed;
@@ -235,7 +254,7 @@ bool ScriptMFD::ConsumeKeyBuffered (DWORD key)
 	if (bclbk[CONSUMEKEYBUFFERED]) {
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[CONSUMEKEYBUFFERED]);
 		lua_pushnumber (L, key);
-		lua_call (L, 1, 1);
+		CallClbk (L, CONSUMEKEYBUFFERED, 1, 1);
 		bool consumed = (lua_toboolean (L, -1) ? true : false);
 		lua_pop (L, 1);
 		return consumed;
@@ -248,7 +267,7 @@ bool ScriptMFD::ConsumeKeyImmediate (char *kstate)
 	if (bclbk[CONSUMEKEYIMMEDIATE]) {
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[CONSUMEKEYIMMEDIATE]);
 		lua_pushlightuserdata (L, kstate);
-		lua_call (L, 1, 1);
+		CallClbk (L, CONSUMEKEYIMMEDIATE, 1, 1);
 		bool consumed = (lua_toboolean (L, -1) ? true : false);
 		lua_pop (L, 1);
 		return consumed;
@@ -264,7 +283,7 @@ char *ScriptMFD::ButtonLabel (int bt)
 	if (bclbk[BUTTONLABEL]) {
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[BUTTONLABEL]);
 		lua_pushnumber (L, bt);
-		lua_call (L, 1, 1);
+		CallClbk (L, BUTTONLABEL, 1, 1);
 		if (lua_isstring (L, -1)) {
 			label = (char*)lua_tostring (L,-1);
 		}
@@ -282,7 +301,7 @@ int ScriptMFD::ButtonMenu (const MFDBUTTONMENU **menu) const
 		static MFDBUTTONMENU *mnu = 0;
 		static int nmnu = 0;
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[BUTTONMENU]);
-		lua_call (L, 0, 2);
+		CallClbk (L, BUTTONMENU, 0, 2);
 		if (lua_isnumber(L,-1)) {
 			nbt = lua_tointeger(L,-1);
 			if (menu) {
@@ -348,7 +367,7 @@ bool ScriptMFD::Update (oapi::Sketchpad *skp)
 	if (bclbk[UPDATE]) {
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[UPDATE]);
 		Interpreter::lua_pushsketchpad (L, skp);
-		lua_call (L, 1, 1);
+		CallClbk (L, UPDATE, 1, 1);
 		bool consumed = (lua_toboolean (L, -1) ? true : false);
 		lua_pop (L, 1);
 		return true; //consumed;
@@ -361,7 +380,7 @@ void ScriptMFD::StoreStatus () const
 {
 	if (bclbk[STORESTATUS]) {
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[STORESTATUS]);
-		lua_call (L, 0, 0);
+		CallClbk (L, STORESTATUS, 0, 0);
 	}
 }
 
@@ -370,7 +389,7 @@ void ScriptMFD::RecallStatus ()
 {
 	if (bclbk[RECALLSTATUS]) {
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[RECALLSTATUS]);
-		lua_call (L, 0, 0);
+		CallClbk (L, RECALLSTATUS, 0, 0);
 	}
 }
 
@@ -380,7 +399,7 @@ void ScriptMFD::WriteStatus (FILEHANDLE scn) const
 	if (bclbk[WRITESTATUS]) {
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[WRITESTATUS]);
 		lua_pushlightuserdata (L, scn);
-		lua_call (L, 1, 0);
+		CallClbk (L, WRITESTATUS, 1, 0);
 	}
 }
 
@@ -390,7 +409,7 @@ void ScriptMFD::ReadStatus (FILEHANDLE scn)
 	if (bclbk[READSTATUS]) {
 		lua_getfield (L, LUA_GLOBALSINDEX, CLBKNAME[READSTATUS]);
 		lua_pushlightuserdata (L, scn);
-		lua_call (L, 1, 0);
+		CallClbk (L, READSTATUS, 1, 0);
 	}
 }
 
@@ -13,6 +13,8 @@
 // This class creates an interpreter instance, loads a vessel class-
 // specific script and and implements the VESSEL2 callback functions
 // by calling corresponding script functions.
+// Optionally, all vessels of a class can share a single interpreter
+// instance (see ScriptClass below).
 // ==============================================================
 
 #define STRICT
@@ -20,8 +22,10 @@
 
 extern "C" {
 #include "Lua\lua.h"
+#include "Lua\lauxlib.h"
 }
 #include "orbitersdk.h"
+#include "../Common/AeroTable.h"
 
 const int NCLBK        = 4;
 const int SETCLASSCAPS = 0;
@@ -33,20 +37,104 @@ const char *CLBKNAME[NCLBK] = {
 	"setclasscaps", "postcreation", "prestep", "poststep"
 };
 
+// Lift coefficient table, shared by all ScriptVessel instances.
+// Built by DefineLiftTable at class caps time.
+static AeroTable lift;
+
 // Calculate lift coefficient [Cl] as a function of aoa (angle of attack) over -Pi ... Pi
 // Implemented here as a piecewise linear function
 double LiftCoeff (double aoa)
 {
-	int i;
+	return lift.Cl (aoa);
+}
+
+static void DefineLiftTable ()
+{
+	if (lift.Defined()) return;
+
 	const int nlift = 9;
 	static const double AOA[nlift] = {-180*RAD,-60*RAD,-30*RAD,-1*RAD,15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
 	static const double CL[nlift]  = {       0,      0,   -0.1,     0,   0.2,  0.25,   0.2,     0,      0};
-	static const double SCL[nlift] = {(CL[1]-CL[0])/(AOA[1]-AOA[0]), (CL[2]-CL[1])/(AOA[2]-AOA[1]),
-		                              (CL[3]-CL[2])/(AOA[3]-AOA[2]), (CL[4]-CL[3])/(AOA[4]-AOA[3]),
-									  (CL[5]-CL[4])/(AOA[5]-AOA[4]), (CL[6]-CL[5])/(AOA[6]-AOA[5]),
-									  (CL[7]-CL[6])/(AOA[7]-AOA[6]), (CL[8]-CL[7])/(AOA[8]-AOA[7])};
-	for (i = 0; i < nlift-1 && AOA[i+1] < aoa; i++);
-	return CL[i] + (aoa-AOA[i])*SCL[i];
+	lift.SetLift (nlift, AOA, CL);
+}
+
+// ==============================================================
+// Compile the vessel script Config/Vessels/<script>[.lua] and push the
+// chunk, or log the error and return false. Both interpreter modes load
+// their script through here, using the interpreter's loadfile (and
+// thereby its precompiled chunk cache).
+// ==============================================================
+
+static bool LoadScript (lua_State *L, const char *script)
+{
+	char path[256];
+	sprintf (path, "Config/Vessels/%.200s", script);
+	if (!strchr (script, '.')) strcat (path, ".lua");
+	lua_getfield (L, LUA_GLOBALSINDEX, "loadfile");
+	lua_pushstring (L, path);
+	lua_call (L, 1, 2);
+	if (lua_isnil (L, -2)) {
+		oapiWriteLog ((char*)lua_tostring (L, -1));
+		lua_pop (L, 2);
+		return false;
+	}
+	lua_pop (L, 1);
+	return true;
+}
+
+// ==============================================================
+// Shared interpreter for all vessels of a script class
+//
+// In shared mode (class config: SharedInterpreter = TRUE), all
+// vessels using the same script share one interpreter instance.
+// The script file is compiled once, and the compiled chunk is run
+// for each vessel inside a private environment table, so that the
+// callback functions and any global variables set by the script
+// are instance-specific, while the code itself is shared.
+// ==============================================================
+
+struct ScriptClass {
+	char script[256];          // script name as given in the class config
+	INTERPRETERHANDLE hInterp; // shared interpreter instance
+	lua_State *L;              // Lua state of the interpreter
+	int chunkref;              // registry reference to the compiled script
+	int nref;                  // number of vessels using this class
+	ScriptClass *next;
+};
+
+ScriptClass *g_ScriptClass = 0; // list of shared script classes
+
+ScriptClass *AcquireScriptClass (const char *script)
+{
+	ScriptClass *sc;
+	for (sc = g_ScriptClass; sc; sc = sc->next)
+		if (!strcmp (sc->script, script)) {
+			sc->nref++;
+			return sc;
+		}
+
+	sc = new ScriptClass;
+	strncpy (sc->script, script, 255); sc->script[255] = '\0';
+	sc->hInterp = oapiCreateInterpreter();
+	sc->L = oapiGetLua (sc->hInterp);
+	sc->nref = 1;
+
+	// compile the script once and keep the chunk in the registry
+	sc->chunkref = (LoadScript (sc->L, script) ? luaL_ref (sc->L, LUA_REGISTRYINDEX) : LUA_NOREF);
+
+	sc->next = g_ScriptClass;
+	g_ScriptClass = sc;
+	return sc;
+}
+
+void ReleaseScriptClass (ScriptClass *sc)
+{
+	if (--sc->nref) return;
+	ScriptClass **psc;
+	for (psc = &g_ScriptClass; *psc != sc; psc = &(*psc)->next);
+	*psc = sc->next;
+	oapiDelInterpreter (sc->hInterp);
+	delete sc;
 }
 
 // ==============================================================
@@ -63,11 +151,16 @@ public:
 	void clbkPostStep (double simt, double simdt, double mjd);
 
 protected:
-	INTERPRETERHANDLE hInterp;
+	void LoadPrivate (const char *script);
+	void LoadShared (const char *script);
+	void CallClbk (int clbk, int nargs);
+
+	INTERPRETERHANDLE hInterp; // private interpreter (0 in shared mode)
+	ScriptClass *sclass;       // shared interpreter (0 in private mode)
 	lua_State *L;
 
-	bool bclbk[NCLBK];
-	char func[256];
+	int envref;                // registry reference to the instance environment (shared mode)
+	int clbkref[NCLBK];        // registry references to the script callback functions
 };
 
 // ==============================================================
@@ -75,16 +168,113 @@ protected:
 // ==============================================================
 ScriptVessel::ScriptVessel (OBJHANDLE hVessel, int flightmodel): VESSEL2 (hVessel, flightmodel)
 {
+	// the interpreter is created in clbkSetClassCaps, once the
+	// sharing mode is known
+	hInterp = 0;
+	sclass = 0;
+	L = 0;
+	envref = LUA_NOREF;
+	for (int i = 0; i < NCLBK; i++) clbkref[i] = LUA_NOREF;
+}
+
+ScriptVessel::~ScriptVessel ()
+{
+	if (sclass) {
+		// release the instance environment and callbacks, and the shared interpreter
+		for (int i = 0; i < NCLBK; i++) luaL_unref (L, LUA_REGISTRYINDEX, clbkref[i]);
+		luaL_unref (L, LUA_REGISTRYINDEX, envref);
+		ReleaseScriptClass (sclass);
+	} else if (hInterp) {
+		// delete the interpreter instance
+		oapiDelInterpreter (hInterp);
+	}
+}
+
+// ==============================================================
+// Script loading
+// ==============================================================
+
+// --------------------------------------------------------------
+// Private mode: run the script in an interpreter of our own
+// --------------------------------------------------------------
+void ScriptVessel::LoadPrivate (const char *script)
+{
+	char cmd[256];
+
 	// create the interpreter instance to run the vessel script
 	hInterp = oapiCreateInterpreter();
 	L = oapiGetLua (hInterp);
-	strcpy (func, "clbk_");
+
+	// Run the vessel script in the interpreter globals
+	if (LoadScript (L, script) && lua_pcall (L, 0, 0, 0)) {
+		oapiWriteLog ((char*)lua_tostring (L, -1));
+		lua_pop (L, 1);
+	}
+
+	// Define the vessel instance
+	lua_pushlightuserdata (L, GetHandle());  // push vessel handle
+	lua_setfield (L, LUA_GLOBALSINDEX, "hVessel");
+	strcpy (cmd, "vi = vessel.get_interface(hVessel)");
+	oapiExecScriptCmd (hInterp, cmd);
+
+	lua_pushvalue (L, LUA_GLOBALSINDEX);     // callbacks are looked up in the globals
 }
 
-ScriptVessel::~ScriptVessel ()
+// --------------------------------------------------------------
+// Shared mode: run the compiled class script in a private
+// environment table in the shared interpreter
+// --------------------------------------------------------------
+void ScriptVessel::LoadShared (const char *script)
+{
+	sclass = AcquireScriptClass (script);
+	L = sclass->L;
+
+	// instance environment, falling back to the interpreter globals
+	lua_newtable (L);
+	lua_newtable (L);
+	lua_pushvalue (L, LUA_GLOBALSINDEX);
+	lua_setfield (L, -2, "__index");
+	lua_setmetatable (L, -2);
+
+	// Define the vessel instance
+	lua_pushlightuserdata (L, GetHandle());
+	lua_setfield (L, -2, "hVessel");
+	lua_getfield (L, LUA_GLOBALSINDEX, "vessel");
+	lua_getfield (L, -1, "get_interface");
+	lua_pushlightuserdata (L, GetHandle());
+	lua_call (L, 1, 1);
+	lua_setfield (L, -3, "vi");
+	lua_pop (L, 1);
+
+	// Run the script in the instance environment. Functions defined by the
+	// script inherit this environment, so each instance gets its own set.
+	if (sclass->chunkref != LUA_NOREF) {
+		lua_rawgeti (L, LUA_REGISTRYINDEX, sclass->chunkref);
+		lua_pushvalue (L, -2);
+		lua_setfenv (L, -2);
+		if (lua_pcall (L, 0, 0, 0)) {
+			oapiWriteLog ((char*)lua_tostring (L, -1));
+			lua_pop (L, 1);
+		}
+	}
+
+	lua_pushvalue (L, -1);
+	envref = luaL_ref (L, LUA_REGISTRYINDEX); // environment table stays on the stack
+}
+
+// --------------------------------------------------------------
+// Call a script callback with nargs arguments on the stack above
+// the function. Errors (including an exceeded instruction budget)
+// are logged rather than terminating the simulation.
+// --------------------------------------------------------------
+void ScriptVessel::CallClbk (int clbk, int nargs)
 {
-	// delete the interpreter instance
-	oapiDelInterpreter (hInterp);
+	if (lua_pcall (L, nargs, 0, 0)) {
+		char cbuf[256];
+		sprintf (cbuf, "ScriptVessel: clbk_%s: %.200s", CLBKNAME[clbk], lua_tostring (L, -1));
+		oapiWriteLog (cbuf);
+		lua_pop (L, 1);
+	}
 }
 
 // ==============================================================
@@ -96,67 +286,63 @@ ScriptVessel::~ScriptVessel ()
 // --------------------------------------------------------------
 void ScriptVessel::clbkSetClassCaps (FILEHANDLE cfg)
 {
-	char script[256], cmd[256];
+	char script[256], func[256];
+	bool shared = false;
 	int i;
 
+	DefineLiftTable ();
+
 	// Load the vessel script
 	oapiReadItem_string (cfg, "Script", script);
-	sprintf (cmd, "run_global('Config/Vessels/%s')", script);
-	oapiExecScriptCmd (hInterp, cmd);
-
-	// Define the vessel instance
-	lua_pushlightuserdata (L, GetHandle());  // push vessel handle
-	lua_setfield (L, LUA_GLOBALSINDEX, "hVessel");
-	strcpy (cmd, "vi = vessel.get_interface(hVessel)");
-	oapiExecScriptCmd (hInterp, cmd);
+	oapiReadItem_bool (cfg, "SharedInterpreter", shared);
+	if (shared) LoadShared (script);
+	else        LoadPrivate (script);
 
-	// check for defined callback functions in script
+	// check for defined callback functions in script, and keep references
+	// to them so they don't need to be looked up by name at each call
 	for (i = 0; i < NCLBK; i++) {
-		strcpy (func+5, CLBKNAME[i]);
-		lua_getfield (L, LUA_GLOBALSINDEX, func);
-		bclbk[i] = (lua_isfunction (L,-1) != 0);
-		lua_pop(L,1);
+		sprintf (func, "clbk_%s", CLBKNAME[i]);
+		lua_getfield (L, -1, func);
+		if (lua_isfunction (L,-1)) clbkref[i] = luaL_ref (L, LUA_REGISTRYINDEX);
+		else lua_pop(L,1);
 	}
+	lua_pop (L,1); // callback table
 
 	// Run the SetClassCaps function
-	if (bclbk[SETCLASSCAPS]) {
-		strcpy (func+5, "setclasscaps");
-		lua_getfield (L, LUA_GLOBALSINDEX, func);
+	if (clbkref[SETCLASSCAPS] != LUA_NOREF) {
+		lua_rawgeti (L, LUA_REGISTRYINDEX, clbkref[SETCLASSCAPS]);
 		lua_pushlightuserdata (L, cfg);
-		lua_call (L, 1, 0);
+		CallClbk (SETCLASSCAPS, 1);
 	}
 }
 
 void ScriptVessel::clbkPostCreation ()
 {
-	if (bclbk[POSTCREATION]) {
-		strcpy (func+5, "postcreation");
-		lua_getfield (L, LUA_GLOBALSINDEX, func);
-		lua_call (L, 0, 0);
+	if (clbkref[POSTCREATION] != LUA_NOREF) {
+		lua_rawgeti (L, LUA_REGISTRYINDEX, clbkref[POSTCREATION]);
+		CallClbk (POSTCREATION, 0);
 	}
 }
 
 void ScriptVessel::clbkPreStep (double simt, double simdt, double mjd)
 {
-	if (bclbk[PRESTEP]) {
-		strcpy (func+5, "prestep");
-		lua_getfield (L, LUA_GLOBALSINDEX, func);
+	if (clbkref[PRESTEP] != LUA_NOREF) {
+		lua_rawgeti (L, LUA_REGISTRYINDEX, clbkref[PRESTEP]);
 		lua_pushnumber(L,simt);
 		lua_pushnumber(L,simdt);
 		lua_pushnumber(L,mjd);
-		lua_call (L, 3, 0);
+		CallClbk (PRESTEP, 3);
 	}
 }
 
 void ScriptVessel::clbkPostStep (double simt, double simdt, double mjd)
 {
-	if (bclbk[POSTSTEP]) {
-		strcpy (func+5, "poststep");
-		lua_getfield (L, LUA_GLOBALSINDEX, func);
+	if (clbkref[POSTSTEP] != LUA_NOREF) {
+		lua_rawgeti (L, LUA_REGISTRYINDEX, clbkref[POSTSTEP]);
 		lua_pushnumber(L,simt);
 		lua_pushnumber(L,simdt);
 		lua_pushnumber(L,mjd);
-		lua_call (L, 3, 0);
+		CallClbk (POSTSTEP, 3);
 	}
 }
 
@@ -15,6 +15,8 @@
 #include "ScnEditorAPI.h"
 #include "DlgCtrl.h"
 #include "resource.h"
+#include "../Common/AttachIndex.h"
+#include "../Common/AeroTable.h"
 #include <math.h>
 #include <stdio.h>
 
@@ -25,28 +27,34 @@
 // ==============================================================
 
 GDIParams g_Param;
+AttachIndex *g_AttachIndex = 0; // grappling candidate search
 
 
 // ==============================================================
 // Airfoil definition
 // ==============================================================
 
+// Coefficient table, shared by all ShuttleA instances.
+// Built by DefineAirfoilTable at class caps time.
+static AeroTable lift;
+
 void Shuttle_MomentCoeff (double aoa,double M,double Re,double *cl,double *cm,double *cd)
 {
-	int i;
+	lift.Eval (aoa, M, cl, cm, cd);
+}
+
+// drag: profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+
+static void DefineAirfoilTable ()
+{
+	if (lift.Defined()) return;
+
 	const int nabsc = 7;
 	static const double AOA[nabsc] = {-180*RAD, -90*RAD,-30*RAD, 0*RAD, 60*RAD,90*RAD,180*RAD};
 	static const double CL[nabsc]  = {       0,      0,   -0.004,     0,     0.008,     0,      0};
 	static const double CM[nabsc]  = {       0,      0,   0.0014,  0,-0.0012,     0,      0};
-	
-	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
-	double f = (aoa-AOA[i]) / (AOA[i+1]-AOA[i]);
-	*cl = CL[i] + (CL[i+1]-CL[i]) * f;  // aoa-dependent lift coefficient
-	*cm = CM[i] + (CM[i+1]-CM[i]) * f;  // aoa-dependent moment coefficient
-	double saoa = sin(aoa);
-	double pd = 0.045 + 0.4*saoa*saoa;  // profile drag
-	*cd = pd + oapiGetInducedDrag (*cl, 0.1,0.7) + oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);
-	// profile drag + (lift-)induced drag + transonic/supersonic wave (compressibility) drag
+	lift.SetLift (nabsc, AOA, CL, CM, 0.045, 0.4, 0.1, 0.7);
+	lift.SetWaveDrag (0.75, 1.0, 1.1, 0.04);
 }
 // ==============================================================
 // Specialised vessel class ShuttleA
@@ -56,16 +64,16 @@ void Shuttle_MomentCoeff (double aoa,double M,double Re,double *cl,double *cm,do
 // Constructor
 // --------------------------------------------------------------
 ShuttleA::ShuttleA (OBJHANDLE hObj, int fmodel)
-: VESSEL3 (hObj, fmodel)
+: VESSEL3 (hObj, fmodel),
+  dock_status (act.State(ACT_DOCK).action), lock_status (act.State(ACT_LOCK).action),
+  gear_status (act.State(ACT_GEAR).action),
+  dock_proc (act.State(ACT_DOCK).pos), lock_proc (act.State(ACT_LOCK).pos),
+  gear_proc (act.State(ACT_GEAR).pos)
 {
 	int i;
-	dock_proc = 0.0;
-	dock_status = DOOR_CLOSED;
-	lock_proc = 0.0;
-	lock_status = DOOR_CLOSED;
-	gear_proc = 0.0;
-	gear_status = DOOR_CLOSED;
+	hudscl = 0;
 	DefineAnimations ();
+	DefineActuators ();
 	for (i = 0; i < nsurf; i++)
 		srf[i] = 0;
 	for (i = 0; i < 2; i++) {
@@ -260,6 +268,46 @@ void ShuttleA::DefineAnimations ()
 
 }
 
+// --------------------------------------------------------------
+// Define docking hatch, airlock and gear actuators
+// --------------------------------------------------------------
+void ShuttleA::DefineActuators ()
+{
+	act.Init (this, this);
+	act.Define (ACT_DOCK, DOCK_OPERATING_SPEED,    anim_dock, 0,             ActuatorDone);
+	act.Define (ACT_LOCK, AIRLOCK_OPERATING_SPEED, anim_lock, 0,             ActuatorDone);
+	act.Define (ACT_GEAR, GEAR_OPERATING_SPEED,    anim_gear, ActuatorMoved, ActuatorDone);
+}
+
+// --------------------------------------------------------------
+// Actuator callback: adjust touchdown points while the gear moves
+// --------------------------------------------------------------
+void ShuttleA::ActuatorMoved (void *context, int id, const AnimState &state)
+{
+	if (id == ACT_GEAR)
+		((ShuttleA*)context)->SetGearParameters (state.pos);
+}
+
+// --------------------------------------------------------------
+// Actuator callback: update panel indicators at the end position
+// --------------------------------------------------------------
+void ShuttleA::ActuatorDone (void *context, int id, const AnimState &state)
+{
+	switch (id) {
+	case ACT_DOCK: oapiTriggerRedrawArea (1, 0, AID_DOCKINDICATOR); break;
+	case ACT_LOCK: oapiTriggerRedrawArea (1, 0, AID_AIRLOCK1INDICATOR); break;
+	case ACT_GEAR: oapiTriggerRedrawArea (1, 0, AID_GEARINDICATOR); break;
+	}
+}
+
+// --------------------------------------------------------------
+// Set touchdown points for gear position state (0=retracted, 1=deployed)
+// --------------------------------------------------------------
+void ShuttleA::SetGearParameters (double state)
+{
+	SetTouchdownPoints (_V(0,-2.93+state*0.555,9), _V(-2,-2.93+state*0.555,-8), _V(2,-2.93+state*0.555,-8));
+}
+
 // --------------------------------------------------------------
 // 
 // --------------------------------------------------------------
@@ -378,12 +426,8 @@ void ShuttleA::SetPodAngle (UINT which, double angle)
 // --------------------------------------------------------------
 void ShuttleA::ActivateDockingPort (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	dock_status = action;
-	if (action <= DOOR_OPEN) {
-		dock_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_dock, dock_proc);
-	}
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_DOCK, action);
 	oapiTriggerRedrawArea (1, 0,AID_DOCKSWITCH);
 	oapiTriggerRedrawArea (1, 0,AID_DOCKINDICATOR);
 	RecordEvent ("DOCK", close ? "CLOSE" : "OPEN");
@@ -394,8 +438,8 @@ void ShuttleA::ActivateDockingPort (DoorStatus action)
 // --------------------------------------------------------------
 void ShuttleA::RevertDockingPort ()
 {
-	ActivateDockingPort (dock_status == DOOR_CLOSED || dock_status == DOOR_CLOSING ?
-						 DOOR_OPENING : DOOR_CLOSING);
+	ActivateDockingPort (dock_status == AnimState::CLOSED || dock_status == AnimState::CLOSING ?
+						 AnimState::OPENING : AnimState::CLOSING);
 }
 
 // --------------------------------------------------------------
@@ -403,12 +447,8 @@ void ShuttleA::RevertDockingPort ()
 // --------------------------------------------------------------
 void ShuttleA::ActivateAirlock (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	lock_status = action;
-	if (action <= DOOR_OPEN) {
-		lock_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_lock, lock_proc);
-	}
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_LOCK, action);
 	oapiTriggerRedrawArea (1,0, AID_AIRLOCK1SWITCH);
 	oapiTriggerRedrawArea (1,0, AID_AIRLOCK1INDICATOR);
 	RecordEvent ("AIRLOCK", close ? "CLOSE" : "OPEN");
@@ -419,8 +459,8 @@ void ShuttleA::ActivateAirlock (DoorStatus action)
 // --------------------------------------------------------------
 void ShuttleA::RevertAirlock ()
 {
-	ActivateAirlock (lock_status == DOOR_CLOSED || lock_status == DOOR_CLOSING ?
-		             DOOR_OPENING : DOOR_CLOSING);
+	ActivateAirlock (lock_status == AnimState::CLOSED || lock_status == AnimState::CLOSING ?
+		             AnimState::OPENING : AnimState::CLOSING);
 }
 
 // --------------------------------------------------------------
@@ -428,12 +468,10 @@ void ShuttleA::RevertAirlock ()
 // --------------------------------------------------------------
 void ShuttleA::ActivateLandingGear (DoorStatus action)
 {
-	bool close = (action == DOOR_CLOSED || action == DOOR_CLOSING);
-	gear_status = action;
-	if (action <= DOOR_OPEN) {
-		gear_proc = (action == DOOR_CLOSED ? 0.0 : 1.0);
-		SetAnimation (anim_gear, gear_proc);
-	}
+	bool close = (action == AnimState::CLOSED || action == AnimState::CLOSING);
+	act.Operate (ACT_GEAR, action);
+	if (action <= AnimState::OPEN)
+		SetGearParameters (gear_proc);
 	oapiTriggerRedrawArea (1, 0,AID_GEARSWITCH);
 	oapiTriggerRedrawArea (1, 0,AID_GEARINDICATOR);
 	RecordEvent ("GEAR", close ? "UP" : "DOWN");
@@ -444,8 +482,8 @@ void ShuttleA::ActivateLandingGear (DoorStatus action)
 // --------------------------------------------------------------
 void ShuttleA::RevertLandingGear ()
 {
-	ActivateLandingGear (gear_status == DOOR_CLOSED || gear_status == DOOR_CLOSING ?
-		             DOOR_OPENING : DOOR_CLOSING);
+	ActivateLandingGear (gear_status == AnimState::CLOSED || gear_status == AnimState::CLOSING ?
+		             AnimState::OPENING : AnimState::CLOSING);
 }
 
 // --------------------------------------------------------------
@@ -467,6 +505,26 @@ void ShuttleA::ActivateCargo (int status)
 	RecordEvent ("CARGO", status ? "ARM" : "DISARM");
 }
 
+// --------------------------------------------------------------
+// Grappling candidate filter
+// --------------------------------------------------------------
+// Orientation of a payload attachment point, for grappling candidate checks
+struct GrappleAlign {
+	VECTOR3 gdir, grot; // attachment direction and rotation in the global frame
+};
+
+// check if the attachment points are pointing the right way
+static bool GrappleAligned (VESSEL *v, ATTACHMENTHANDLE hAtt, void *context)
+{
+	const GrappleAlign *align = (const GrappleAlign*)context;
+	VECTOR3 pos, dir, rot, gcdir, gcrot;
+	v->GetAttachmentParams (hAtt, pos, dir, rot);
+	v->GlobalRot(rot,gcrot);
+	v->GlobalRot(dir,gcdir); //should be normal by now
+	//dotrot=1 and dotdir=-1(same up vector, but opposing dir vectors)
+	return (dotp(align->grot,gcrot)>MAX_GRAPPLING_ANG)&&(dotp(align->gdir,gcdir)<-MAX_GRAPPLING_ANG);
+}
+
 // --------------------------------------------------------------
 // 
 // --------------------------------------------------------------
@@ -485,43 +543,21 @@ bool ShuttleA::ToggleGrapple (int grapple)
 
 	} else {             // grapple payload
 
-		VECTOR3 gpos, grms, pos, dir, rot;
-		VECTOR3 gdir,grot;
-		VECTOR3 gcdir,gcrot;
+		VECTOR3 grms, pos, dir, rot;
+		GrappleAlign align;
 		GetAttachmentParams (payload_attachment[grapple], pos, dir, rot);
 		Local2Global (pos, grms);	//local attach point to global frame
-		GlobalRot(rot,grot);
-		GlobalRot(dir,gdir);
-		// Search the complete vessel list for a grappling candidate.
-		// Not very scalable ...
-		for (DWORD i = 0; i < oapiGetVesselCount(); i++) {
-			OBJHANDLE hV = oapiGetVesselByIndex (i);
-			if (hV == GetHandle()) continue; // we don't want to grapple ourselves ...
-			oapiGetGlobalPos (hV, &gpos);
-			if (dist (gpos, grms) < oapiGetSize (hV)) { // in range
-				VESSEL *v = oapiGetVesselInterface (hV);
-				DWORD nAttach = v->AttachmentCount (true);
-				for (DWORD j = 0; j < nAttach; j++) { // now scan all attachment points of the candidate
-					ATTACHMENTHANDLE hAtt = v->GetAttachmentHandle (true, j);
-					const char *id = v->GetAttachmentId (hAtt);
-					if (strncmp (id, "SH", 2)) continue; // attachment point not compatible
-					v->GetAttachmentParams (hAtt, pos, dir, rot);
-					v->Local2Global (pos, gpos);
-					if (dist (gpos, grms) < MAX_GRAPPLING_DIST) { // found one!
-						
-						// check if the attachment points are pointing the right way
-						v->GlobalRot(rot,gcrot);
-						v->GlobalRot(dir,gcdir); //should be normal by now
-						if ((dotp(grot,gcrot)>MAX_GRAPPLING_ANG)&&(dotp(gdir,gcdir)<-MAX_GRAPPLING_ANG))//dotrot=1 and dotdir=-1(same up vector, but opposing dir vectors)
-						{
-							AttachChild (hV, payload_attachment[grapple], hAtt);
-							ComputePayloadMass();
-							RecordEvent ("CARGO", cbuf);
-							return true;
-						}
-					}
-				}
-			}
+		GlobalRot(rot,align.grot);
+		GlobalRot(dir,align.gdir);
+		// Find the closest compatible and aligned attachment point within reach
+		OBJHANDLE hV;
+		ATTACHMENTHANDLE hAtt = g_AttachIndex->FindNearest (grms, MAX_GRAPPLING_DIST, "SH", GetHandle(), &hV,
+			GrappleAligned, &align);
+		if (hAtt) {
+			AttachChild (hV, payload_attachment[grapple], hAtt);
+			ComputePayloadMass();
+			RecordEvent ("CARGO", cbuf);
+			return true;
 		}
 	}
 
@@ -563,7 +599,7 @@ void ShuttleA::RedrawPanel_MFDButton (SURFHANDLE surf, int mfd, int side)
 	SetBkMode (hDC, TRANSPARENT);
 	const char *label;
 	for (int bt = 0; bt < 6; bt++) {
-		if (label = oapiMFDButtonLabel (mfd, bt+side*6))
+		if ((label = oapiMFDButtonLabel (mfd, bt+side*6)))
 			TextOut (hDC, 13, 3+38*bt, label, strlen(label));
 		else break;
 	}
@@ -949,7 +985,6 @@ void ShuttleA::clbkSetClassCaps (FILEHANDLE cfg)
 	SetPMI (_V(86.6, 89.8, 5.5));
 	SetEmptyMass (EMPTY_MASS);
 	payload_mass = 0.0;
-	VECTOR3 r[2] = {{0,0,8}, {0,0,-8}};
 	SetGravityGradientDamping (20.0);
 	SetCW (0.2, 0.2, 1.5, 1.5);
 	SetCrossSections (_V(132.2, 237.9, 42.4));
@@ -1086,6 +1121,7 @@ void ShuttleA::clbkSetClassCaps (FILEHANDLE cfg)
 
 	// ************************ Airfoil  ****************************
 	ClearAirfoilDefinitions();
+	DefineAirfoilTable();
 	CreateAirfoil (LIFT_VERTICAL, _V(0,0,0), Shuttle_MomentCoeff,  8, 140, 0.1);
 
 
@@ -1132,11 +1168,11 @@ void ShuttleA::clbkLoadStateEx (FILEHANDLE scn, void *vs)
 		if (!_strnicmp (line, "PODANGLE", 8)) {
 			sscanf (line+8, "%lf%lf", pod_angle+0, pod_angle+1);
 		} else if (!_strnicmp (line, "DOCKSTATE", 9)) {
-			sscanf (line+9, "%d%lf", &dock_status, &dock_proc);
+			sscan_doorstate (line+9, act.State(ACT_DOCK));
 		} else if (!_strnicmp (line, "AIRLOCK", 7)) {
-			sscanf (line+7, "%d%lf", &lock_status, &lock_proc);
+			sscan_doorstate (line+7, act.State(ACT_LOCK));
 		} else if (!_strnicmp (line, "GEAR", 4)) {
-			sscanf (line+4, "%d%lf", &gear_status, &gear_proc);
+			sscan_doorstate (line+4, act.State(ACT_GEAR));
 		} else if (!_strnicmp (line, "PAYLOAD MASS", 12)) {
 			sscanf (line+12, "%lf%d", &payload_mass,&cargo_arm_status);
 		} else {
@@ -1160,14 +1196,11 @@ void ShuttleA::clbkSaveState (FILEHANDLE scn)
 	sprintf (cbuf, "%0.4f %0.4f", pod_angle[0], pod_angle[1]);
 	oapiWriteScenario_string (scn, "PODANGLE", cbuf);
 
-	sprintf (cbuf, "%d %0.4f", dock_status, dock_proc);
-	oapiWriteScenario_string (scn, "DOCKSTATE", cbuf);
+	WriteScenario_doorstate (scn, "DOCKSTATE", act.State(ACT_DOCK));
 
-	sprintf (cbuf, "%d %0.4f", lock_status, lock_proc);
-	oapiWriteScenario_string (scn, "AIRLOCK", cbuf);
+	WriteScenario_doorstate (scn, "AIRLOCK", act.State(ACT_LOCK));
 
-	sprintf (cbuf, "%d %0.4f", gear_status, gear_proc);
-	oapiWriteScenario_string (scn, "GEAR", cbuf);
+	WriteScenario_doorstate (scn, "GEAR", act.State(ACT_GEAR));
 
 	sprintf (cbuf, "%0.1f %d", payload_mass,cargo_arm_status);
 	oapiWriteScenario_string (scn, "PAYLOAD MASS", cbuf);
@@ -1179,13 +1212,13 @@ void ShuttleA::clbkSaveState (FILEHANDLE scn)
 bool ShuttleA::clbkPlaybackEvent (double simt, double event_t, const char *event_type, const char *event)
 {
 	if (!_stricmp (event_type, "DOCK")) {
-		ActivateDockingPort (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateDockingPort (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "AIRLOCK")) {
-		ActivateAirlock (!_stricmp (event, "CLOSE") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateAirlock (!_stricmp (event, "CLOSE") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "GEAR")) {
-		ActivateLandingGear (!_stricmp (event, "UP") ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateLandingGear (!_stricmp (event, "UP") ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	} else if (!_stricmp (event_type, "POD")) {
 		UINT which;
@@ -1222,11 +1255,8 @@ void ShuttleA::clbkPostCreation ()
 		SetAnimation (anim_pod[i], pod_angle[i]/PI);
 		SetThrusterDir (th_pod[i], _V(0,sina,-cosa));
 	}
-	SetAnimation (anim_dock, dock_proc);
-	SetAnimation (anim_lock, lock_proc);
-	SetAnimation (anim_dock, dock_proc);
-	SetAnimation (anim_gear, gear_proc);
-		SetTouchdownPoints (_V(0,-2.93+gear_proc*0.555,9), _V(-2,-2.93+gear_proc*0.555,-8), _V(2,-2.93+gear_proc*0.555,-8));
+	act.Update();
+	SetGearParameters (gear_proc);
 
 	SetEmptyMass (EMPTY_MASS + payload_mass);
 }
@@ -1258,68 +1288,8 @@ void ShuttleA::clbkPostStep (double simt, double simdt, double mjd)
 	}
 	if (redraw) oapiTriggerPanelRedrawArea (0, AID_PODANGLEINDICATOR);
 
-	// animate docking hatch
-	if (dock_status >= DOOR_CLOSING) {
-		double da = simdt * DOCK_OPERATING_SPEED;
-		if (dock_status == DOOR_CLOSING) {
-			if (dock_proc > 0.0)
-				dock_proc = max (0.0, dock_proc-da);
-			else {
-				dock_status = DOOR_CLOSED;
-				oapiTriggerRedrawArea (1, 0,AID_DOCKINDICATOR);
-			}
-		} else { // hatch opening
-			if (dock_proc < 1.0)
-				dock_proc = min (1.0, dock_proc+da);
-			else {
-				dock_status = DOOR_OPEN;
-				oapiTriggerRedrawArea (1,0, AID_DOCKINDICATOR);
-			}
-		}
-		SetAnimation (anim_dock, dock_proc);
-	}
-
-	// animate airlock
-	if (lock_status >= DOOR_CLOSING) {
-		double da = simdt * AIRLOCK_OPERATING_SPEED;
-		if (lock_status == DOOR_CLOSING) {
-			if (lock_proc > 0.0)
-				lock_proc = max (0.0, lock_proc-da);
-			else {
-				lock_status = DOOR_CLOSED;
-				oapiTriggerRedrawArea (1,0, AID_AIRLOCK1INDICATOR);
-			}
-		} else { // door opening
-			if (lock_proc < 1.0)
-				lock_proc = min (1.0, lock_proc+da);
-			else {
-				lock_status = DOOR_OPEN;
-				oapiTriggerRedrawArea (1,0, AID_AIRLOCK1INDICATOR);
-			}
-		}
-		SetAnimation (anim_lock, lock_proc);
-	}
-	// animate gear
-	if (gear_status >= DOOR_CLOSING) {
-		double da = simdt * GEAR_OPERATING_SPEED;
-		if (gear_status == DOOR_CLOSING) {
-			if (gear_proc > 0.0)
-				gear_proc = max (0.0, gear_proc-da);
-			else {
-				gear_status = DOOR_CLOSED;
-				oapiTriggerRedrawArea (1,0, AID_GEARINDICATOR);
-			}
-		} else { // door opening
-			if (gear_proc < 1.0)
-				gear_proc = min (1.0, gear_proc+da);
-			else {
-				gear_status = DOOR_OPEN;
-			    oapiTriggerRedrawArea (1,0, AID_GEARINDICATOR);
-			}
-		}
-		SetAnimation (anim_gear, gear_proc);
-		SetTouchdownPoints (_V(0,-2.93+gear_proc*0.555,9), _V(-2,-2.93+gear_proc*0.555,-8), _V(2,-2.93+gear_proc*0.555,-8));
-	}
+	// animate docking hatch, airlock and gear
+	act.Step (simdt);
 }
 
 
@@ -1504,13 +1474,13 @@ bool ShuttleA::clbkPanelMouseEvent (int id, int event, int mx, int my)
 
 	// panel 1 events:
 	case AID_AIRLOCK1SWITCH:
-		ActivateAirlock (my < 25 ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateAirlock (my < 25 ? AnimState::CLOSING : AnimState::OPENING);
 		break;
 	case AID_DOCKSWITCH:
-		ActivateDockingPort (my < 25 ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateDockingPort (my < 25 ? AnimState::CLOSING : AnimState::OPENING);
 		break;
 	case AID_GEARSWITCH:
-		ActivateLandingGear(my<25 ? DOOR_CLOSING:DOOR_OPENING);
+		ActivateLandingGear(my<25 ? AnimState::CLOSING:AnimState::OPENING);
 		break;
 	case AID_CARGO_OPEN:
 		mode =(mx >45?0:3);
@@ -1573,36 +1543,36 @@ bool ShuttleA::clbkPanelRedrawEvent (int id, int event, SURFHANDLE surf)
 		RedrawPanel_Fuelstatus (surf, id-AID_FUELSTATUS1);
 		return true;
 	case AID_AIRLOCK1SWITCH:
-		oapiBlt (surf, srf[0], 0, 0, lock_status == DOOR_OPEN ||
-			lock_status == DOOR_OPENING ? 24:0, 0, 24, 50);
+		oapiBlt (surf, srf[0], 0, 0, lock_status == AnimState::OPEN ||
+			lock_status == AnimState::OPENING ? 24:0, 0, 24, 50);
 		return true;
 	case AID_AIRLOCK1INDICATOR:
 		switch (lock_status) {
-		case DOOR_CLOSED: oapiBlt (surf, srf[3], 0, 0, 0,  0, 34, 8); break;
-		case DOOR_OPEN:   oapiBlt (surf, srf[3], 0, 0, 0, 16, 34, 8); break;
-		default:          oapiBlt (surf, srf[3], 0, 0, 0,  8, 34, 8); break;
+		case AnimState::CLOSED: oapiBlt (surf, srf[3], 0, 0, 0,  0, 34, 8); break;
+		case AnimState::OPEN:   oapiBlt (surf, srf[3], 0, 0, 0, 16, 34, 8); break;
+		default:                oapiBlt (surf, srf[3], 0, 0, 0,  8, 34, 8); break;
 		}
 		return true;
 	case AID_DOCKSWITCH:
-		oapiBlt (surf, srf[2], 0, 0, dock_status == DOOR_OPEN ||
-			dock_status == DOOR_OPENING ? 24:0, 0, 24, 50);
+		oapiBlt (surf, srf[2], 0, 0, dock_status == AnimState::OPEN ||
+			dock_status == AnimState::OPENING ? 24:0, 0, 24, 50);
 		return true;
 	case AID_DOCKINDICATOR:
 		switch (dock_status) {
-		case DOOR_CLOSED: oapiBlt (surf, srf[4], 0, 0, 0,  0, 34, 8); break;
-		case DOOR_OPEN:   oapiBlt (surf, srf[4], 0, 0, 0, 16, 34, 8); break;
-		default:          oapiBlt (surf, srf[4], 0, 0, 0,  8, 34, 8); break;
+		case AnimState::CLOSED: oapiBlt (surf, srf[4], 0, 0, 0,  0, 34, 8); break;
+		case AnimState::OPEN:   oapiBlt (surf, srf[4], 0, 0, 0, 16, 34, 8); break;
+		default:                oapiBlt (surf, srf[4], 0, 0, 0,  8, 34, 8); break;
 		}
 		return true;
 	case AID_GEARSWITCH:
-		oapiBlt (surf, srf[2], 0, 0, gear_status == DOOR_OPEN ||
-			gear_status == DOOR_OPENING ? 24:0, 0, 24, 50);
+		oapiBlt (surf, srf[2], 0, 0, gear_status == AnimState::OPEN ||
+			gear_status == AnimState::OPENING ? 24:0, 0, 24, 50);
 		return true;
 	case AID_GEARINDICATOR:
 		switch (gear_status) {
-		case DOOR_CLOSED: oapiBlt (surf, srf[4], 0, 0, 0,  0, 34, 8); break;
-		case DOOR_OPEN:   oapiBlt (surf, srf[4], 0, 0, 0, 16, 34, 8); break;
-		default:          oapiBlt (surf, srf[4], 0, 0, 0,  8, 34, 8); break;
+		case AnimState::CLOSED: oapiBlt (surf, srf[4], 0, 0, 0,  0, 34, 8); break;
+		case AnimState::OPEN:   oapiBlt (surf, srf[4], 0, 0, 0, 16, 34, 8); break;
+		default:                oapiBlt (surf, srf[4], 0, 0, 0,  8, 34, 8); break;
 		}
 		return true;
 	case AID_CARGO_OPEN:
@@ -1691,7 +1661,7 @@ bool ShuttleA::clbkDrawHUD (int mode, const HUDPAINTSPEC *hps, oapi::Sketchpad *
 	int cx = hps->CX, cy = hps->CY;
 
 	// show gear deployment status
-	if (gear_status == DOOR_CLOSED || (gear_status >= DOOR_CLOSING && fmod (oapiGetSimTime(), 1.0) < 0.5)) {
+	if (gear_status == AnimState::CLOSED || (gear_status >= AnimState::CLOSING && fmod (oapiGetSimTime(), 1.0) < 0.5)) {
 		int d = hps->Markersize/2;
 		if (cx >= -d*3 && cx < hps->W+d*3 && cy >= d && cy < hps->H+d*5) {
 			skp->Rectangle (cx-d*3, cy-d*2, cx-d*2, cy-d);
@@ -1718,10 +1688,10 @@ bool ShuttleA::clbkDrawHUD (int mode, const HUDPAINTSPEC *hps, oapi::Sketchpad *
 	}
 
 	if (oapiGetHUDMode() == HUD_DOCKING) {
-		if (dock_status != DOOR_OPEN) {
+		if (dock_status != AnimState::OPEN) {
 			int d = hps->Markersize*5;
 			double tmp;
-			if (dock_status == DOOR_CLOSED || modf (oapiGetSimTime(), &tmp) < 0.5) {
+			if (dock_status == AnimState::CLOSED || modf (oapiGetSimTime(), &tmp) < 0.5) {
 				skp->Line (cx-d,cy-d,cx+d,cy+d);
 				skp->Line (cx-d,cy+d,cx+d,cy-d);
 			}
@@ -1746,12 +1716,7 @@ void ShuttleA::clbkRenderHUD (int mode, const HUDPAINTSPEC *hps, SURFHANDLE hTex
 
 	static float texw = 512.0f, texh = 256.0f;
 	float cx = (float)hps->CX, cy = (float)hps->CY;
-	int i, nvtx = 0, nidx = 0;
-	static NTVERTEX vtx[24+12];
-	static WORD idx[36+30];
-	static float scl = 0;
-	static NTVERTEX vgear[24];
-	static NTVERTEX vnose[12];
+	int i;
 	static WORD igear[36] = {
 		 0, 3, 1,  2, 3, 0,
 		 4, 7, 5,  6, 7, 4,
@@ -1768,8 +1733,10 @@ void ShuttleA::clbkRenderHUD (int mode, const HUDPAINTSPEC *hps, SURFHANDLE hTex
 		3,4,0, 0,4,5
 	};
 
-	if (scl != hps->Markersize*0.25f) {
-		scl = hps->Markersize*0.25f;
+	if (hudscl != hps->Markersize*0.25f) {
+		float scl = hudscl = hps->Markersize*0.25f;
+		NTVERTEX vgear[24];
+		NTVERTEX vnose[12];
 		memset (vgear, 0, 24*sizeof(NTVERTEX));
 		float x[24] = {-5,-3,-5,-3,-5,-3,-5,-3,-5,-3,-5,-3, 3,5,3,5,3,5,3,5,3,5,3,5};
 		float y[24] = {-6.5,-6.5,-8.5,-8.5,-1.5,-1.5,-3.5,-3.5,3.5,3.5,1.5,1.5,-6.5,-6.5,-8.5,-8.5,-1.5,-1.5,-3.5,-3.5,3.5,3.5,1.5,1.5};
@@ -1790,33 +1757,20 @@ void ShuttleA::clbkRenderHUD (int mode, const HUDPAINTSPEC *hps, SURFHANDLE hTex
 			vnose[i].tu = un[i]/texw;
 			vnose[i].tv = vn[i]/texh;
 		}
+		hudovl.SetElement (HUDELEM_GEAR, vgear, 24, igear, 36);
+		hudovl.SetElement (HUDELEM_DOCK, vnose, 12, inose, 30);
 	}
 
+	double tmp, blink = modf (oapiGetSimTime(), &tmp);
+
 	// show gear deployment status
-	if (gear_status == DOOR_CLOSED || (gear_status >= DOOR_CLOSING && fmod (oapiGetSimTime(), 1.0) < 0.5)) {
-		memcpy (vtx+nvtx, vgear, 24*sizeof(NTVERTEX));
-		for (i = 0; i < 36; i++) idx[nidx+i] = igear[i]+nvtx;
-		nvtx += 24;
-		nidx += 36;
-	}
+	hudovl.Show (HUDELEM_GEAR, gear_status == AnimState::CLOSED || (gear_status >= AnimState::CLOSING && blink < 0.5));
 
 	// show dock cover status
-	if (oapiGetHUDMode() == HUD_DOCKING && dock_status != DOOR_OPEN) {
-		double tmp;
-		if (dock_status == DOOR_CLOSED || modf (oapiGetSimTime(), &tmp) < 0.5) {
-			memcpy (vtx+nvtx, vnose, 12*sizeof(NTVERTEX));
-			for (i = 0; i < 30; i++) idx[nidx+i] = inose[i]+nvtx;
-			nvtx += 12;
-			nidx += 30;
-		}
-	}
+	hudovl.Show (HUDELEM_DOCK, oapiGetHUDMode() == HUD_DOCKING && dock_status != AnimState::OPEN &&
+		(dock_status == AnimState::CLOSED || blink < 0.5));
 
-	if (nvtx) {
-		MESHGROUP grp = {vtx, idx, nvtx, nidx, 0, 0, 0, 0, 0};
-		MESHHANDLE hmesh = oapiCreateMesh (1, &grp);
-		oapiRenderHUD (hmesh, &hTex);
-		oapiDeleteMesh (hmesh);
-	}
+	hudovl.Render (&hTex);
 }
 
 // --------------------------------------------------------------
@@ -2097,13 +2051,13 @@ bool ShuttleA::clbkVCMouseEvent (int id, int event, VECTOR3 &p)
 		if (mode != pmode) SetAttitudeMode (mode);
 		return mode != pmode;
 	case AID_DOCKSWITCH:
-		ActivateDockingPort (p.y < 0.5 ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateDockingPort (p.y < 0.5 ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	case AID_AIRLOCK1SWITCH:
-		ActivateAirlock (p.y < 0.5 ? DOOR_CLOSING : DOOR_OPENING);
+		ActivateAirlock (p.y < 0.5 ? AnimState::CLOSING : AnimState::OPENING);
 		return true;
 	case AID_GEARSWITCH:
-		ActivateLandingGear(p.y<0.5 ? DOOR_CLOSING:DOOR_OPENING);
+		ActivateLandingGear(p.y<0.5 ? AnimState::CLOSING:AnimState::OPENING);
 		return true;
 	case AID_CARGO_OPEN:
 		mx=(int)(p.x*83);
@@ -2176,36 +2130,36 @@ bool ShuttleA::clbkVCRedrawEvent (int id, int event, SURFHANDLE surf)
 			return true;
 	case AID_AIRLOCK1INDICATOR:
 		switch (lock_status) {
-		case DOOR_CLOSED: oapiBlt (surf, srf[3], 0, 0, 0,  0, 34, 8); break;
-		case DOOR_OPEN:   oapiBlt (surf, srf[3], 0, 0, 0, 16, 34, 8); break;
-		default:          oapiBlt (surf, srf[3], 0, 0, 0,  8, 34, 8); break;
+		case AnimState::CLOSED: oapiBlt (surf, srf[3], 0, 0, 0,  0, 34, 8); break;
+		case AnimState::OPEN:   oapiBlt (surf, srf[3], 0, 0, 0, 16, 34, 8); break;
+		default:                oapiBlt (surf, srf[3], 0, 0, 0,  8, 34, 8); break;
 		}
 		return true;
 	case AID_DOCKINDICATOR:
 		switch (dock_status) {
-		case DOOR_CLOSED: oapiBlt (surf, srf[4], 0, 0, 0,  0, 34, 8); break;
-		case DOOR_OPEN:   oapiBlt (surf, srf[4], 0, 0, 0, 16, 34, 8); break;
-		default:          oapiBlt (surf, srf[4], 0, 0, 0,  8, 34, 8); break;
+		case AnimState::CLOSED: oapiBlt (surf, srf[4], 0, 0, 0,  0, 34, 8); break;
+		case AnimState::OPEN:   oapiBlt (surf, srf[4], 0, 0, 0, 16, 34, 8); break;
+		default:                oapiBlt (surf, srf[4], 0, 0, 0,  8, 34, 8); break;
 		}
 		return true;
 	case AID_GEARINDICATOR:
 		switch (gear_status) {
-		case DOOR_CLOSED: oapiBlt (surf, srf[4], 0, 0, 0,  0, 34, 8); break;
-		case DOOR_OPEN:   oapiBlt (surf, srf[4], 0, 0, 0, 16, 34, 8); break;
-		default:          oapiBlt (surf, srf[4], 0, 0, 0,  8, 34, 8); break;
+		case AnimState::CLOSED: oapiBlt (surf, srf[4], 0, 0, 0,  0, 34, 8); break;
+		case AnimState::OPEN:   oapiBlt (surf, srf[4], 0, 0, 0, 16, 34, 8); break;
+		default:                oapiBlt (surf, srf[4], 0, 0, 0,  8, 34, 8); break;
 		}
 		return true;
 	case AID_DOCKSWITCH:
-		  SetAnimation  (anim_dock_switch,dock_status == DOOR_OPEN ||
-			dock_status == DOOR_OPENING ? 0.0:1.0);
+		  SetAnimation  (anim_dock_switch,dock_status == AnimState::OPEN ||
+			dock_status == AnimState::OPENING ? 0.0:1.0);
 		return false;
 	case AID_AIRLOCK1SWITCH:
-			  SetAnimation  (anim_airlock_switch,lock_status == DOOR_OPEN ||
-			lock_status == DOOR_OPENING ? 0.0:1.0);
+			  SetAnimation  (anim_airlock_switch,lock_status == AnimState::OPEN ||
+			lock_status == AnimState::OPENING ? 0.0:1.0);
 		return false;
 	case AID_GEARSWITCH:
-			  SetAnimation  (anim_gear_switch,gear_status == DOOR_OPEN ||
-			gear_status == DOOR_OPENING ? 0.0:1.0);
+			  SetAnimation  (anim_gear_switch,gear_status == AnimState::OPEN ||
+			gear_status == AnimState::OPENING ? 0.0:1.0);
 		return false;
 	case AID_CARGO_OPEN:
 		RedrawPanel_CargoOpen(surf);
@@ -2233,6 +2187,7 @@ DLLCLBK void InitModule (HINSTANCE hModule)
 {
 	g_Param.hDLL = hModule;
 	oapiRegisterCustomControls (hModule);
+	oapiRegisterModule (g_AttachIndex = new AttachIndex (hModule));
 
 	// allocate GDI resources
 	g_Param.hFont[0] = CreateFont (-10, 0, 0, 0, 400, 0, 0, 0, 0, 0, 0, 0, 0, "Arial");
@@ -2278,7 +2233,7 @@ DLLCLBK void ovcExit (VESSEL *vessel)
 ShuttleA *GetV (HWND hDlg)
 {
 	// retrieve DG interface from scenario editor
-	OBJHANDLE hVessel;
+	OBJHANDLE hVessel = 0;
 	SendMessage (hDlg, WM_SCNEDITOR, SE_GETVESSEL, (LPARAM)&hVessel);
 	return (ShuttleA*)oapiGetVesselInterface (hVessel);
 }
@@ -2318,22 +2273,22 @@ BOOL CALLBACK EdPg1Proc (HWND hTab, UINT uMsg, WPARAM wParam, LPARAM lParam)
 	case WM_COMMAND:
 		switch (LOWORD (wParam)) {
 		case IDC_GEAR_UP:
-			GetV(hTab)->ActivateLandingGear (ShuttleA::DOOR_OPEN);
+			GetV(hTab)->ActivateLandingGear (AnimState::OPEN);
 			return TRUE;
 		case IDC_GEAR_DOWN:
-			GetV(hTab)->ActivateLandingGear (ShuttleA::DOOR_CLOSED);
+			GetV(hTab)->ActivateLandingGear (AnimState::CLOSED);
 			return TRUE;
 		case IDC_DPORT_CLOSE:
-			GetV(hTab)->ActivateDockingPort (ShuttleA::DOOR_CLOSED);
+			GetV(hTab)->ActivateDockingPort (AnimState::CLOSED);
 			return TRUE;
 		case IDC_DPORT_OPEN:
-			GetV(hTab)->ActivateDockingPort (ShuttleA::DOOR_OPEN);
+			GetV(hTab)->ActivateDockingPort (AnimState::OPEN);
 			return TRUE;
 		case IDC_OLOCK_CLOSE:
-			GetV(hTab)->ActivateAirlock (ShuttleA::DOOR_CLOSED);
+			GetV(hTab)->ActivateAirlock (AnimState::CLOSED);
 			return TRUE;
 		case IDC_OLOCK_OPEN:
-			GetV(hTab)->ActivateAirlock (ShuttleA::DOOR_OPEN);
+			GetV(hTab)->ActivateAirlock (AnimState::OPEN);
 			return TRUE;
 		case IDC_AUX_RETRO: {
 			ShuttleA *v = GetV(hTab);
@@ -12,6 +12,8 @@
 #define __SHUTTLEA_H
 
 #include "orbitersdk.h"
+#include "../Common/HUDOverlay.h"
+#include "../Common/Actuator.h"
 
 // ==========================================================
 // Some vessel class caps
@@ -105,8 +107,11 @@ public:
 	THRUSTER_HANDLE th_main[2], th_hover[2], th_pod[2];
 	MESHHANDLE vcmesh_tpl,exmesh_tpl;
 	UINT podswitch[2];
-	double dock_proc, lock_proc,gear_proc;
-	enum DoorStatus { DOOR_CLOSED, DOOR_OPEN, DOOR_CLOSING, DOOR_OPENING } dock_status, lock_status,gear_status;
+	enum { ACT_DOCK, ACT_LOCK, ACT_GEAR, NACTUATOR };
+	ActuatorSet act;        // docking hatch, airlock and gear actuators
+	typedef AnimState::Action DoorStatus;
+	DoorStatus &dock_status, &lock_status, &gear_status;
+	double &dock_proc, &lock_proc, &gear_proc;  // references into act
 
 	void ActivateDockingPort (DoorStatus action);
 	void RevertDockingPort ();
@@ -138,6 +143,10 @@ public:
 
 private:
 	void DefineAnimations ();
+	void DefineActuators ();
+	static void ActuatorMoved (void *context, int id, const AnimState &state);
+	static void ActuatorDone (void *context, int id, const AnimState &state);
+	void SetGearParameters (double state);
 	bool ToggleGrapple (int grapple);
 	double payload_mass;
 	void ComputePayloadMass();
@@ -177,6 +186,10 @@ private:
 	void RedrawVC_ThPOD();
 	void RedrawVC_ThMain();
 	void RedrawVC_ThHover();
+
+	HUDOverlay hudovl;          // custom HUD elements
+	float hudscl;               // HUD element scale of the current overlay
+	enum { HUDELEM_GEAR, HUDELEM_DOCK }; // HUD overlay element ids
 };
 
 typedef struct {
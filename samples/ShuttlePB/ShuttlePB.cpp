@@ -18,6 +18,7 @@
 #define ORBITER_MODULE
 
 #include "orbitersdk.h"
+#include "../Common/AeroTable.h"
 
 // ==============================================================
 // Some vessel parameters
@@ -46,20 +47,41 @@ const VECTOR3 PB_DOCK_POS   = {0,1.3,-1};      // docking port location [m]
 const VECTOR3 PB_DOCK_DIR   = {0,1,0};         // docking port approach direction
 const VECTOR3 PB_DOCK_ROT   = {0,0,-1};        // docking port alignment direction
 
+// Coefficient tables, shared by all ShuttlePB instances.
+// Built by DefineAirfoilTables at class caps time.
+static AeroTable lift, vlift_table, hlift_table;
+
 // Calculate lift coefficient [Cl] as a function of aoa (angle of attack) over -Pi ... Pi
 // Implemented here as a piecewise linear function
 double LiftCoeff (double aoa)
 {
-	int i;
+	return lift.Cl (aoa);
+}
+
+// Build the coefficient tables of LiftCoeff and of the airfoils (vlift,
+// hlift) from their lift profiles, with profile drag, induced drag and
+// wave drag folded in
+
+static void DefineAirfoilTables ()
+{
+	if (lift.Defined()) return;
+
 	const int nlift = 9;
 	static const double AOA[nlift] = {-180*RAD,-60*RAD,-30*RAD,-1*RAD,15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
 	static const double CL[nlift]  = {       0,      0,   -0.1,     0,   0.2,  0.25,   0.2,     0,      0};
-	static const double SCL[nlift] = {(CL[1]-CL[0])/(AOA[1]-AOA[0]), (CL[2]-CL[1])/(AOA[2]-AOA[1]),
-		                              (CL[3]-CL[2])/(AOA[3]-AOA[2]), (CL[4]-CL[3])/(AOA[4]-AOA[3]),
-									  (CL[5]-CL[4])/(AOA[5]-AOA[4]), (CL[6]-CL[5])/(AOA[6]-AOA[5]),
-									  (CL[7]-CL[6])/(AOA[7]-AOA[6]), (CL[8]-CL[7])/(AOA[8]-AOA[7])};
-	for (i = 0; i < nlift-1 && AOA[i+1] < aoa; i++);
-	return CL[i] + (aoa-AOA[i])*SCL[i];
+	lift.SetLift (nlift, AOA, CL);
+
+	static const double VCL[37] = {  // lift coefficient from -pi to pi in 10deg steps
+		-0.1,-0.5,-0.4,-0.1,0,0,0,0,0,0,0,0,0,0,-0.2,-0.6,-0.6,-0.4,0.2,0.5,0.9,0.8,0.2,0,0,0,0,0,0,0,0,0,0.1,0.4,0.5,0.3,-0.1
+	};
+	vlift_table.SetLift (37, 0, VCL, 0, 0.03, 0.4, 1.0, 0.5);
+	vlift_table.SetWaveDrag (0.75, 1.0, 1.1, 0.04);
+
+	static const double HCL[9] = {  // lift coefficient from -pi to pi in 45deg steps
+		0,0.4,0,-0.4,0,0.4,0,-0.4,0
+	};
+	hlift_table.SetLift (9, 0, HCL, 0, 0.03, 0.0, 1.5, 0.6);
+	hlift_table.SetWaveDrag (0.75, 1.0, 1.1, 0.04);
 }
 
 // ==============================================================
@@ -130,6 +152,7 @@ void ShuttlePB::clbkSetClassCaps (FILEHANDLE cfg)
 	SetDockParams (PB_DOCK_POS, PB_DOCK_DIR, PB_DOCK_ROT);
 
 	// airfoil definitions
+	DefineAirfoilTables ();
 	CreateAirfoil3 (LIFT_VERTICAL,   PB_COP, vlift, NULL, PB_VLIFT_C, PB_VLIFT_S, PB_VLIFT_A);
 	CreateAirfoil3 (LIFT_HORIZONTAL, PB_COP, hlift, NULL, PB_HLIFT_C, PB_HLIFT_S, PB_HLIFT_A);
 
@@ -275,35 +298,13 @@ void ShuttlePB::clbkSetClassCaps (FILEHANDLE cfg)
 void ShuttlePB::vlift (VESSEL *v, double aoa, double M, double Re,
 	void *context, double *cl, double *cm, double *cd)
 {
-	static const double clp[] = {  // lift coefficient from -pi to pi in 10deg steps
-		-0.1,-0.5,-0.4,-0.1,0,0,0,0,0,0,0,0,0,0,-0.2,-0.6,-0.6,-0.4,0.2,0.5,0.9,0.8,0.2,0,0,0,0,0,0,0,0,0,0.1,0.4,0.5,0.3,-0.1,-0.5
-	};
-	static const double aoa_step = 10.0*RAD;
-	double a, fidx, saoa = sin(aoa);
-	a = modf((aoa+PI)/aoa_step, &fidx);
-	int idx = (int)(fidx+0.5);
-	*cl = clp[idx]*(1.0-a) + clp[idx+1]*a;     // linear interpolation
-	*cm = 0.0; //-0.03*sin(aoa-0.1);
-	*cd = 0.03 + 0.4*saoa*saoa;                // profile drag
-	*cd += oapiGetInducedDrag (*cl, 1.0, 0.5); // induced drag
-	*cd += oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);  // wave drag
+	vlift_table.Eval (aoa, M, cl, cm, cd);
 }
 
 void ShuttlePB::hlift (VESSEL *v, double aoa, double M, double Re,
 	void *context, double *cl, double *cm, double *cd)
 {
-	static const double clp[] = {  // lift coefficient from -pi to pi in 45deg steps
-		0,0.4,0,-0.4,0,0.4,0,-0.4,0,0.4
-	};
-	static const double aoa_step = 45.0*RAD;
-	double a, fidx;
-	a = modf((aoa+PI)/aoa_step, &fidx);
-	int idx = (int)(fidx+0.5);
-	*cl = clp[idx]*(1.0-a) + clp[idx+1]*a;     // linear interpolation
-	*cm = 0.0;
-	*cd = 0.03;
-	*cd += oapiGetInducedDrag (*cl, 1.5, 0.6); // induced drag
-	*cd += oapiGetWaveDrag (M, 0.75, 1.0, 1.1, 0.04);  // wave drag
+	hlift_table.Eval (aoa, M, cl, cm, cd);
 }
 
 // ==============================================================
@@ -0,0 +1,475 @@
+// ==============================================================
+//                 ORBITER MODULE: SolarSail
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2007 Martin Schweiger
+//                   All rights reserved
+//
+// Membrane.cpp
+// Elastic membrane solver for the sail segments
+// ==============================================================
+
+#include "Membrane.h"
+#include <xmmintrin.h>
+#include <stdlib.h>
+#include <math.h>
+#include <process.h>
+
+const float ELAST  = 1e-1f; // membrane elasticity
+const float PSCALE = 1e3f;  // radiation pressure scaling
+
+// ==============================================================
+// MembraneWork
+
+MembraneWork::MembraneWork (DWORD nvtx)
+{
+	px = new float[nvtx*9];
+	py = px+nvtx;   pz = py+nvtx;
+	fx = pz+nvtx;   fy = fx+nvtx;   fz = fy+nvtx;
+	nx = fz+nvtx;   ny = nx+nvtx;   nz = ny+nvtx;
+}
+
+MembraneWork::~MembraneWork ()
+{
+	delete []px;
+}
+
+// ==============================================================
+// Membrane
+
+struct EDGE { DWORD a, b; };
+
+static int EdgeCmp (const void *p1, const void *p2)
+{
+	const EDGE *e1 = (const EDGE*)p1, *e2 = (const EDGE*)p2;
+	if (e1->a != e2->a) return (e1->a < e2->a ? -1 : 1);
+	if (e1->b != e2->b) return (e1->b < e2->b ? -1 : 1);
+	return 0;
+}
+
+// --------------------------------------------------------------
+// Reorder a triangle index list so that blocks of four triangles whose
+// corners run in parallel, (a,b,c), (a+1,b+1,c+1) ... (a+3,b+3,c+3),
+// come first. Returns the number of triangles in blocks
+// --------------------------------------------------------------
+static DWORD TriangleBlocks (WORD *idx, DWORD ntri, DWORD nvtx)
+{
+	DWORD i, j, k, nvec, blk[4];
+
+	// triangles by first corner, for the search below
+	DWORD *first = new DWORD[nvtx+1], *bucket = new DWORD[ntri];
+	memset (first, 0, (nvtx+1)*sizeof(DWORD));
+	for (i = 0; i < ntri; i++) first[idx[i*3]+1]++;
+	for (i = 0; i < nvtx; i++) first[i+1] += first[i];
+	for (i = 0; i < ntri; i++) bucket[first[idx[i*3]]++] = i;
+	for (i = nvtx; i > 0; i--) first[i] = first[i-1];
+	first[0] = 0;
+
+	DWORD *order = new DWORD[ntri];
+	bool *used = new bool[ntri];
+	memset (used, 0, ntri*sizeof(bool));
+	for (i = nvec = 0; i < ntri; i++) {
+		const WORD *t = idx+i*3;
+		if (used[i] || (DWORD)max (t[0], max (t[1], t[2]))+3 >= nvtx) continue;
+		for (blk[0] = i, j = 1; j < 4; j++) {
+			DWORD a = t[0]+j;
+			for (k = first[a]; k < first[a+1]; k++) {
+				const WORD *u = idx+bucket[k]*3;
+				if (u[1] == t[1]+j && u[2] == t[2]+j && !used[bucket[k]]) break;
+			}
+			if (k == first[a+1]) break;
+			blk[j] = bucket[k];
+		}
+		if (j < 4) continue;
+		for (j = 0; j < 4; j++) {
+			used[blk[j]] = true;
+			order[nvec++] = blk[j];
+		}
+	}
+	for (i = 0, j = nvec; i < ntri; i++)
+		if (!used[i]) order[j++] = i;
+
+	WORD *tmp = new WORD[ntri*3];
+	for (i = 0; i < ntri; i++)
+		memcpy (tmp+i*3, idx+order[i]*3, 3*sizeof(WORD));
+	memcpy (idx, tmp, ntri*3*sizeof(WORD));
+	delete []tmp;
+	delete []order;
+	delete []used;
+	delete []bucket;
+	delete []first;
+	return nvec;
+}
+
+// --------------------------------------------------------------
+// Build the spring list from the front side triangles of a segment
+// --------------------------------------------------------------
+Membrane::Membrane (const MESHGROUP *grp)
+{
+	nvtx = grp->nVtx/2; // scan front side only
+	ntri = grp->nIdx/6; // scan front side only
+	const NTVERTEX *vtx = grp->Vtx;
+	DWORD i, j;
+
+	idx = new WORD[ntri*3];
+	memcpy (idx, grp->Idx, ntri*3*sizeof(WORD));
+	fix = new bool[nvtx];
+	for (i = 0; i < nvtx; i++)
+		fix[i] = (vtx[i].x == 0 || vtx[i].y == 0);
+
+	// the smooth normal of a node averages the normals of its triangles
+	nscale = new float[nvtx];
+	for (i = 0; i < nvtx; i++) nscale[i] = 0.0f;
+	for (i = 0; i < ntri*3; i++) nscale[idx[i]] += 1.0f;
+	for (i = 0; i < nvtx; i++)
+		nscale[i] = (nscale[i] > 1.0f ? 1.0f/nscale[i] : 1.0f);
+
+	// collect all triangle edges, then sort and remove duplicates
+	EDGE *edge = new EDGE[ntri*3];
+	for (i = 0; i < ntri; i++) {
+		WORD *tri = idx+(i*3);
+		for (j = 0; j < 3; j++) {
+			DWORD n1 = tri[j], n2 = tri[(j+1)%3];
+			edge[i*3+j].a = min (n1, n2);
+			edge[i*3+j].b = max (n1, n2);
+		}
+	}
+	qsort (edge, ntri*3, sizeof(EDGE), EdgeCmp);
+	for (i = nedge = 0; i < ntri*3; i++)
+		if (!nedge || EdgeCmp (edge+i, edge+nedge-1))
+			edge[nedge++] = edge[i];
+
+	// index of the first edge of each node, for the search below
+	DWORD *first = new DWORD[nvtx+1];
+	memset (first, 0, (nvtx+1)*sizeof(DWORD));
+	for (i = 0; i < nedge; i++) first[edge[i].a+1]++;
+	for (i = 0; i < nvtx; i++) first[i+1] += first[i];
+
+	// collect blocks of four parallel springs, then the rest in CSR order
+	DWORD *order = new DWORD[nedge], blk[4], k;
+	bool *used = new bool[nedge];
+	memset (used, 0, nedge*sizeof(bool));
+	for (i = nvec = 0; i < nedge; i++) {
+		if (used[i] || edge[i].b+3 >= nvtx) continue;
+		for (blk[0] = i, j = 1; j < 4; j++) {
+			DWORD a = edge[i].a+j, b = edge[i].b+j;
+			for (k = first[a]; k < first[a+1] && edge[k].b != b; k++);
+			if (k == first[a+1] || used[k]) break;
+			blk[j] = k;
+		}
+		if (j < 4) continue;
+		for (j = 0; j < 4; j++) {
+			used[blk[j]] = true;
+			order[nvec++] = blk[j];
+		}
+	}
+	for (i = 0, j = nvec; i < nedge; i++)
+		if (!used[i]) order[j++] = i;
+
+	ea = new DWORD[nedge];
+	eb = new DWORD[nedge];
+	ek = new float[nedge];
+	ed0sq = new float[nedge];
+	for (i = 0; i < nedge; i++) {
+		const EDGE *e = edge+order[i];
+		const NTVERTEX *v1 = vtx+e->a, *v2 = vtx+e->b;
+		float dx = v2->x - v1->x, dy = v2->y - v1->y, dz = v2->z - v1->z;
+		ea[i] = e->a;
+		eb[i] = e->b;
+		ed0sq[i] = dx*dx + dy*dy + dz*dz;
+		ek[i] = ELAST/(float)sqrt(ed0sq[i]);
+	}
+	delete []first;
+	delete []order;
+	delete []used;
+	delete []edge;
+
+	ntvec = TriangleBlocks (idx, ntri, nvtx);
+}
+
+Membrane::~Membrane ()
+{
+	delete []idx;
+	delete []fix;
+	delete []nscale;
+	delete []ea;
+	delete []eb;
+	delete []ek;
+	delete []ed0sq;
+}
+
+// --------------------------------------------------------------
+// Accumulate the forces of all stretched springs. A spring pulls both
+// of its end nodes, so each edge is evaluated only once.
+// --------------------------------------------------------------
+void Membrane::SpringForces (MembraneWork &wk) const
+{
+	const float *px = wk.px, *py = wk.py, *pz = wk.pz;
+	float *fx = wk.fx, *fy = wk.fy, *fz = wk.fz;
+	DWORD i, a, b;
+
+	// blocks of four springs with consecutive end nodes: the positions
+	// and forces of both ends are contiguous in the SoA buffers. The a
+	// and b ranges of a block may overlap, so they are updated in turn
+	for (i = 0; i < nvec; i += 4) {
+		a = ea[i], b = eb[i];
+		__m128 dx = _mm_sub_ps (_mm_loadu_ps (px+b), _mm_loadu_ps (px+a));
+		__m128 dy = _mm_sub_ps (_mm_loadu_ps (py+b), _mm_loadu_ps (py+a));
+		__m128 dz = _mm_sub_ps (_mm_loadu_ps (pz+b), _mm_loadu_ps (pz+a));
+		__m128 d2 = _mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy)), _mm_mul_ps (dz, dz));
+		// zero stiffness for springs that are not stretched
+		__m128 k  = _mm_and_ps (_mm_cmpgt_ps (d2, _mm_loadu_ps (ed0sq+i)), _mm_loadu_ps (ek+i));
+		dx = _mm_mul_ps (dx, k);
+		dy = _mm_mul_ps (dy, k);
+		dz = _mm_mul_ps (dz, k);
+		_mm_storeu_ps (fx+a, _mm_add_ps (_mm_loadu_ps (fx+a), dx));
+		_mm_storeu_ps (fy+a, _mm_add_ps (_mm_loadu_ps (fy+a), dy));
+		_mm_storeu_ps (fz+a, _mm_add_ps (_mm_loadu_ps (fz+a), dz));
+		_mm_storeu_ps (fx+b, _mm_sub_ps (_mm_loadu_ps (fx+b), dx));
+		_mm_storeu_ps (fy+b, _mm_sub_ps (_mm_loadu_ps (fy+b), dy));
+		_mm_storeu_ps (fz+b, _mm_sub_ps (_mm_loadu_ps (fz+b), dz));
+	}
+	for (; i < nedge; i++) {
+		a = ea[i], b = eb[i];
+		float dx = px[b]-px[a], dy = py[b]-py[a], dz = pz[b]-pz[a];
+		if (dx*dx + dy*dy + dz*dz > ed0sq[i]) { // is stretched
+			dx *= ek[i], dy *= ek[i], dz *= ek[i];
+			fx[a] += dx;  fy[a] += dy;  fz[a] += dz;
+			fx[b] -= dx;  fy[b] -= dy;  fz[b] -= dz;
+		}
+	}
+}
+
+// --------------------------------------------------------------
+// Average the unit normals of the triangles sharing each node
+// --------------------------------------------------------------
+void Membrane::SmoothNormals (MembraneWork &wk) const
+{
+	const float *px = wk.px, *py = wk.py, *pz = wk.pz;
+	float *nx = wk.nx, *ny = wk.ny, *nz = wk.nz;
+	DWORD i, j;
+
+	memset (nx, 0, nvtx*3*sizeof(float)); // nx, ny, nz are contiguous
+
+	// blocks of four triangles with consecutive corners, as the springs
+	const __m128 one = _mm_set1_ps (1.0f), zero = _mm_setzero_ps();
+	for (i = 0; i < ntvec; i += 4) {
+		const WORD *tri = idx + i*3;
+		__m128 x0 = _mm_loadu_ps (px+tri[0]), y0 = _mm_loadu_ps (py+tri[0]), z0 = _mm_loadu_ps (pz+tri[0]);
+		__m128 dx1 = _mm_sub_ps (_mm_loadu_ps (px+tri[1]), x0), dx2 = _mm_sub_ps (_mm_loadu_ps (px+tri[2]), x0);
+		__m128 dy1 = _mm_sub_ps (_mm_loadu_ps (py+tri[1]), y0), dy2 = _mm_sub_ps (_mm_loadu_ps (py+tri[2]), y0);
+		__m128 dz1 = _mm_sub_ps (_mm_loadu_ps (pz+tri[1]), z0), dz2 = _mm_sub_ps (_mm_loadu_ps (pz+tri[2]), z0);
+		__m128 cx = _mm_sub_ps (_mm_mul_ps (dy1, dz2), _mm_mul_ps (dy2, dz1));
+		__m128 cy = _mm_sub_ps (_mm_mul_ps (dz1, dx2), _mm_mul_ps (dz2, dx1));
+		__m128 cz = _mm_sub_ps (_mm_mul_ps (dx1, dy2), _mm_mul_ps (dx2, dy1));
+		__m128 len = _mm_sqrt_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (cx, cx), _mm_mul_ps (cy, cy)), _mm_mul_ps (cz, cz)));
+		// degenerate triangles have a zero normal
+		__m128 scale = _mm_and_ps (_mm_cmpgt_ps (len, zero), _mm_div_ps (one, len));
+		cx = _mm_mul_ps (cx, scale);
+		cy = _mm_mul_ps (cy, scale);
+		cz = _mm_mul_ps (cz, scale);
+		for (j = 0; j < 3; j++) {
+			DWORD n = tri[j];
+			_mm_storeu_ps (nx+n, _mm_add_ps (_mm_loadu_ps (nx+n), cx));
+			_mm_storeu_ps (ny+n, _mm_add_ps (_mm_loadu_ps (ny+n), cy));
+			_mm_storeu_ps (nz+n, _mm_add_ps (_mm_loadu_ps (nz+n), cz));
+		}
+	}
+	for (; i < ntri; i++) {
+		const WORD *tri = idx + i*3;
+		DWORD n0 = tri[0], n1 = tri[1], n2 = tri[2];
+		float dx1 = px[n1]-px[n0], dx2 = px[n2]-px[n0];
+		float dy1 = py[n1]-py[n0], dy2 = py[n2]-py[n0];
+		float dz1 = pz[n1]-pz[n0], dz2 = pz[n2]-pz[n0];
+		float cx = dy1*dz2 - dy2*dz1, cy = dz1*dx2 - dz2*dx1, cz = dx1*dy2 - dx2*dy1;
+		float len = sqrtf (cx*cx + cy*cy + cz*cz);
+		if (len) {
+			float scale = 1.0f/len;
+			cx *= scale, cy *= scale, cz *= scale;
+		}
+		for (j = 0; j < 3; j++) {
+			DWORD n = tri[j];
+			nx[n] += cx;  ny[n] += cy;  nz[n] += cz;
+		}
+	}
+	for (i = 0; i < nvtx; i++) {
+		nx[i] *= nscale[i], ny[i] *= nscale[i], nz[i] *= nscale[i];
+	}
+}
+
+// --------------------------------------------------------------
+// One relaxation step for a sail segment
+// --------------------------------------------------------------
+void Membrane::Update (NTVERTEX *vtx, const VECTOR3 &mflux, MembraneWork &wk) const
+{
+	DWORD i;
+	NTVERTEX *vf, *vb;
+	float mfx = (float)mflux.x, mfy = (float)mflux.y, mfz = (float)mflux.z;
+
+	// load positions and radiation pressure along the current local normals
+	for (i = 0, vf = vtx; i < nvtx; i++, vf++) {
+		wk.px[i] = vf->x, wk.py[i] = vf->y, wk.pz[i] = vf->z;
+		float n2 = vf->nx*vf->nx + vf->ny*vf->ny + vf->nz*vf->nz;
+		float p = (n2 ? (mfx*vf->nx + mfy*vf->ny + mfz*vf->nz)*PSCALE/n2 : 0.0f);
+		wk.fx[i] = vf->nx*p, wk.fy[i] = vf->ny*p, wk.fz[i] = vf->nz*p;
+	}
+
+	SpringForces (wk);
+
+	// displace free nodes on both sides of the sail
+	for (i = 0, vf = vtx, vb = vtx+nvtx; i < nvtx; i++, vf++, vb++) {
+		if (fix[i]) continue;
+		vf->x = (wk.px[i] += wk.fx[i]);  vb->x += wk.fx[i];
+		vf->y = (wk.py[i] += wk.fy[i]);  vb->y += wk.fy[i];
+		vf->z = (wk.pz[i] += wk.fz[i]);  vb->z += wk.fz[i];
+	}
+
+	SmoothNormals (wk);
+	for (i = 0, vf = vtx, vb = vtx+nvtx; i < nvtx; i++, vf++, vb++) {
+		vf->nx =  wk.nx[i], vf->ny =  wk.ny[i], vf->nz =  wk.nz[i];
+		vb->nx = -wk.nx[i], vb->ny = -wk.ny[i], vb->nz = -wk.nz[i];
+	}
+}
+
+// ==============================================================
+// MembranePool
+
+MembranePool::MembranePool (int n)
+{
+	unsigned int id;
+	InitializeCriticalSection (&cs);
+	hJobs = CreateSemaphore (NULL, 0, 0x7fffffff, NULL);
+	head = tail = NULL;
+	quit = false;
+	nthread = n;
+	hThread = new HANDLE[nthread];
+	for (int i = 0; i < nthread; i++)
+		hThread[i] = (HANDLE)_beginthreadex (NULL, 0, &WorkerProc, this, 0, &id);
+}
+
+MembranePool::~MembranePool ()
+{
+	int i;
+	EnterCriticalSection (&cs);
+	quit = true;
+	LeaveCriticalSection (&cs);
+	ReleaseSemaphore (hJobs, nthread, NULL);
+	WaitForMultipleObjects (nthread, hThread, TRUE, INFINITE);
+	for (i = 0; i < nthread; i++)
+		CloseHandle (hThread[i]);
+	delete []hThread;
+	CloseHandle (hJobs);
+	DeleteCriticalSection (&cs);
+}
+
+void MembranePool::Submit (MembraneJob *job)
+{
+	job->next = NULL;
+	EnterCriticalSection (&cs);
+	if (tail) tail->next = job;
+	else      head = job;
+	tail = job;
+	LeaveCriticalSection (&cs);
+	ReleaseSemaphore (hJobs, 1, NULL);
+}
+
+unsigned int WINAPI MembranePool::WorkerProc (LPVOID context)
+{
+	MembranePool *pool = (MembranePool*)context;
+	MembraneJob *job;
+	bool quit;
+
+	for (;;) {
+		WaitForSingleObject (pool->hJobs, INFINITE);
+		EnterCriticalSection (&pool->cs);
+		if ((job = pool->head)) {
+			if (!(pool->head = job->next)) pool->tail = NULL;
+		}
+		quit = pool->quit;
+		LeaveCriticalSection (&pool->cs);
+		if (job) {
+			job->mb->Update (job->vtx, job->mflux, *job->wk);
+			if (!InterlockedDecrement (job->pending))
+				SetEvent (job->hDone);
+		} else if (quit) break;
+	}
+	_endthreadex(0);
+	return 0;
+}
+
+// ==============================================================
+// MembraneSolver
+
+MembraneSolver::MembraneSolver (const Membrane *membrane, DWORD n)
+{
+	mb = membrane;
+	nseg = n;
+	nvtx = mb->nVtx()*2; // front and back side
+	vbuf = new NTVERTEX*[nseg];
+	work = new MembraneWork*[nseg];
+	job = new MembraneJob[nseg];
+	for (DWORD i = 0; i < nseg; i++) {
+		vbuf[i] = NULL; // only needed in asynchronous mode, see Load
+		work[i] = new MembraneWork (mb->nVtx());
+		job[i].mb = mb;
+		job[i].vtx = NULL;
+		job[i].wk = work[i];
+		job[i].pending = &pending;
+	}
+	pending = 0;
+	hDone = CreateEvent (NULL, TRUE, TRUE, NULL);
+	for (DWORD i = 0; i < nseg; i++)
+		job[i].hDone = hDone;
+	loaded = false;
+}
+
+MembraneSolver::~MembraneSolver ()
+{
+	Wait (); // let the workers finish with our buffers
+	for (DWORD i = 0; i < nseg; i++) {
+		if (vbuf[i]) delete []vbuf[i];
+		delete work[i];
+	}
+	delete []vbuf;
+	delete []work;
+	delete []job;
+	CloseHandle (hDone);
+}
+
+void MembraneSolver::Load (MESHHANDLE hMesh, const UINT *grp)
+{
+	if (loaded) return; // keep the deformed state across visual re-creation
+	for (DWORD i = 0; i < nseg; i++) {
+		job[i].vtx = vbuf[i] = new NTVERTEX[nvtx];
+		memcpy (vbuf[i], oapiMeshGroup (hMesh, grp[i])->Vtx, nvtx*sizeof(NTVERTEX));
+	}
+	loaded = true;
+}
+
+void MembraneSolver::Update (MESHHANDLE hMesh, const UINT *grp, const VECTOR3 &mflux)
+{
+	for (DWORD i = 0; i < nseg; i++)
+		mb->Update (oapiMeshGroup (hMesh, grp[i])->Vtx, mflux, *work[i]);
+}
+
+void MembraneSolver::Submit (MembranePool *pool, const VECTOR3 &mflux)
+{
+	if (!loaded || pending) return;
+	ResetEvent (hDone);
+	pending = nseg;
+	for (DWORD i = 0; i < nseg; i++) {
+		job[i].mflux = mflux;
+		pool->Submit (job+i);
+	}
+}
+
+void MembraneSolver::Wait ()
+{
+	if (pending) WaitForSingleObject (hDone, INFINITE);
+}
+
+void MembraneSolver::Publish (MESHHANDLE hMesh, const UINT *grp)
+{
+	if (!loaded || pending) return;
+	for (DWORD i = 0; i < nseg; i++)
+		memcpy (oapiMeshGroup (hMesh, grp[i])->Vtx, vbuf[i], nvtx*sizeof(NTVERTEX));
+}
@@ -0,0 +1,151 @@
+// ==============================================================
+//                 ORBITER MODULE: SolarSail
+//                  Part of the ORBITER SDK
+//          Copyright (C) 2007 Martin Schweiger
+//                   All rights reserved
+//
+// Membrane.h
+// Elastic membrane solver for the sail segments
+// ==============================================================
+
+#ifndef __MEMBRANE_H
+#define __MEMBRANE_H
+
+#include "orbitersdk.h"
+
+// ==============================================================
+// Per-segment work buffers, in structure-of-arrays layout
+
+struct MembraneWork {
+	MembraneWork (DWORD nvtx);
+	~MembraneWork ();
+	float *px, *py, *pz;        // node positions
+	float *fx, *fy, *fz;        // accumulated nodal forces
+	float *nx, *ny, *nz;        // accumulated nodal normals
+};
+
+// ==============================================================
+// Membrane topology and solver
+//
+// All four sail segments have the same mesh structure, so a single
+// Membrane instance describes all of them. Each mesh edge is stored
+// once as a spring, with the end nodes, stiffness and squared rest
+// length in separate arrays. Springs whose end nodes run in parallel,
+// (a,b), (a+1,b+1), (a+2,b+2), (a+3,b+3), as along the rows and columns
+// of a regular mesh, come first in blocks of four: the force kernel
+// reads and accumulates both ends of a block with one SSE load and
+// store per coordinate. The remaining springs, sorted by first node,
+// are processed one at a time. The triangles, for the smooth normals,
+// are arranged and processed the same way.
+
+class Membrane {
+public:
+	Membrane (const MESHGROUP *grp);
+	~Membrane ();
+
+	inline DWORD nVtx() const { return nvtx; }
+
+	// Advance one segment by one relaxation step: accumulate spring forces
+	// and radiation pressure along the local surface normals, displace the
+	// front and back vertices, and recompute smooth normals.
+	// vtx:   segment vertex list (front side followed by back side)
+	// mflux: radiation momentum flux in vessel coordinates
+	// wk:    work buffers, sized for nVtx() nodes
+	void Update (NTVERTEX *vtx, const VECTOR3 &mflux, MembraneWork &wk) const;
+
+	// spring and triangle counts, total and in blocks of four
+	inline DWORD nSpring() const { return nedge; }
+	inline DWORD nVecSpring() const { return nvec; }
+	inline DWORD nTri() const { return ntri; }
+	inline DWORD nVecTri() const { return ntvec; }
+
+private:
+	void SpringForces (MembraneWork &wk) const;
+	void SmoothNormals (MembraneWork &wk) const;
+
+	DWORD nvtx, ntri, nedge;
+	DWORD nvec;                 // springs in blocks of four, at the start of the lists
+	DWORD ntvec;                // triangles in blocks of four, at the start of idx
+	WORD *idx;                  // front side triangle index list
+	DWORD *ea, *eb;             // spring end nodes (ea < eb)
+	float *ek;                  // spring stiffness (elasticity/rest length)
+	float *ed0sq;               // squared spring rest length
+	bool *fix;                  // fixed node flags
+	float *nscale;              // 1/number of triangles sharing a node
+};
+
+// ==============================================================
+// A single segment update, queued on the worker pool
+
+struct MembraneJob {
+	const Membrane *mb;         // segment topology
+	NTVERTEX *vtx;              // segment vertex buffer
+	MembraneWork *wk;           // segment work buffers
+	VECTOR3 mflux;              // radiation momentum flux
+	volatile LONG *pending;     // decremented when the job is done
+	HANDLE hDone;               // set when pending drops to zero
+	MembraneJob *next;          // queue link
+};
+
+// ==============================================================
+// Worker threads shared by all sails of the module
+
+class MembranePool {
+public:
+	MembranePool (int nthread);
+	~MembranePool ();
+	void Submit (MembraneJob *job);
+
+private:
+	static unsigned int WINAPI WorkerProc (LPVOID context);
+	CRITICAL_SECTION cs;        // protects the job queue
+	HANDLE hJobs;               // semaphore counting queued jobs
+	HANDLE *hThread;
+	int nthread;
+	MembraneJob *head, *tail;   // job queue
+	bool quit;
+};
+
+// ==============================================================
+// Per-vessel sail state
+//
+// The solver keeps its own copy of the segment vertices. In asynchronous
+// mode the worker threads relax this copy, and the vessel copies it into
+// the visual mesh only when all segments of a step have completed, so the
+// mesh never shows a half-updated sail.
+
+class MembraneSolver {
+public:
+	MembraneSolver (const Membrane *mb, DWORD nseg);
+	~MembraneSolver ();
+
+	// load the segment vertices from a mesh (first visual only)
+	void Load (MESHHANDLE hMesh, const UINT *grp);
+
+	// true while a step is being solved on the worker pool
+	inline bool Busy () const { return pending != 0; }
+
+	// block until the step queued with Submit has completed
+	void Wait ();
+
+	// relax the mesh segments in place on the calling thread
+	void Update (MESHHANDLE hMesh, const UINT *grp, const VECTOR3 &mflux);
+
+	// queue a step for all segments on the worker pool
+	void Submit (MembranePool *pool, const VECTOR3 &mflux);
+
+	// copy the last completed step into the mesh
+	void Publish (MESHHANDLE hMesh, const UINT *grp);
+
+private:
+	const Membrane *mb;
+	DWORD nseg, nvtx;           // number of segments, vertices per segment
+	NTVERTEX **vbuf;            // solver copy of the segment vertices
+	MembraneWork **work;        // per-segment work buffers
+	MembraneJob *job;           // per-segment pool jobs
+	volatile LONG pending;      // segments still being solved
+	HANDLE hDone;               // manual-reset event, set when pending drops to zero
+	bool loaded;
+};
+
+#endif // !__MEMBRANE_H
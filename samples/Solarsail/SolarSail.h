@@ -13,15 +13,7 @@
 
 #define STRICT 1
 #include "orbitersdk.h"
-
-#define MAXNBHR 6 // max node neighbours
-
-struct NBHR {            // node neigbourhood structure
-	DWORD nnd;              // number of neighbours
-	DWORD nd[MAXNBHR];      // neighbour index list
-	double dst0[MAXNBHR];   // neighbour distance list
-	bool fix;               // fix node position
-};
+#include "Membrane.h"
 
 // ==============================================================
 // SolarSail interface
@@ -30,8 +22,10 @@ class SolarSail: public VESSEL3 {
 public:
 	SolarSail (OBJHANDLE hVessel, int flightmodel);
 
-	// one-time global setup across all instances
+	// one-time global setup and cleanup across all instances
 	static void GlobalSetup();
+	static void GlobalExit();
+	~SolarSail ();
 
 	void clbkSetClassCaps (FILEHANDLE cfg);
 	void clbkPreStep (double simt, double simdt, double mjd);
@@ -51,6 +45,8 @@ private:
 	UINT anim_paddle[4];        // steering paddle animation identifiers
 	double paddle_rot[4];       // paddle logical rotation state (0-1, 0.5=neutral)
 	double paddle_vis[4];       // paddle visual rotation state
+	MembraneSolver *sail;       // sail segment state of this vessel
+	bool sail_async;            // solve the sail on the worker pool
 
 	void DefineAnimations();
 
@@ -60,9 +56,8 @@ private:
 
 	static void SetupElasticity (MESHHANDLE hMesh);
 	static MESHHANDLE hMeshTpl; // global mesh template
-	static DWORD sail_nvtx, sail_ntri;
-	static NBHR *nbhr;
-	static VECTOR3 *sail_vbuf;   // vertex temporary buffer
+	static Membrane *membrane;  // sail segment topology (shared, read-only)
+	static MembranePool *pool;  // worker threads for asynchronous sail updates
 };
 
 #endif // !__SOLARSAIL_H
\ No newline at end of file
@@ -12,44 +12,33 @@
 
 #include "SolarSail.h"
 #include "meshres.h"
+#include "../Common/AeroTable.h"
 
 // ==============================================================
 // Some vessel parameters
 // ==============================================================
 const double SAIL_RADIUS = 500.0;
+const int NSAILWORKER = 4;     // worker threads for asynchronous sail updates
 
-// Calculate lift coefficient [Cl] as a function of aoa (angle of attack) over -Pi ... Pi
-// Implemented here as a piecewise linear function
-double LiftCoeff (double aoa)
-{
-	int i;
-	const int nlift = 9;
-	static const double AOA[nlift] = {-180*RAD,-60*RAD,-30*RAD,-1*RAD,15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
-	static const double CL[nlift]  = {       0,      0,   -0.1,     0,   0.2,  0.25,   0.2,     0,      0};
-	static const double SCL[nlift] = {(CL[1]-CL[0])/(AOA[1]-AOA[0]), (CL[2]-CL[1])/(AOA[2]-AOA[1]),
-		                              (CL[3]-CL[2])/(AOA[3]-AOA[2]), (CL[4]-CL[3])/(AOA[4]-AOA[3]),
-									  (CL[5]-CL[4])/(AOA[5]-AOA[4]), (CL[6]-CL[5])/(AOA[6]-AOA[5]),
-									  (CL[7]-CL[6])/(AOA[7]-AOA[6]), (CL[8]-CL[7])/(AOA[8]-AOA[7])};
-	for (i = 0; i < nlift-1 && AOA[i+1] < aoa; i++);
-	return CL[i] + (aoa-AOA[i])*SCL[i];
-}
+static const UINT SailGrp[4] = {GRP_sail1, GRP_sail2, GRP_sail3, GRP_sail4};
+
+// Lift coefficient [Cl] as a function of aoa (angle of attack) over -Pi ... Pi,
+// tabulated from a piecewise linear function by DefineLiftTable
+static AeroTable lift;
 
-// distance between two vertices
-inline double Dst (const NTVERTEX *v1, const NTVERTEX *v2)
+double LiftCoeff (double aoa)
 {
-	double dx = v1->x - v2->x;
-	double dy = v1->y - v2->y;
-	double dz = v1->z - v2->z;
-	return sqrt (dx*dx + dy*dy + dz*dz);
+	return lift.Cl (aoa);
 }
 
-inline VECTOR3 Nml (const NTVERTEX *v1, const NTVERTEX *v2, const NTVERTEX *v3)
+static void DefineLiftTable ()
 {
-	float dx1 = v2->x - v1->x,   dx2 = v3->x - v1->x;
-	float dy1 = v2->y - v1->y,   dy2 = v3->y - v1->y;
-	float dz1 = v2->z - v1->z,   dz2 = v3->z - v1->z;
+	if (lift.Defined()) return;
 
-	return _V(dy1*dz2 - dy2*dz1, dz1*dx2 - dz2*dx1, dx1*dy2 - dx2*dy1);
+	const int nlift = 9;
+	static const double AOA[nlift] = {-180*RAD,-60*RAD,-30*RAD,-1*RAD,15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
+	static const double CL[nlift]  = {       0,      0,   -0.1,     0,   0.2,  0.25,   0.2,     0,      0};
+	lift.SetLift (nlift, AOA, CL);
 }
 
 inline VECTOR3 crossp (const NTVERTEX *v1, const NTVERTEX *v2)
@@ -67,51 +56,24 @@ void SolarSail::GlobalSetup()
 	SetupElasticity (hMeshTpl);
 }
 
+// --------------------------------------------------------------
+// One-time global cleanup
+// --------------------------------------------------------------
+void SolarSail::GlobalExit()
+{
+	if (pool) delete pool;
+	delete membrane;
+	pool = NULL;
+	membrane = NULL;
+}
+
 // --------------------------------------------------------------
 // Set up the dynamic elastic sail deformation code
 // --------------------------------------------------------------
 void SolarSail::SetupElasticity (MESHHANDLE hMesh)
 {
-	MESHGROUP *sail = oapiMeshGroup (hMesh, GRP_sail1);
 	// all sail segments have the same mesh structure, so segment 1 represents all 4
-	DWORD nvtx = sail->nVtx/2; // scan front side only
-	DWORD nidx = sail->nIdx/2; // scan front side only
-	DWORD ntri = nidx/3;
-	WORD *idx = sail->Idx;
-	NTVERTEX *vtx = sail->Vtx;
-	DWORD i, j, k, m, nj, nk;
-
-	// generate node neighbour graph
-	sail_vbuf = new VECTOR3[nvtx];
-	nbhr = new NBHR[nvtx];
-	for (i = 0; i < nvtx; i++) {
-		nbhr[i].nnd = 0;
-		nbhr[i].fix = (vtx[i].x == 0 || vtx[i].y == 0);
-	}
-
-	for (i = 0; i < ntri; i++) {
-		WORD *tri = idx+(i*3);
-		for (j = 0; j < 3; j++) {
-			nj = tri[j];
-			for (k = 0; k < 3; k++) {
-				if (j == k) continue;
-				nk = tri[k];
-				for (m = 0; m < nbhr[nj].nnd; m++)
-					if (nbhr[nj].nd[m] == nk) break; // already in neighbour list
-				if (m == nbhr[nj].nnd) {
-					if (nbhr[nj].nnd == MAXNBHR) 
-						strcpy (oapiDebugString(), "Problems!");
-					else {
-						nbhr[nj].nd[m] = nk;
-						nbhr[nj].dst0[m] = Dst (vtx+nj, vtx+nk);
-						nbhr[nj].nnd++;
-					}
-				}
-			}
-		}
-	}
-	sail_nvtx = nvtx;
-	sail_ntri = ntri;
+	membrane = new Membrane (oapiMeshGroup (hMesh, GRP_sail1));
 }
 
 // --------------------------------------------------------------
@@ -124,11 +86,21 @@ SolarSail::SolarSail (OBJHANDLE hVessel, int flightmodel)
 
 	hMesh = NULL;
 	mf = _V(0,0,0);
+	sail = new MembraneSolver (membrane, 4);
+	sail_async = false;
 	DefineAnimations();
 	for (i = 0; i < 4; i++)
 		paddle_rot[i] = paddle_vis[i] = 0.5;
 }
 
+// --------------------------------------------------------------
+// Destructor
+// --------------------------------------------------------------
+SolarSail::~SolarSail ()
+{
+	delete sail;
+}
+
 // --------------------------------------------------------------
 // Define animation sequences for moving parts
 // --------------------------------------------------------------
@@ -156,78 +128,15 @@ void SolarSail::DefineAnimations ()
 // --------------------------------------------------------------
 void SolarSail::UpdateSail (const VECTOR3 *rpressure)
 {
-	// A kind of poor man's finite element code. Should eventually be done properly!
-	
-	static int sailidx = 0;
-
-	const double elast = 1e-1;
-	const double pscale = 1e3;
-	DWORD i, j;
-	NBHR *nb;
-	NTVERTEX *vi, *vj;
-	VECTOR3 dv, F, nm;
-	static VECTOR3 *nml = 0;
-	static DWORD *nsd = 0;
-	double dst;
-
-	sailidx = ++sailidx % 4;
-	MESHGROUP *sail = oapiMeshGroup (hMesh, sailidx);
-
-	for (i = 0; i < sail_nvtx; i++) {
-		F = _V(0,0,rpressure->z*pscale); // note - should be calculated for LOCAL normal
-		vi = sail->Vtx+i;
-		nb = nbhr+i;
-		if (nb->fix) {
-			sail_vbuf[i] = _V(0,0,0);
-			continue;
-		}
-		for (j = 0; j < nb->nnd; j++) {
-			vj = sail->Vtx+nb->nd[j];
-			dv.x = vj->x - vi->x;
-			dv.y = vj->y - vi->y;
-			dv.z = vj->z - vi->z;
-			dst = length(dv);
-			if (dst > nb->dst0[j]) { // is stretched
-				F += dv*(elast/nb->dst0[j]);
-			}
-		}
-		sail_vbuf[i] = F;
-	}
-	for (i = 0; i < sail_nvtx; i++) {
-		sail->Vtx[i].x += (float)sail_vbuf[i].x;
-		sail->Vtx[i].y += (float)sail_vbuf[i].y;
-		sail->Vtx[i].z += (float)sail_vbuf[i].z;
-	}
-	for (i = 0; i < sail_nvtx; i++) {
-		sail->Vtx[i+sail_nvtx].x += (float)sail_vbuf[i].x;
-		sail->Vtx[i+sail_nvtx].y += (float)sail_vbuf[i].y;
-		sail->Vtx[i+sail_nvtx].z += (float)sail_vbuf[i].z;
-	}
-
-	// calculate smooth normals - surely this could be done more efficiently!
-	if (!nml) {
-		nml = new VECTOR3[sail_nvtx];
-		nsd = new DWORD[sail_nvtx];
-	}
-	memset (nml, 0, sail_nvtx*sizeof(VECTOR3));
-	memset (nsd, 0, sail_nvtx*sizeof(DWORD));
-	for (i = 0; i < sail_ntri; i++) {
-		WORD *idx = sail->Idx + i*3;
-		nm = Nml(sail->Vtx + *idx, sail->Vtx + *(idx+1), sail->Vtx + *(idx+2));
-		for (j = 0; j < 3; j++) {
-			nml[*(idx+j)] += unit(nm);
-			nsd[*(idx+j)]++;
-		}
-	}
-	for (i = 0; i < sail_nvtx; i++) {
-		sail->Vtx[i].nx = (float)nml[i].x/nsd[i];
-		sail->Vtx[i].ny = (float)nml[i].y/nsd[i];
-		sail->Vtx[i].nz = (float)nml[i].z/nsd[i];
-	}
-	for (i = 0; i < sail_nvtx; i++) {
-		sail->Vtx[i+sail_nvtx].nx = -(float)nml[i].x/nsd[i];
-		sail->Vtx[i+sail_nvtx].ny = -(float)nml[i].y/nsd[i];
-		sail->Vtx[i+sail_nvtx].nz = -(float)nml[i].z/nsd[i];
+	// all four segments are relaxed every frame, with the radiation
+	// pressure acting along the local normals of each node
+	if (!sail_async) {
+		sail->Update (hMesh, SailGrp, *rpressure);
+	} else if (!sail->Busy()) {
+		// show the step that has just completed, then start the next one.
+		// If the workers are still busy, the mesh keeps the previous state
+		sail->Publish (hMesh, SailGrp);
+		sail->Submit (pool, *rpressure);
 	}
 }
 
@@ -263,10 +172,17 @@ void SolarSail::clbkSetClassCaps (FILEHANDLE cfg)
 	SetPMI (_V(3e3,3e3,6e3));
 	SetTrimScale (0.05);
 	SetCameraOffset (_V(0,0.8,0));
+	DefineLiftTable();
 	SetLiftCoeffFunc (LiftCoeff);
 	SetDockParams (_V(0,1.3,-1), _V(0,1,0), _V(0,0,-1));
 	SetTouchdownPoints (_V(0,-1.5,2), _V(-1,-1.5,-1.5), _V(1,-1.5,-1.5));
 
+	// solve the sail membrane off the simulation thread?
+	if (!oapiReadItem_bool (cfg, "AsyncSail", sail_async))
+		sail_async = false;
+	if (sail_async && !pool)
+		pool = new MembranePool (NSAILWORKER);
+
 	// visual specs
 	AddMesh (hMeshTpl);
 }
@@ -337,6 +253,7 @@ void SolarSail::clbkGetRadiationForce (const VECTOR3 &mflux, VECTOR3 &F, VECTOR3
 void SolarSail::clbkVisualCreated (VISHANDLE vis, int refcount)
 {
 	hMesh = GetMesh (vis, 0);
+	if (sail_async) sail->Load (hMesh, SailGrp);
 }
 
 // --------------------------------------------------------------
@@ -365,10 +282,8 @@ int SolarSail::clbkGeneric (int msgid, int prm, void *context)
 // Static member initialisations
 // --------------------------------------------------------------
 MESHHANDLE SolarSail::hMeshTpl = NULL;
-NBHR *SolarSail::nbhr = NULL;
-VECTOR3 *SolarSail::sail_vbuf = NULL;
-DWORD SolarSail::sail_nvtx = 0;
-DWORD SolarSail::sail_ntri = 0;
+Membrane *SolarSail::membrane = NULL;
+MembranePool *SolarSail::pool = NULL;
 
 // ==============================================================
 // API callback interface
@@ -383,6 +298,14 @@ DLLCLBK void InitModule (HINSTANCE hModule)
 	SolarSail::GlobalSetup();
 }
 
+// --------------------------------------------------------------
+// Global cleanup
+// --------------------------------------------------------------
+DLLCLBK void ExitModule (HINSTANCE hModule)
+{
+	SolarSail::GlobalExit();
+}
+
 // --------------------------------------------------------------
 // Vessel initialisation
 // --------------------------------------------------------------